@@ -20,6 +20,7 @@
 #include "kernel/log/Log.h"
 #include "GatesOfHell.h"
 #include "kernel/memory/MemoryLayout.h"
+#include "kernel/memory/MagazineAllocator.h"
 #include "kernel/memory/Paging.h"
 #include "kernel/memory/PagingAreaManager.h"
 #include "kernel/memory/PageFrameAllocator.h"
@@ -27,6 +28,7 @@
 #include "kernel/service/MemoryService.h"
 #include "kernel/service/InterruptService.h"
 #include "device/interrupt/apic/Apic.h"
+#include "device/interrupt/apic/LocalApic.h"
 #include "device/system/Acpi.h"
 #include "kernel/service/InformationService.h"
 #include "device/system/SmBios.h"
@@ -55,6 +57,7 @@
 #include "filesystem/memory/RandomNode.h"
 #include "filesystem/memory/MountsNode.h"
 #include "kernel/memory/MemoryStatusNode.h"
+#include "device/storage/block/BufferCacheNode.h"
 #include "device/system/FirmwareConfiguration.h"
 #include "filesystem/qemu/FirmwareConfigurationDriver.h"
 #include "filesystem/acpi/AcpiDriver.h"
@@ -75,7 +78,7 @@
 #include "lib/util/graphic/Ansi.h"
 #include "lib/util/base/System.h"
 #include "BuildConfig.h"
-#include "kernel/memory/PagingAreaManagerRefillRunnable.h"
+#include "kernel/memory/MemoryPoolRefillRunnable.h"
 #include "lib/util/async/Process.h"
 #include "device/hid/Ps2Controller.h"
 #include "device/interrupt/pic/Pic.h"
@@ -93,6 +96,7 @@
 #include "lib/util/base/Address.h"
 #include "lib/util/base/Exception.h"
 #include "lib/util/base/FreeListMemoryManager.h"
+#include "lib/util/base/TlsfMemoryManager.h"
 #include "lib/util/base/String.h"
 #include "lib/util/collection/Array.h"
 #include "lib/util/hardware/SmBios.h"
@@ -204,6 +208,18 @@ void GatesOfHell::enter(uint32_t multibootMagic, const Kernel::Multiboot *multib
     uint32_t pagingAreaPhysical = bootstrapMemory;
     uint32_t kernelHeapPhysical = bootstrapMemory + INITIAL_PAGING_AREA_SIZE;
 
+    // Page size extension allows mapping large, physically contiguous regions (e.g. frame buffers) with 4 MiB pages
+    auto cpuFeatures = Util::Hardware::CpuId::getCpuFeatureBits();
+    if (cpuFeatures & Util::Hardware::CpuId::PSE) {
+        Device::Cpu::writeCr4(Device::Cpu::readCr4() | Device::Cpu::PAGE_SIZE_EXTENSION);
+    }
+
+    // Global pages are not flushed from the TLB on address space switches, which is used for the kernel area.
+    // This is enabled before creating the initial mappings, so that they are created as global pages as well.
+    if (cpuFeatures & Util::Hardware::CpuId::PGE) {
+        Device::Cpu::writeCr4(Device::Cpu::readCr4() | Device::Cpu::PAGE_GLOBAL_ENABLE);
+    }
+
     LOG_INFO("Creating initial mappings");
 
     // Create page directory
@@ -233,13 +249,17 @@ void GatesOfHell::enter(uint32_t multibootMagic, const Kernel::Multiboot *multib
     // Enable paging
     LOG_INFO("Enabling paging");
     Kernel::Paging::loadDirectory(*pageDirectory);
-    Device::Cpu::writeCr0(Device::Cpu::readCr0() | Device::Cpu::PAGING);
+    // Write protection makes read-only pages apply to the kernel as well (needed for protecting kernel code and for copy-on-write pages)
+    Device::Cpu::writeCr0(Device::Cpu::readCr0() | Device::Cpu::PAGING | Device::Cpu::WRITE_PROTECT);
 
     // Initialize kernel heap
     LOG_INFO("Initializing kernel heap");
     static Util::FreeListMemoryManager kernelHeapManager;
     kernelHeapManager.initialize(reinterpret_cast<uint8_t*>(kernelHeapVirtual), reinterpret_cast<uint8_t*>(Kernel::MemoryLayout::KERNEL_HEAP_END_ADDRESS));
-    kernelHeap = &kernelHeapManager;
+
+    // Small objects are served from per-CPU magazine caches in front of the free list
+    static Kernel::MagazineAllocator kernelHeapCache(kernelHeapManager);
+    kernelHeap = &kernelHeapCache;
     LOG_INFO("Kernel heap initialized (Bootstrap memory: [0x%08x])", bootstrapMemory);
 
     // Setup GDT
@@ -346,6 +366,10 @@ void GatesOfHell::enter(uint32_t multibootMagic, const Kernel::Multiboot *multib
     memoryService->mapPhysical(reinterpret_cast<void*>(Kernel::MemoryLayout::USABLE_LOWER_MEMORY.endAddress + 1), reinterpret_cast<void*>(Kernel::MemoryLayout::USABLE_LOWER_MEMORY.endAddress + 1),
                                (KERNEL_DATA_START - (Kernel::MemoryLayout::USABLE_LOWER_MEMORY.endAddress + 1)) / Util::PAGESIZE, Kernel::Paging::PRESENT | Kernel::Paging::WRITABLE);
 
+    // All boot time reservations are done and page faults can be handled, so the page frame allocator can build its free lists
+    LOG_INFO("Enabling buddy system for page frame allocation");
+    pageFrameAllocator->enableBuddySystem();
+
     // Set log level
     if (multiboot->hasKernelOption("log_level")) {
         const auto level = multiboot->getKernelOption("log_level");
@@ -360,7 +384,6 @@ void GatesOfHell::enter(uint32_t multibootMagic, const Kernel::Multiboot *multib
     LOG_INFO("Initializing scheduler");
     auto *kernelProcess = new Kernel::Process(*kernelAddressSpace, "Kernel");
     auto *processService = new Kernel::ProcessService(kernelProcess);
-    auto &scheduler = processService->getScheduler();
     Kernel::Service::registerService(Kernel::ProcessService::SERVICE_ID, processService);
 
     // Initialize frame buffer
@@ -520,6 +543,10 @@ void GatesOfHell::enter(uint32_t multibootMagic, const Kernel::Multiboot *multib
             LOG_WARN("Failed to initializeScene APIC -> Falling back to PIC");
         } else {
             interruptService->useApic(apic);
+
+            // Per-CPU structures of the bootstrap processor have been stored at index 0 until now -> Move them to its APIC id
+            memoryService->assignBootstrapProcessorId(Device::LocalApic::getId());
+            processService->assignBootstrapProcessorId(Device::LocalApic::getId());
             apic->startCurrentTimer();
 
             if (apic->isSymmetricMultiprocessingSupported()) {
@@ -530,12 +557,13 @@ void GatesOfHell::enter(uint32_t multibootMagic, const Kernel::Multiboot *multib
         LOG_INFO("APIC not available -> Falling back to PIC");
     }
 
-    // Create thread to refill block pool of paging area manager
-    auto &refillThread = Kernel::Thread::createKernelThread("Paging-Area-Pool-Refiller", processService->getKernelProcess(), new Kernel::PagingAreaManagerRefillRunnable(*pagingAreaManager));
-    scheduler.ready(refillThread);
+    // Create thread to refill the pools of zeroed page tables and page frames
+    auto &refillThread = Kernel::Thread::createKernelThread("Memory-Pool-Refiller", processService->getKernelProcess(), new Kernel::MemoryPoolRefillRunnable(*pagingAreaManager, memoryService->getZeroedPageFramePool()));
+    processService->ready(refillThread);
 
     // Register memory manager
     Util::Reflection::InstanceFactory::registerPrototype(new Util::FreeListMemoryManager());
+    Util::Reflection::InstanceFactory::registerPrototype(new Util::TlsfMemoryManager());
 
     // Protect kernel code
     for (uint32_t address = WRITE_PROTECTED_START; address < WRITE_PROTECTED_END; address += Util::PAGESIZE) {
@@ -602,7 +630,8 @@ void GatesOfHell::enter(uint32_t multibootMagic, const Kernel::Multiboot *multib
     Device::Pci::scan();
 
     // Initialize storage devices
-    auto *storageService = new Kernel::StorageService();
+    auto bufferCacheSize = static_cast<uint32_t>(Util::String::parseInt(multiboot->getKernelOption("buffer_cache", "4096"))) * 1024;
+    auto *storageService = new Kernel::StorageService(bufferCacheSize);
     Kernel::Service::registerService(Kernel::StorageService::SERVICE_ID, storageService);
 
     LOG_INFO("Searching multiboot modules for virtual disk drive");
@@ -634,6 +663,7 @@ void GatesOfHell::enter(uint32_t multibootMagic, const Kernel::Multiboot *multib
     auto *filesystemService = new Kernel::FilesystemService();
     Kernel::Service::registerService(Kernel::FilesystemService::SERVICE_ID, filesystemService);
 
+    Filesystem::Fat::FatDriver::setWriteBack(multiboot->getKernelOption("fat_write_back", "true") == "true");
     Util::Reflection::InstanceFactory::registerPrototype(new Filesystem::Fat::FatDriver());
     Util::Reflection::InstanceFactory::registerPrototype(new Filesystem::Iso::IsoDriver());
 
@@ -675,6 +705,9 @@ void GatesOfHell::enter(uint32_t multibootMagic, const Kernel::Multiboot *multib
     deviceDriver->addNode("/", new Filesystem::Memory::MountsNode());
     deviceDriver->addNode("", new Kernel::LogNode());
     deviceDriver->addNode("/", new Kernel::MemoryStatusNode());
+    if (storageService->getBufferCache() != nullptr) {
+        deviceDriver->addNode("/", new Device::Storage::BufferCacheNode(*storageService->getBufferCache()));
+    }
 
     if (Device::FirmwareConfiguration::isAvailable()) {
         auto *fwCfg = new Device::FirmwareConfiguration();
@@ -845,8 +878,6 @@ void GatesOfHell::enter(uint32_t multibootMagic, const Kernel::Multiboot *multib
             << Util::Graphic::Ansi::RESET << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
     }
 
-    memoryService->enableSlabAllocator();
-
     LOG_INFO("Starting scheduler");
     processService->startScheduler();
 
@@ -878,7 +909,7 @@ uint32_t GatesOfHell::createInitialMapping(Kernel::Paging::Table &pageDirectory,
         auto tableIndex = Kernel::Paging::TABLE_INDEX(virtualAddress);
 
         // Create identity mapping for current kernel frame
-        table[tableIndex].set(physicalAddress, Kernel::Paging::PRESENT | Kernel::Paging::WRITABLE);
+        table[tableIndex].set(physicalAddress, Kernel::Paging::PRESENT | Kernel::Paging::WRITABLE | Kernel::Paging::getKernelPageFlags());
     }
 
     return allocatedPageTables;
@@ -35,6 +35,9 @@
 #include "lib/util/io/key/layout/DeLayout.h"
 #include "lib/util/io/key/KeyDecoder.h"
 
+// Many small, short-lived allocations -> Use the constant time TLSF allocator
+HHUOS_HEAP_MANAGER(TLSF_HEAP_MANAGER)
+
 const ClownMDEmu_Constant constants = ClownMDEmu_Constant_Initialise();
 ClownMDEmu emulator{};
 ClownMDEmu_State state{};
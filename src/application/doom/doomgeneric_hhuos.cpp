@@ -21,6 +21,10 @@
 #include "lib/util/io/key/layout/DeLayout.h"
 #include "lib/util/sound/PcSpeaker.h"
 #include "lib/util/graphic/BufferedLinearFrameBuffer.h"
+#include "lib/util/base/System.h"
+
+// Many small, short-lived allocations -> Use the constant time TLSF allocator
+HHUOS_HEAP_MANAGER(TLSF_HEAP_MANAGER)
 
 uint32_t palette[256];
 Util::Graphic::LinearFrameBuffer *lfb;
@@ -22,118 +22,635 @@
 #include "lib/util/time/Timestamp.h"
 #include "lib/util/base/ArgumentParser.h"
 #include "lib/util/collection/Array.h"
+#include "lib/util/collection/ArrayList.h"
+#include "lib/util/collection/HashMap.h"
 #include "lib/util/base/String.h"
+#include "lib/util/base/FreeListMemoryManager.h"
+#include "lib/util/base/TlsfMemoryManager.h"
+#include "lib/util/io/file/File.h"
+#include "lib/util/io/stream/FileInputStream.h"
+#include "lib/util/io/stream/FileOutputStream.h"
+#include "lib/util/io/stream/PipedInputStream.h"
+#include "lib/util/io/stream/PipedOutputStream.h"
 #include "lib/util/io/stream/PrintStream.h"
+#include "lib/util/async/Thread.h"
+#include "lib/util/async/Semaphore.h"
+#include "lib/util/async/FunctionPointerRunnable.h"
+#include "lib/util/hardware/CpuId.h"
 #include "lib/util/math/Random.h"
 #include "lib/interface.h"
 #include "lib/util/base/Constants.h"
+#include "kernel/memory/BitmapMemoryManager.h"
+#include "kernel/memory/SlabAllocator.h"
 
-const constexpr uint8_t BENCHMARK_REPETITIONS = 10;
+const constexpr uint8_t DEFAULT_REPETITIONS = 10;
+const constexpr uint32_t RANDOM_SEED = 42;
+const constexpr uint32_t CALIBRATION_TIME_MS = 200;
 
-Util::Math::Random random;
+const constexpr uint32_t ALLOCATOR_OPERATIONS = 1024;
+const constexpr uint32_t ALLOCATOR_HEAP_SIZE = 16 * 1024 * 1024;
+const constexpr uint32_t ALLOCATOR_MAX_SIZE = 1024;
+const constexpr uint32_t SLAB_OPERATIONS = 128;
+const constexpr uint32_t SLAB_MEMORY_SIZE = 4 * 1024 * 1024;
+const constexpr uint32_t SLAB_OBJECT_SIZE = 128;
+const constexpr uint32_t COLLECTION_OPERATIONS = 4096;
+const constexpr uint32_t LATENCY_OPERATIONS = 10000;
+const constexpr uint32_t SWITCH_OPERATIONS = 1000;
+const constexpr uint32_t PIPE_TRANSFER_SIZE = 4 * 1024 * 1024;
+const constexpr uint32_t PIPE_CHUNK_SIZE = 4096;
+const constexpr uint32_t FILE_CHUNK_SIZE = 64 * 1024;
 
-Util::Time::Timestamp benchmarkMemset(const Util::Address<uint32_t> &address, uint32_t length) {
-    auto value = static_cast<uint32_t>(random.nextRandomNumber() * 0xff);
+struct Result {
+    Util::String benchmark;
+    Util::String variant;
+    uint32_t size;          // Buffer size in bytes (0, if not applicable)
+    uint32_t operations;    // Operations per repetition
+    uint64_t bytes;         // Bytes processed per repetition (0, if not applicable)
+    uint64_t minimumNanos;
+    uint64_t averageNanos;
+    uint64_t maximumNanos;
 
-    auto start = Util::Time::getSystemTime();
-    address.setRange(value, length);
-    return Util::Time::getSystemTime() - start;
+    bool operator==(const Result &other) const {
+        return benchmark == other.benchmark && variant == other.variant && size == other.size;
+    }
+
+    bool operator!=(const Result &other) const {
+        return !(*this == other);
+    }
+};
+
+// A fixed seed makes sure, that every run uses the same sizes and access patterns
+Util::Math::Random random(RANDOM_SEED);
+Util::ArrayList<Result> results;
+uint8_t repetitions = DEFAULT_REPETITIONS;
+
+// Timestamp counter frequency in kHz (0, if the system time is used for measurements)
+uint64_t timestampCounterFrequency = 0;
+
+// Shared state for the benchmark functions (set up before a benchmark is run)
+uint8_t *sourceBuffer = nullptr;
+uint8_t *targetBuffer = nullptr;
+Util::HeapMemoryManager *heapManager = nullptr;
+Kernel::BitmapMemoryManager *bitmapManager = nullptr;
+Kernel::SlabCache *slabCache = nullptr;
+uint32_t allocationSizes[ALLOCATOR_OPERATIONS];
+uint32_t freeOrder[ALLOCATOR_OPERATIONS];
+void *allocations[ALLOCATOR_OPERATIONS];
+uint32_t collectionKeys[COLLECTION_OPERATIONS];
+Util::Async::Semaphore *pingSemaphore = nullptr;
+Util::Async::Semaphore *pongSemaphore = nullptr;
+Util::Io::PipedOutputStream *pipeOutput = nullptr;
+Util::String benchmarkFilePath;
+volatile uint32_t sink;
+
+uint64_t readTimestampCounter() {
+    uint32_t low, high;
+    asm volatile ("rdtsc" : "=a"(low), "=d"(high));
+    return static_cast<uint64_t>(high) << 32 | low;
+}
+
+/**
+ * Measure the timestamp counter frequency against the system time.
+ * If the CPU does not have a timestamp counter, the (less precise) system time is used for all measurements.
+ */
+void calibrateTimestampCounter() {
+    if ((Util::Hardware::CpuId::getCpuFeatureBits() & Util::Hardware::CpuId::TSC) == 0) {
+        return;
+    }
+
+    auto startTime = Util::Time::getSystemTime();
+    auto startTicks = readTimestampCounter();
+    Util::Async::Thread::sleep(Util::Time::Timestamp::ofMilliseconds(CALIBRATION_TIME_MS));
+    auto endTicks = readTimestampCounter();
+    auto elapsedNanos = (Util::Time::getSystemTime() - startTime).toNanoseconds();
+
+    timestampCounterFrequency = (endTicks - startTicks) * 1000000 / elapsedNanos;
+}
+
+uint64_t now() {
+    return timestampCounterFrequency == 0 ? Util::Time::getSystemTime().toNanoseconds() : readTimestampCounter();
 }
 
-Util::Time::Timestamp benchmarkMemcpy(const Util::Address<uint32_t> &source, const Util::Address<uint32_t> &target, uint32_t length) {
-    auto start = Util::Time::getSystemTime();
-    target.copyRange(source, length);
-    return Util::Time::getSystemTime() - start;
+uint64_t toNanoseconds(uint64_t ticks) {
+    return timestampCounterFrequency == 0 ? ticks : ticks * 1000000 / timestampCounterFrequency;
 }
 
-Util::String powerAsString(uint8_t power) {
-    auto bytes = 1 << power;
-    if (power < 10) {
-        return Util::String::format("%d B", bytes);
-    } else if (power < 20) {
-        return Util::String::format("%d KiB", bytes >> 10);
-    } else if (power < 30) {
-        return Util::String::format("%d MiB", bytes >> 20);
+Util::String sizeAsString(uint32_t bytes) {
+    if (bytes < 1024) {
+        return Util::String::format("%u B", bytes);
+    } else if (bytes < 1024 * 1024) {
+        return Util::String::format("%u KiB", bytes >> 10);
+    } else if (bytes < 1024 * 1024 * 1024) {
+        return Util::String::format("%u MiB", bytes >> 20);
     } else {
-        return Util::String::format("%d GiB", bytes >> 30);
+        return Util::String::format("%u GiB", bytes >> 30);
+    }
+}
+
+void printResult(const Result &result) {
+    Util::System::out << result.benchmark << " " << result.variant;
+    if (result.size > 0) {
+        Util::System::out << " " << sizeAsString(result.size);
+    }
+
+    Util::System::out.setDecimalPrecision(2);
+    Util::System::out << ":\t" << static_cast<double>(result.averageNanos) / result.operations << " ns/op";
+
+    if (result.bytes > 0 && result.averageNanos > 0) {
+        Util::System::out << " (" << result.bytes * 1000.0 / result.averageNanos << " MB/s)";
+    }
+
+    Util::System::out << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
+}
+
+/**
+ * Run a benchmark function once for warmup (e.g. to make sure that memory is mapped)
+ * and 'repetitions' times for measurement. The function returns the elapsed timer ticks.
+ */
+void runBenchmark(const char *benchmark, const char *variant, uint32_t size, uint32_t operations, uint64_t bytes, uint64_t (*function)(uint32_t size)) {
+    function(size);
+
+    uint64_t minimum = UINT64_MAX;
+    uint64_t maximum = 0;
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < repetitions; i++) {
+        auto nanos = toNanoseconds(function(size));
+        minimum = nanos < minimum ? nanos : minimum;
+        maximum = nanos > maximum ? nanos : maximum;
+        sum += nanos;
+    }
+
+    auto result = Result{benchmark, variant, size, operations, bytes, minimum, sum / repetitions, maximum};
+    results.add(result);
+    printResult(result);
+}
+
+uint64_t benchmarkMemset(uint32_t size) {
+    auto value = static_cast<uint8_t>(random.nextRandomNumber() * 0xff);
+
+    auto start = now();
+    Util::Address<uint32_t>(targetBuffer).setRange(value, size);
+    return now() - start;
+}
+
+uint64_t benchmarkMemcpy(uint32_t size) {
+    auto start = now();
+    Util::Address<uint32_t>(targetBuffer).copyRange(Util::Address<uint32_t>(sourceBuffer), size);
+    return now() - start;
+}
+
+void runMemoryBenchmarks(bool memset, bool memcpy, uint8_t minPower, uint8_t maxPower) {
+    auto maxSize = 1U << maxPower;
+    sourceBuffer = static_cast<uint8_t*>(::allocateMemory(maxSize, Util::PAGESIZE));
+    targetBuffer = static_cast<uint8_t*>(::allocateMemory(maxSize, Util::PAGESIZE));
+    Util::Address<uint32_t>(sourceBuffer).setRange(static_cast<uint8_t>(random.nextRandomNumber() * 0xff), maxSize);
+
+    for (uint8_t i = minPower; i <= maxPower; i++) {
+        auto size = 1U << i;
+        if (memset) {
+            runBenchmark("memset", "Address::setRange", size, 1, size, benchmarkMemset);
+        }
+
+        if (memcpy) {
+            runBenchmark("memcpy", "Address::copyRange", size, 1, size, benchmarkMemcpy);
+        }
+    }
+
+    ::freeMemory(sourceBuffer, Util::PAGESIZE);
+    ::freeMemory(targetBuffer, Util::PAGESIZE);
+}
+
+uint64_t benchmarkHeapManager(uint32_t) {
+    auto start = now();
+    for (uint32_t i = 0; i < ALLOCATOR_OPERATIONS; i++) {
+        allocations[i] = heapManager->allocateMemory(allocationSizes[i], 0);
+    }
+
+    for (auto index : freeOrder) {
+        heapManager->freeMemory(allocations[index], 0);
+    }
+
+    return now() - start;
+}
+
+uint64_t benchmarkBitmapManager(uint32_t) {
+    auto start = now();
+    for (uint32_t i = 0; i < ALLOCATOR_OPERATIONS; i++) {
+        allocations[i] = bitmapManager->allocateBlock();
+    }
+
+    for (auto index : freeOrder) {
+        bitmapManager->freeBlock(allocations[index]);
+    }
+
+    return now() - start;
+}
+
+uint64_t benchmarkSlabAllocator(uint32_t) {
+    auto start = now();
+    for (uint32_t i = 0; i < SLAB_OPERATIONS; i++) {
+        allocations[i] = slabCache->allocate();
     }
+
+    for (uint32_t i = 0; i < SLAB_OPERATIONS; i++) {
+        slabCache->free(allocations[SLAB_OPERATIONS - i - 1]);
+    }
+
+    return now() - start;
+}
+
+void runAllocatorBenchmarks() {
+    for (uint32_t i = 0; i < ALLOCATOR_OPERATIONS; i++) {
+        allocationSizes[i] = static_cast<uint32_t>(random.nextRandomNumber() * (ALLOCATOR_MAX_SIZE - 1)) + 1;
+        freeOrder[i] = i;
+    }
+
+    // Free blocks in random order to create fragmentation
+    for (uint32_t i = ALLOCATOR_OPERATIONS - 1; i > 0; i--) {
+        auto j = static_cast<uint32_t>(random.nextRandomNumber() * (i + 1)) % (i + 1);
+        auto tmp = freeOrder[i];
+        freeOrder[i] = freeOrder[j];
+        freeOrder[j] = tmp;
+    }
+
+    auto *heap = static_cast<uint8_t*>(::allocateMemory(ALLOCATOR_HEAP_SIZE, Util::PAGESIZE));
+
+    auto freeListManager = Util::FreeListMemoryManager();
+    freeListManager.initialize(heap, heap + ALLOCATOR_HEAP_SIZE - 1);
+    freeListManager.disableAutomaticUnmapping();
+    heapManager = &freeListManager;
+    runBenchmark("allocator", "FreeListMemoryManager", 0, 2 * ALLOCATOR_OPERATIONS, 0, benchmarkHeapManager);
+
+    auto tlsfManager = Util::TlsfMemoryManager();
+    tlsfManager.initialize(heap, heap + ALLOCATOR_HEAP_SIZE - 1);
+    tlsfManager.disableAutomaticUnmapping();
+    heapManager = &tlsfManager;
+    runBenchmark("allocator", "TlsfMemoryManager", 0, 2 * ALLOCATOR_OPERATIONS, 0, benchmarkHeapManager);
+
+    auto bitmap = Kernel::BitmapMemoryManager(heap, heap + ALLOCATOR_HEAP_SIZE - 1, Util::PAGESIZE);
+    bitmapManager = &bitmap;
+    runBenchmark("allocator", "BitmapMemoryManager", 0, 2 * ALLOCATOR_OPERATIONS, 0, benchmarkBitmapManager);
+
+    ::freeMemory(heap, Util::PAGESIZE);
+
+    // Slabs are taken from a private heap, so that the benchmark does not depend on the state of the process heap
+    auto *slabMemory = static_cast<uint8_t*>(::allocateMemory(SLAB_MEMORY_SIZE, Util::PAGESIZE));
+    auto slabHeap = Util::FreeListMemoryManager();
+    slabHeap.initialize(slabMemory, slabMemory + SLAB_MEMORY_SIZE - 1);
+    slabHeap.disableAutomaticUnmapping();
+
+    {
+        auto slabAllocator = Kernel::SlabAllocator(slabHeap);
+        slabCache = &slabAllocator.createCache("membench", SLAB_OBJECT_SIZE);
+        runBenchmark("allocator", "SlabAllocator", SLAB_OBJECT_SIZE, 2 * SLAB_OPERATIONS, 0, benchmarkSlabAllocator);
+    }
+
+    ::freeMemory(slabMemory, Util::PAGESIZE);
+}
+
+uint64_t benchmarkArrayListAdd(uint32_t) {
+    auto list = Util::ArrayList<uint32_t>();
+
+    auto start = now();
+    for (auto key : collectionKeys) {
+        list.add(key);
+    }
+
+    return now() - start;
+}
+
+uint64_t benchmarkArrayListGet(uint32_t) {
+    auto list = Util::ArrayList<uint32_t>();
+    for (auto key : collectionKeys) {
+        list.add(key);
+    }
+
+    auto start = now();
+    for (auto key : collectionKeys) {
+        sink = list.get(key % COLLECTION_OPERATIONS);
+    }
+
+    return now() - start;
+}
+
+uint64_t benchmarkHashMapPut(uint32_t) {
+    auto map = Util::HashMap<uint32_t, uint32_t>();
+
+    auto start = now();
+    for (auto key : collectionKeys) {
+        map.put(key, key);
+    }
+
+    return now() - start;
+}
+
+uint64_t benchmarkHashMapGet(uint32_t) {
+    auto map = Util::HashMap<uint32_t, uint32_t>();
+    for (auto key : collectionKeys) {
+        map.put(key, key);
+    }
+
+    auto start = now();
+    for (auto key : collectionKeys) {
+        sink = map.get(key);
+    }
+
+    return now() - start;
+}
+
+uint64_t benchmarkHashMapRemove(uint32_t) {
+    auto map = Util::HashMap<uint32_t, uint32_t>();
+    for (auto key : collectionKeys) {
+        map.put(key, key);
+    }
+
+    auto start = now();
+    for (auto key : collectionKeys) {
+        sink = map.remove(key);
+    }
+
+    return now() - start;
+}
+
+void runCollectionBenchmarks() {
+    for (uint32_t i = 0; i < COLLECTION_OPERATIONS; i++) {
+        // Unique keys in random order
+        collectionKeys[i] = i * 2654435761U;
+    }
+
+    runBenchmark("collection", "ArrayList::add", 0, COLLECTION_OPERATIONS, 0, benchmarkArrayListAdd);
+    runBenchmark("collection", "ArrayList::get", 0, COLLECTION_OPERATIONS, 0, benchmarkArrayListGet);
+    runBenchmark("collection", "HashMap::put", 0, COLLECTION_OPERATIONS, 0, benchmarkHashMapPut);
+    runBenchmark("collection", "HashMap::get", 0, COLLECTION_OPERATIONS, 0, benchmarkHashMapGet);
+    runBenchmark("collection", "HashMap::remove", 0, COLLECTION_OPERATIONS, 0, benchmarkHashMapRemove);
+}
+
+uint64_t benchmarkSystemCall(uint32_t) {
+    auto start = now();
+    for (uint32_t i = 0; i < LATENCY_OPERATIONS; i++) {
+        sink = Util::Async::Thread::getCurrentThread().getId();
+    }
+
+    return now() - start;
+}
+
+uint64_t benchmarkYield(uint32_t) {
+    auto start = now();
+    for (uint32_t i = 0; i < LATENCY_OPERATIONS; i++) {
+        Util::Async::Thread::yield();
+    }
+
+    return now() - start;
+}
+
+uint64_t benchmarkThreadSwitch(uint32_t) {
+    auto ping = Util::Async::Semaphore();
+    auto pong = Util::Async::Semaphore();
+    pingSemaphore = &ping;
+    pongSemaphore = &pong;
+
+    auto thread = Util::Async::Thread::createThread("membench-pong", new Util::Async::FunctionPointerRunnable([]() {
+        for (uint32_t i = 0; i < SWITCH_OPERATIONS; i++) {
+            pingSemaphore->acquire();
+            pongSemaphore->release();
+        }
+    }));
+
+    // Each round trip consists of two blocking thread switches
+    auto start = now();
+    for (uint32_t i = 0; i < SWITCH_OPERATIONS; i++) {
+        ping.release();
+        pong.acquire();
+    }
+    auto end = now();
+
+    thread.join();
+    return end - start;
+}
+
+void runLatencyBenchmarks(bool systemCall, bool threadSwitch) {
+    if (systemCall) {
+        runBenchmark("syscall", "getCurrentThread", 0, LATENCY_OPERATIONS, 0, benchmarkSystemCall);
+        runBenchmark("syscall", "yield", 0, LATENCY_OPERATIONS, 0, benchmarkYield);
+    }
+
+    if (threadSwitch) {
+        runBenchmark("switch", "Semaphore round trip", 0, SWITCH_OPERATIONS, 0, benchmarkThreadSwitch);
+    }
+}
+
+uint64_t benchmarkPipe(uint32_t) {
+    auto input = Util::Io::PipedInputStream();
+    auto output = Util::Io::PipedOutputStream(input);
+    pipeOutput = &output;
+
+    auto start = now();
+    auto thread = Util::Async::Thread::createThread("membench-pipe", new Util::Async::FunctionPointerRunnable([]() {
+        for (uint32_t i = 0; i < PIPE_TRANSFER_SIZE; i += PIPE_CHUNK_SIZE) {
+            pipeOutput->write(sourceBuffer, 0, PIPE_CHUNK_SIZE);
+        }
+    }));
+
+    uint32_t received = 0;
+    while (received < PIPE_TRANSFER_SIZE) {
+        auto count = input.read(targetBuffer, 0, PIPE_CHUNK_SIZE);
+        if (count <= 0) {
+            break;
+        }
+
+        received += count;
+    }
+    auto end = now();
+
+    thread.join();
+    return end - start;
+}
+
+uint64_t benchmarkFileRead(uint32_t) {
+    auto stream = Util::Io::FileInputStream(benchmarkFilePath);
+
+    auto start = now();
+    while (stream.read(targetBuffer, 0, FILE_CHUNK_SIZE) > 0) {}
+    return now() - start;
+}
+
+void runIoBenchmarks(bool pipe, bool file) {
+    sourceBuffer = static_cast<uint8_t*>(::allocateMemory(FILE_CHUNK_SIZE, Util::PAGESIZE));
+    targetBuffer = static_cast<uint8_t*>(::allocateMemory(FILE_CHUNK_SIZE, Util::PAGESIZE));
+
+    if (pipe) {
+        runBenchmark("pipe", "PipedInputStream", PIPE_CHUNK_SIZE, PIPE_TRANSFER_SIZE / PIPE_CHUNK_SIZE, PIPE_TRANSFER_SIZE, benchmarkPipe);
+    }
+
+    if (file) {
+        auto benchmarkFile = Util::Io::File(benchmarkFilePath);
+        if (!benchmarkFile.exists() || !benchmarkFile.isFile()) {
+            Util::System::error << "membench: '" << benchmarkFilePath << "' is not a file, skipping file benchmark!" << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
+        } else {
+            auto length = benchmarkFile.getLength();
+            runBenchmark("file", "FileInputStream", FILE_CHUNK_SIZE, (length + FILE_CHUNK_SIZE - 1) / FILE_CHUNK_SIZE, length, benchmarkFileRead);
+        }
+    }
+
+    ::freeMemory(sourceBuffer, Util::PAGESIZE);
+    ::freeMemory(targetBuffer, Util::PAGESIZE);
+}
+
+void writeCsv(Util::Io::PrintStream &stream) {
+    stream << "benchmark,variant,size,operations,bytes,repetitions,min_ns,avg_ns,max_ns,ns_per_op,mb_per_s" << Util::Io::PrintStream::endl;
+    stream.setDecimalPrecision(3);
+
+    for (const auto &result : results) {
+        stream << result.benchmark << "," << result.variant << "," << result.size << "," << result.operations << ","
+               << result.bytes << "," << static_cast<uint32_t>(repetitions) << "," << result.minimumNanos << ","
+               << result.averageNanos << "," << result.maximumNanos << ","
+               << static_cast<double>(result.averageNanos) / result.operations << ","
+               << (result.averageNanos > 0 ? result.bytes * 1000.0 / result.averageNanos : 0.0) << Util::Io::PrintStream::endl;
+    }
+}
+
+void writeJson(Util::Io::PrintStream &stream) {
+    stream << "{" << Util::Io::PrintStream::endl
+           << "  \"timer\": \"" << (timestampCounterFrequency == 0 ? "system" : "tsc") << "\"," << Util::Io::PrintStream::endl
+           << "  \"tsc_khz\": " << timestampCounterFrequency << "," << Util::Io::PrintStream::endl
+           << "  \"repetitions\": " << static_cast<uint32_t>(repetitions) << "," << Util::Io::PrintStream::endl
+           << "  \"results\": [" << Util::Io::PrintStream::endl;
+    stream.setDecimalPrecision(3);
+
+    for (uint32_t i = 0; i < results.size(); i++) {
+        const auto &result = results.get(i);
+        stream << "    {\"benchmark\": \"" << result.benchmark << "\", \"variant\": \"" << result.variant
+               << "\", \"size\": " << result.size << ", \"operations\": " << result.operations
+               << ", \"bytes\": " << result.bytes << ", \"min_ns\": " << result.minimumNanos
+               << ", \"avg_ns\": " << result.averageNanos << ", \"max_ns\": " << result.maximumNanos
+               << ", \"ns_per_op\": " << static_cast<double>(result.averageNanos) / result.operations
+               << ", \"mb_per_s\": " << (result.averageNanos > 0 ? result.bytes * 1000.0 / result.averageNanos : 0.0)
+               << "}" << (i < results.size() - 1 ? "," : "") << Util::Io::PrintStream::endl;
+    }
+
+    stream << "  ]" << Util::Io::PrintStream::endl << "}" << Util::Io::PrintStream::endl;
+}
+
+bool writeResults(const Util::String &path, const Util::String &format) {
+    auto file = Util::Io::File(path);
+    if (file.exists() && (!file.isFile() || !file.remove())) {
+        Util::System::error << "membench: Unable to overwrite '" << path << "'!" << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
+        return false;
+    }
+
+    if (!file.create(Util::Io::File::REGULAR)) {
+        Util::System::error << "membench: Unable to create '" << path << "'!" << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
+        return false;
+    }
+
+    auto fileStream = Util::Io::FileOutputStream(file);
+    auto printStream = Util::Io::PrintStream(fileStream);
+
+    if (format == "json") {
+        writeJson(printStream);
+    } else {
+        writeCsv(printStream);
+    }
+
+    printStream.flush();
+    return true;
 }
 
 int32_t main(int32_t argc, char *argv[]) {
     auto argumentParser = Util::ArgumentParser();
-    argumentParser.setHelpText("Memory bandwidth benchmark comparing different acceleration techniques.\n"
-                               "Each iteration operates on 1 MiB of memory (Default: 100 iterations).\n"
-                               "Usage: membench [memset/memcpy] [Minimimum power of 2] [Maximum power of 2]\n"
+    argumentParser.setHelpText("Microbenchmark suite for memory operations, allocators, collections, system calls and I/O.\n"
+                               "Timing is based on the timestamp counter (calibrated against the system time), if available.\n"
+                               "Usage: membench [OPTION]... [BENCHMARK]...\n"
+                               "Benchmarks: memset, memcpy, allocator, collection, syscall, switch, pipe, file, all (Default: all)\n"
                                "Options:\n"
+                               "  -r, --repetitions: Number of measured repetitions per benchmark (Default: 10)\n"
+                               "  -m, --min-power: Minimum buffer size for memset/memcpy as power of 2 (Default: 10)\n"
+                               "  -M, --max-power: Maximum buffer size for memset/memcpy as power of 2 (Default: 24)\n"
+                               "  -i, --input: File to read for the file benchmark (skipped, if not given)\n"
+                               "  -o, --output: Write results to the given file\n"
+                               "  -f, --format: Output file format [csv/json] (Default: csv)\n"
                                "  -h, --help: Show this help message");
 
+    argumentParser.addArgument("repetitions", false, "r");
+    argumentParser.addArgument("min-power", false, "m");
+    argumentParser.addArgument("max-power", false, "M");
+    argumentParser.addArgument("input", false, "i");
+    argumentParser.addArgument("output", false, "o");
+    argumentParser.addArgument("format", false, "f");
+
     if (!argumentParser.parse(argc, argv)) {
         Util::System::error << argumentParser.getErrorString() << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
         return -1;
     }
 
-    auto arguments = argumentParser.getUnnamedArguments();
-    if (arguments.length() == 0) {
-        Util::System::error << "membench: No arguments provided!" << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
+    if (argumentParser.hasArgument("repetitions")) {
+        auto value = Util::String::parseInt(argumentParser.getArgument("repetitions"));
+        repetitions = value < 1 ? 1 : value > 255 ? 255 : value;
+    }
+
+    const uint8_t minPower = argumentParser.hasArgument("min-power") ? Util::String::parseInt(argumentParser.getArgument("min-power")) : 10;
+    const uint8_t maxPower = argumentParser.hasArgument("max-power") ? Util::String::parseInt(argumentParser.getArgument("max-power")) : 24;
+    if (minPower > maxPower || maxPower > 28) {
+        Util::System::error << "membench: Invalid buffer size range!" << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
+        return -1;
+    }
+
+    const auto format = argumentParser.hasArgument("format") ? argumentParser.getArgument("format") : Util::String("csv");
+    if (format != "csv" && format != "json") {
+        Util::System::error << "membench: Invalid output format!" << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
         return -1;
     }
 
-    const auto &benchmarkType = arguments[0];
-    const uint8_t minPower = arguments.length() > 1 ? Util::String::parseInt(static_cast<const char*>(arguments[1])) : 10;
-    const uint8_t maxPower = arguments.length() > 2 ? Util::String::parseInt(static_cast<const char*>(arguments[2])) : 24;
-
-    if (benchmarkType == "memset" || benchmarkType == "memcpy") {
-        for (uint8_t i = minPower; i <= maxPower; i++) {
-            auto size = 1 << i;
-            auto results = Util::Array<Util::Time::Timestamp>(BENCHMARK_REPETITIONS);
-
-            Util::System::out << benchmarkType << " " << powerAsString(i) << ":\t" << Util::Io::PrintStream::flush;
-
-            if (benchmarkType == "memset") {
-                // Allocate buffer
-                auto buffer = ::allocateMemory(size, Util::PAGESIZE);
-                auto address = Util::Address<uint32_t>(buffer);
-
-                // Warmup round to make sure the memory is mapped
-                benchmarkMemset(address, size);
-
-                for (uint32_t j = 0; j < BENCHMARK_REPETITIONS; j++) {
-                    results[j] = benchmarkMemset(address, size);
-                }
-            } else {
-                // Allocate source and target buffer
-                auto source = ::allocateMemory(size, Util::PAGESIZE);
-                auto target = ::allocateMemory(size, Util::PAGESIZE);
-                auto sourceAddress = Util::Address<uint32_t>(source);
-                auto targetAddress = Util::Address<uint32_t>(target);
-
-                // Warmup round to make sure the memory is mapped
-                sourceAddress.setRange(static_cast<uint8_t>(random.nextRandomNumber() * 0xff), size);
-                benchmarkMemcpy(sourceAddress, targetAddress, size);
-
-                for (uint32_t j = 0; j < BENCHMARK_REPETITIONS; j++) {
-                    results[j] = benchmarkMemcpy(sourceAddress, targetAddress, size);
-                }
-            }
-
-            uint64_t sum = 0;
-            for (auto result : results) {
-                sum += result.toNanoseconds();
-            }
-
-            auto averageNanos = sum / BENCHMARK_REPETITIONS;
-            auto averageSeconds = averageNanos / 1000000000.0;
-            auto bandwidth = size / averageSeconds / 1000000.0;
-
-            Util::System::out.setDecimalPrecision(9);
-            Util::System::out << averageSeconds << "s (" << Util::Io::PrintStream::flush;
-            Util::System::out.setDecimalPrecision(2);
-            Util::System::out << bandwidth << " MB/s)" << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
+    if (argumentParser.hasArgument("input")) {
+        benchmarkFilePath = argumentParser.getArgument("input");
+    }
+
+    auto benchmarks = argumentParser.getUnnamedArguments();
+    auto all = benchmarks.length() == 0 || benchmarks.contains("all");
+    for (const auto &benchmark : benchmarks) {
+        if (benchmark != "all" && benchmark != "memset" && benchmark != "memcpy" && benchmark != "allocator" && benchmark != "collection"
+            && benchmark != "syscall" && benchmark != "switch" && benchmark != "pipe" && benchmark != "file") {
+            Util::System::error << "membench: Invalid benchmark type '" << benchmark << "'!" << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
+            return -1;
         }
+    }
+
+    calibrateTimestampCounter();
+    if (timestampCounterFrequency == 0) {
+        Util::System::out << "Timer: System time" << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
     } else {
-        Util::System::error << "membench: Invalid benchmark type!" << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
+        Util::System::out << "Timer: Timestamp counter (" << timestampCounterFrequency << " kHz)" << Util::Io::PrintStream::endl << Util::Io::PrintStream::flush;
+    }
+
+    auto memset = all || benchmarks.contains("memset");
+    auto memcpy = all || benchmarks.contains("memcpy");
+    if (memset || memcpy) {
+        runMemoryBenchmarks(memset, memcpy, minPower, maxPower);
+    }
+
+    if (all || benchmarks.contains("allocator")) {
+        runAllocatorBenchmarks();
+    }
+
+    if (all || benchmarks.contains("collection")) {
+        runCollectionBenchmarks();
+    }
+
+    auto systemCall = all || benchmarks.contains("syscall");
+    auto threadSwitch = all || benchmarks.contains("switch");
+    if (systemCall || threadSwitch) {
+        runLatencyBenchmarks(systemCall, threadSwitch);
+    }
+
+    auto pipe = all || benchmarks.contains("pipe");
+    auto file = !benchmarkFilePath.isEmpty() && (all || benchmarks.contains("file"));
+    if (pipe || file) {
+        runIoBenchmarks(pipe, file);
+    }
+
+    if (argumentParser.hasArgument("output") && !writeResults(argumentParser.getArgument("output"), format)) {
         return -1;
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -39,6 +39,9 @@
 #include "lib/util/io/key/Key.h"
 #include "lib/util/io/stream/PrintStream.h"
 
+// Many small, short-lived allocations -> Use the constant time TLSF allocator
+HHUOS_HEAP_MANAGER(TLSF_HEAP_MANAGER)
+
 uint32_t palette[256];
 Util::Graphic::LinearFrameBuffer *lfb;
 Util::Graphic::BufferedLinearFrameBuffer *bufferedlfb;
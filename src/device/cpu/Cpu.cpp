@@ -218,6 +218,29 @@ void Cpu::writeCr3(const Kernel::Paging::Table *pageDirectory) {
             );
 }
 
+uint32_t Cpu::readCr4() {
+    uint32_t cr4 = 0;
+    asm volatile (
+            "mov %%cr4, %%eax;"
+            "mov %%eax, (%0);"
+            : :
+            "r"(&cr4)
+            :
+            "eax"
+            );
+
+    return cr4;
+}
+
+void Cpu::writeCr4(uint32_t value) {
+    asm volatile(
+            "mov %0, %%cr4"
+            : :
+            "r"(value)
+            :
+            );
+}
+
 void Cpu::loadTaskStateSegment(const Cpu::SegmentSelector &selector) {
     asm volatile(
             "ltr %0"
@@ -47,6 +47,17 @@ public:
         PAGING = 0x80000000
     };
 
+    enum Configuration4 {
+        VIRTUAL_8086_MODE_EXTENSIONS = 0x01,
+        PROTECTED_MODE_VIRTUAL_INTERRUPTS = 0x02,
+        TIME_STAMP_DISABLE = 0x04,
+        DEBUGGING_EXTENSIONS = 0x08,
+        PAGE_SIZE_EXTENSION = 0x10,
+        PHYSICAL_ADDRESS_EXTENSION = 0x20,
+        MACHINE_CHECK_EXCEPTION = 0x40,
+        PAGE_GLOBAL_ENABLE = 0x80
+    };
+
     enum PrivilegeLevel : uint8_t  {
         Ring0 = 0,
         Ring1 = 1,
@@ -122,6 +133,10 @@ public:
 
     static void writeCr3(const Kernel::Paging::Table *pageDirectory);
 
+    static uint32_t readCr4();
+
+    static void writeCr4(uint32_t value);
+
     static void loadTaskStateSegment(const SegmentSelector &selector);
 
     /**
@@ -22,6 +22,8 @@
 
 #include "device/interrupt/apic/Apic.h"
 #include "kernel/service/InterruptService.h"
+#include "kernel/service/MemoryService.h"
+#include "kernel/service/ProcessService.h"
 #include "kernel/service/Service.h"
 
 namespace Device {
@@ -29,16 +31,26 @@ namespace Device {
 volatile bool runningApplicationProcessors[256]{}; // Once an AP is running it sets its corresponding entry to true
 
 [[noreturn]] void applicationProcessorEntry(uint8_t initializedApplicationProcessorsCounter) {
-    runningApplicationProcessors[initializedApplicationProcessorsCounter] = true; // Mark this AP as running
-    while (true) {}
-
     // Initialize this AP's APIC
     auto &interruptService = Kernel::Service::getService<Kernel::InterruptService>();
     auto &apic = interruptService.getApic();
     apic.initializeCurrentLocalApic();
     apic.enableCurrentErrorHandler();
 
-    while (!interruptService.isParallelComputingAllowed()) {}
+    // The TSS is needed for switching from user mode threads back to their kernel stacks
+    auto &memoryService = Kernel::Service::getService<Kernel::MemoryService>();
+    memoryService.registerTaskStateSegment(&apic.getApplicationProcessorTaskStateSegment(initializedApplicationProcessorsCounter));
+
+    // The scheduler has to be created on this AP, because it sets up the FPU of the executing core.
+    // The BSP waits with interrupts disabled until we mark ourselves as running, so registering the timer interrupt handler is not racy.
+    auto &processService = Kernel::Service::getService<Kernel::ProcessService>();
+    processService.createScheduler();
+    apic.startCurrentTimer();
+
+    runningApplicationProcessors[initializedApplicationProcessorsCounter] = true; // Mark this AP as running
+
+    // Wait until the BSP has finished booting and starts its own scheduler
+    processService.startApplicationProcessorScheduler();
 }
 
-}
\ No newline at end of file
+}
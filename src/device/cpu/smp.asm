@@ -80,12 +80,12 @@ boot_ap32:
     ; 1. Set cr3 to BSP value (for the page directory)
     mov eax, [boot_ap_cr3 - boot_ap + startup_address]
     mov cr3, eax
-    ; 2. Set cr0 to BSP value (to enable paging + page protection)
-    mov eax, [boot_ap_cr0 - boot_ap + startup_address]
-    mov cr0, eax
-    ; 3. Set cr4 to BSP value (for PAE + PSE, if enabled)
+    ; 2. Set cr4 to BSP value (for PAE + PSE + PGE, if enabled), before paging is enabled, since the kernel may use large pages
     mov eax, [boot_ap_cr4 - boot_ap + startup_address]
     mov cr4, eax
+    ; 3. Set cr0 to BSP value (to enable paging + page protection)
+    mov eax, [boot_ap_cr0 - boot_ap + startup_address]
+    mov cr0, eax
 
     ; Load the system IDT
     lidt [boot_ap_idtr - boot_ap + startup_address]
@@ -143,6 +143,9 @@ void Apic::sendEndOfInterrupt(Kernel::InterruptVector vector) {
         // Excludes NMI, IPIs and SMIs are also excluded, but these don't have vector numbers,
         // so they won't reach this anyway.
         LocalApic::sendEndOfInterrupt();
+    } else if (vector == Kernel::InterruptVector::WAKEUP || vector == Kernel::InterruptVector::TLB_SHOOTDOWN) {
+        // FIXED IPIs are accepted by the local APIC like local interrupts
+        LocalApic::sendEndOfInterrupt();
     } else if (isExternalInterrupt(vector)) {
         // Edge-triggered external interrupts have to be EOId in the local APIC,
         // level-triggered external interrupts can EOId in the local APIC if EOI-broadcasting is enabled,
@@ -385,8 +388,12 @@ void Apic::startupApplicationProcessors() {
             readCount++;
         }
 
+        if (runningApplicationProcessors[initializedApplicationProcessorsCounter]) {
+            onlineApplicationProcessors.add(localApic->getCpuId());
+            LOG_INFO("CPU [%u] is now online", localApic->getCpuId());
+        }
+
         initializedApplicationProcessorsCounter++;
-        LOG_INFO("CPU [%u] is now online", localApic->getCpuId());
     }
 
     Cmos::enableNmi();
@@ -451,13 +458,22 @@ Kernel::GlobalDescriptorTable::Descriptor** Apic::prepareApplicationProcessorGdt
         gdt->addSegment(Kernel::GlobalDescriptorTable::SegmentDescriptor(0x00000000, 0xffffffff, 0x92, 0x0c)); // Kernel data segment
         gdt->addSegment(Kernel::GlobalDescriptorTable::SegmentDescriptor(0x00000000, 0xffffffff, 0xfa, 0x0c)); // User code segment
         gdt->addSegment(Kernel::GlobalDescriptorTable::SegmentDescriptor(0x00000000, 0xffffffff, 0xf2, 0x0c)); // User data segment
-        gdt->addSegment(Kernel::GlobalDescriptorTable::SegmentDescriptor(reinterpret_cast<uint32_t>(&tss), sizeof(Kernel::GlobalDescriptorTable::TaskStateSegment), 0x89, 0x04));
+        gdt->addSegment(Kernel::GlobalDescriptorTable::SegmentDescriptor(reinterpret_cast<uint32_t>(tss), sizeof(Kernel::GlobalDescriptorTable::TaskStateSegment), 0x89, 0x04));
 
-        // Store current GDT descriptor in array
+        // Store current GDT descriptor in array and keep the TSS, so that the AP can register it with the memory service
         gdts[i] = new Kernel::GlobalDescriptorTable::Descriptor(gdt->getDescriptor());
+        applicationProcessorTaskStateSegments.add(tss);
     }
 
     return gdts;
 }
 
+Util::Array<uint8_t> Apic::getOnlineApplicationProcessors() const {
+    return onlineApplicationProcessors.toArray();
+}
+
+Kernel::GlobalDescriptorTable::TaskStateSegment& Apic::getApplicationProcessorTaskStateSegment(uint8_t index) const {
+    return *applicationProcessorTaskStateSegments.get(index);
+}
+
 }
@@ -27,6 +27,7 @@
 #include "LocalApicErrorHandler.h"
 #include "lib/util/collection/HashMap.h"
 #include "lib/util/collection/Array.h"
+#include "lib/util/collection/ArrayList.h"
 #include "kernel/memory/GlobalDescriptorTable.h"
 
 namespace Kernel {
@@ -137,6 +138,18 @@ public:
     
     void startupApplicationProcessors();
 
+    /**
+     * Get the ids of all application processors, that have been started successfully.
+     */
+    [[nodiscard]] Util::Array<uint8_t> getOnlineApplicationProcessors() const;
+
+    /**
+     * Get the task state segment, that has been prepared for an application processor.
+     *
+     * @param index The index passed by the startup routine to 'applicationProcessorEntry()'
+     */
+    [[nodiscard]] Kernel::GlobalDescriptorTable::TaskStateSegment& getApplicationProcessorTaskStateSegment(uint8_t index) const;
+
     Kernel::GlobalSystemInterrupt getIrqOverride(InterruptRequest interruptRequest);
 
     InterruptRequest getIrqSource(Kernel::GlobalSystemInterrupt gsi);
@@ -179,6 +192,8 @@ private:
     // Once the switch from PIC to APIC is done, it can't be switched back.
     Util::HashMap<uint8_t, LocalApic*> localApics;  // All LocalApic instances.
     Util::HashMap<uint8_t, ApicTimer*> localTimers; // All ApicTimer instances.
+    Util::ArrayList<uint8_t> onlineApplicationProcessors; // Ids of all successfully started APs.
+    Util::ArrayList<Kernel::GlobalDescriptorTable::TaskStateSegment*> applicationProcessorTaskStateSegments; // One TSS per AP.
     IoApic *ioApic;                      // The IoApic instance responsible for the external interrupts.
     LocalApicErrorHandler errorHandler;  // The interrupt handler that gets triggered on an internal APIC error.
 
@@ -42,8 +42,9 @@ NetworkDevice::NetworkDevice() :
         reader(new PacketReader(*this)) {
     auto &processService = Kernel::Service::getService<Kernel::ProcessService>();
     auto &readerThread = Kernel::Thread::createKernelThread("Packet-Reader", processService.getKernelProcess(), reader);
+    readerThread.setPriority(Util::Async::Thread::HIGH);
 
-    processService.getScheduler().ready(readerThread);
+    processService.ready(readerThread);
 }
 
 NetworkDevice::~NetworkDevice() {
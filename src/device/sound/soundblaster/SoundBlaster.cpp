@@ -64,7 +64,7 @@ SoundBlaster::SoundBlaster(uint16_t baseAddress, uint8_t irqNumber, uint8_t dmaC
     auto *soundBlasterNode = new SoundBlasterNode(this, *runnable, thread);
 
     filesystemService.getFilesystem().getVirtualDriver("/device").addNode("/", soundBlasterNode);
-    processService.getScheduler().ready(thread);
+    processService.ready(thread);
 }
 
 SoundBlaster::~SoundBlaster() {
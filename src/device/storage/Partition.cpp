@@ -18,6 +18,8 @@
 #include "Partition.h"
 
 #include "device/storage/StorageDevice.h"
+#include "device/storage/block/BlockRequest.h"
+#include "lib/util/base/Exception.h"
 
 namespace Device::Storage {
 
@@ -39,4 +41,21 @@ uint32_t Partition::write(const uint8_t *buffer, uint32_t startSector, uint32_t
     return parentDevice.write(buffer, this->startSector + startSector, sectorCount);
 }
 
+void Partition::submit(BlockRequest &request) {
+    if (request.getStartSector() + static_cast<uint64_t>(request.getSectorCount()) > sectorCount) {
+        Util::Exception::throwException(Util::Exception::OUT_OF_BOUNDS, "Partition: Trying to access sectors out of partition bounds!");
+    }
+
+    request.translate(startSector);
+    parentDevice.submit(request);
+}
+
+uint32_t Partition::getQueueDepth() {
+    return parentDevice.getQueueDepth();
+}
+
+bool Partition::flush() {
+    return parentDevice.flush();
+}
+
 }
\ No newline at end of file
@@ -67,6 +67,23 @@ public:
      */
     uint32_t write(const uint8_t *buffer, uint32_t startSector, uint32_t sectorCount) override;
 
+    /**
+     * Overriding function from StorageDevice.
+     * The request is translated into the parent device's sectors and passed on to it.
+     */
+    void submit(BlockRequest &request) override;
+
+    /**
+     * Overriding function from StorageDevice.
+     */
+    uint32_t getQueueDepth() override;
+
+    /**
+     * Overriding function from StorageDevice.
+     * Flushes the whole parent device, since cached sectors are not tracked per partition.
+     */
+    bool flush() override;
+
 private:
 
     StorageDevice &parentDevice;
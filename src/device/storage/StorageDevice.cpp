@@ -17,6 +17,24 @@
 
 #include "StorageDevice.h"
 
+#include "device/storage/block/BlockRequest.h"
+
 namespace Device::Storage {
 
-}
\ No newline at end of file
+void StorageDevice::submit(BlockRequest &request) {
+    auto processedSectors = request.getOperation() == BlockRequest::READ ?
+            read(request.getBuffer(), request.getStartSector(), request.getSectorCount()) :
+            write(request.getBuffer(), request.getStartSector(), request.getSectorCount());
+
+    request.complete(processedSectors);
+}
+
+uint32_t StorageDevice::getQueueDepth() {
+    return 1;
+}
+
+bool StorageDevice::flush() {
+    return true;
+}
+
+}
@@ -21,6 +21,7 @@
 #include <stdint.h>
 
 namespace Device::Storage {
+class BlockRequest;
 
 class StorageDevice {
 
@@ -76,6 +77,29 @@ public:
      * @return The amount of written sectors
      */
     virtual uint32_t write(const uint8_t *buffer, uint32_t startSector, uint32_t sectorCount) = 0;
+
+    /**
+     * Submit an asynchronous request (see BlockRequest).
+     * The default implementation processes the request synchronously via read()/write() and completes it before returning.
+     * Devices registered at the storage service are wrapped by a block request queue, which returns immediately.
+     *
+     * @param request The request (must stay valid until it has completed)
+     */
+    virtual void submit(BlockRequest &request);
+
+    /**
+     * Get the number of requests, that the device can process concurrently.
+     * The block layer starts one dispatcher thread per request (up to a fixed limit).
+     */
+    virtual uint32_t getQueueDepth();
+
+    /**
+     * Write back data, that has been written to the device, but is still cached in memory.
+     * The default implementation does nothing, since device drivers write synchronously.
+     *
+     * @return false, if cached data could not be written to the device
+     */
+    virtual bool flush();
 };
 
 }
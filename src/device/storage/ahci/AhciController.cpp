@@ -35,6 +35,11 @@
 #include "lib/util/base/String.h"
 #include "lib/util/collection/Array.h"
 #include "lib/util/base/Exception.h"
+#include "lib/util/async/Atomic.h"
+#include "lib/util/async/PeriodicRunnable.h"
+#include "kernel/process/Scheduler.h"
+#include "kernel/service/ProcessService.h"
+#include "kernel/process/Thread.h"
 
 namespace Kernel {
 enum InterruptVector : uint8_t;
@@ -67,11 +72,12 @@ AhciController::AhciController(const PciDevice &pciDevice) : pciDevice(pciDevice
 
     // Read maximum number of supported ports from lowest 5 bits of capabilities registers
     portCount = (registers->hostCapabilities & 0x0000001f) + 1;
-    LOG_INFO("[%u] ports supported", portCount);
+    slotCount = ((registers->hostCapabilities >> 8) & 0x0000001f) + 1;
+    LOG_INFO("[%u] ports with [%u] command slots supported (NCQ: %s)", portCount, slotCount, registers->hostCapabilities & NATIVE_COMMAND_QUEUING ? "yes" : "no");
 
     // Allocate port structures
     virtualCommandLists = new HbaCommandHeader*[portCount]{};
-    portLocks = new Util::Async::Spinlock[portCount]{};
+    portStates = new PortState[portCount];
 
     LOG_INFO("Scanning ports for devices");
     for (uint32_t i = 0; i < portCount; i++) {
@@ -101,6 +107,8 @@ AhciController::AhciController(const PciDevice &pciDevice) : pciDevice(pciDevice
                     readAtapiCapacity(i, info);
                 }
 
+                enableQueuing(i, *info);
+
                 if (info->bytesPerSector > 0 && info->lbaCapacity > 0) {
                     auto *device = new AhciDevice(i, type, info, *this);
                     Kernel::Service::getService<Kernel::StorageService>().registerDevice(device, type == ATA ? "ata" : "atapi");
@@ -128,7 +136,7 @@ AhciController::~AhciController() {
         delete virtualCommandLists[i];
     }
 
-    delete portLocks;
+    delete[] portStates;
     delete virtualCommandLists;
     delete registers;
 }
@@ -206,6 +214,9 @@ void AhciController::rebasePort(uint32_t portNumber) {
     // Make sure, no commands are being processed during rebase
     port.stopCommandEngine();
 
+    // A single slot is used until the device has been identified
+    portStates[portNumber].freeSlots.release();
+
     // Allocate memory for command list
     virtualCommandLists[portNumber] = static_cast<HbaCommandHeader*>(memoryService.mapIO(1));
     port.commandListBaseAddress = reinterpret_cast<uint32_t>(memoryService.getPhysicalAddress(virtualCommandLists[portNumber]));
@@ -215,18 +226,29 @@ void AhciController::rebasePort(uint32_t portNumber) {
     port.startCommandEngine();
 }
 
-uint32_t AhciController::findCommandSlot(uint32_t portNumber) {
-    auto &port = registers->ports[portNumber];
+uint32_t AhciController::getQueueDepth(uint32_t portNumber) const {
+    return portStates[portNumber].queueDepth;
+}
 
-    uint32_t slotCount = ((registers->hostCapabilities >> 8) & 0x0000001f) + 1;
-    uint32_t slotStatus = (port.sataActive | port.commandIssue); // Set bits correspond to currently occupied slots
-    for (uint32_t i = 0; i < slotCount; i++) {
-        if (!(slotStatus & (1 << i))) {
-            return i;
-        }
+void AhciController::enableQueuing(uint32_t portNumber, const DeviceInfo &info) {
+    auto &state = portStates[portNumber];
+
+    // Non-queued commands in multiple slots are processed one after another by the HBA, but can still be issued at once
+    uint32_t depth = slotCount;
+    if (registers->ports[portNumber].signature == ATA && (registers->hostCapabilities & NATIVE_COMMAND_QUEUING) && (info.sata_capability & SATA_NATIVE_COMMAND_QUEUING)) {
+        uint32_t deviceDepth = (info.queue_depth & 0x1f) + 1;
+        state.nativeCommandQueuing = true;
+        depth = deviceDepth < slotCount ? deviceDepth : slotCount;
     }
 
-    return UINT32_MAX;
+    state.lock.acquire();
+    for (uint32_t i = state.queueDepth; i < depth; i++) {
+        state.freeSlots.release();
+    }
+    state.queueDepth = depth;
+    state.lock.release();
+
+    LOG_INFO("Port [%u] uses [%u] command slots (NCQ: %s)", portNumber, depth, state.nativeCommandQueuing ? "yes" : "no");
 }
 
 void AhciController::byteSwapString(char *string, uint32_t length) {
@@ -293,15 +315,25 @@ uint16_t AhciController::performAtaIO(uint32_t portNumber, const DeviceInfo &dev
     auto &hostToDeviceFis = *reinterpret_cast<FisRegisterHostToDevice*>(commandFis);
     hostToDeviceFis.type = REGISTER_HOST_TO_DEVICE;
     hostToDeviceFis.commandControl = 1;
-    hostToDeviceFis.command = mode == READ ? READ_DMA_EX : WRITE_DMA_EX;
     hostToDeviceFis.device = 1 << 6; // LBA mode
-    hostToDeviceFis.featureLow = 1; // DMA mode
     hostToDeviceFis.lba0 = startSector & 0xff;
     hostToDeviceFis.lba1 = (startSector >> 8) & 0xff;
     hostToDeviceFis.lba2 = (startSector >> 16) & 0xff;
     hostToDeviceFis.lba3 = (startSector >> 24) & 0xff;
-    hostToDeviceFis.countLow = sectorCount & 0xff;
-    hostToDeviceFis.countHigh = (sectorCount >> 8) & 0xff;
+    hostToDeviceFis.lba4 = (startSector >> 32) & 0xff;
+    hostToDeviceFis.lba5 = (startSector >> 40) & 0xff;
+
+    if (portStates[portNumber].nativeCommandQueuing) {
+        // With NCQ, the sector count is moved into the feature registers and the count register holds the tag (set when issuing)
+        hostToDeviceFis.command = mode == READ ? READ_FPDMA_QUEUED : WRITE_FPDMA_QUEUED;
+        hostToDeviceFis.featureLow = sectorCount & 0xff;
+        hostToDeviceFis.featureHigh = (sectorCount >> 8) & 0xff;
+    } else {
+        hostToDeviceFis.command = mode == READ ? READ_DMA_EX : WRITE_DMA_EX;
+        hostToDeviceFis.featureLow = 1; // DMA mode
+        hostToDeviceFis.countLow = sectorCount & 0xff;
+        hostToDeviceFis.countHigh = (sectorCount >> 8) & 0xff;
+    }
 
     if (mode == READ) {
         auto *dmaBuffer = readFromDevice(portNumber, sectorCount * deviceInfo.bytesPerSector, commandFis, atapiCommand);
@@ -373,89 +405,257 @@ uint16_t AhciController::performAtapiIO(uint32_t portNumber, const AhciControlle
 }
 
 void* AhciController::readFromDevice(uint32_t portNumber, uint32_t byteCount, const uint8_t commandFis[64], const uint8_t atapiCommand[16]) {
-    auto &memoryService = Kernel::Service::getService<Kernel::MemoryService>();
-    auto &port = registers->ports[portNumber];
-    auto *commandList = virtualCommandLists[portNumber];
-
-    portLocks[portNumber].acquire();
+    auto *dmaBuffer = allocateDmaBuffer(byteCount);
+    auto *physicalDmaAddress = Kernel::Service::getService<Kernel::MemoryService>().getPhysicalAddress(dmaBuffer);
 
-    if (!port.isActive()) {
-        portLocks[portNumber].release();
+    if (!executeCommand(portNumber, physicalDmaAddress, byteCount, commandFis, atapiCommand, false)) {
+        delete reinterpret_cast<uint8_t*>(dmaBuffer);
         return nullptr;
     }
 
-    auto slot = findCommandSlot(portNumber);
-    if (slot == UINT32_MAX) {
-        portLocks[portNumber].release();
-        return nullptr;
-    }
+    return dmaBuffer;
+}
 
-    auto *dmaBuffer = allocateDmaBuffer(byteCount);
-    auto *physicalDmaAddress = memoryService.getPhysicalAddress(dmaBuffer);
+bool AhciController::writeToDevice(uint32_t portNumber, void *physicalDmaAddress, uint32_t byteCount, const uint8_t *commandFis, const uint8_t *atapiCommand) {
+    return executeCommand(portNumber, physicalDmaAddress, byteCount, commandFis, atapiCommand, true);
+}
+
+bool AhciController::executeCommand(uint32_t portNumber, void *physicalDmaAddress, uint32_t byteCount, const uint8_t *commandFis, const uint8_t *atapiCommand, bool write) {
+    auto &memoryService = Kernel::Service::getService<Kernel::MemoryService>();
+    auto &scheduler = Kernel::Service::getService<Kernel::ProcessService>().getScheduler();
+    auto &port = registers->ports[portNumber];
+    auto &state = portStates[portNumber];
+    auto *commandList = virtualCommandLists[portNumber];
 
+    // Build the command table before occupying a slot, since this may take a while
     auto *commandTable = HbaCommandTable::createCommandTable(byteCount, physicalDmaAddress);
     Util::Address<uint32_t>(commandTable->commandFis).copyRange(Util::Address<uint32_t>(commandFis), sizeof(HbaCommandTable::commandFis));
     Util::Address<uint32_t>(commandTable->atapiCommand).copyRange(Util::Address<uint32_t>(atapiCommand), sizeof(HbaCommandTable::atapiCommand));
 
-    auto &commandHeader = commandList[slot];
+    auto &hostToDeviceFis = *reinterpret_cast<FisRegisterHostToDevice*>(commandTable->commandFis);
+    auto queued = hostToDeviceFis.command == READ_FPDMA_QUEUED || hostToDeviceFis.command == WRITE_FPDMA_QUEUED;
+
+    state.freeSlots.acquire();
+    if (!lockPort(portNumber, queued)) {
+        state.freeSlots.release();
+        delete commandTable;
+        return false;
+    }
+
+    uint32_t slotNumber = 0;
+    while (state.usedSlots & (1 << slotNumber)) {
+        slotNumber++;
+    }
+    state.usedSlots |= (1 << slotNumber);
+
+    if (queued) {
+        hostToDeviceFis.countLow = slotNumber << 3; // NCQ tag
+    }
+
+    auto &commandHeader = commandList[slotNumber];
     commandHeader.clear();
     commandHeader.physicalRegionDescriptorTableLength = byteCount % BYTES_PER_DESCRIPTOR_ENTRY == 0 ? (byteCount / BYTES_PER_DESCRIPTOR_ENTRY) : (byteCount / BYTES_PER_DESCRIPTOR_ENTRY) + 1;
     commandHeader.commandFisLength = sizeof(FisRegisterHostToDevice) / sizeof(uint32_t);
     commandHeader.commandTableDescriptorBaseAddress = reinterpret_cast<uint32_t>(memoryService.getPhysicalAddress(commandTable));
     commandHeader.atapi = atapiCommand[0] == 0 ? 0 : 1;
+    commandHeader.write = write ? 1 : 0;
 
-    // Issue command
-    if (!port.issueCommand(slot)) {
-        portLocks[portNumber].release();
-        delete reinterpret_cast<uint8_t*>(dmaBuffer);
-        delete commandTable;
-        return nullptr;
+    // Threads can only be blocked, once the scheduler is running (devices are identified and partitions are scanned before)
+    auto interruptDriven = interruptsEnabled && scheduler.isInitialized();
+
+    auto &slot = state.slots[slotNumber];
+    slot.thread = interruptDriven ? &scheduler.getCurrentThread() : nullptr;
+    slot.failed = false;
+    slot.deadline = Util::Time::getSystemTime().toMilliseconds() + COMMAND_TIMEOUT;
+    Util::Async::Atomic<uint32_t>(slot.waitState).set(Kernel::Scheduler::INTERRUPT_PENDING);
+
+    // Issue command (both registers are write-1-to-set, so other slots are not affected)
+    auto activeWrapper = Util::Async::Atomic<uint32_t>(state.activeSlots);
+    activeWrapper.bitSet(slotNumber);
+    if (queued) {
+        port.sataActive = 1 << slotNumber;
+    }
+    port.commandIssue = 1 << slotNumber;
+
+    state.lock.release();
+
+    // Wait for command completion (if the interrupt gets lost, the watchdog fails the command after its deadline)
+    if (interruptDriven) {
+        scheduler.blockForInterrupt(slot.waitState);
+    } else {
+        auto waitStateWrapper = Util::Async::Atomic<uint32_t>(slot.waitState);
+        while (waitStateWrapper.get() != Kernel::Scheduler::INTERRUPT_SIGNALED) {
+            completeCommands(portNumber);
+            failTimedOutCommands(portNumber);
+            Util::Async::Thread::yield();
+        }
     }
 
-    portLocks[portNumber].release();
+    auto success = !slot.failed;
+
+    state.lock.acquire();
+    state.usedSlots &= ~(1 << slotNumber);
+    state.lock.release();
+    state.freeSlots.release();
+
     delete commandTable;
-    return dmaBuffer;
+    return success;
 }
 
-bool AhciController::writeToDevice(uint32_t portNumber, void *physicalDmaAddress, uint32_t byteCount, const uint8_t *commandFis, const uint8_t *atapiCommand) {
-    auto &memoryService = Kernel::Service::getService<Kernel::MemoryService>();
+void AhciController::completeCommands(uint32_t portNumber) {
     auto &port = registers->ports[portNumber];
-    auto *commandList = virtualCommandLists[portNumber];
+    auto &state = portStates[portNumber];
+    auto activeWrapper = Util::Async::Atomic<uint32_t>(state.activeSlots);
 
-    portLocks[portNumber].acquire();
+    // Clear handled interrupts first, so that completions arriving in the meantime raise a new interrupt
+    auto status = port.interruptStatus;
+    port.interruptStatus = status;
 
-    if (!port.isActive()) {
-        portLocks[portNumber].release();
-        return false;
+    if (state.recovering) {
+        // Stopping the command engine clears all issued commands, which must not be mistaken for completions
+        return;
     }
 
-    auto slot = findCommandSlot(portNumber);
-    if (slot == UINT32_MAX) {
-        portLocks[portNumber].release();
-        return false;
+    // After an error, the HBA stops processing commands -> Fail all commands, that have not completed yet
+    auto error = (status & ERROR_INTERRUPTS) != 0;
+    if (error) {
+        state.recoveryNeeded = true;
     }
 
-    auto *commandTable = HbaCommandTable::createCommandTable(byteCount, physicalDmaAddress);
-    Util::Address<uint32_t>(commandTable->commandFis).copyRange(Util::Address<uint32_t>(commandFis), sizeof(HbaCommandTable::commandFis));
-    Util::Address<uint32_t>(commandTable->atapiCommand).copyRange(Util::Address<uint32_t>(atapiCommand), sizeof(HbaCommandTable::atapiCommand));
+    auto pendingSlots = port.commandIssue | port.sataActive;
+    auto activeSlots = activeWrapper.get();
+    for (uint32_t i = 0; i < slotCount; i++) {
+        if (!(activeSlots & (1 << i))) {
+            continue;
+        }
 
-    auto &commandHeader = commandList[slot];
-    commandHeader.clear();
-    commandHeader.physicalRegionDescriptorTableLength = byteCount % BYTES_PER_DESCRIPTOR_ENTRY == 0 ? (byteCount / BYTES_PER_DESCRIPTOR_ENTRY) : (byteCount / BYTES_PER_DESCRIPTOR_ENTRY) + 1;
-    commandHeader.commandFisLength = sizeof(FisRegisterHostToDevice) / sizeof(uint32_t);
-    commandHeader.commandTableDescriptorBaseAddress = reinterpret_cast<uint32_t>(memoryService.getPhysicalAddress(commandTable));
-    commandHeader.atapi = atapiCommand[0] == 0 ? 0 : 1;
+        auto pending = (pendingSlots & (1 << i)) != 0;
+        if ((!pending || error) && activeWrapper.bitTestAndReset(i)) {
+            finishSlot(portNumber, i, pending);
+        }
+    }
+}
 
-    // Issue command
-    if (!port.issueCommand(slot)) {
-        portLocks[portNumber].release();
-        delete commandTable;
-        return false;
+void AhciController::finishSlot(uint32_t portNumber, uint32_t slotNumber, bool failed) {
+    auto &slot = portStates[portNumber].slots[slotNumber];
+    slot.failed = failed;
+
+    if (slot.thread == nullptr) {
+        // The issuing thread is polling the port
+        Util::Async::Atomic<uint32_t>(slot.waitState).set(Kernel::Scheduler::INTERRUPT_SIGNALED);
+    } else {
+        Kernel::Scheduler::signalFromInterrupt(slot.waitState, *slot.thread);
     }
+}
 
-    portLocks[portNumber].release();
-    delete commandTable;
-    return true;
+bool AhciController::lockPort(uint32_t portNumber, bool queued) {
+    auto &port = registers->ports[portNumber];
+    auto &state = portStates[portNumber];
+    auto activeWrapper = Util::Async::Atomic<uint32_t>(state.activeSlots);
+
+    while (true) {
+        if (state.recoveryNeeded) {
+            recoverPort(portNumber);
+        }
+
+        // Non-queued commands must not be started while the device is still busy with a previous command.
+        // Waiting may take a while, so it is done before locking the port and the device state is checked again afterward.
+        if (!queued && activeWrapper.get() == 0 && !port.waitUntilReady()) {
+            return false;
+        }
+
+        state.lock.acquire();
+        if (!state.recovering) {
+            if (!port.isActive()) {
+                state.lock.release();
+                return false;
+            }
+
+            if (queued || activeWrapper.get() != 0 || (port.taskFileData & (BUSY | DATA_TRANSFER_REQUESTED)) == 0) {
+                return true;
+            }
+        }
+
+        state.lock.release();
+        Util::Async::Thread::yield();
+    }
+}
+
+void AhciController::recoverPort(uint32_t portNumber) {
+    auto &port = registers->ports[portNumber];
+    auto &state = portStates[portNumber];
+    auto activeWrapper = Util::Async::Atomic<uint32_t>(state.activeSlots);
+
+    state.lock.acquire();
+    if (!state.recoveryNeeded || state.recovering) {
+        state.lock.release();
+        return;
+    }
+
+    // Errors occurring from now on need another recovery
+    state.recovering = true;
+    state.recoveryNeeded = false;
+    state.lock.release();
+
+    LOG_WARN("Recovering port [%u] after command failure (Task file: [0x%02x], SATA error: [0x%08x])", portNumber, port.taskFileData & 0xff, port.sataError);
+
+    // Outstanding commands are only failed once the HBA has stopped processing them,
+    // since their issuers free the command tables and DMA buffers right afterward
+    port.stopCommandEngine();
+    for (uint32_t i = 0; i < slotCount; i++) {
+        if (activeWrapper.bitTestAndReset(i)) {
+            finishSlot(portNumber, i, true);
+        }
+    }
+
+    port.sataError = 0xffffffff;
+    port.interruptStatus = 0xffffffff;
+    port.startCommandEngine();
+
+    state.lock.acquire();
+    state.recovering = false;
+    state.lock.release();
+}
+
+void AhciController::failTimedOutCommands(uint32_t portNumber) {
+    auto &state = portStates[portNumber];
+    auto activeWrapper = Util::Async::Atomic<uint32_t>(state.activeSlots);
+    auto systemTime = Util::Time::getSystemTime().toMilliseconds();
+
+    // Commands are issued with the port locked, so no slot gets a new deadline while checking it
+    state.lock.acquire();
+    if (state.recovering) {
+        // The recovery fails all outstanding commands anyway
+        state.lock.release();
+        return;
+    }
+
+    auto activeSlots = activeWrapper.get();
+    auto timedOut = false;
+    for (uint32_t i = 0; i < slotCount; i++) {
+        if ((activeSlots & (1 << i)) && systemTime >= state.slots[i].deadline) {
+            LOG_WARN("Command in slot [%u] of port [%u] timed out", i, portNumber);
+            timedOut = true;
+        }
+    }
+
+    if (timedOut) {
+        state.recoveryNeeded = true;
+    }
+    state.lock.release();
+
+    // The HBA may still own the command's buffers, so it must be stopped before the command is failed (done by the recovery)
+    if (timedOut) {
+        recoverPort(portNumber);
+    }
+}
+
+void AhciController::checkCommandTimeouts() {
+    for (uint32_t i = 0; i < portCount; i++) {
+        if (virtualCommandLists[i] != nullptr) {
+            failTimedOutCommands(i);
+        }
+    }
 }
 
 void *AhciController::allocateDmaBuffer(uint32_t size) {
@@ -463,12 +663,49 @@ void *AhciController::allocateDmaBuffer(uint32_t size) {
     return Kernel::Service::getService<Kernel::MemoryService>().mapIO(dmaPages);
 }
 
-void AhciController::trigger([[maybe_unused]] const Kernel::InterruptFrame &frame, [[maybe_unused]] Kernel::InterruptVector slot) {}
+void AhciController::trigger([[maybe_unused]] const Kernel::InterruptFrame &frame, [[maybe_unused]] Kernel::InterruptVector slot) {
+    if (registers == nullptr || virtualCommandLists == nullptr) {
+        return;
+    }
+
+    auto pendingPorts = registers->interruptStatus;
+    for (uint32_t i = 0; i < portCount; i++) {
+        if ((pendingPorts & (1 << i)) && virtualCommandLists[i] != nullptr) {
+            completeCommands(i);
+        }
+    }
+
+    // The global status may only be cleared after the port status
+    registers->interruptStatus = pendingPorts;
+}
 
 void AhciController::plugin() {
     auto &interruptService = Kernel::InterruptService::getService<Kernel::InterruptService>();
     interruptService.assignInterrupt(static_cast<Kernel::InterruptVector>(pciDevice.getInterruptLine() + 32), *this);
     interruptService.allowHardwareInterrupt(pciDevice.getInterruptLine());
+
+    if (virtualCommandLists == nullptr) {
+        return;
+    }
+
+    // Commands issued from now on are completed by the interrupt handler, instead of polling the ports
+    for (uint32_t i = 0; i < portCount; i++) {
+        if (virtualCommandLists[i] != nullptr && registers->ports[i].isActive()) {
+            registers->ports[i].interruptStatus = 0xffffffff;
+            registers->ports[i].interruptEnable = COMPLETION_INTERRUPTS | ERROR_INTERRUPTS;
+        }
+    }
+
+    registers->globalHostControl |= INTERRUPT_ENABLE;
+    interruptsEnabled = true;
+
+    auto &processService = Kernel::Service::getService<Kernel::ProcessService>();
+    auto *watchdog = new Util::Async::PeriodicRunnable(Util::Time::Timestamp::ofMilliseconds(TIMEOUT_CHECK_INTERVAL), [](void *controller) {
+        static_cast<AhciController*>(controller)->checkCommandTimeouts();
+    }, this);
+
+    auto &watchdogThread = Kernel::Thread::createKernelThread("Ahci-Watchdog", processService.getKernelProcess(), watchdog);
+    processService.ready(watchdogThread);
 }
 
 void AhciController::HbaPort::startCommandEngine() {
@@ -490,8 +727,7 @@ void AhciController::HbaPort::stopCommandEngine() {
     }
 }
 
-bool AhciController::HbaPort::issueCommand(uint8_t slot) {
-    // Wait while device is busy
+bool AhciController::HbaPort::waitUntilReady() const {
     uint32_t timeout = Util::Time::getSystemTime().toMilliseconds() + COMMAND_TIMEOUT;
     while (taskFileData & (BUSY | DATA_TRANSFER_REQUESTED)) {
         if (Util::Time::getSystemTime().toMilliseconds() >= timeout) {
@@ -501,27 +737,6 @@ bool AhciController::HbaPort::issueCommand(uint8_t slot) {
         Util::Async::Thread::yield();
     }
 
-    // Issue command
-    commandIssue = 1 << slot;
-
-    // Wait for command completion
-    timeout = Util::Time::getSystemTime().toMilliseconds() + COMMAND_TIMEOUT;
-    while (true) {
-        if (!(commandIssue & (1 << slot))) {
-            break;
-        }
-
-        if (interruptStatus & TASK_FILE_ERROR) {
-            return false;
-        }
-
-        if (Util::Time::getSystemTime().toMilliseconds() >= timeout) {
-            return false;
-        }
-
-        Util::Async::Thread::yield();
-    }
-
     return true;
 }
 
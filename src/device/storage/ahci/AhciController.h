@@ -26,16 +26,14 @@
 #include "device/bus/pci/PciDevice.h"
 #include "kernel/interrupt/InterruptHandler.h"
 #include "lib/util/base/Constants.h"
+#include "lib/util/async/Spinlock.h"
+#include "lib/util/async/Semaphore.h"
 
 namespace Kernel {
 enum InterruptVector : uint8_t;
 struct InterruptFrame;
+class Thread;
 }  // namespace Kernel
-namespace Util {
-namespace Async {
-class Spinlock;
-}  // namespace Async
-}  // namespace Util
 
 namespace Device::Storage {
 
@@ -206,6 +204,17 @@ public:
 
     uint16_t performAtapiIO(uint32_t portNumber, const DeviceInfo &deviceInfo, TransferMode mode, uint8_t *buffer, uint64_t startSector, uint32_t sectorCount);
 
+    /**
+     * Get the number of commands, that can be in flight on a port at once.
+     */
+    [[nodiscard]] uint32_t getQueueDepth(uint32_t portNumber) const;
+
+    /**
+     * Recover all ports with commands, that have been in flight for longer than COMMAND_TIMEOUT (failing their outstanding commands).
+     * This is called periodically by the controller's watchdog thread, so that threads never wait forever for a lost interrupt.
+     */
+    void checkCommandTimeouts();
+
     void plugin() override;
 
     void trigger(const Kernel::InterruptFrame &frame, Kernel::InterruptVector slot) override;
@@ -242,6 +251,10 @@ private:
         COMMAND_LIST_RUNNING = 1 << 15
     };
 
+    enum HostCapabilities {
+        NATIVE_COMMAND_QUEUING = 1 << 30
+    };
+
     enum HostControl {
         HBA_RESET = 1 << 0,
         INTERRUPT_ENABLE = 1 << 1,
@@ -256,7 +269,20 @@ private:
     };
 
     enum PortInterruptStatus {
-        TASK_FILE_ERROR = 1 << 30
+        DEVICE_TO_HOST_REGISTER_FIS = 1 << 0,
+        PIO_SETUP_FIS = 1 << 1,
+        DMA_SETUP_FIS = 1 << 2,
+        SET_DEVICE_BITS_FIS = 1 << 3,
+        INTERFACE_FATAL_ERROR = 1 << 27,
+        HOST_BUS_DATA_ERROR = 1 << 28,
+        HOST_BUS_FATAL_ERROR = 1 << 29,
+        TASK_FILE_ERROR = 1 << 30,
+        COMPLETION_INTERRUPTS = DEVICE_TO_HOST_REGISTER_FIS | PIO_SETUP_FIS | SET_DEVICE_BITS_FIS,
+        ERROR_INTERRUPTS = INTERFACE_FATAL_ERROR | HOST_BUS_DATA_ERROR | HOST_BUS_FATAL_ERROR | TASK_FILE_ERROR
+    };
+
+    enum SataCapabilities : uint16_t {
+        SATA_NATIVE_COMMAND_QUEUING = 1 << 8
     };
 
     enum FisType : uint8_t {
@@ -277,6 +303,8 @@ private:
         READ_DMA_EX = 0x25,
         WRITE_DMA = 0xca,
         WRITE_DMA_EX = 0x35,
+        READ_FPDMA_QUEUED = 0x60,
+        WRITE_FPDMA_QUEUED = 0x61,
         ATA_PACKET = 0xa0,
         ATAPI_READ = 0xa8,
         ATAPI_READ_CAPACITY = 0x25
@@ -341,7 +369,7 @@ private:
 
         void stopCommandEngine();
 
-        bool issueCommand(uint8_t slot);
+        bool waitUntilReady() const;
 
         [[nodiscard]] bool isActive() const;
 
@@ -412,6 +440,32 @@ private:
         static AhciController::HbaCommandTable *createCommandTable(uint32_t byteCount, void *physicalDmaBuffer);
     } __attribute__((packed));
 
+    /**
+     * A command slot of a port and the thread waiting for the command issued in it.
+     */
+    struct CommandSlot {
+        uint32_t waitState = 0; // Kernel::Scheduler::InterruptWaitState (only accessed atomically)
+        Kernel::Thread *thread = nullptr;
+        uint32_t deadline = 0; // System time in milliseconds, after which the command is considered lost
+        bool failed = false;
+    };
+
+    /**
+     * Software state of a port. Each issued command occupies one of up to 32 slots,
+     * so multiple threads can have commands in flight on the same port at once.
+     */
+    struct PortState {
+        Util::Async::Spinlock lock; // Protects slot allocation and issuing commands
+        Util::Async::Semaphore freeSlots; // One permit per usable command slot
+        uint32_t usedSlots = 0; // Slots allocated by threads (protected by the lock)
+        uint32_t activeSlots = 0; // Slots with commands issued to the HBA, that have not completed yet (only accessed atomically)
+        uint32_t queueDepth = 1;
+        bool nativeCommandQueuing = false;
+        volatile bool recoveryNeeded = false;
+        volatile bool recovering = false; // No commands may be issued or completed while the command engine is restarted (written with the lock held)
+        CommandSlot slots[32];
+    };
+
     bool biosHandoff();
 
     bool enableAhci();
@@ -426,7 +480,41 @@ private:
 
     bool writeToDevice(uint32_t portNumber, void *physicalDmaAddress, uint32_t byteCount, const uint8_t commandFis[64], const uint8_t atapiCommand[16]);
 
-    uint32_t findCommandSlot(uint32_t portNumber);
+    /**
+     * Issue a command in a free slot of the given port and block until it has completed.
+     * Once the controller's interrupt handler is installed, the calling thread is blocked and woken up by the handler.
+     * Before that (e.g. while identifying devices), the port is polled.
+     * NCQ commands (READ/WRITE FPDMA QUEUED) get their slot number written into the FIS as tag.
+     */
+    bool executeCommand(uint32_t portNumber, void *physicalDmaAddress, uint32_t byteCount, const uint8_t commandFis[64], const uint8_t atapiCommand[16], bool write);
+
+    /**
+     * Complete all commands of a port, that the HBA has finished (or fail all outstanding commands after an error).
+     * This is called by the interrupt handler and by threads polling the port and acquires no locks.
+     */
+    void completeCommands(uint32_t portNumber);
+
+    /**
+     * Lock a port for issuing a command, recovering it first if necessary.
+     * Returns false with the port unlocked, if the port is inactive or the device does not become ready.
+     */
+    bool lockPort(uint32_t portNumber, bool queued);
+
+    /**
+     * Restart a port's command engine after an error and fail all outstanding commands, once the engine has stopped.
+     * The port lock must not be held, since restarting may sleep. If another thread is already recovering the port, this returns immediately.
+     */
+    void recoverPort(uint32_t portNumber);
+
+    /**
+     * Recover a port, if one of its commands has passed its deadline. The recovery stops the command engine and fails
+     * all outstanding commands of the port. The port lock must not be held.
+     */
+    void failTimedOutCommands(uint32_t portNumber);
+
+    void enableQueuing(uint32_t portNumber, const DeviceInfo &info);
+
+    void finishSlot(uint32_t portNumber, uint32_t slot, bool failed);
 
     static void *allocateDmaBuffer(uint32_t size);
 
@@ -435,12 +523,15 @@ private:
     PciDevice pciDevice;
     HbaRegisters *registers = nullptr;
     HbaCommandHeader **virtualCommandLists = nullptr;
-    Util::Async::Spinlock *portLocks = nullptr;
+    PortState *portStates = nullptr;
     uint32_t portCount = 0;
+    uint32_t slotCount = 1;
+    bool interruptsEnabled = false;
 
     static const constexpr uint8_t PCI_SUBCLASS_AHCI = 0x06;
     static const constexpr uint32_t AHCI_ENABLE_TIMEOUT = 5000;
     static const constexpr uint32_t COMMAND_TIMEOUT = 10000;
+    static const constexpr uint32_t TIMEOUT_CHECK_INTERVAL = 1000;
     static const constexpr uint32_t BYTES_PER_DESCRIPTOR_ENTRY = Util::PAGESIZE;
 };
 
@@ -50,4 +50,8 @@ uint32_t AhciDevice::write(const uint8_t *buffer, uint32_t startSector, uint32_t
     return controller.performAtaIO(portNumber, info, AhciController::WRITE, const_cast<uint8_t*>(buffer), startSector, sectorCount);
 }
 
+uint32_t AhciDevice::getQueueDepth() {
+    return controller.getQueueDepth(portNumber);
+}
+
 }
\ No newline at end of file
@@ -71,6 +71,11 @@ public:
      */
     uint32_t write(const uint8_t *buffer, uint32_t startSector, uint32_t sectorCount) override;
 
+    /**
+     * Overriding function from StorageDevice.
+     */
+    uint32_t getQueueDepth() override;
+
 private:
 
     const uint32_t portNumber;
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "BlockRequest.h"
+
+#include "lib/interface.h"
+#include "lib/util/async/Atomic.h"
+#include "lib/util/async/Thread.h"
+
+namespace Device::Storage {
+
+BlockRequest::BlockRequest(Operation operation, uint8_t *buffer, uint32_t startSector, uint32_t sectorCount, void (*callback)(BlockRequest&, void*), void *context) :
+        operation(operation), buffer(buffer), startSector(startSector), sectorCount(sectorCount), callback(callback), context(context) {}
+
+BlockRequest::Operation BlockRequest::getOperation() const {
+    return operation;
+}
+
+uint8_t* BlockRequest::getBuffer() const {
+    return buffer;
+}
+
+uint32_t BlockRequest::getStartSector() const {
+    return startSector;
+}
+
+uint32_t BlockRequest::getSectorCount() const {
+    return sectorCount;
+}
+
+uint32_t BlockRequest::getProcessedSectors() const {
+    return processedSectors;
+}
+
+bool BlockRequest::isCompleted() const {
+    return Util::Async::Atomic<uint32_t>(const_cast<uint32_t&>(completed)).get();
+}
+
+void BlockRequest::detach() {
+    detached = true;
+}
+
+void BlockRequest::translate(uint32_t sectorOffset) {
+    startSector += sectorOffset;
+}
+
+void BlockRequest::complete(uint32_t processedSectors) {
+    this->processedSectors = processedSectors;
+    if (callback != nullptr) {
+        callback(*this, context);
+    }
+
+    if (detached) {
+        delete[] buffer;
+        delete this;
+        return;
+    }
+
+    // The submitter may delete the request as soon as it sees the completed flag, so only its address is used afterward
+    auto *address = &completed;
+    Util::Async::Atomic<uint32_t>(completed).set(true);
+    wakeAddress(address, UINT32_MAX);
+}
+
+uint32_t BlockRequest::waitForCompletion() {
+    while (!isCompleted()) {
+        // Without a running scheduler, waiting on the address returns immediately
+        if (!waitOnAddress(&completed, false)) {
+            Util::Async::Thread::yield();
+        }
+    }
+
+    return processedSectors;
+}
+
+}
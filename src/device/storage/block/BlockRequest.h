@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_BLOCKREQUEST_H
+#define HHUOS_BLOCKREQUEST_H
+
+#include <stdint.h>
+
+#include "lib/util/time/Timestamp.h"
+
+namespace Device::Storage {
+
+/**
+ * An asynchronous read or write operation on a storage device.
+ * Requests are submitted via StorageDevice::submit() and completed by the device (or its request queue) later on.
+ * The request object and its buffer are owned by the submitter and must stay valid until the request has completed.
+ * The completion callback runs in the context of the thread completing the request (e.g. a queue's dispatcher thread),
+ * so it must not block for long.
+ */
+class BlockRequest {
+
+    friend class BlockRequestQueue;
+
+public:
+
+    enum Operation : uint8_t {
+        READ = 0x00,
+        WRITE = 0x01
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param operation Read or write
+     * @param buffer The buffer to read into or write from (at least sectorCount * sectorSize bytes)
+     * @param startSector The first sector on the device the request is submitted to
+     * @param sectorCount The amount of sectors to transfer
+     * @param callback Called once the request has completed (may be nullptr)
+     * @param context Passed to the callback
+     */
+    BlockRequest(Operation operation, uint8_t *buffer, uint32_t startSector, uint32_t sectorCount, void (*callback)(BlockRequest &request, void *context) = nullptr, void *context = nullptr);
+
+    /**
+     * Copy Constructor.
+     */
+    BlockRequest(const BlockRequest &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    BlockRequest &operator=(const BlockRequest &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~BlockRequest() = default;
+
+    [[nodiscard]] Operation getOperation() const;
+
+    [[nodiscard]] uint8_t* getBuffer() const;
+
+    /**
+     * Get the start sector, translated by all partitions the request has passed through.
+     */
+    [[nodiscard]] uint32_t getStartSector() const;
+
+    [[nodiscard]] uint32_t getSectorCount() const;
+
+    /**
+     * Get the amount of sectors, that have actually been transferred (only valid after completion).
+     */
+    [[nodiscard]] uint32_t getProcessedSectors() const;
+
+    [[nodiscard]] bool isCompleted() const;
+
+    /**
+     * Let the request delete itself and its buffer (allocated with new[]) after completion.
+     * This is meant for requests, that nobody waits for (e.g. readahead) and must be called before submitting the request.
+     * The request must have been allocated with new.
+     */
+    void detach();
+
+    /**
+     * Shift the start sector of the request. This is used by partitions to translate requests into their parent device.
+     */
+    void translate(uint32_t sectorOffset);
+
+    /**
+     * Mark the request as completed, run its callback and wake up threads waiting for it.
+     * After this has returned, the request may already have been deleted by its submitter.
+     *
+     * @param processedSectors The amount of sectors, that have actually been transferred
+     */
+    void complete(uint32_t processedSectors);
+
+    /**
+     * Block the current thread until the request has completed.
+     *
+     * @return The amount of sectors, that have actually been transferred
+     */
+    uint32_t waitForCompletion();
+
+private:
+
+    Operation operation;
+    uint8_t *buffer;
+    uint32_t startSector;
+    uint32_t sectorCount;
+    void (*callback)(BlockRequest &request, void *context);
+    void *context;
+
+    Util::Time::Timestamp deadline; // Set by request queues on submission
+    uint32_t processedSectors = 0;
+    uint32_t completed = false; // Only accessed atomically
+    bool detached = false;
+};
+
+}
+
+#endif
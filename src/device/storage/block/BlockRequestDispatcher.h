@@ -15,44 +15,47 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>
  */
 
-#ifndef HHUOS_PAGINGAREAMANAGERREFILLRUNNABLE_H
-#define HHUOS_PAGINGAREAMANAGERREFILLRUNNABLE_H
+#ifndef HHUOS_BLOCKREQUESTDISPATCHER_H
+#define HHUOS_BLOCKREQUESTDISPATCHER_H
 
 #include "lib/util/async/Runnable.h"
 
-namespace Kernel {
-class PagingAreaManager;
+namespace Device::Storage {
+class BlockRequestQueue;
 
-class PagingAreaManagerRefillRunnable : public Util::Async::Runnable {
+/**
+ * Background thread, which takes requests from a block request queue and passes them to the device driver.
+ */
+class BlockRequestDispatcher : public Util::Async::Runnable {
 
 public:
     /**
      * Constructor.
      */
-    explicit PagingAreaManagerRefillRunnable(PagingAreaManager &pagingAreaManager);
+    explicit BlockRequestDispatcher(BlockRequestQueue &queue);
 
     /**
      * Copy Constructor.
      */
-    PagingAreaManagerRefillRunnable(const PagingAreaManagerRefillRunnable &other) = delete;
+    BlockRequestDispatcher(const BlockRequestDispatcher &other) = delete;
 
     /**
      * Assignment operator.
      */
-    PagingAreaManagerRefillRunnable &operator=(const PagingAreaManagerRefillRunnable &other) = delete;
+    BlockRequestDispatcher &operator=(const BlockRequestDispatcher &other) = delete;
 
     /**
      * Destructor.
      */
-    ~PagingAreaManagerRefillRunnable() override = default;
+    ~BlockRequestDispatcher() override = default;
 
     void run() override;
 
 private:
 
-    PagingAreaManager &pagingAreaManager;
+    BlockRequestQueue &queue;
 };
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "BlockRequestQueue.h"
+
+#include "BlockRequest.h"
+#include "BlockRequestDispatcher.h"
+#include "BufferCache.h"
+#include "kernel/memory/MemoryLayout.h"
+#include "kernel/process/Thread.h"
+#include "kernel/service/ProcessService.h"
+#include "kernel/service/Service.h"
+#include "lib/interface.h"
+#include "lib/util/async/Atomic.h"
+#include "lib/util/base/Address.h"
+#include "lib/util/base/Exception.h"
+#include "lib/util/time/Timestamp.h"
+
+namespace Device::Storage {
+
+BlockRequestQueue::BlockRequestQueue(StorageDevice *device, const Util::String &name, BufferCache *cache) : device(device), cache(cache), queueDepth(device->getQueueDepth()) {
+    if (cache != nullptr) {
+        cache->addDevice(*device);
+    }
+
+    auto &processService = Kernel::Service::getService<Kernel::ProcessService>();
+    auto dispatcherCount = queueDepth < MAX_DISPATCHERS ? queueDepth : MAX_DISPATCHERS;
+
+    for (uint32_t i = 0; i < dispatcherCount; i++) {
+        auto &thread = Kernel::Thread::createKernelThread(Util::String::format("Block-Dispatcher-%s-%u", static_cast<const char*>(name), i), processService.getKernelProcess(), new BlockRequestDispatcher(*this));
+        processService.ready(thread);
+    }
+}
+
+BlockRequestQueue::~BlockRequestQueue() {
+    if (cache != nullptr) {
+        cache->invalidate(*device);
+    }
+
+    delete device;
+}
+
+uint32_t BlockRequestQueue::getSectorSize() {
+    return device->getSectorSize();
+}
+
+uint64_t BlockRequestQueue::getSectorCount() {
+    return device->getSectorCount();
+}
+
+uint32_t BlockRequestQueue::read(uint8_t *buffer, uint32_t startSector, uint32_t sectorCount) {
+    if (reinterpret_cast<uint32_t>(buffer) >= Kernel::MemoryLayout::KERNEL_AREA.endAddress) {
+        return transferUserBuffer(BlockRequest::READ, buffer, startSector, sectorCount);
+    }
+
+    auto request = BlockRequest(BlockRequest::READ, buffer, startSector, sectorCount);
+    submit(request);
+
+    return request.waitForCompletion();
+}
+
+uint32_t BlockRequestQueue::write(const uint8_t *buffer, uint32_t startSector, uint32_t sectorCount) {
+    if (reinterpret_cast<uint32_t>(buffer) >= Kernel::MemoryLayout::KERNEL_AREA.endAddress) {
+        return transferUserBuffer(BlockRequest::WRITE, const_cast<uint8_t*>(buffer), startSector, sectorCount);
+    }
+
+    auto request = BlockRequest(BlockRequest::WRITE, const_cast<uint8_t*>(buffer), startSector, sectorCount);
+    submit(request);
+
+    return request.waitForCompletion();
+}
+
+void BlockRequestQueue::submit(BlockRequest &request) {
+    // Check bounds here, so that invalid requests fail in the context of the submitting thread
+    if (request.startSector + static_cast<uint64_t>(request.sectorCount) > device->getSectorCount()) {
+        Util::Exception::throwException(Util::Exception::OUT_OF_BOUNDS, "BlockRequestQueue: Trying to access sectors out of device bounds!");
+    }
+
+    // Dispatcher threads do not run before the scheduler has been started (e.g. while partition tables are scanned)
+    if (!isSchedulerInitialized()) {
+        BlockRequest *requests[1] = { &request };
+        process(requests, 1);
+        return;
+    }
+
+    auto deadline = request.operation == BlockRequest::READ ? READ_DEADLINE_MS : WRITE_DEADLINE_MS;
+    request.deadline = Util::Time::getSystemTime() + Util::Time::Timestamp::ofMilliseconds(deadline);
+
+    lock.acquire();
+
+    // Keep the queue sorted by start sector (requests for the same sector stay in submission order)
+    uint32_t index = 0;
+    while (index < pendingRequests.size() && pendingRequests.get(index)->startSector <= request.startSector) {
+        index++;
+    }
+
+    pendingRequests.add(index, &request);
+    submittedRequests++;
+    Util::Async::Atomic<uint32_t>(pendingCount).inc();
+
+    lock.release();
+
+    wakeAddress(&pendingCount, 1);
+}
+
+uint32_t BlockRequestQueue::getQueueDepth() {
+    return queueDepth;
+}
+
+bool BlockRequestQueue::flush() {
+    return cache == nullptr || cache->flush(*device);
+}
+
+void BlockRequestQueue::dispatch() {
+    auto pendingWrapper = Util::Async::Atomic<uint32_t>(pendingCount);
+    while (pendingWrapper.get() == 0) {
+        waitOnAddress(&pendingCount, 0);
+    }
+
+    lock.acquire();
+    if (pendingRequests.isEmpty()) {
+        // Another dispatcher has been faster
+        lock.release();
+        return;
+    }
+
+    auto index = selectRequest();
+    auto sectorSize = device->getSectorSize();
+
+    BlockRequest *requests[MAX_MERGED_REQUESTS];
+    requests[0] = pendingRequests.removeIndex(index);
+    uint32_t count = 1;
+
+    // After removing the selected request, the index points to its successor in sector order -> Merge adjacent requests
+    auto operation = requests[0]->operation;
+    auto endSector = requests[0]->startSector + requests[0]->sectorCount;
+    auto size = requests[0]->sectorCount * sectorSize;
+    while (index < pendingRequests.size() && count < MAX_MERGED_REQUESTS) {
+        auto *next = pendingRequests.get(index);
+        if (next->operation != operation || next->startSector != endSector || size + next->sectorCount * sectorSize > MAX_MERGE_SIZE) {
+            break;
+        }
+
+        requests[count++] = pendingRequests.removeIndex(index);
+        endSector += next->sectorCount;
+        size += next->sectorCount * sectorSize;
+    }
+
+    headPosition = endSector;
+    dispatchedOperations++;
+    mergedRequests += count - 1;
+    pendingWrapper.sub(count);
+
+    lock.release();
+
+    process(requests, count);
+}
+
+BlockRequestQueue::Statistics BlockRequestQueue::getStatistics() {
+    lock.acquire();
+    auto statistics = Statistics{submittedRequests, dispatchedOperations, mergedRequests, expiredRequests, pendingRequests.size()};
+    lock.release();
+
+    return statistics;
+}
+
+uint32_t BlockRequestQueue::selectRequest() {
+    // Requests waiting longer than their deadline are served first (oldest deadline first)
+    auto now = Util::Time::getSystemTime();
+    auto expiredIndex = UINT32_MAX;
+    for (uint32_t i = 0; i < pendingRequests.size(); i++) {
+        auto *request = pendingRequests.get(i);
+        if (request->deadline <= now && (expiredIndex == UINT32_MAX || request->deadline < pendingRequests.get(expiredIndex)->deadline)) {
+            expiredIndex = i;
+        }
+    }
+
+    if (expiredIndex != UINT32_MAX) {
+        expiredRequests++;
+        return expiredIndex;
+    }
+
+    // C-LOOK: Continue upwards from the current head position and wrap around to the lowest sector at the end
+    for (uint32_t i = 0; i < pendingRequests.size(); i++) {
+        if (pendingRequests.get(i)->startSector >= headPosition) {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+uint32_t BlockRequestQueue::transferUserBuffer(BlockRequest::Operation operation, uint8_t *buffer, uint32_t startSector, uint32_t sectorCount) {
+    // Large transfers are split, so that the kernel buffer never exceeds the size of a merged operation
+    auto sectorSize = device->getSectorSize();
+    auto maxSectors = MAX_MERGE_SIZE / sectorSize > 0 ? MAX_MERGE_SIZE / sectorSize : 1;
+    auto *kernelBuffer = new uint8_t[(sectorCount < maxSectors ? sectorCount : maxSectors) * sectorSize];
+
+    uint32_t processedSectors = 0;
+    while (processedSectors < sectorCount) {
+        auto count = sectorCount - processedSectors < maxSectors ? sectorCount - processedSectors : maxSectors;
+        auto userBuffer = Util::Address<uint32_t>(buffer + processedSectors * sectorSize);
+        if (operation == BlockRequest::WRITE) {
+            Util::Address<uint32_t>(kernelBuffer).copyRange(userBuffer, count * sectorSize);
+        }
+
+        auto request = BlockRequest(operation, kernelBuffer, startSector + processedSectors, count);
+        submit(request);
+        auto requestProcessed = request.waitForCompletion();
+
+        if (operation == BlockRequest::READ && requestProcessed > 0) {
+            userBuffer.copyRange(Util::Address<uint32_t>(kernelBuffer), requestProcessed * sectorSize);
+        }
+
+        processedSectors += requestProcessed;
+        if (requestProcessed < count) {
+            break;
+        }
+    }
+
+    delete[] kernelBuffer;
+    return processedSectors;
+}
+
+void BlockRequestQueue::process(BlockRequest **requests, uint32_t count) {
+    auto sectorSize = device->getSectorSize();
+    auto operation = requests[0]->operation;
+    auto startSector = requests[0]->startSector;
+
+    // Merged requests may only share the buffer of the first one, if their buffers are adjacent in memory
+    auto contiguous = true;
+    uint32_t sectorCount = requests[0]->sectorCount;
+    for (uint32_t i = 1; i < count; i++) {
+        contiguous &= requests[i]->buffer == requests[i - 1]->buffer + requests[i - 1]->sectorCount * sectorSize;
+        sectorCount += requests[i]->sectorCount;
+    }
+
+    auto *buffer = contiguous ? requests[0]->buffer : new uint8_t[sectorCount * sectorSize];
+    if (!contiguous && operation == BlockRequest::WRITE) {
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            auto target = Util::Address<uint32_t>(buffer + offset);
+            target.copyRange(Util::Address<uint32_t>(requests[i]->buffer), requests[i]->sectorCount * sectorSize);
+            offset += requests[i]->sectorCount * sectorSize;
+        }
+    }
+
+    uint32_t processedSectors;
+    if (cache != nullptr) {
+        processedSectors = operation == BlockRequest::READ ? cache->read(*device, buffer, startSector, sectorCount) : cache->write(*device, buffer, startSector, sectorCount);
+    } else {
+        processedSectors = operation == BlockRequest::READ ? device->read(buffer, startSector, sectorCount) : device->write(buffer, startSector, sectorCount);
+    }
+
+    // Split the result among the merged requests (a request may be deleted by its submitter as soon as it is completed)
+    uint32_t offset = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        auto *request = requests[i];
+        auto requestSectors = request->sectorCount;
+        auto requestProcessed = processedSectors > offset ? processedSectors - offset : 0;
+        if (requestProcessed > requestSectors) {
+            requestProcessed = requestSectors;
+        }
+
+        if (!contiguous && operation == BlockRequest::READ && requestProcessed > 0) {
+            auto source = Util::Address<uint32_t>(buffer + offset * sectorSize);
+            Util::Address<uint32_t>(request->buffer).copyRange(source, requestProcessed * sectorSize);
+        }
+
+        offset += requestSectors;
+        request->complete(requestProcessed);
+    }
+
+    if (!contiguous) {
+        delete[] buffer;
+    }
+}
+
+}
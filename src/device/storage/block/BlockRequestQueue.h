@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_BLOCKREQUESTQUEUE_H
+#define HHUOS_BLOCKREQUESTQUEUE_H
+
+#include <stdint.h>
+
+#include "device/storage/StorageDevice.h"
+#include "device/storage/block/BlockRequest.h"
+#include "lib/util/async/Spinlock.h"
+#include "lib/util/collection/ArrayList.h"
+#include "lib/util/base/String.h"
+
+namespace Device::Storage {
+class BufferCache;
+
+/**
+ * Block layer between filesystems and a storage device driver.
+ * Requests are collected in a queue, sorted by sector, and dispatched by background threads (one per request the device
+ * can process concurrently). Dispatching follows a deadline scheduler: Usually, requests are served in elevator order
+ * (C-LOOK, ascending sectors starting at the current head position), but requests, that have been waiting
+ * longer than their deadline, are served first. Reads get a shorter deadline than writes, since threads usually wait for them.
+ * Adjacent requests of the same type are merged into a single device operation.
+ *
+ * If a buffer cache is given, requests are processed through it, so that cached sectors are not read from the device again
+ * and small writes are written back later.
+ *
+ * The queue is itself a storage device, so all synchronous callers (e.g. filesystem drivers and partitions) go through it.
+ * Since the dispatcher threads run in the kernel address space, user space buffers are copied through kernel buffers
+ * by the submitting thread. Asynchronously submitted requests must use kernel buffers.
+ */
+class BlockRequestQueue : public StorageDevice {
+
+public:
+
+    struct Statistics {
+        uint32_t submittedRequests;
+        uint32_t dispatchedOperations;
+        uint32_t mergedRequests;
+        uint32_t expiredRequests;
+        uint32_t pendingRequests;
+    };
+
+    /**
+     * Constructor.
+     * The queue takes ownership of the device and starts its dispatcher threads.
+     *
+     * @param device The device driver, that processes the requests
+     * @param name Used to name the dispatcher threads
+     * @param cache The buffer cache, shared with other devices (may be nullptr)
+     */
+    BlockRequestQueue(StorageDevice *device, const Util::String &name, BufferCache *cache = nullptr);
+
+    /**
+     * Copy Constructor.
+     */
+    BlockRequestQueue(const BlockRequestQueue &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    BlockRequestQueue &operator=(const BlockRequestQueue &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~BlockRequestQueue() override;
+
+    /**
+     * Overriding function from StorageDevice.
+     */
+    uint32_t getSectorSize() override;
+
+    /**
+     * Overriding function from StorageDevice.
+     */
+    uint64_t getSectorCount() override;
+
+    /**
+     * Overriding function from StorageDevice.
+     * The request is queued and the calling thread is blocked until it has completed.
+     */
+    uint32_t read(uint8_t *buffer, uint32_t startSector, uint32_t sectorCount) override;
+
+    /**
+     * Overriding function from StorageDevice.
+     * The request is queued and the calling thread is blocked until it has completed.
+     */
+    uint32_t write(const uint8_t *buffer, uint32_t startSector, uint32_t sectorCount) override;
+
+    /**
+     * Overriding function from StorageDevice.
+     * Until the scheduler is running, requests are processed directly by the submitting thread.
+     */
+    void submit(BlockRequest &request) override;
+
+    /**
+     * Overriding function from StorageDevice.
+     */
+    uint32_t getQueueDepth() override;
+
+    /**
+     * Overriding function from StorageDevice.
+     * Writes back the device's dirty sectors from the buffer cache.
+     */
+    bool flush() override;
+
+    /**
+     * Take the next batch of requests from the queue and process it.
+     * This is called by the dispatcher threads and blocks, while the queue is empty.
+     */
+    void dispatch();
+
+    [[nodiscard]] Statistics getStatistics();
+
+private:
+
+    uint32_t selectRequest();
+
+    /**
+     * Read into or write from a user space buffer via a kernel buffer, which is copied in the context of the calling thread.
+     */
+    uint32_t transferUserBuffer(BlockRequest::Operation operation, uint8_t *buffer, uint32_t startSector, uint32_t sectorCount);
+
+    void process(BlockRequest **requests, uint32_t count);
+
+    StorageDevice *device;
+    BufferCache *cache;
+    uint32_t queueDepth;
+
+    // Pending requests, sorted by start sector
+    Util::ArrayList<BlockRequest*> pendingRequests;
+    Util::Async::Spinlock lock;
+    uint32_t pendingCount = 0; // Dispatcher threads wait on this while the queue is empty (only accessed atomically)
+    uint32_t headPosition = 0; // Sector following the last dispatched request
+
+    uint32_t submittedRequests = 0;
+    uint32_t dispatchedOperations = 0;
+    uint32_t mergedRequests = 0;
+    uint32_t expiredRequests = 0;
+
+    static const constexpr uint32_t MAX_DISPATCHERS = 4;
+    static const constexpr uint32_t MAX_MERGED_REQUESTS = 32;
+    static const constexpr uint32_t MAX_MERGE_SIZE = 128 * 1024;
+    static const constexpr uint32_t READ_DEADLINE_MS = 50;
+    static const constexpr uint32_t WRITE_DEADLINE_MS = 500;
+};
+
+}
+
+#endif
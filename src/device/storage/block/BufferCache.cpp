@@ -0,0 +1,559 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "BufferCache.h"
+
+#include "device/storage/StorageDevice.h"
+#include "kernel/log/Log.h"
+#include "kernel/memory/SlabCache.h"
+#include "kernel/service/MemoryService.h"
+#include "kernel/service/Service.h"
+#include "lib/util/base/Address.h"
+#include "lib/util/base/Exception.h"
+#include "lib/util/base/String.h"
+
+namespace Device::Storage {
+
+uint8_t* BufferCache::Buffer::getData() {
+    return reinterpret_cast<uint8_t*>(this + 1);
+}
+
+BufferCache::BufferCache(uint32_t capacity) : capacity(capacity) {
+    // Aim for about two buffers of the smallest common sector size (512 bytes) per bucket
+    uint32_t log2 = 6;
+    while (hashTableSize < capacity / 1024 && hashTableSize < MAX_HASH_TABLE_SIZE) {
+        hashTableSize <<= 1;
+        log2++;
+    }
+
+    hashShift = 32 - log2;
+    hashTable = new Buffer*[hashTableSize];
+    for (uint32_t i = 0; i < hashTableSize; i++) {
+        hashTable[i] = nullptr;
+    }
+}
+
+BufferCache::~BufferCache() {
+    auto *buffer = lruHead;
+    while (buffer != nullptr) {
+        auto *next = buffer->lruNext;
+        getSlabCache(buffer->size).free(buffer);
+        buffer = next;
+    }
+
+    auto &memoryService = Kernel::Service::getService<Kernel::MemoryService>();
+    for (uint32_t i = 0; i < sizeClassCount; i++) {
+        memoryService.destroySlabCache(*sizeClasses[i].slabCache);
+    }
+
+    delete[] hashTable;
+}
+
+void BufferCache::addDevice(StorageDevice &device) {
+    auto sectorSize = device.getSectorSize();
+    for (uint32_t i = 0; i < sizeClassCount; i++) {
+        if (sizeClasses[i].sectorSize == sectorSize) {
+            return;
+        }
+    }
+
+    if (sizeClassCount == MAX_SIZE_CLASSES) {
+        Util::Exception::throwException(Util::Exception::UNSUPPORTED_OPERATION, "BufferCache: Too many different sector sizes!");
+    }
+
+    // Buffers are looked up without holding the lock, so the size class must be complete, before it is counted
+    auto &slabCache = Kernel::Service::getService<Kernel::MemoryService>().createSlabCache(Util::String::format("Buffer-%u", sectorSize), sizeof(Buffer) + sectorSize);
+    lock.acquire();
+    sizeClasses[sizeClassCount] = SizeClass{sectorSize, &slabCache};
+    sizeClassCount++;
+    lock.release();
+}
+
+uint32_t BufferCache::read(StorageDevice &device, uint8_t *buffer, uint32_t startSector, uint32_t sectorCount) {
+    auto sectorSize = device.getSectorSize();
+    auto bypass = sectorCount * sectorSize > capacity / BYPASS_DIVISOR;
+
+    uint32_t sector = 0;
+    while (sector < sectorCount) {
+        lock.acquire();
+
+        // Copy cached sectors
+        auto *cached = find(device, startSector + sector);
+        while (cached != nullptr) {
+            auto target = Util::Address<uint32_t>(buffer + sector * sectorSize);
+            target.copyRange(Util::Address<uint32_t>(cached->getData()), sectorSize);
+            touch(*cached);
+            hits++;
+
+            sector++;
+            cached = sector < sectorCount ? find(device, startSector + sector) : nullptr;
+        }
+
+        // Collect the following uncached sectors, so that they can be read with a single operation
+        auto missStart = sector;
+        while (sector < sectorCount && find(device, startSector + sector) == nullptr) {
+            sector++;
+        }
+
+        misses += sector - missStart;
+        auto generation = getGeneration(device);
+        lock.release();
+
+        auto missCount = sector - missStart;
+        if (missCount == 0) {
+            continue;
+        }
+
+        auto *target = buffer + missStart * sectorSize;
+        auto readSectors = device.read(target, startSector + missStart, missCount);
+        if (!bypass) {
+            insertClean(device, target, startSector + missStart, readSectors, generation);
+        }
+
+        if (readSectors < missCount) {
+            return missStart + readSectors;
+        }
+    }
+
+    return sectorCount;
+}
+
+uint32_t BufferCache::write(StorageDevice &device, const uint8_t *buffer, uint32_t startSector, uint32_t sectorCount) {
+    auto sectorSize = device.getSectorSize();
+    Buffer *freeList = nullptr;
+
+    if (sectorCount * sectorSize > capacity / BYPASS_DIVISOR) {
+        return writeThrough(device, buffer, startSector, sectorCount);
+    }
+
+    auto dirtyLimitExceeded = false;
+    for (uint32_t i = 0; i < sectorCount; i++) {
+        auto sector = startSector + i;
+        Buffer *newBuffer = nullptr;
+
+        lock.acquire();
+        auto *cached = find(device, sector);
+        if (cached == nullptr) {
+            // Allocate without holding the lock (the sector may have been added in the meantime)
+            lock.release();
+            newBuffer = allocateBuffer(device, sector);
+            lock.acquire();
+            cached = find(device, sector);
+
+            if (cached == nullptr && newBuffer == nullptr) {
+                // Out of memory -> Dirty data cannot be cached, so the remaining sectors are written directly
+                lock.release();
+                return i + writeThrough(device, buffer + i * sectorSize, sector, sectorCount - i);
+            }
+        }
+
+        if (cached == nullptr) {
+            // Dirty data must not be dropped, so the cache may exceed its capacity, if there are no clean buffers left.
+            // Reaching the dirty limit forces a write back, which brings it down again.
+            reserve(sectorSize, freeList);
+            insert(*newBuffer);
+            cached = newBuffer;
+            newBuffer = nullptr;
+        }
+
+        auto target = Util::Address<uint32_t>(cached->getData());
+        target.copyRange(Util::Address<uint32_t>(buffer + i * sectorSize), sectorSize);
+        touch(*cached);
+        markDirty(*cached);
+        dirtyLimitExceeded = dirtyBytes > capacity / DIRTY_LIMIT_DIVISOR;
+        lock.release();
+
+        if (newBuffer != nullptr) {
+            newBuffer->hashNext = freeList;
+            freeList = newBuffer;
+        }
+
+        freeBuffers(freeList);
+        freeList = nullptr;
+    }
+
+    if (dirtyLimitExceeded) {
+        writeBack(nullptr);
+    }
+
+    return sectorCount;
+}
+
+bool BufferCache::flush() {
+    return writeBack(nullptr);
+}
+
+bool BufferCache::flush(StorageDevice &device) {
+    return writeBack(&device);
+}
+
+void BufferCache::invalidate(StorageDevice &device) {
+    if (!writeBack(&device)) {
+        LOG_ERROR("Dropping dirty sectors, that could not be written back before invalidating the device");
+    }
+
+    writeBackLock.acquire();
+    lock.acquire();
+
+    Buffer *freeList = nullptr;
+    auto *buffer = lruHead;
+    while (buffer != nullptr) {
+        auto *next = buffer->lruNext;
+        if (buffer->device == &device) {
+            remove(*buffer);
+            buffer->hashNext = freeList;
+            freeList = buffer;
+        }
+
+        buffer = next;
+    }
+
+    getGeneration(device)++;
+    lock.release();
+    writeBackLock.release();
+
+    freeBuffers(freeList);
+}
+
+BufferCache::Statistics BufferCache::getStatistics() {
+    lock.acquire();
+    auto statistics = Statistics{capacity, usedBytes, bufferCount, dirtyCount, hits, misses, writeBacks, evictions};
+    lock.release();
+
+    return statistics;
+}
+
+bool BufferCache::writeBack(StorageDevice *device) {
+    Buffer *batch[MAX_WRITE_BACK_BATCH];
+    writeBackLock.acquire();
+
+    auto success = true;
+    auto batchFull = true;
+    while (batchFull && success) {
+        // Dirty buffers are only removed while holding the write back lock, so they stay valid after releasing the cache lock
+        lock.acquire();
+        uint32_t count = 0;
+        uint32_t size = 0;
+        for (auto *buffer = dirtyHead; buffer != nullptr && count < MAX_WRITE_BACK_BATCH; buffer = buffer->dirtyNext) {
+            if (device == nullptr || buffer->device == device) {
+                batch[count++] = buffer;
+                size += buffer->size;
+            }
+        }
+        lock.release();
+
+        if (count == 0) {
+            break;
+        }
+
+        batchFull = count == MAX_WRITE_BACK_BATCH;
+
+        // Sort by device and sector (insertion sort, since batches are small)
+        for (uint32_t i = 1; i < count; i++) {
+            auto *buffer = batch[i];
+            auto j = i;
+            while (j > 0 && (batch[j - 1]->device > buffer->device || (batch[j - 1]->device == buffer->device && batch[j - 1]->sector > buffer->sector))) {
+                batch[j] = batch[j - 1];
+                j--;
+            }
+
+            batch[j] = buffer;
+        }
+
+        // Take a snapshot of the data and mark the buffers as clean (writing a buffer again, while it is written back, makes it dirty again)
+        auto *snapshot = new uint8_t[size];
+        lock.acquire();
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            auto target = Util::Address<uint32_t>(snapshot + offset);
+            target.copyRange(Util::Address<uint32_t>(batch[i]->getData()), batch[i]->size);
+            batch[i]->writing = true;
+            markClean(*batch[i]);
+            offset += batch[i]->size;
+        }
+        lock.release();
+
+        // Write consecutive sectors of the same device with a single operation
+        offset = 0;
+        for (uint32_t i = 0; i < count;) {
+            auto *first = batch[i];
+            uint32_t runLength = 1;
+            while (i + runLength < count && batch[i + runLength]->device == first->device && batch[i + runLength]->sector == first->sector + runLength) {
+                runLength++;
+            }
+
+            auto writtenSectors = first->device->write(snapshot + offset, first->sector, runLength);
+            if (writtenSectors < runLength) {
+                LOG_ERROR("Failed to write back %u sectors, starting at sector [%u]", runLength - writtenSectors, first->sector + writtenSectors);
+
+                // Keep the unwritten sectors dirty, so that they are not evicted and written back again by the next flush
+                lock.acquire();
+                for (uint32_t j = writtenSectors; j < runLength; j++) {
+                    markDirty(*batch[i + j]);
+                }
+                lock.release();
+
+                success = false;
+            }
+
+            offset += runLength * first->size;
+            i += runLength;
+        }
+
+        lock.acquire();
+        for (uint32_t i = 0; i < count; i++) {
+            batch[i]->writing = false;
+        }
+
+        writeBacks += count;
+        lock.release();
+
+        delete[] snapshot;
+    }
+
+    writeBackLock.release();
+    return success;
+}
+
+void BufferCache::insertClean(StorageDevice &device, const uint8_t *data, uint32_t startSector, uint32_t sectorCount, uint32_t generation) {
+    auto sectorSize = device.getSectorSize();
+    for (uint32_t i = 0; i < sectorCount; i++) {
+        auto *buffer = allocateBuffer(device, startSector + i);
+        if (buffer == nullptr) {
+            // Caching clean sectors is optional, so nothing is lost if memory runs out
+            return;
+        }
+
+        auto target = Util::Address<uint32_t>(buffer->getData());
+        target.copyRange(Util::Address<uint32_t>(data + i * sectorSize), sectorSize);
+
+        Buffer *freeList = nullptr;
+        lock.acquire();
+        auto outdated = getGeneration(device) != generation;
+        if (!outdated && find(device, startSector + i) == nullptr && reserve(sectorSize, freeList)) {
+            insert(*buffer);
+        } else {
+            buffer->hashNext = freeList;
+            freeList = buffer;
+        }
+        lock.release();
+
+        freeBuffers(freeList);
+        if (outdated) {
+            return;
+        }
+    }
+}
+
+uint32_t BufferCache::writeThrough(StorageDevice &device, const uint8_t *buffer, uint32_t startSector, uint32_t sectorCount) {
+    Buffer *freeList = nullptr;
+
+    // Cached copies are outdated and dirty ones must not be written back after this write
+    writeBackLock.acquire();
+    lock.acquire();
+    discard(device, startSector, sectorCount, freeList);
+    getGeneration(device)++;
+    lock.release();
+    freeBuffers(freeList);
+
+    auto writtenSectors = device.write(buffer, startSector, sectorCount);
+
+    // Reads, that have been running concurrently to the write, may have fetched old data, which must not be cached
+    lock.acquire();
+    getGeneration(device)++;
+    lock.release();
+    writeBackLock.release();
+
+    return writtenSectors;
+}
+
+void BufferCache::discard(StorageDevice &device, uint32_t startSector, uint32_t sectorCount, Buffer *&freeList) {
+    for (uint32_t i = 0; i < sectorCount; i++) {
+        auto *buffer = find(device, startSector + i);
+        if (buffer != nullptr) {
+            remove(*buffer);
+            buffer->hashNext = freeList;
+            freeList = buffer;
+        }
+    }
+}
+
+bool BufferCache::reserve(uint32_t size, Buffer *&freeList) {
+    auto *candidate = lruTail;
+    while (usedBytes + size > capacity && candidate != nullptr) {
+        auto *previous = candidate->lruPrevious;
+        if (!candidate->dirty && !candidate->writing) {
+            remove(*candidate);
+            candidate->hashNext = freeList;
+            freeList = candidate;
+            evictions++;
+        }
+
+        candidate = previous;
+    }
+
+    return usedBytes + size <= capacity;
+}
+
+BufferCache::Buffer* BufferCache::allocateBuffer(StorageDevice &device, uint32_t sector) {
+    auto size = device.getSectorSize();
+    auto *buffer = static_cast<Buffer*>(getSlabCache(size).allocate());
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+
+    *buffer = Buffer{&device, sector, size, false, false, nullptr, nullptr, nullptr, nullptr, nullptr};
+
+    return buffer;
+}
+
+void BufferCache::freeBuffers(Buffer *freeList) {
+    while (freeList != nullptr) {
+        auto *next = freeList->hashNext;
+        getSlabCache(freeList->size).free(freeList);
+        freeList = next;
+    }
+}
+
+BufferCache::Buffer* BufferCache::find(StorageDevice &device, uint32_t sector) {
+    auto *buffer = hashTable[hash(device, sector)];
+    while (buffer != nullptr && (buffer->device != &device || buffer->sector != sector)) {
+        buffer = buffer->hashNext;
+    }
+
+    return buffer;
+}
+
+void BufferCache::insert(Buffer &buffer) {
+    auto index = hash(*buffer.device, buffer.sector);
+    buffer.hashNext = hashTable[index];
+    hashTable[index] = &buffer;
+
+    buffer.lruPrevious = nullptr;
+    buffer.lruNext = lruHead;
+    if (lruHead != nullptr) {
+        lruHead->lruPrevious = &buffer;
+    } else {
+        lruTail = &buffer;
+    }
+    lruHead = &buffer;
+
+    usedBytes += buffer.size;
+    bufferCount++;
+}
+
+void BufferCache::remove(Buffer &buffer) {
+    auto **link = &hashTable[hash(*buffer.device, buffer.sector)];
+    while (*link != &buffer) {
+        link = &(*link)->hashNext;
+    }
+    *link = buffer.hashNext;
+
+    if (buffer.lruPrevious != nullptr) {
+        buffer.lruPrevious->lruNext = buffer.lruNext;
+    } else {
+        lruHead = buffer.lruNext;
+    }
+
+    if (buffer.lruNext != nullptr) {
+        buffer.lruNext->lruPrevious = buffer.lruPrevious;
+    } else {
+        lruTail = buffer.lruPrevious;
+    }
+
+    markClean(buffer);
+    usedBytes -= buffer.size;
+    bufferCount--;
+}
+
+void BufferCache::touch(Buffer &buffer) {
+    if (lruHead == &buffer) {
+        return;
+    }
+
+    // Buffer is not the head, so it has a predecessor
+    buffer.lruPrevious->lruNext = buffer.lruNext;
+    if (buffer.lruNext != nullptr) {
+        buffer.lruNext->lruPrevious = buffer.lruPrevious;
+    } else {
+        lruTail = buffer.lruPrevious;
+    }
+
+    buffer.lruPrevious = nullptr;
+    buffer.lruNext = lruHead;
+    lruHead->lruPrevious = &buffer;
+    lruHead = &buffer;
+}
+
+void BufferCache::markDirty(Buffer &buffer) {
+    if (buffer.dirty) {
+        return;
+    }
+
+    buffer.dirty = true;
+    buffer.dirtyPrevious = nullptr;
+    buffer.dirtyNext = dirtyHead;
+    if (dirtyHead != nullptr) {
+        dirtyHead->dirtyPrevious = &buffer;
+    }
+    dirtyHead = &buffer;
+
+    dirtyBytes += buffer.size;
+    dirtyCount++;
+}
+
+void BufferCache::markClean(Buffer &buffer) {
+    if (!buffer.dirty) {
+        return;
+    }
+
+    if (buffer.dirtyPrevious != nullptr) {
+        buffer.dirtyPrevious->dirtyNext = buffer.dirtyNext;
+    } else {
+        dirtyHead = buffer.dirtyNext;
+    }
+
+    if (buffer.dirtyNext != nullptr) {
+        buffer.dirtyNext->dirtyPrevious = buffer.dirtyPrevious;
+    }
+
+    buffer.dirty = false;
+    dirtyBytes -= buffer.size;
+    dirtyCount--;
+}
+
+uint32_t BufferCache::hash(const StorageDevice &device, uint32_t sector) const {
+    // Fibonacci hashing of the sector number, offset by the device address
+    auto key = sector + static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&device) >> 4) * 0x9e3779b1;
+    return (key * 0x9e3779b1) >> hashShift;
+}
+
+uint32_t& BufferCache::getGeneration(const StorageDevice &device) {
+    return generations[(reinterpret_cast<uintptr_t>(&device) >> 4) % GENERATION_COUNTERS];
+}
+
+Kernel::SlabCache& BufferCache::getSlabCache(uint32_t sectorSize) {
+    for (uint32_t i = 0; i < sizeClassCount; i++) {
+        if (sizeClasses[i].sectorSize == sectorSize) {
+            return *sizeClasses[i].slabCache;
+        }
+    }
+
+    Util::Exception::throwException(Util::Exception::ILLEGAL_STATE, "BufferCache: Device has not been added!");
+}
+
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_BUFFERCACHE_H
+#define HHUOS_BUFFERCACHE_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Mutex.h"
+#include "lib/util/async/Spinlock.h"
+
+namespace Kernel {
+class SlabCache;
+}  // namespace Kernel
+
+namespace Device::Storage {
+class StorageDevice;
+
+/**
+ * Sector cache shared by all storage devices. Each cached sector is identified by its device and sector number.
+ * Block request queues process their requests through the cache, so that repeated reads of the same sectors
+ * (e.g. directory listings or filesystem metadata) are served from memory.
+ *
+ * The cache size is limited to a fixed amount of bytes. If it is full, the least recently used clean sector is evicted.
+ * Writes are cached as well and written back later (write-back), either periodically by a background thread,
+ * or synchronously by the writing thread, if dirty sectors take up more than half of the cache.
+ * Large requests bypass the cache (large reads are not added to it and large writes are written through),
+ * so that a single sequential transfer does not evict the whole cache.
+ *
+ * All device writes of cached data are serialized by a mutex, so that an older version of a sector can never overwrite
+ * a newer one on the device. A sector is not evicted, while it is being written back, so that a concurrent read
+ * does not fetch outdated data from the device.
+ */
+class BufferCache {
+
+public:
+
+    struct Statistics {
+        uint32_t capacity;
+        uint32_t usedBytes;
+        uint32_t bufferCount;
+        uint32_t dirtyBuffers;
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t writeBacks;
+        uint32_t evictions;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param capacity The maximum amount of bytes used for cached sectors
+     */
+    explicit BufferCache(uint32_t capacity);
+
+    /**
+     * Copy Constructor.
+     */
+    BufferCache(const BufferCache &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    BufferCache &operator=(const BufferCache &other) = delete;
+
+    /**
+     * Destructor.
+     * Dirty sectors are not written back, so flush() must be called before.
+     */
+    ~BufferCache();
+
+    /**
+     * Prepare the cache for sectors of a device (must be called once, before the device is accessed through the cache).
+     */
+    void addDevice(StorageDevice &device);
+
+    /**
+     * Read sectors through the cache. Sectors, that are not cached, are read from the device and added to the cache.
+     *
+     * @return The amount of sectors, that have been read (starting at startSector)
+     */
+    uint32_t read(StorageDevice &device, uint8_t *buffer, uint32_t startSector, uint32_t sectorCount);
+
+    /**
+     * Write sectors through the cache. Small writes only update the cache and are written back later.
+     *
+     * @return The amount of sectors, that have been written (starting at startSector)
+     */
+    uint32_t write(StorageDevice &device, const uint8_t *buffer, uint32_t startSector, uint32_t sectorCount);
+
+    /**
+     * Write back all dirty sectors of all devices.
+     * Sectors, that could not be written, stay dirty and are written back again by the next flush.
+     *
+     * @return false, if at least one sector could not be written back
+     */
+    bool flush();
+
+    /**
+     * Write back all dirty sectors of a device.
+     *
+     * @return false, if at least one sector could not be written back
+     */
+    bool flush(StorageDevice &device);
+
+    /**
+     * Write back all dirty sectors of a device and remove its sectors from the cache (e.g. before the device is removed).
+     */
+    void invalidate(StorageDevice &device);
+
+    [[nodiscard]] Statistics getStatistics();
+
+    static const constexpr uint32_t FLUSH_INTERVAL = 1000; // Milliseconds between two periodic write-backs
+
+private:
+
+    static const constexpr uint32_t MAX_SIZE_CLASSES = 4;
+    static const constexpr uint32_t MIN_HASH_TABLE_SIZE = 64;
+    static const constexpr uint32_t MAX_HASH_TABLE_SIZE = 65536;
+    static const constexpr uint32_t BYPASS_DIVISOR = 4; // Requests larger than a quarter of the cache bypass it
+    static const constexpr uint32_t DIRTY_LIMIT_DIVISOR = 2;
+    static const constexpr uint32_t MAX_WRITE_BACK_BATCH = 256;
+    static const constexpr uint32_t GENERATION_COUNTERS = 16;
+
+    struct Buffer {
+        StorageDevice *device;
+        uint32_t sector;
+        uint32_t size;
+        bool dirty;
+        bool writing; // Set while a copy of the buffer is being written back
+
+        Buffer *hashNext;
+        Buffer *lruPrevious;
+        Buffer *lruNext;
+        Buffer *dirtyPrevious;
+        Buffer *dirtyNext;
+
+        [[nodiscard]] uint8_t* getData();
+    };
+
+    struct SizeClass {
+        uint32_t sectorSize;
+        Kernel::SlabCache *slabCache;
+    };
+
+    /**
+     * Write back dirty sectors (of a single device, or all devices if device is nullptr).
+     * Sectors are written in batches, sorted by device and sector, so that consecutive sectors are written with a single operation.
+     * Writing stops at the first batch with a failed write, whose unwritten sectors are marked dirty again.
+     */
+    bool writeBack(StorageDevice *device);
+
+    /**
+     * Add sectors, that have just been read from the device, to the cache. Sectors, that are already cached, are skipped
+     * (they may have been written in the meantime). Nothing is added, if the device's generation has changed since
+     * the read has been started, because the data may have been overwritten or discarded while it was read.
+     */
+    void insertClean(StorageDevice &device, const uint8_t *data, uint32_t startSector, uint32_t sectorCount, uint32_t generation);
+
+    /**
+     * Write sectors directly to the device, discarding cached copies of them.
+     */
+    uint32_t writeThrough(StorageDevice &device, const uint8_t *buffer, uint32_t startSector, uint32_t sectorCount);
+
+    /**
+     * Remove all sectors in the given range from the cache (dirty sectors are discarded). The cache lock must be held.
+     */
+    void discard(StorageDevice &device, uint32_t startSector, uint32_t sectorCount, Buffer *&freeList);
+
+    /**
+     * Make room for a new buffer by evicting clean buffers, starting at the least recently used one. The cache lock must be held.
+     * Evicted buffers are added to the free list and must be returned to their slab cache after releasing the lock.
+     *
+     * @return Whether there is enough room for the buffer
+     */
+    bool reserve(uint32_t size, Buffer *&freeList);
+
+    Buffer* allocateBuffer(StorageDevice &device, uint32_t sector);
+
+    void freeBuffers(Buffer *freeList);
+
+    Buffer* find(StorageDevice &device, uint32_t sector);
+
+    void insert(Buffer &buffer);
+
+    void remove(Buffer &buffer);
+
+    void touch(Buffer &buffer);
+
+    void markDirty(Buffer &buffer);
+
+    void markClean(Buffer &buffer);
+
+    [[nodiscard]] uint32_t hash(const StorageDevice &device, uint32_t sector) const;
+
+    [[nodiscard]] uint32_t& getGeneration(const StorageDevice &device);
+
+    [[nodiscard]] Kernel::SlabCache& getSlabCache(uint32_t sectorSize);
+
+    const uint32_t capacity;
+    uint32_t usedBytes = 0;
+    uint32_t bufferCount = 0;
+    uint32_t dirtyBytes = 0;
+    uint32_t dirtyCount = 0;
+
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t writeBacks = 0;
+    uint32_t evictions = 0;
+
+    Buffer **hashTable;
+    uint32_t hashTableSize = MIN_HASH_TABLE_SIZE;
+    uint32_t hashShift = 0;
+
+    // Most recently used buffer at the head
+    Buffer *lruHead = nullptr;
+    Buffer *lruTail = nullptr;
+    Buffer *dirtyHead = nullptr;
+
+    SizeClass sizeClasses[MAX_SIZE_CLASSES]{};
+    uint32_t sizeClassCount = 0;
+
+    // Incremented whenever sectors of a device are written through or invalidated (shared by devices with the same hash)
+    uint32_t generations[GENERATION_COUNTERS]{};
+
+    Util::Async::Spinlock lock;
+    Util::Async::Mutex writeBackLock;
+};
+
+}
+
+#endif
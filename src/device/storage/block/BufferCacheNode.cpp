@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "BufferCacheNode.h"
+
+#include "device/storage/block/BufferCache.h"
+
+namespace Device::Storage {
+
+BufferCacheNode::BufferCacheNode(BufferCache &cache, const Util::String &name) : StringNode(name), cache(cache) {}
+
+Util::String BufferCacheNode::getString() {
+    auto statistics = cache.getStatistics();
+    auto accesses = statistics.hits + statistics.misses;
+    auto hitRate = accesses == 0 ? 0 : static_cast<uint32_t>((static_cast<uint64_t>(statistics.hits) * 100) / accesses);
+
+    return Util::String::format("Used:        %u / %u KiB\n", statistics.usedBytes / 1024, statistics.capacity / 1024)
+            + Util::String::format("Buffers:     %u (%u dirty)\n", statistics.bufferCount, statistics.dirtyBuffers)
+            + Util::String::format("Hits:        %u\n", statistics.hits)
+            + Util::String::format("Misses:      %u\n", statistics.misses)
+            + Util::String::format("Hit rate:    %u", hitRate) + "%\n"
+            + Util::String::format("Write backs: %u\n", statistics.writeBacks)
+            + Util::String::format("Evictions:   %u\n", statistics.evictions);
+}
+
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_BUFFERCACHENODE_H
+#define HHUOS_BUFFERCACHENODE_H
+
+#include "filesystem/memory/StringNode.h"
+#include "lib/util/base/String.h"
+
+namespace Device::Storage {
+class BufferCache;
+
+/**
+ * Shows the usage and hit rate of the buffer cache.
+ */
+class BufferCacheNode : public Filesystem::Memory::StringNode {
+
+public:
+    /**
+     * Constructor.
+     */
+    explicit BufferCacheNode(BufferCache &cache, const Util::String &name = "buffer_cache");
+
+    /**
+     * Copy Constructor.
+     */
+    BufferCacheNode(const BufferCacheNode &copy) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    BufferCacheNode& operator=(const BufferCacheNode &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~BufferCacheNode() override = default;
+
+    /**
+     * Overriding function from StringNode.
+     */
+    Util::String getString() override;
+
+private:
+
+    BufferCache &cache;
+};
+
+}
+
+#endif
@@ -59,7 +59,7 @@ FloppyDevice::FloppyDevice(FloppyController &controller, uint8_t driveNumber, Fl
     }
 
     auto &motorControlThread = Kernel::Thread::createKernelThread(Util::String::format("Floppy-%u-Motor-Controller", driveNumber), Kernel::Service::getService<Kernel::ProcessService>().getKernelProcess(), motorControlRunnable);
-    Kernel::Service::getService<Kernel::ProcessService>().getScheduler().ready(motorControlThread);
+    Kernel::Service::getService<Kernel::ProcessService>().ready(motorControlThread);
 }
 
 uint32_t FloppyDevice::getSectorSize() {
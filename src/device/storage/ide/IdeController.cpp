@@ -44,6 +44,12 @@
 #include "lib/util/collection/Iterator.h"
 #include "kernel/service/Service.h"
 #include "kernel/service/TimeService.h"
+#include "kernel/service/ProcessService.h"
+#include "kernel/process/Scheduler.h"
+#include "kernel/memory/MemoryLayout.h"
+#include "lib/util/async/Atomic.h"
+#include "lib/util/async/PeriodicRunnable.h"
+#include "kernel/process/Thread.h"
 
 namespace Kernel {
 struct InterruptFrame;
@@ -93,9 +99,16 @@ IdeController::IdeController(const PciDevice &pciDevice) {
             LOG_INFO("Channel [%u] is running in native mode", i);
             baseAddress = pciDevice.readDoubleWord(Pci::Register::BASE_ADDRESS_0) & 0xfffffffc;
             controlBaseAddress = pciDevice.readDoubleWord(Pci::Register::BASE_ADDRESS_1) & 0xfffffffc;
+            pciInterruptLine = pciDevice.getInterruptLine();
         }
 
         channels[i] = ChannelRegisters(baseAddress, controlBaseAddress, dmaBaseAddress + (i == 0 ? 0 : BUS_MASTER_CHANNEL_OFFSET));
+
+        if (supportsDma) {
+            auto &memoryService = Kernel::Service::getService<Kernel::MemoryService>();
+            channels[i].prdTable = static_cast<uint32_t*>(memoryService.mapIO(1));
+            channels[i].prdTablePhysical = reinterpret_cast<uint32_t>(memoryService.getPhysicalAddress(channels[i].prdTable));
+        }
     }
 }
 
@@ -428,13 +441,37 @@ void IdeController::plugin() {
     interruptService.allowHardwareInterrupt(Device::InterruptRequest::PRIMARY_ATA);
     interruptService.assignInterrupt(Kernel::InterruptVector::SECONDARY_ATA, *this);
     interruptService.allowHardwareInterrupt(Device::InterruptRequest::SECONDARY_ATA);
+
+    // Channels in native mode use the controller's PCI interrupt instead of the legacy ATA interrupts
+    if (pciInterruptLine != NO_INTERRUPT_LINE && pciInterruptLine != Device::InterruptRequest::PRIMARY_ATA && pciInterruptLine != Device::InterruptRequest::SECONDARY_ATA) {
+        interruptService.assignInterrupt(static_cast<Kernel::InterruptVector>(pciInterruptLine + 32), *this);
+        interruptService.allowHardwareInterrupt(static_cast<Device::InterruptRequest>(pciInterruptLine));
+    }
+
+    if (supportsDma) {
+        auto &processService = Kernel::Service::getService<Kernel::ProcessService>();
+        auto *watchdog = new Util::Async::PeriodicRunnable(Util::Time::Timestamp::ofMilliseconds(TIMEOUT_CHECK_INTERVAL), [](void *controller) {
+            static_cast<IdeController*>(controller)->checkDmaTimeouts();
+        }, this);
+
+        auto &watchdogThread = Kernel::Thread::createKernelThread("Ide-Watchdog", processService.getKernelProcess(), watchdog);
+        processService.ready(watchdogThread);
+    }
 }
 
 void IdeController::trigger([[maybe_unused]] const Kernel::InterruptFrame &frame, [[maybe_unused]] Kernel::InterruptVector slot) {
     if (slot == Kernel::InterruptVector::PRIMARY_ATA) {
         channels[0].receivedInterrupt = true;
+        completeDma(0);
     } else if (slot == Kernel::InterruptVector::SECONDARY_ATA) {
         channels[1].receivedInterrupt = true;
+        completeDma(1);
+    } else {
+        // Shared PCI interrupt of both native mode channels
+        for (uint8_t i = 0; i < CHANNELS_PER_CONTROLLER; i++) {
+            channels[i].receivedInterrupt = true;
+            completeDma(i);
+        }
     }
 }
 
@@ -511,19 +548,27 @@ uint16_t IdeController::performAtaIO(const DeviceInfo &info, TransferMode mode,
         return 0;
     }
 
+    auto useDma = supportsDma && info.supportsDma() && info.addressing != CHS;
     uint16_t maxSectorCount = info.addressing == LBA48 ? 0xffff : 0xff;
+    if (useDma && maxSectorCount > DMA_MAX_SIZE / info.sectorSize) {
+        maxSectorCount = DMA_MAX_SIZE / info.sectorSize;
+    }
+
     uint32_t processedSectors = 0;
     while (processedSectors < sectorCount) {
         uint32_t sectorsLeft = sectorCount - processedSectors;
         uint32_t start = startSector + processedSectors;
         uint32_t count = sectorsLeft > maxSectorCount ? maxSectorCount : sectorsLeft;
 
-        uint16_t sectors;
-        if (supportsDma && info.supportsDma()) {
-            // TODO: Reactivate DMA once issues on real hardware have been fixed
-            // sectors = performDmaAtaIO(info, mode, reinterpret_cast<uint16_t*>(buffer + (processedSectors * info.sectorSize)), start, count);
-            sectors = performProgrammedAtaIO(info, mode, reinterpret_cast<uint16_t *>(buffer + (processedSectors * info.sectorSize)), start, count);
-        } else {
+        uint16_t sectors = 0;
+        if (useDma) {
+            sectors = performDmaAtaIO(info, mode, reinterpret_cast<uint16_t*>(buffer + (processedSectors * info.sectorSize)), start, count);
+            if (sectors == 0) {
+                LOG_WARN("DMA transfer on channel [%u] failed -> Falling back to PIO", info.channel);
+            }
+        }
+
+        if (sectors == 0) {
             sectors = performProgrammedAtaIO(info, mode, reinterpret_cast<uint16_t *>(buffer + (processedSectors * info.sectorSize)), start, count);
         }
 
@@ -616,6 +661,7 @@ uint16_t IdeController::performProgrammedAtaIO(const DeviceInfo &info, TransferM
 
 uint16_t IdeController::performDmaAtaIO(const DeviceInfo &info, TransferMode mode, uint16_t *buffer, uint64_t startSector, uint16_t sectorCount) {
     auto &memoryService = Kernel::Service::getService<Kernel::MemoryService>();
+    auto &scheduler = Kernel::Service::getService<Kernel::ProcessService>().getScheduler();
     auto &registers = channels[info.channel];
 
     uint8_t command;
@@ -627,95 +673,193 @@ uint16_t IdeController::performDmaAtaIO(const DeviceInfo &info, TransferMode mod
         Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "IDE: Unsupported address type!");
     }
 
-    // Calculate the amount of pages needed for the operation
+    // Transfer directly from/to the buffer if possible, otherwise use a physically contiguous bounce buffer
     auto size = sectorCount * info.sectorSize;
-    auto pages = size / Util::PAGESIZE + (size % Util::PAGESIZE == 0 ? 0 : 1);
+    uint8_t *bounceBuffer = nullptr;
+    if (!fillPrdTable(registers, reinterpret_cast<const uint8_t*>(buffer), size)) {
+        auto pages = size / Util::PAGESIZE + (size % Util::PAGESIZE == 0 ? 0 : 1);
+        bounceBuffer = static_cast<uint8_t*>(memoryService.mapIO(pages));
+        fillPrdTable(registers, bounceBuffer, size);
+
+        if (mode == WRITE) {
+            auto source = Util::Address<uint32_t>(buffer);
+            auto target = Util::Address<uint32_t>(bounceBuffer);
+            target.copyRange(source, size);
+        }
+    }
 
-    // Each page corresponds to an 8-byte entry in the PRD
-    auto prdVirtual = reinterpret_cast<uint32_t*>(memoryService.mapIO(pages));
-    auto prdPhysical = reinterpret_cast<uint32_t>(memoryService.getPhysicalAddress(prdVirtual));
+    // Prepare bus master (the direction bit is set, if the bus master writes to memory)
+    registers.dmaCommand = mode == READ ? DmaCommand::DIRECTION : 0x00;
+    registers.dma.command.writeByte(registers.dmaCommand);
+    registers.dma.address.writeDoubleWord(registers.prdTablePhysical);
 
-    // Allocate memory for the DMA transfer
-    auto dmaMemoryVirtual = reinterpret_cast<uint32_t*>(memoryService.mapIO(pages));
-    auto dmaMemoryPhysical = reinterpret_cast<uint32_t>(memoryService.getPhysicalAddress(dmaMemoryVirtual));
+    // Clear interrupt and error bits (write-1-to-clear, the drive capability bits must be preserved)
+    registers.dma.status.writeByte(registers.dma.status.readByte() | DmaStatus::DMA_ERROR | DmaStatus::INTERRUPT);
 
-    if (mode == WRITE) {
-        auto source = Util::Address<uint32_t>(buffer);
-        auto target = Util::Address<uint32_t>(dmaMemoryVirtual);
-        target.copyRange(source, size);
-    }
+    // Select drive and sector
+    prepareAtaIO(info, startSector, sectorCount);
 
-    // Fill PRD
-    uint32_t i;
-    for (i = 0; i < (pages - 1); i++) {
-        prdVirtual[2 * i] = dmaMemoryPhysical + (Util::PAGESIZE * i);
-        prdVirtual[(2 * i) + 1] = Util::PAGESIZE;
-    }
+    // Threads can only be blocked, once the scheduler is running (partitions are scanned before)
+    auto interruptDriven = scheduler.isInitialized();
+    registers.dmaThread = interruptDriven ? &scheduler.getCurrentThread() : nullptr;
+    registers.dmaDeadline = Util::Time::getSystemTime().toMilliseconds() + DMA_TIMEOUT;
+    Util::Async::Atomic<uint32_t>(registers.dmaWaitState).set(Kernel::Scheduler::INTERRUPT_PENDING);
+    Util::Async::Atomic<uint32_t>(registers.dmaActive).set(true);
 
-    // Set last PRD entry wit EOT bit
-    prdVirtual[2 * i] = dmaMemoryPhysical + (Util::PAGESIZE * i);
-    prdVirtual[(2 * i) + 1] = (size % Util::PAGESIZE) | PRD_END_OF_TRANSMISSION;
+    // Send command and start DMA transfer
+    registers.command.command.writeByte(command);
+    registers.dma.command.writeByte(registers.dmaCommand | DmaCommand::ENABLE);
 
-    // Prepare DMA transfer to physical address
-    registers.dma.address.writeDoubleWord(prdPhysical);
+    // Wait for the drive's interrupt (if it gets lost, the watchdog aborts the transfer after its deadline)
+    if (interruptDriven) {
+        scheduler.blockForInterrupt(registers.dmaWaitState);
+    } else {
+        auto waitStateWrapper = Util::Async::Atomic<uint32_t>(registers.dmaWaitState);
+        while (waitStateWrapper.get() != Kernel::Scheduler::INTERRUPT_SIGNALED && !completeDma(info.channel) && !abortTimedOutDma(info.channel)) {
+            Util::Async::Thread::yield();
+        }
+    }
 
-    // Set DMA direction
-    registers.dma.command.writeByte(mode == READ ? 0x00 : DmaCommand::DIRECTION);
+    auto success = !(registers.dmaStatus & DmaStatus::DMA_ERROR) && !(registers.ataStatus & (BUSY | ERROR));
+    if (!success && (registers.control.alternateStatus.readByte() & BUSY)) {
+        // The drive is still busy with the failed command and would ignore the PIO fallback
+        resetChannel(info.channel);
+    }
+    if (bounceBuffer != nullptr) {
+        if (success && mode == READ) {
+            auto source = Util::Address<uint32_t>(bounceBuffer);
+            auto target = Util::Address<uint32_t>(buffer);
+            target.copyRange(source, size);
+        }
 
-    // Clear interrupt and error bits
-    registers.dma.status.writeByte(~(DmaStatus::DMA_ERROR | DmaStatus::INTERRUPT));
+        delete bounceBuffer;
+    }
 
-    // Select drive and sector
-    prepareAtaIO(info, startSector, sectorCount);
+    return success ? sectorCount : 0;
+}
 
-    // Send command
-    registers.command.command.writeByte(command);
-    if (!waitStatus(registers.control.alternateStatus, DATA_REQUEST)) {
-        delete prdVirtual;
-        delete dmaMemoryVirtual;
-        return 0;
+bool IdeController::fillPrdTable(ChannelRegisters &registers, const uint8_t *buffer, uint32_t size) {
+    auto &memoryService = Kernel::Service::getService<Kernel::MemoryService>();
+    auto startAddress = reinterpret_cast<uint32_t>(buffer);
+
+    // Bus masters transfer whole words
+    if (startAddress + size > Kernel::MemoryLayout::KERNEL_AREA.endAddress || (startAddress & 0x01) || (size & 0x01)) {
+        return false;
     }
 
-    // Start DMA transfer
-    registers.dma.command.writeByte(DmaCommand::ENABLE);
+    uint32_t entryCount = 0;
+    uint32_t offset = 0;
+    while (offset < size) {
+        auto *physicalAddress = memoryService.getPhysicalAddress(const_cast<uint8_t*>(buffer + offset));
+        if (physicalAddress == nullptr) {
+            return false;
+        }
 
-    registers.receivedInterrupt = false;
-    uint32_t timeout = Util::Time::getSystemTime().toMilliseconds() + DMA_TIMEOUT;
-    do {
-        if (registers.receivedInterrupt) {
-            // Stop DMA and check flags
-            registers.dma.command.writeByte(0x00);
-
-            auto dmaStatus = registers.dma.status.readByte();
-            if ((dmaStatus & DmaStatus::INTERRUPT) == DmaStatus::INTERRUPT) {
-                // An interrupt has been fired -> Check if bus master is still enabled
-                if ((dmaStatus & DmaStatus::BUS_MASTER_ACTIVE) == DmaStatus::BUS_MASTER_ACTIVE) {
-                    // Continue DMA transfer
-                    registers.receivedInterrupt = false;
-                    registers.dma.command.writeByte(DmaCommand::ENABLE);
-                } else {
-                    // DMA transfer is finished
-                    break;
-                }
+        // Each page may be located anywhere in physical memory
+        auto physical = reinterpret_cast<uint32_t>(physicalAddress);
+        auto pageRemaining = Util::PAGESIZE - ((startAddress + offset) % Util::PAGESIZE);
+        auto length = size - offset < pageRemaining ? size - offset : pageRemaining;
+
+        // Merge physically contiguous pages, as long as the entry does not cross a 64 KiB boundary
+        auto *lastEntry = entryCount > 0 ? &registers.prdTable[2 * (entryCount - 1)] : nullptr;
+        if (lastEntry != nullptr && lastEntry[0] + lastEntry[1] == physical && lastEntry[0] / PRD_BOUNDARY == (physical + length - 1) / PRD_BOUNDARY) {
+            lastEntry[1] += length;
+        } else {
+            if (entryCount == PRD_MAX_ENTRIES) {
+                return false;
             }
+
+            registers.prdTable[2 * entryCount] = physical;
+            registers.prdTable[2 * entryCount + 1] = length;
+            entryCount++;
         }
-    } while (Util::Time::getSystemTime().toMilliseconds() < timeout);
 
-    if (Util::Time::getSystemTime().toMilliseconds() >= timeout) {
-        delete prdVirtual;
-        delete dmaMemoryVirtual;
-        return 0;
+        offset += length;
+    }
+
+    // A byte count of 0 stands for 64 KiB and the last entry is marked with the EOT bit
+    for (uint32_t i = 0; i < entryCount; i++) {
+        registers.prdTable[2 * i + 1] &= 0xffff;
+    }
+    registers.prdTable[2 * (entryCount - 1) + 1] |= PRD_END_OF_TRANSMISSION;
+
+    return true;
+}
+
+bool IdeController::completeDma(uint8_t channel) {
+    auto &registers = channels[channel];
+    auto activeWrapper = Util::Async::Atomic<uint32_t>(registers.dmaActive);
+    if (!activeWrapper.get()) {
+        return false;
+    }
+
+    // The interrupt may also have been raised by the other drive or a PIO transfer
+    auto dmaStatus = registers.dma.status.readByte();
+    if (!(dmaStatus & (DmaStatus::INTERRUPT | DmaStatus::DMA_ERROR)) || !activeWrapper.compareAndSet(true, false)) {
+        return false;
+    }
+
+    // Stop bus master and acknowledge the drive's interrupt by reading its status
+    registers.dma.command.writeByte(registers.dmaCommand);
+    registers.ataStatus = registers.command.status.readByte();
+    registers.dmaStatus = dmaStatus;
+    registers.dma.status.writeByte(dmaStatus | DmaStatus::DMA_ERROR | DmaStatus::INTERRUPT);
+
+    signalDmaCompletion(registers);
+    return true;
+}
+
+bool IdeController::abortTimedOutDma(uint8_t channel) {
+    auto &registers = channels[channel];
+    auto activeWrapper = Util::Async::Atomic<uint32_t>(registers.dmaActive);
+
+    // The transfer may complete concurrently, so it is only aborted if it is still active when resetting the flag
+    if (Util::Time::getSystemTime().toMilliseconds() < registers.dmaDeadline || !activeWrapper.compareAndSet(true, false)) {
+        return false;
+    }
+
+    LOG_WARN("DMA transfer on channel [%u] timed out", channel);
+
+    // Stop bus master
+    registers.dma.command.writeByte(registers.dmaCommand);
+    registers.ataStatus = registers.control.alternateStatus.readByte();
+    registers.dmaStatus = DmaStatus::DMA_ERROR;
+
+    signalDmaCompletion(registers);
+    return true;
+}
+
+void IdeController::checkDmaTimeouts() {
+    for (uint8_t i = 0; i < CHANNELS_PER_CONTROLLER; i++) {
+        abortTimedOutDma(i);
     }
+}
 
-    if (mode == READ) {
-        auto source = Util::Address<uint32_t>(dmaMemoryVirtual);
-        auto target = Util::Address<uint32_t>(buffer);
-        target.copyRange(source, size);
+void IdeController::signalDmaCompletion(ChannelRegisters &registers) {
+    if (registers.dmaThread == nullptr) {
+        // The issuing thread is polling the channel
+        Util::Async::Atomic<uint32_t>(registers.dmaWaitState).set(Kernel::Scheduler::INTERRUPT_SIGNALED);
+    } else {
+        Kernel::Scheduler::signalFromInterrupt(registers.dmaWaitState, *registers.dmaThread);
     }
+}
 
-    delete prdVirtual;
-    delete dmaMemoryVirtual;
-    return sectorCount;
+void IdeController::resetChannel(uint8_t channel) {
+    auto &registers = channels[channel];
+    uint8_t deviceControl = registers.interruptsDisabled ? 0x02 : 0x00;
+
+    // Set and clear the software reset bit, keeping the interrupt state of the channel
+    registers.control.deviceControl.writeByte(deviceControl | 0x04);
+    Util::Async::Thread::sleep(Util::Time::Timestamp::ofMilliseconds(5));
+    registers.control.deviceControl.writeByte(deviceControl);
+    Util::Async::Thread::sleep(Util::Time::Timestamp::ofMilliseconds(5));
+
+    // The reset selects the master drive, so the next access has to select its drive again
+    registers.lastDeviceControl = UINT8_MAX;
+
+    if (!waitBusy(registers.command.status)) {
+        LOG_ERROR("Failed to reset channel [%u]", channel);
+    }
 }
 
 void IdeController::prepareAtapiIO(uint8_t channel, uint16_t len) {
@@ -29,10 +29,12 @@
 #include "kernel/interrupt/InterruptHandler.h"
 #include "device/cpu/IoPort.h"
 #include "lib/util/async/Spinlock.h"
+#include "lib/util/base/Constants.h"
 
 namespace Kernel {
 enum InterruptVector : uint8_t;
 struct InterruptFrame;
+class Thread;
 }  // namespace Kernel
 
 namespace Device {
@@ -77,6 +79,12 @@ public:
 
     static void initializeAvailableControllers();
 
+    /**
+     * Abort all DMA transfers, that have been running for longer than DMA_TIMEOUT.
+     * This is called periodically by the controller's watchdog thread, so that threads never wait forever for a lost interrupt.
+     */
+    void checkDmaTimeouts();
+
     void plugin() override;
 
     void trigger(const Kernel::InterruptFrame &frame, Kernel::InterruptVector slot) override;
@@ -97,7 +105,12 @@ private:
     static const constexpr uint32_t BUS_MASTER_CHANNEL_OFFSET = 0x08;
     static const constexpr uint32_t WAIT_ON_STATUS_TIMEOUT = 4095;
     static const constexpr uint32_t DMA_TIMEOUT = 30000;
+    static const constexpr uint32_t TIMEOUT_CHECK_INTERVAL = 1000;
     static const constexpr uint32_t PRD_END_OF_TRANSMISSION = 1 << 31;
+    static const constexpr uint32_t PRD_MAX_ENTRIES = Util::PAGESIZE / (2 * sizeof(uint32_t));
+    static const constexpr uint32_t PRD_BOUNDARY = 0x10000;
+    static const constexpr uint32_t DMA_MAX_SIZE = 256 * Util::PAGESIZE;
+    static const constexpr uint8_t NO_INTERRUPT_LINE = 0xff;
 
     enum AddressType : uint8_t {
         CHS = 0x00,
@@ -273,6 +286,15 @@ private:
         ChannelRegisters(uint16_t commandBaseAddress, uint16_t controlBaseAddress, uint16_t dmaBaseAddress);
 
         bool receivedInterrupt = false;         // Currently received interrupt
+        uint32_t *prdTable = nullptr;           // Physical region descriptor table for bus master DMA (one page)
+        uint32_t prdTablePhysical = 0;          // Physical address of the PRD table
+        uint32_t dmaActive = false;             // Set while a DMA transfer is in progress (only accessed atomically)
+        uint32_t dmaWaitState = 0;              // Kernel::Scheduler::InterruptWaitState (only accessed atomically)
+        uint32_t dmaDeadline = 0;               // System time in milliseconds, after which the DMA transfer is aborted
+        Kernel::Thread *dmaThread = nullptr;    // Thread waiting for the DMA transfer (nullptr, if it is polling)
+        uint8_t dmaCommand = 0;                 // Bus master command (direction) of the current DMA transfer
+        uint8_t dmaStatus = 0;                  // Bus master status at the end of the last DMA transfer
+        uint8_t ataStatus = 0;                  // Drive status at the end of the last DMA transfer
         uint8_t lastDeviceControl = UINT8_MAX;  // Saves current state of deviceControlRegister
         bool interruptsDisabled = false;        // nIEN (No Interrupt);
         DriveType driveType[2]{};               // Initially found drive types;
@@ -307,6 +329,36 @@ private:
 
     uint16_t performDmaAtaIO(const DeviceInfo &info, TransferMode mode, uint16_t *buffer, uint64_t startSector, uint16_t sectorCount);
 
+    /**
+     * Fill a channel's PRD table with the physical regions of a buffer (scatter-gather).
+     * Only kernel buffers are transferred directly, since user space pages may be shared copy-on-write or not present at all.
+     *
+     * @return false, if the buffer cannot be used for DMA (a bounce buffer is needed in this case)
+     */
+    bool fillPrdTable(ChannelRegisters &registers, const uint8_t *buffer, uint32_t size);
+
+    /**
+     * Finish the DMA transfer of a channel, if the bus master has signaled its completion.
+     * This is called by the interrupt handler and by threads polling the channel and acquires no locks.
+     *
+     * @return true, if a transfer has been finished
+     */
+    bool completeDma(uint8_t channel);
+
+    /**
+     * Stop the bus master of a channel and fail its DMA transfer, if the transfer's deadline has passed.
+     *
+     * @return true, if a transfer has been aborted
+     */
+    bool abortTimedOutDma(uint8_t channel);
+
+    void signalDmaCompletion(ChannelRegisters &registers);
+
+    /**
+     * Reset both drives of a channel via the software reset bit (e.g. after an aborted DMA transfer).
+     */
+    void resetChannel(uint8_t channel);
+
     void prepareAtapiIO(uint8_t channel, uint16_t len);
 
     uint16_t performProgrammedAtapiIO(const DeviceInfo &info, TransferMode mode, uint16_t *buffer, uint64_t startSector, uint16_t sectorCount);
@@ -320,6 +372,7 @@ private:
     ChannelRegisters channels[CHANNELS_PER_CONTROLLER]{};
     Util::Async::Spinlock ioLock;
     bool supportsDma = false;
+    uint8_t pciInterruptLine = NO_INTERRUPT_LINE; // Only used by channels running in native mode
 };
 
 }
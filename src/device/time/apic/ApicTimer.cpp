@@ -23,6 +23,7 @@
 #include "device/interrupt/apic/LocalApic.h"
 #include "kernel/service/InterruptService.h"
 #include "kernel/interrupt/InterruptVector.h"
+#include "kernel/interrupt/InterruptFrame.h"
 #include "kernel/log/Log.h"
 #include "kernel/service/Service.h"
 #include "kernel/service/ProcessService.h"
@@ -37,8 +38,9 @@ namespace Device {
 
 uint32_t ApicTimer::BASE_FREQUENCY = 0;
 
-ApicTimer::ApicTimer(Util::Time::Timestamp timerInterval, Util::Time::Timestamp yieldInterval) : cpuId(LocalApic::getId()), timerInterval(timerInterval), yieldInterval(yieldInterval) {
-    auto counter = (BASE_FREQUENCY / 1000) * timerInterval.toMilliseconds();
+ApicTimer::ApicTimer(Util::Time::Timestamp timerInterval, Util::Time::Timestamp yieldInterval) : cpuId(LocalApic::getId()), timerInterval(timerInterval), yieldInterval(yieldInterval),
+        periodicCounter((BASE_FREQUENCY / 1000) * timerInterval.toMilliseconds()) {
+    auto counter = periodicCounter;
     LOG_INFO("Setting APIC timer [%u] interval to [%ums] (Counter: [%u])", cpuId, static_cast<uint32_t>(timerInterval.toMilliseconds()), static_cast<uint32_t>(counter));
 
     // Recommended order: Divide -> LVT -> Initial Count (OSDev)
@@ -52,31 +54,33 @@ ApicTimer::ApicTimer(Util::Time::Timestamp timerInterval, Util::Time::Timestamp
 void ApicTimer::plugin() {
     auto &interruptService = Kernel::Service::getService<Kernel::InterruptService>();
     interruptService.assignInterrupt(Kernel::InterruptVector::APICTIMER, *this);
+    interruptService.assignInterrupt(Kernel::InterruptVector::WAKEUP, *this);
     LocalApic::allow(LocalApic::TIMER);
 }
 
-void ApicTimer::trigger([[maybe_unused]] const Kernel::InterruptFrame &frame, [[maybe_unused]] Kernel::InterruptVector slot) {
+void ApicTimer::trigger(const Kernel::InterruptFrame &frame, Kernel::InterruptVector slot) {
     if (cpuId != LocalApic::getId()) {
         // Every core's timer uses the same (this) handler, but it exists once per core (each core has its own ApicTimer instance).
         // All handlers are registered to the same interrupt vector, we only want to reach the instance belonging to this core.
         return;
     }
 
-    // Increase the "core-local" time, the system time is still managed by the PIT/HPET.
-    time += timerInterval;
-
-    if (cpuId != 0) {
-        // Currently there is only one scheduler, it should get triggered only by the BSP.
-        // Otherwise, the scheduler would be triggered n-times faster than intended, where n
-        // is the CPU count.
+    if (oneShot || slot == Kernel::InterruptVector::WAKEUP) {
+        // This core has been halted by its idle thread and is woken up, either because its sleep deadline
+        // has been reached, or because another core readied a thread on its scheduler -> Resume preemption.
+        setPeriodic();
         return;
     }
 
+    // Increase the "core-local" time, the system time is still managed by the PIT/HPET.
+    time += timerInterval;
+
     timeSinceLastYield += timerInterval;
     if (timeSinceLastYield >= yieldInterval) {
         timeSinceLastYield.reset();
-        // Currently there is only one main scheduler, for SMP systems this should yield the core scheduler or something similar.
-        Kernel::Service::getService<Kernel::ProcessService>().getScheduler().yield(true);
+        // Every core has its own scheduler, so this only preempts the thread running on this core.
+        // Threads preempted in user mode (CPL 3) may be stolen by other cores.
+        Kernel::Service::getService<Kernel::ProcessService>().getScheduler().yield(true, (frame.codeSegment & 0x3) == 0x3);
     }
 }
 
@@ -105,6 +109,34 @@ void ApicTimer::calibrate() {
     LOG_INFO("Apic Timer frequency: [%u MHz]", BASE_FREQUENCY / 1000000);
 }
 
+void ApicTimer::setOneShot(const Util::Time::Timestamp &timeout) {
+    auto counter = (static_cast<uint64_t>(BASE_FREQUENCY) * timeout.toMicroseconds()) / 1000000;
+    oneShotCounter = counter > UINT32_MAX ? UINT32_MAX : counter == 0 ? 1 : static_cast<uint32_t>(counter);
+    oneShot = true;
+
+    LocalApic::LocalVectorTableEntry lvtEntry = LocalApic::readLocalVectorTable(LocalApic::TIMER);
+    lvtEntry.timerMode = LocalApic::LocalVectorTableEntry::TimerMode::ONESHOT;
+    LocalApic::writeLocalVectorTable(LocalApic::TIMER, lvtEntry);
+    LocalApic::writeDoubleWord(LocalApic::TIMER_INITIAL, oneShotCounter); // Writing restarts the timer
+}
+
+void ApicTimer::setPeriodic() {
+    if (!oneShot) {
+        return;
+    }
+
+    // The current counter is 0, if the timeout has expired
+    auto elapsedTicks = oneShotCounter - LocalApic::readDoubleWord(LocalApic::TIMER_CURRENT);
+    time += Util::Time::Timestamp::ofMicroseconds((static_cast<uint64_t>(elapsedTicks) * 1000000) / BASE_FREQUENCY);
+    timeSinceLastYield.reset();
+    oneShot = false;
+
+    LocalApic::LocalVectorTableEntry lvtEntry = LocalApic::readLocalVectorTable(LocalApic::TIMER);
+    lvtEntry.timerMode = LocalApic::LocalVectorTableEntry::TimerMode::PERIODIC;
+    LocalApic::writeLocalVectorTable(LocalApic::TIMER, lvtEntry);
+    LocalApic::writeDoubleWord(LocalApic::TIMER_INITIAL, periodicCounter);
+}
+
 uint8_t ApicTimer::getCpuId() const {
     return cpuId;
 }
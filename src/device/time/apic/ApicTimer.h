@@ -37,11 +37,14 @@ namespace Device {
 /**
  * This class implements the APIC timer device.
  *
- * Its purpose is to handlePageFault per-core scheduler preemption in SMP systems, although it is also used
+ * Its purpose is to handle per-core scheduler preemption in SMP systems, although it is also used
  * in single core systems. It is not used for system-time keeping, this is still done by the PIT.
  *
  * It receives its tick interval in milliseconds, which should be precise enough for scheduling.
  * If a more precise interval is required, the timer divider might need adjustment.
+ *
+ * Idle cores switch their timer to one-shot mode, so that they are only woken up at the next sleep deadline
+ * instead of on every tick. Any interrupt on the timer (or wakeup) vector switches it back to periodic mode.
  */
 class ApicTimer : public Kernel::InterruptHandler, public TimeProvider {
 
@@ -112,6 +115,22 @@ public:
      */
     static void calibrate();
 
+    /**
+     * Switch the timer to one-shot mode, so that it fires only once after the given timeout.
+     * The timeout is capped to the longest interval, the 32-bit counter register can represent.
+     * This must be called on the CPU, the timer belongs to.
+     *
+     * @param timeout The time after which the timer fires
+     */
+    void setOneShot(const Util::Time::Timestamp &timeout);
+
+    /**
+     * Switch the timer back to periodic mode and account for the time spent in one-shot mode.
+     * Has no effect, if the timer is already in periodic mode.
+     * This must be called on the CPU, the timer belongs to.
+     */
+    void setPeriodic();
+
     [[nodiscard]] uint8_t getCpuId() const;
 
 private:
@@ -119,6 +138,9 @@ private:
     Util::Time::Timestamp timerInterval; // The interrupt trigger interval in milliseconds.
     Util::Time::Timestamp yieldInterval; // The preemption trigger interval in milliseconds.
     Util::Time::Timestamp timeSinceLastYield;
+    uint32_t periodicCounter;   // The initial counter for the periodic interval.
+    uint32_t oneShotCounter = 0; // The initial counter of the last one-shot timeout.
+    bool oneShot = false;
 
     Util::Time::Timestamp time{}; // The "core-local" timestamp.
 
@@ -214,7 +214,7 @@ Util::Time::Date Rtc::readDate() const {
 
 void Rtc::alarm() {
     auto &alarmThread = Kernel::Thread::createKernelThread("Rtc-Alarm", Kernel::Service::getService<Kernel::ProcessService>().getKernelProcess(), new AlarmRunnable());
-    Kernel::Service::getService<Kernel::ProcessService>().getScheduler().ready(alarmThread);
+    Kernel::Service::getService<Kernel::ProcessService>().ready(alarmThread);
 }
 
 void Rtc::setInterruptRate(const Util::Time::Timestamp &interval) {
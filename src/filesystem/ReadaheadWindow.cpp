@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "ReadaheadWindow.h"
+
+#include "device/storage/StorageDevice.h"
+#include "device/storage/block/BlockRequest.h"
+#include "kernel/service/Service.h"
+#include "kernel/service/StorageService.h"
+#include "lib/interface.h"
+
+namespace Filesystem {
+
+ReadaheadWindow::Range ReadaheadWindow::update(uint64_t position, uint64_t length, uint64_t fileLength) {
+    if (position != nextPosition) {
+        // Random access -> Start over
+        nextPosition = position + length;
+        readaheadEnd = 0;
+        windowSize = 0;
+        return Range{0, 0};
+    }
+
+    nextPosition = position + length;
+    if (readaheadEnd < nextPosition) {
+        // The reader has overtaken the readahead
+        readaheadEnd = nextPosition;
+    }
+
+    // Wait until half of the data read ahead has been consumed
+    if (windowSize > 0 && readaheadEnd - nextPosition >= windowSize / 2) {
+        return Range{0, 0};
+    }
+
+    windowSize = windowSize == 0 ? INITIAL_WINDOW_SIZE : windowSize * 2;
+    if (windowSize > MAX_WINDOW_SIZE) {
+        windowSize = MAX_WINDOW_SIZE;
+    }
+
+    auto end = nextPosition + windowSize;
+    if (end > fileLength) {
+        end = fileLength;
+    }
+
+    if (readaheadEnd >= end) {
+        return Range{0, 0};
+    }
+
+    auto range = Range{readaheadEnd, end};
+    readaheadEnd = end;
+
+    return range;
+}
+
+void ReadaheadWindow::prefetch(Device::Storage::StorageDevice &device, uint32_t startSector, uint32_t sectorCount) {
+    if (sectorCount == 0 || !isSchedulerInitialized() || Kernel::Service::getService<Kernel::StorageService>().getBufferCache() == nullptr) {
+        return;
+    }
+
+    // Sector numbers come from filesystem metadata, which might be corrupted
+    if (startSector + static_cast<uint64_t>(sectorCount) > device.getSectorCount()) {
+        return;
+    }
+
+    // Split large ranges, so that foreground requests do not have to wait for a single huge transfer
+    auto sectorSize = device.getSectorSize();
+    auto maxSectors = MAX_REQUEST_SIZE / sectorSize > 0 ? MAX_REQUEST_SIZE / sectorSize : 1;
+    while (sectorCount > 0) {
+        auto count = sectorCount < maxSectors ? sectorCount : maxSectors;
+        auto *request = new Device::Storage::BlockRequest(Device::Storage::BlockRequest::READ, new uint8_t[count * sectorSize], startSector, count);
+        request->detach();
+        device.submit(*request);
+
+        startSector += count;
+        sectorCount -= count;
+    }
+}
+
+}
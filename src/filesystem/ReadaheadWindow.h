@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_READAHEADWINDOW_H
+#define HHUOS_READAHEADWINDOW_H
+
+#include <stdint.h>
+
+namespace Device {
+namespace Storage {
+class StorageDevice;
+}  // namespace Storage
+}  // namespace Device
+
+namespace Filesystem {
+
+/**
+ * Sequential readahead for an open file (each node instance represents an open file).
+ * After each read, the window decides which part of the file should be read ahead. Filesystem drivers translate this
+ * range into sectors and call prefetch(), which reads them into the buffer cache asynchronously. Following reads of the
+ * file are then served from memory, while the device already transfers the next part of the file.
+ *
+ * Reads continuing where the previous one stopped are considered sequential. The window starts small and doubles
+ * each time the reader has consumed half of the data read ahead, up to a maximum size. A non-sequential read resets it,
+ * so that random access does not cause unnecessary reads.
+ */
+class ReadaheadWindow {
+
+public:
+
+    struct Range {
+        uint64_t start;
+        uint64_t end;
+
+        [[nodiscard]] bool isEmpty() const {
+            return start >= end;
+        }
+    };
+
+    /**
+     * Default Constructor.
+     */
+    ReadaheadWindow() = default;
+
+    /**
+     * Copy Constructor.
+     */
+    ReadaheadWindow(const ReadaheadWindow &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    ReadaheadWindow &operator=(const ReadaheadWindow &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~ReadaheadWindow() = default;
+
+    /**
+     * Update the window after a read of the file.
+     *
+     * @param position The file offset, at which the read started
+     * @param length The amount of bytes, that have been read
+     * @param fileLength The length of the file
+     * @return The range of the file, that should be read ahead now (may be empty)
+     */
+    Range update(uint64_t position, uint64_t length, uint64_t fileLength);
+
+    /**
+     * Read sectors into the buffer cache without waiting for them.
+     * Nothing is read, if there is no buffer cache to hold the data or the scheduler is not running yet.
+     */
+    static void prefetch(Device::Storage::StorageDevice &device, uint32_t startSector, uint32_t sectorCount);
+
+    static const constexpr uint32_t INITIAL_WINDOW_SIZE = 16 * 1024;
+    static const constexpr uint32_t MAX_WINDOW_SIZE = 256 * 1024;
+    static const constexpr uint32_t MAX_REQUEST_SIZE = 64 * 1024;
+
+private:
+
+    uint64_t nextPosition = 0;
+    uint64_t readaheadEnd = 0;
+    uint32_t windowSize = 0;
+};
+
+}
+
+#endif
@@ -18,12 +18,13 @@
 #include "FatDirectory.h"
 
 #include "lib/util/collection/ArrayList.h"
+#include "filesystem/fat/FatDriver.h"
 #include "filesystem/fat/FatNode.h"
 #include "lib/util/base/String.h"
 
 namespace Filesystem::Fat {
 
-FatDirectory::FatDirectory(DIR *dir, FILINFO *info) : FatNode(info), directory(dir) {}
+FatDirectory::FatDirectory(DIR *dir, FILINFO *info, FatDriver &driver) : FatNode(info), directory(dir), driver(driver) {}
 
 FatDirectory::~FatDirectory() {
     delete directory;
@@ -41,6 +42,7 @@ Util::Array<Util::String> FatDirectory::getChildren() {
     auto children = Util::ArrayList<Util::String>();
     auto *childInfo = new FILINFO{};
 
+    driver.getLock().acquire();
     while (true) {
         auto result = f_readdir(directory, childInfo);
         if (result != FR_OK || childInfo->fname[0] == 0) {
@@ -51,6 +53,8 @@ Util::Array<Util::String> FatDirectory::getChildren() {
     }
 
     f_rewinddir(directory);
+    driver.getLock().release();
+
     delete childInfo;
     return children.toArray();
 }
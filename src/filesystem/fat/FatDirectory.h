@@ -32,6 +32,7 @@ class String;
 }  // namespace Util
 
 namespace Filesystem::Fat {
+class FatDriver;
 
 class FatDirectory : public FatNode {
 
@@ -39,7 +40,7 @@ public:
     /**
      * Constructor.
      */
-    FatDirectory(DIR *dir, FILINFO *info);
+    FatDirectory(DIR *dir, FILINFO *info, FatDriver &driver);
 
     /**
      * Copy Constructor.
@@ -79,6 +80,7 @@ public:
 private:
 
     DIR *directory;
+    FatDriver &driver;
 };
 
 }
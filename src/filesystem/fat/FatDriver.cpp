@@ -18,10 +18,18 @@
 #include "filesystem/fat/ff/source/ff.h"
 #include "FatNode.h"
 #include "FatDriver.h"
+#include "FatFile.h"
+#include "device/storage/StorageDevice.h"
 #include "filesystem/fat/ff/source/ffconf.h"
+#include "kernel/process/Thread.h"
+#include "kernel/service/ProcessService.h"
+#include "kernel/service/Service.h"
 #include "lib/util/base/Exception.h"
 #include "lib/util/collection/Array.h"
 #include "lib/util/async/AtomicBitmap.h"
+#include "lib/util/async/Thread.h"
+#include "lib/util/async/PeriodicRunnable.h"
+#include "lib/util/time/Timestamp.h"
 
 namespace Device {
 namespace Storage {
@@ -36,10 +44,42 @@ namespace Filesystem::Fat {
 
 Util::Async::AtomicBitmap FatDriver::volumeIdAllocator(FF_VOLUMES);
 Util::Array<Device::Storage::StorageDevice*> FatDriver::deviceMap(FF_VOLUMES);
+bool FatDriver::writeBackDefault = true;
+bool FatDriver::flusherStarted = false;
+Util::ArrayList<FatDriver*> FatDriver::mountedVolumes;
+Util::Async::Mutex FatDriver::mountedVolumesLock;
+Util::Async::Spinlock FatDriver::detachLock;
 
 FatDriver::~FatDriver() {
+    // Make sure, that the flusher thread does not access the volume anymore
+    mountedVolumesLock.acquire();
+    mountedVolumes.remove(this);
+    mountedVolumesLock.release();
+
+    // Files may still be open -> Sync them and prevent them from accessing the volume after it has been unmounted
+    lock.acquire();
+    for (auto *file : openFiles) {
+        file->sync();
+        file->detach();
+    }
+    openFiles.clear();
+
     f_mount(nullptr, static_cast<const char*>(Util::String::format("%u:", volumeId)), 1);
     volumeIdAllocator.unset(volumeId);
+    lock.release();
+
+    // Files, that have looked up the driver before being detached, may still be waiting for the volume lock
+    detachLock.acquire();
+    while (fileUsers > 0) {
+        detachLock.release();
+        Util::Async::Thread::yield();
+        detachLock.acquire();
+    }
+    detachLock.release();
+
+    if (device != nullptr) {
+        device->flush();
+    }
 }
 
 Device::Storage::StorageDevice& FatDriver::getStorageDevice(uint8_t volumeId) {
@@ -53,9 +93,22 @@ bool FatDriver::mount(Device::Storage::StorageDevice &device) {
     }
 
     deviceMap[volumeId] = &device;
+    FatDriver::device = &device;
 
+    lock.acquire();
     auto result = f_mount(&fatVolume, static_cast<const char*>(Util::String::format("%u:", volumeId)), 1);
-    return result == FR_OK;
+    lock.release();
+
+    if (result != FR_OK) {
+        return false;
+    }
+
+    writeBack = writeBackDefault;
+    if (writeBack) {
+        registerVolume();
+    }
+
+    return true;
 }
 
 bool FatDriver::createFilesystem(Device::Storage::StorageDevice &device) {
@@ -65,6 +118,7 @@ bool FatDriver::createFilesystem(Device::Storage::StorageDevice &device) {
     }
 
     deviceMap[volumeId] = &device;
+    FatDriver::device = &device;
     auto *work = new uint8_t[FF_MAX_SS];
     MKFS_PARM parameters{
         FM_ANY | FM_SFD,
@@ -74,19 +128,29 @@ bool FatDriver::createFilesystem(Device::Storage::StorageDevice &device) {
         0
     };
 
+    lock.acquire();
     auto result = f_mkfs(static_cast<const char*>(Util::String::format("%u:", volumeId)), &parameters, work, FF_MAX_SS);
+    lock.release();
+
+    delete[] work;
     return result == FR_OK;
 }
 
 Node* FatDriver::getNode(const Util::String &path) {
     auto fatPath = Util::String::format("%u:%s", volumeId, static_cast<const char*>(path));
-    return FatNode::open(fatPath);
+
+    lock.acquire();
+    auto *node = FatNode::open(fatPath, *this);
+    lock.release();
+
+    return node;
 }
 
 bool FatDriver::createNode(const Util::String &path, Util::Io::File::Type type) {
     auto fatPath = Util::String::format("%u:%s", volumeId, static_cast<const char*>(path));
     FRESULT result = FR_DISK_ERR;
 
+    lock.acquire();
     if (type == Util::Io::File::DIRECTORY) {
         result = f_mkdir(static_cast<const char*>(fatPath));
     } else if (type == Util::Io::File::REGULAR) {
@@ -98,15 +162,78 @@ bool FatDriver::createNode(const Util::String &path, Util::Io::File::Type type)
 
         delete file;
     }
+    lock.release();
 
     return result == FR_OK;
 }
 
 bool FatDriver::deleteNode(const Util::String &path) {
     auto fatPath = Util::String::format("%u:%s", volumeId, static_cast<const char*>(path));
+    lock.acquire();
     auto result = f_unlink(static_cast<const char*>(fatPath));
+    lock.release();
 
     return result == FR_OK;
 }
 
+bool FatDriver::flush() {
+    auto success = true;
+    lock.acquire();
+    for (auto *file : openFiles) {
+        success &= file->sync();
+    }
+    lock.release();
+
+    return device->flush() && success;
+}
+
+bool FatDriver::isWriteBackEnabled() const {
+    return writeBack;
+}
+
+Util::Async::Mutex& FatDriver::getLock() {
+    return lock;
+}
+
+void FatDriver::addOpenFile(FatFile &file) {
+    openFiles.add(&file);
+}
+
+void FatDriver::removeOpenFile(FatFile &file) {
+    openFiles.remove(&file);
+}
+
+bool FatDriver::flushAll() {
+    auto success = true;
+    mountedVolumesLock.acquire();
+    for (auto *volume : mountedVolumes) {
+        success &= volume->flush();
+    }
+    mountedVolumesLock.release();
+
+    return success;
+}
+
+void FatDriver::setWriteBack(bool enabled) {
+    writeBackDefault = enabled;
+}
+
+void FatDriver::registerVolume() {
+    mountedVolumesLock.acquire();
+    mountedVolumes.add(this);
+
+    if (!flusherStarted) {
+        auto &processService = Kernel::Service::getService<Kernel::ProcessService>();
+        auto *flusher = new Util::Async::PeriodicRunnable(Util::Time::Timestamp::ofMilliseconds(FLUSH_INTERVAL), [](void*) {
+            flushAll();
+        });
+
+        auto &flusherThread = Kernel::Thread::createKernelThread("Fat-Flusher", processService.getKernelProcess(), flusher);
+        processService.ready(flusherThread);
+        flusherStarted = true;
+    }
+
+    mountedVolumesLock.release();
+}
+
 }
\ No newline at end of file
@@ -22,7 +22,10 @@
 
 #include "filesystem/fat/ff/source/ff.h"
 #include "filesystem/PhysicalDriver.h"
+#include "lib/util/async/Mutex.h"
+#include "lib/util/async/Spinlock.h"
 #include "lib/util/base/String.h"
+#include "lib/util/collection/ArrayList.h"
 #include "lib/util/reflection/Prototype.h"
 #include "lib/util/io/file/File.h"
 
@@ -44,9 +47,19 @@ class AtomicBitmap;
 }  // namespace Util
 
 namespace Filesystem::Fat {
+class FatFile;
 
+/**
+ * Driver for FAT volumes, based on FatFs. Since FatFs is not reentrant, all FatFs calls on a volume are serialized by the volume's lock.
+ *
+ * In write-back mode, writing to a file only marks it as dirty, instead of syncing its directory entry and the FAT after every write.
+ * Dirty files are synced periodically by a background thread, when they are synced explicitly (see Util::Io::File::sync()),
+ * when they are closed and when the volume is unmounted or the machine is shut down.
+ */
 class FatDriver : public PhysicalDriver {
 
+friend class FatFile;
+
 public:
     /**
      * Constructor.
@@ -65,6 +78,7 @@ public:
 
     /**
      * Destructor.
+     * Syncs all open files and detaches them from the volume.
      */
     ~FatDriver() override;
 
@@ -97,15 +111,68 @@ public:
      */
     bool deleteNode(const Util::String &path) override;
 
+    /**
+     * Sync all dirty files of the volume and write back the storage device's cached sectors.
+     *
+     * @return false, if a file could not be synced or a sector could not be written back
+     */
+    bool flush();
+
+    [[nodiscard]] bool isWriteBackEnabled() const;
+
+    [[nodiscard]] Util::Async::Mutex& getLock();
+
+    /**
+     * Register an open file, so that it is synced by flush(). The volume lock must be held.
+     */
+    void addOpenFile(FatFile &file);
+
+    /**
+     * Unregister an open file. The volume lock must be held.
+     */
+    void removeOpenFile(FatFile &file);
+
     static Device::Storage::StorageDevice& getStorageDevice(uint8_t volumeId);
 
+    /**
+     * Flush all mounted volumes (called periodically by the flusher thread and before shutdown).
+     *
+     * @return false, if at least one volume could not be flushed completely
+     */
+    static bool flushAll();
+
+    /**
+     * Enable or disable write-back mode for volumes, that are mounted afterward (enabled by default).
+     */
+    static void setWriteBack(bool enabled);
+
 private:
 
+    /**
+     * Add the volume to the mounted volumes, which are flushed by the flusher thread, and start the thread on the first call.
+     */
+    void registerVolume();
+
     uint32_t volumeId{};
     FATFS fatVolume{};
+    Device::Storage::StorageDevice *device = nullptr;
+
+    bool writeBack = false;
+    Util::Async::Mutex lock;
+    Util::ArrayList<FatFile*> openFiles;
+    uint32_t fileUsers = 0; // Open files, which are using or waiting for the volume lock (protected by detachLock)
 
     static Util::Async::AtomicBitmap volumeIdAllocator;
     static Util::Array<Device::Storage::StorageDevice*> deviceMap;
+
+    static bool writeBackDefault;
+    static bool flusherStarted;
+    static const constexpr uint32_t FLUSH_INTERVAL = 5000; // Milliseconds between two syncs of volumes in write-back mode
+    static Util::ArrayList<FatDriver*> mountedVolumes;
+    static Util::Async::Mutex mountedVolumesLock;
+
+    // Protects the driver references of open files, which are cleared on unmount (static, so that it outlives all drivers)
+    static Util::Async::Spinlock detachLock;
 };
 
 }
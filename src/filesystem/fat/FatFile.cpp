@@ -17,14 +17,25 @@
 
 #include "FatFile.h"
 
+#include "device/storage/StorageDevice.h"
+#include "filesystem/fat/FatDriver.h"
 #include "filesystem/fat/FatNode.h"
 #include "lib/util/base/String.h"
 
 namespace Filesystem::Fat {
 
-FatFile::FatFile(FIL *file, FILINFO *info) : FatNode(info), file(file) {}
+FatFile::FatFile(FIL *file, FILINFO *info, FatDriver &driver) : FatNode(info), file(file), driver(&driver) {
+    driver.addOpenFile(*this);
+}
 
 FatFile::~FatFile() {
+    auto *volume = lockDriver();
+    if (volume != nullptr) {
+        volume->removeOpenFile(*this);
+        f_close(file);
+        unlockDriver(*volume);
+    }
+
     delete file;
 }
 
@@ -37,34 +48,223 @@ Util::Array<Util::String> FatFile::getChildren() {
 }
 
 uint64_t FatFile::readData(uint8_t *targetBuffer, uint64_t pos, uint64_t numBytes) {
-    auto result = f_lseek(file, pos);
-    if (result != FR_OK) {
+    auto *volume = lockDriver();
+    if (volume == nullptr) {
         return 0;
     }
 
-    uint32_t readBytes;
-    result = f_read(file, targetBuffer, numBytes, &readBytes);
-    if (result != FR_OK) {
-        return 0;
+    uint32_t readBytes = 0;
+    if (f_lseek(file, pos) == FR_OK && f_read(file, targetBuffer, numBytes, &readBytes) == FR_OK) {
+        readAhead(pos, readBytes);
+    } else {
+        readBytes = 0;
     }
 
+    unlockDriver(*volume);
     return readBytes;
 }
 
 uint64_t FatFile::writeData(const uint8_t *sourceBuffer, uint64_t pos, uint64_t numBytes) {
-    auto result = f_lseek(file, pos);
-    if (result != FR_OK) {
+    auto *volume = lockDriver();
+    if (volume == nullptr) {
         return 0;
     }
 
-    uint32_t writtenBytes;
-    result = f_write(file, sourceBuffer, numBytes, &writtenBytes);
-    if (result != FR_OK) {
+    uint32_t writtenBytes = 0;
+    if (f_lseek(file, pos) != FR_OK || f_write(file, sourceBuffer, numBytes, &writtenBytes) != FR_OK) {
+        unlockDriver(*volume);
         return 0;
     }
 
-    f_sync(file);
+    // In write-back mode, the directory entry and the FAT are updated later by the flusher thread
+    dirty = true;
+    if (!volume->isWriteBackEnabled()) {
+        sync();
+    }
+
+    unlockDriver(*volume);
     return writtenBytes;
 }
 
+bool FatFile::control(uint32_t request, [[maybe_unused]] const Util::Array<uint32_t> &parameters) {
+    if (request != Util::Io::File::SYNC) {
+        return false;
+    }
+
+    auto *volume = lockDriver();
+    if (volume == nullptr) {
+        return false;
+    }
+
+    auto success = sync();
+    unlockDriver(*volume);
+
+    // Sync must also write back the sectors, that are still held in the buffer cache
+    return FatDriver::getStorageDevice(file->obj.fs->pdrv).flush() && success;
+}
+
+bool FatFile::sync() {
+    if (!dirty) {
+        return true;
+    }
+
+    // Keep the file dirty on failure, so that the flusher thread tries again
+    dirty = f_sync(file) != FR_OK;
+    return !dirty;
+}
+
+void FatFile::detach() {
+    FatDriver::detachLock.acquire();
+    driver = nullptr;
+    FatDriver::detachLock.release();
+}
+
+FatDriver* FatFile::lockDriver() {
+    // The driver may be destroyed concurrently, so it is only dereferenced after registering as its user
+    FatDriver::detachLock.acquire();
+    auto *volume = driver;
+    if (volume == nullptr) {
+        FatDriver::detachLock.release();
+        return nullptr;
+    }
+
+    volume->fileUsers++;
+    FatDriver::detachLock.release();
+
+    volume->lock.acquire();
+    if (driver == nullptr) {
+        // The volume has been unmounted while waiting for its lock
+        unlockDriver(*volume);
+        return nullptr;
+    }
+
+    return volume;
+}
+
+void FatFile::unlockDriver(FatDriver &volume) {
+    volume.lock.release();
+
+    FatDriver::detachLock.acquire();
+    volume.fileUsers--;
+    FatDriver::detachLock.release();
+}
+
+void FatFile::readAhead(uint64_t position, uint32_t length) {
+    auto range = readahead.update(position, length, f_size(file));
+    if (range.isEmpty() || file->obj.sclust == 0) {
+        return;
+    }
+
+    const auto &volume = *file->obj.fs;
+    auto &device = FatDriver::getStorageDevice(volume.pdrv);
+    auto sectorSize = device.getSectorSize();
+    auto clusterSize = volume.csize * sectorSize;
+
+    // Contiguous exFAT files have no FAT chain. Otherwise, start at the cluster, in which the last read has stopped,
+    // instead of following the whole chain from the start of the file.
+    auto contiguous = volume.fs_type == FS_EXFAT && (file->obj.stat & 0x02);
+    uint32_t cluster;
+    uint32_t clusterIndex;
+    if (contiguous) {
+        clusterIndex = range.start / clusterSize;
+        cluster = file->obj.sclust + clusterIndex;
+    } else if (file->fptr == 0) {
+        clusterIndex = 0;
+        cluster = file->obj.sclust;
+    } else {
+        clusterIndex = (file->fptr - 1) / clusterSize;
+        cluster = file->clust;
+    }
+
+    if (clusterIndex > range.start / clusterSize) {
+        return;
+    }
+
+    auto *sectorBuffer = new uint8_t[2 * sectorSize];
+    LBA_t bufferedSector = 0;
+
+    while (cluster != 0 && clusterIndex < range.start / clusterSize) {
+        cluster = getNextCluster(volume, device, cluster, sectorBuffer, bufferedSector);
+        clusterIndex++;
+    }
+
+    LBA_t runStart = 0;
+    uint32_t runLength = 0;
+    while (cluster != 0) {
+        uint64_t clusterStart = static_cast<uint64_t>(clusterIndex) * clusterSize;
+        uint64_t clusterEnd = clusterStart + clusterSize;
+        auto from = static_cast<uint32_t>(((range.start > clusterStart ? range.start : clusterStart) - clusterStart) / sectorSize);
+        auto to = static_cast<uint32_t>(((range.end < clusterEnd ? range.end : clusterEnd) - clusterStart + sectorSize - 1) / sectorSize);
+        auto sector = volume.database + static_cast<LBA_t>(cluster - 2) * volume.csize + from;
+
+        if (runLength > 0 && sector == runStart + runLength) {
+            runLength += to - from;
+        } else {
+            ReadaheadWindow::prefetch(device, runStart, runLength);
+            runStart = sector;
+            runLength = to - from;
+        }
+
+        if (clusterEnd >= range.end) {
+            break;
+        }
+
+        cluster = contiguous ? cluster + 1 : getNextCluster(volume, device, cluster, sectorBuffer, bufferedSector);
+        clusterIndex++;
+    }
+
+    ReadaheadWindow::prefetch(device, runStart, runLength);
+    delete[] sectorBuffer;
+}
+
+uint32_t FatFile::getNextCluster(const FATFS &volume, Device::Storage::StorageDevice &device, uint32_t cluster, uint8_t *sectorBuffer, LBA_t &bufferedSector) {
+    if (cluster < 2 || cluster >= volume.n_fatent) {
+        return 0;
+    }
+
+    auto sectorSize = device.getSectorSize();
+    uint32_t offset;
+    switch (volume.fs_type) {
+        case FS_FAT12:
+            offset = cluster + cluster / 2;
+            break;
+        case FS_FAT16:
+            offset = cluster * 2;
+            break;
+        default:
+            offset = cluster * 4;
+    }
+
+    // FAT12 entries may span two sectors -> Only then the following sector is read as well (it may be the end of the device)
+    auto sector = volume.fatbase + offset / sectorSize;
+    uint32_t sectorCount = volume.fs_type == FS_FAT12 && offset % sectorSize == sectorSize - 1 ? 2 : 1;
+    if (bufferedSector != sector || sectorCount > 1) {
+        if (device.read(sectorBuffer, sector, sectorCount) != sectorCount) {
+            bufferedSector = 0;
+            return 0;
+        }
+
+        bufferedSector = sector;
+    }
+
+    const auto *entry = sectorBuffer + offset % sectorSize;
+    uint32_t next;
+    switch (volume.fs_type) {
+        case FS_FAT12:
+            next = entry[0] | (entry[1] << 8);
+            next = (cluster & 0x01) ? next >> 4 : next & 0x0fff;
+            break;
+        case FS_FAT16:
+            next = entry[0] | (entry[1] << 8);
+            break;
+        case FS_FAT32:
+            next = (entry[0] | (entry[1] << 8) | (entry[2] << 16) | (entry[3] << 24)) & 0x0fffffff;
+            break;
+        default:
+            next = entry[0] | (entry[1] << 8) | (entry[2] << 16) | (entry[3] << 24);
+    }
+
+    return next >= 2 && next < volume.n_fatent ? next : 0;
+}
+
 }
\ No newline at end of file
@@ -21,10 +21,17 @@
 #include <stdint.h>
 
 #include "FatNode.h"
+#include "filesystem/ReadaheadWindow.h"
 #include "filesystem/fat/ff/source/ff.h"
 #include "lib/util/collection/Array.h"
 #include "lib/util/io/file/File.h"
 
+namespace Device {
+namespace Storage {
+class StorageDevice;
+}  // namespace Storage
+}  // namespace Device
+
 namespace Util {
 
 class String;
@@ -32,14 +39,16 @@ class String;
 }  // namespace Util
 
 namespace Filesystem::Fat {
+class FatDriver;
 
 class FatFile : public FatNode {
 
 public:
     /**
      * Constructor.
+     * The file registers itself at the driver, so the volume lock must be held.
      */
-    FatFile(FIL *file, FILINFO *info);
+    FatFile(FIL *file, FILINFO *info, FatDriver &driver);
 
     /**
      * Copy Constructor.
@@ -53,6 +62,7 @@ public:
 
     /**
      * Destructor.
+     * Closes the file, which syncs it, if it is dirty.
      */
     ~FatFile() override;
 
@@ -76,9 +86,58 @@ public:
      */
     uint64_t writeData(const uint8_t *sourceBuffer, uint64_t pos, uint64_t numBytes) override;
 
+    /**
+     * Overriding function from Node.
+     * Handles Util::Io::File::SYNC, which syncs the file and writes back the storage device's cached sectors.
+     */
+    bool control(uint32_t request, const Util::Array<uint32_t> &parameters) override;
+
+    /**
+     * Write the file's cached data, its directory entry and the FAT to the storage device, if the file is dirty.
+     * The volume lock must be held.
+     *
+     * @return Whether FatFs has synced the file successfully
+     */
+    bool sync();
+
+    /**
+     * Called, when the volume is unmounted while the file is still open. Afterward, all accesses to the file fail.
+     * The volume lock must be held.
+     */
+    void detach();
+
 private:
 
+    /**
+     * Lock the file's volume, unless the file has been detached.
+     *
+     * @return The driver of the volume or nullptr, if the volume has been unmounted
+     */
+    FatDriver* lockDriver();
+
+    /**
+     * Release a volume locked by lockDriver(). Afterward, the driver may be destroyed at any time.
+     */
+    static void unlockDriver(FatDriver &volume);
+
+    /**
+     * Translate the range of the file, that should be read ahead, into sectors by following the cluster chain
+     * and prefetch consecutive sectors with as few requests as possible.
+     */
+    void readAhead(uint64_t position, uint32_t length);
+
+    /**
+     * Look up the successor of a cluster in the FAT. The FAT is read through the storage device (usually from the buffer cache),
+     * so that FatFs, which is not reentrant, is not involved.
+     *
+     * @return The next cluster or 0, if the cluster is the last one of its chain (or the entry is invalid)
+     */
+    static uint32_t getNextCluster(const FATFS &volume, Device::Storage::StorageDevice &device, uint32_t cluster, uint8_t *sectorBuffer, LBA_t &bufferedSector);
+
     FIL *file;
+    FatDriver *driver;
+    bool dirty = false;
+    ReadaheadWindow readahead;
 };
 
 }
@@ -25,6 +25,7 @@
 #include "lib/util/base/String.h"
 
 namespace Filesystem::Fat {
+class FatDriver;
 
 class FatNode : public Node {
 
@@ -44,7 +45,10 @@ public:
      */
     ~FatNode() override;
 
-    static FatNode* open(const Util::String &path);
+    /**
+     * Open a file or directory. The volume lock of the driver must be held.
+     */
+    static FatNode* open(const Util::String &path, FatDriver &driver);
 
     /**
      * Overriding function from Node.
@@ -87,7 +87,8 @@ DRESULT disk_ioctl(BYTE driveNumber, BYTE command, void *buffer) {
     auto &device = Filesystem::Fat::FatDriver::getStorageDevice(driveNumber);
     switch (command) {
         case CTRL_SYNC:
-            return RES_OK;
+            // Write back sectors, that are still held in the buffer cache
+            return device.flush() ? RES_OK : RES_ERROR;
         case GET_SECTOR_COUNT: {
             auto *lba = reinterpret_cast<LBA_t *>(buffer);
             *lba = device.getSectorCount();
@@ -86,8 +86,9 @@ uint64_t IsoNode::readData(uint8_t *targetBuffer, uint64_t pos, uint64_t numByte
         numBytes = (record.dataLengthLSB - pos);
     }
 
-    uint32_t startSector = record.extentLbaLSB + (static_cast<uint32_t>(pos) / device.getSectorSize());
-    uint32_t sectorCount = (static_cast<uint32_t>(numBytes) / device.getSectorSize()) + 1;
+    auto sectorSize = device.getSectorSize();
+    uint32_t startSector = record.extentLbaLSB + (static_cast<uint32_t>(pos) / sectorSize);
+    uint32_t sectorCount = ((static_cast<uint32_t>(pos) % sectorSize) + static_cast<uint32_t>(numBytes) + sectorSize - 1) / sectorSize;
 
     auto *buffer = new uint8_t[sectorCount * device.getSectorSize()];
     auto readSectors = device.read(buffer, startSector, sectorCount);
@@ -99,8 +100,16 @@ uint64_t IsoNode::readData(uint8_t *targetBuffer, uint64_t pos, uint64_t numByte
     auto sourceAddress = Util::Address<uint32_t>(buffer).add(static_cast<uint32_t>(pos) % device.getSectorSize());
     auto targetAddress = Util::Address<uint32_t>(targetBuffer);
     targetAddress.copyRange(sourceAddress, numBytes);
-
     delete[] buffer;
+
+    // Files are stored contiguously, so the range to read ahead maps directly to sectors
+    auto range = readahead.update(pos, numBytes, record.dataLengthLSB);
+    if (!range.isEmpty()) {
+        auto firstSector = record.extentLbaLSB + static_cast<uint32_t>(range.start / sectorSize);
+        auto lastSector = record.extentLbaLSB + static_cast<uint32_t>((range.end - 1) / sectorSize);
+        ReadaheadWindow::prefetch(device, firstSector, lastSector - firstSector + 1);
+    }
+
     return numBytes;
 }
 
@@ -24,6 +24,7 @@
 #include <stdint.h>
 
 #include "filesystem/Node.h"
+#include "filesystem/ReadaheadWindow.h"
 #include "IsoDriver.h"
 #include "lib/util/base/String.h"
 #include "lib/util/collection/Array.h"
@@ -94,6 +95,7 @@ private:
 
     Device::Storage::StorageDevice &device;
     const IsoDriver::DirectoryRecord &record;
+    ReadaheadWindow readahead;
 };
 
 }
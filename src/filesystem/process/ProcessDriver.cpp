@@ -21,6 +21,9 @@
 #include "ProcessDirectoryNode.h"
 #include "ProcessRootNode.h"
 #include "ProcessFileNode.h"
+#include "ProcessMemoryLimitNode.h"
+#include "kernel/memory/VirtualAddressSpace.h"
+#include "lib/util/base/Constants.h"
 #include "kernel/process/Process.h"
 #include "lib/util/collection/Array.h"
 #include "lib/util/io/file/File.h"
@@ -57,6 +60,13 @@ Node* ProcessDriver::getNode(const Util::String &path) {
             return new ProcessFileNode(name, process->getWorkingDirectory().getCanonicalPath());
         } else if (name == "thread_count") {
             return new ProcessFileNode(name, Util::String::format("%u", process->getThreadCount()));
+        } else if (name == "memory") {
+            auto usage = process->getAddressSpace().getMemoryUsage();
+            auto pageKibibytes = Util::PAGESIZE / 1024;
+            return new ProcessFileNode(name, Util::String::format("Resident:    %u KiB\nHeap:        %u KiB\nPage tables: %u KiB",
+                    usage.residentPages * pageKibibytes, usage.heapPages * pageKibibytes, usage.pageTables * pageKibibytes));
+        } else if (name == "memory_limit") {
+            return new ProcessMemoryLimitNode(id);
         }
     }
 
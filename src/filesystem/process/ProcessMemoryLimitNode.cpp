@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "ProcessMemoryLimitNode.h"
+
+#include "kernel/memory/VirtualAddressSpace.h"
+#include "kernel/process/Process.h"
+#include "kernel/service/ProcessService.h"
+#include "kernel/service/Service.h"
+#include "lib/util/base/Constants.h"
+
+namespace Filesystem::Process {
+
+ProcessMemoryLimitNode::ProcessMemoryLimitNode(uint32_t processId) : StringNode("memory_limit"), processId(processId) {}
+
+Util::String ProcessMemoryLimitNode::getString() {
+    auto *process = Kernel::Service::getService<Kernel::ProcessService>().getProcess(processId);
+    if (process == nullptr) {
+        return "";
+    }
+
+    return Util::String::format("%u\n", process->getAddressSpace().getMemoryUsage().memoryLimit * (Util::PAGESIZE / 1024));
+}
+
+uint64_t ProcessMemoryLimitNode::writeData(const uint8_t *sourceBuffer, uint64_t pos, uint64_t numBytes) {
+    auto *process = Kernel::Service::getService<Kernel::ProcessService>().getProcess(processId);
+    if (process == nullptr || process->isKernelProcess() || pos > 0 || numBytes == 0 || numBytes > MAX_INPUT_LENGTH) {
+        return 0;
+    }
+
+    auto limit = Util::String(sourceBuffer, numBytes).strip();
+    auto kibibytes = Util::String::parseInt(limit);
+    if (kibibytes < 0) {
+        return 0;
+    }
+
+    // Round up to whole pages, so that a small limit does not mean unlimited
+    auto pageCount = (static_cast<uint32_t>(kibibytes) + (Util::PAGESIZE / 1024) - 1) / (Util::PAGESIZE / 1024);
+    process->getAddressSpace().setMemoryLimit(pageCount);
+
+    return numBytes;
+}
+
+}
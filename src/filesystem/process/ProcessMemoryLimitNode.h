@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_PROCESSMEMORYLIMITNODE_H
+#define HHUOS_PROCESSMEMORYLIMITNODE_H
+
+#include <stdint.h>
+
+#include "filesystem/memory/StringNode.h"
+#include "lib/util/base/String.h"
+
+namespace Filesystem::Process {
+
+/**
+ * Shows the memory limit of a process in KiB (0, if unlimited).
+ * Writing a new value (in KiB) to the node changes the limit.
+ */
+class ProcessMemoryLimitNode : public Memory::StringNode {
+
+public:
+    /**
+     * Constructor.
+     */
+    explicit ProcessMemoryLimitNode(uint32_t processId);
+
+    /**
+     * Copy Constructor.
+     */
+    ProcessMemoryLimitNode(const ProcessMemoryLimitNode &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    ProcessMemoryLimitNode &operator=(const ProcessMemoryLimitNode &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~ProcessMemoryLimitNode() override = default;
+
+    /**
+     * Overriding function from StringNode.
+     */
+    Util::String getString() override;
+
+    /**
+     * Overriding function from MemoryNode.
+     */
+    uint64_t writeData(const uint8_t *sourceBuffer, uint64_t pos, uint64_t numBytes) override;
+
+private:
+
+    uint32_t processId;
+
+    static const constexpr uint32_t MAX_INPUT_LENGTH = 16;
+};
+
+}
+
+#endif
@@ -82,6 +82,10 @@ enum InterruptVector : uint8_t {
     PAGING_ERROR = 0xd2,
     UNSUPPORTED_OPERATION = 0xd3,
 
+    // Inter-processor interrupts
+    TLB_SHOOTDOWN = 0xf6,
+    WAKEUP = 0xf7,
+
     // Local APIC interrupts (247 - 254)
     CMCI = 0xf8,
     APICTIMER = 0xf9,
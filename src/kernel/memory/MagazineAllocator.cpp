@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "MagazineAllocator.h"
+
+#include "lib/util/base/Address.h"
+#include "kernel/service/InterruptService.h"
+#include "kernel/service/Service.h"
+
+namespace Kernel {
+
+MagazineAllocator::MagazineAllocator(Util::HeapMemoryManager &backend) : backend(backend) {
+    Util::Address<uint32_t>(slabSizeClasses).setRange(NO_SIZE_CLASS, sizeof(slabSizeClasses));
+}
+
+void MagazineAllocator::initialize(uint8_t *startAddress, uint8_t *endAddress) {
+    backend.initialize(startAddress, endAddress);
+}
+
+void* MagazineAllocator::allocateMemory(uint32_t size, uint32_t alignment) {
+    auto sizeClass = getSizeClass(size, alignment);
+    if (sizeClass == NO_SIZE_CLASS) {
+        return backend.allocateMemory(size, alignment);
+    }
+
+    auto &cache = caches[getCpuId()][sizeClass];
+    if (!cache.lock.tryAcquire()) {
+        // The cache is in use by another thread on this core (e.g. one that has been preempted while allocating)
+        return allocateFromDepot(sizeClass);
+    }
+
+    if (cache.loaded == nullptr || cache.loaded->rounds == 0) {
+        if (cache.previous != nullptr && cache.previous->rounds > 0) {
+            auto *magazine = cache.loaded;
+            cache.loaded = cache.previous;
+            cache.previous = magazine;
+        } else {
+            // Both magazines are empty -> Hand one of them to the depot in exchange for a full one
+            auto *emptyMagazine = cache.previous;
+            cache.previous = cache.loaded;
+            cache.loaded = exchangeEmptyMagazine(sizeClass, emptyMagazine);
+            if (cache.loaded == nullptr) {
+                // No magazine could be filled -> Try to take a single object from the depot
+                cache.lock.release();
+                return allocateFromDepot(sizeClass);
+            }
+        }
+    }
+
+    auto *object = cache.loaded->objects[--cache.loaded->rounds];
+    cache.lock.release();
+
+    return object;
+}
+
+void* MagazineAllocator::reallocateMemory(void *pointer, uint32_t size, uint32_t alignment) {
+    if (pointer == nullptr) {
+        return allocateMemory(size, alignment);
+    }
+
+    auto sizeClass = getSlabSizeClass(pointer);
+    if (sizeClass == NO_SIZE_CLASS) {
+        return backend.reallocateMemory(pointer, size, alignment);
+    }
+
+    if (size == 0) {
+        freeMemory(pointer, alignment);
+        return nullptr;
+    }
+
+    auto objectSize = MIN_OBJECT_SIZE << sizeClass;
+    if (size <= objectSize && (alignment == 0 || reinterpret_cast<uint32_t>(pointer) % alignment == 0)) {
+        return pointer;
+    }
+
+    auto *newPointer = allocateMemory(size, alignment);
+    if (newPointer == nullptr) {
+        return nullptr;
+    }
+
+    Util::Address<uint32_t>(newPointer).copyRange(Util::Address<uint32_t>(pointer), size < objectSize ? size : objectSize);
+    freeMemory(pointer, alignment);
+
+    return newPointer;
+}
+
+void MagazineAllocator::freeMemory(void *pointer, uint32_t alignment) {
+    auto sizeClass = getSlabSizeClass(pointer);
+    if (sizeClass == NO_SIZE_CLASS) {
+        backend.freeMemory(pointer, alignment);
+        return;
+    }
+
+    auto &cache = caches[getCpuId()][sizeClass];
+    if (!cache.lock.tryAcquire()) {
+        freeToDepot(sizeClass, pointer);
+        return;
+    }
+
+    if (cache.loaded == nullptr || cache.loaded->rounds == MAGAZINE_SIZE) {
+        if (cache.previous != nullptr && cache.previous->rounds < MAGAZINE_SIZE) {
+            auto *magazine = cache.loaded;
+            cache.loaded = cache.previous;
+            cache.previous = magazine;
+        } else {
+            // Both magazines are full -> Hand one of them to the depot in exchange for an empty one
+            auto *fullMagazine = cache.previous;
+            cache.previous = cache.loaded;
+            cache.loaded = exchangeFullMagazine(sizeClass, fullMagazine);
+            if (cache.loaded == nullptr) {
+                // No empty magazine available and none could be allocated
+                cache.lock.release();
+                freeToDepot(sizeClass, pointer);
+                return;
+            }
+        }
+    }
+
+    cache.loaded->objects[cache.loaded->rounds++] = pointer;
+    cache.lock.release();
+}
+
+uint32_t MagazineAllocator::getTotalMemory() const {
+    return backend.getTotalMemory();
+}
+
+uint32_t MagazineAllocator::getFreeMemory() const {
+    return backend.getFreeMemory();
+}
+
+uint8_t* MagazineAllocator::getStartAddress() const {
+    return backend.getStartAddress();
+}
+
+uint8_t* MagazineAllocator::getEndAddress() const {
+    return backend.getEndAddress();
+}
+
+bool MagazineAllocator::isLocked() const {
+    if (backend.isLocked()) {
+        return true;
+    }
+
+    // Per-CPU caches are only locked with tryAcquire() and never block, but the depots do
+    for (const auto &depot : depots) {
+        if (depot.lock.isLocked()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+MagazineAllocator::Magazine* MagazineAllocator::exchangeEmptyMagazine(uint8_t sizeClass, Magazine *emptyMagazine) {
+    auto &depot = depots[sizeClass];
+    depot.lock.acquire();
+
+    if (emptyMagazine != nullptr) {
+        emptyMagazine->next = depot.emptyMagazines;
+        depot.emptyMagazines = emptyMagazine;
+    }
+
+    auto *magazine = depot.fullMagazines;
+    if (magazine != nullptr) {
+        depot.fullMagazines = magazine->next;
+        depot.lock.release();
+        return magazine;
+    }
+
+    // No full magazine available -> Fill an empty one with free objects
+    magazine = depot.emptyMagazines;
+    if (magazine != nullptr) {
+        depot.emptyMagazines = magazine->next;
+    } else {
+        depot.lock.release();
+        magazine = createMagazine();
+        if (magazine == nullptr) {
+            return nullptr;
+        }
+
+        depot.lock.acquire();
+    }
+
+    while (magazine->rounds < MAGAZINE_SIZE) {
+        auto *object = takeFreeObject(sizeClass);
+        if (object == nullptr) {
+            break;
+        }
+
+        magazine->objects[magazine->rounds++] = object;
+    }
+
+    if (magazine->rounds == 0) {
+        // Out of memory -> Keep the empty magazine in the depot
+        magazine->next = depot.emptyMagazines;
+        depot.emptyMagazines = magazine;
+        magazine = nullptr;
+    }
+
+    depot.lock.release();
+    return magazine;
+}
+
+MagazineAllocator::Magazine* MagazineAllocator::exchangeFullMagazine(uint8_t sizeClass, Magazine *fullMagazine) {
+    auto &depot = depots[sizeClass];
+    depot.lock.acquire();
+
+    if (fullMagazine != nullptr) {
+        fullMagazine->next = depot.fullMagazines;
+        depot.fullMagazines = fullMagazine;
+    }
+
+    auto *magazine = depot.emptyMagazines;
+    if (magazine != nullptr) {
+        depot.emptyMagazines = magazine->next;
+    }
+
+    depot.lock.release();
+    return magazine == nullptr ? createMagazine() : magazine;
+}
+
+void* MagazineAllocator::allocateFromDepot(uint8_t sizeClass) {
+    auto &depot = depots[sizeClass];
+    depot.lock.acquire();
+    auto *object = takeFreeObject(sizeClass);
+    depot.lock.release();
+
+    return object;
+}
+
+void MagazineAllocator::freeToDepot(uint8_t sizeClass, void *object) {
+    auto &depot = depots[sizeClass];
+    depot.lock.acquire();
+    *reinterpret_cast<void**>(object) = depot.freeObjects;
+    depot.freeObjects = object;
+    depot.lock.release();
+}
+
+void* MagazineAllocator::takeFreeObject(uint8_t sizeClass) {
+    auto &depot = depots[sizeClass];
+    while (depot.freeObjects == nullptr) {
+        // The backend must not be called with the depot locked, since it may allocate memory itself (e.g. when mapping pages)
+        depot.lock.release();
+        auto *slab = static_cast<uint8_t*>(backend.allocateMemory(SLAB_SIZE, SLAB_SIZE));
+        depot.lock.acquire();
+
+        if (slab == nullptr) {
+            // Out of memory, but another thread may have freed objects while the depot was unlocked
+            if (depot.freeObjects == nullptr) {
+                return nullptr;
+            }
+
+            break;
+        }
+
+        slabSizeClasses[reinterpret_cast<uint32_t>(slab) / SLAB_SIZE] = sizeClass;
+
+        // Carve the slab into objects and link them into the depot's free objects
+        auto objectSize = MIN_OBJECT_SIZE << sizeClass;
+        for (uint32_t offset = 0; offset < SLAB_SIZE; offset += objectSize) {
+            auto *object = slab + offset;
+            *reinterpret_cast<void**>(object) = depot.freeObjects;
+            depot.freeObjects = object;
+        }
+    }
+
+    auto *object = depot.freeObjects;
+    depot.freeObjects = *reinterpret_cast<void**>(object);
+
+    return object;
+}
+
+MagazineAllocator::Magazine* MagazineAllocator::createMagazine() {
+    // Magazines are larger than the smallest size classes, so they are allocated from the backend to avoid recursion
+    auto *magazine = static_cast<Magazine*>(backend.allocateMemory(sizeof(Magazine), 0));
+    if (magazine == nullptr) {
+        return nullptr;
+    }
+
+    magazine->next = nullptr;
+    magazine->rounds = 0;
+
+    return magazine;
+}
+
+uint8_t MagazineAllocator::getSlabSizeClass(const void *pointer) const {
+    auto address = reinterpret_cast<uint32_t>(pointer);
+    if (pointer == nullptr || address >= MemoryLayout::KERNEL_HEAP_END_ADDRESS) {
+        return NO_SIZE_CLASS;
+    }
+
+    return slabSizeClasses[address / SLAB_SIZE];
+}
+
+uint8_t MagazineAllocator::getSizeClass(uint32_t size, uint32_t alignment) {
+    // Objects are aligned to their size class within their slab, so small alignments are satisfied implicitly
+    auto requiredSize = size > alignment ? size : alignment;
+    if (size == 0 || requiredSize > MAX_OBJECT_SIZE) {
+        return NO_SIZE_CLASS;
+    }
+
+    uint8_t sizeClass = 0;
+    while ((MIN_OBJECT_SIZE << sizeClass) < requiredSize) {
+        sizeClass++;
+    }
+
+    return sizeClass;
+}
+
+uint8_t MagazineAllocator::getCpuId() {
+    // The kernel heap is used long before the interrupt service exists, but only the bootstrap processor is running at that time
+    return Service::isServiceRegistered(InterruptService::SERVICE_ID) ? Service::getService<InterruptService>().getCpuId() : 0;
+}
+
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_MAGAZINEALLOCATOR_H
+#define HHUOS_MAGAZINEALLOCATOR_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Spinlock.h"
+#include "lib/util/base/HeapMemoryManager.h"
+#include "lib/util/reflection/Prototype.h"
+#include "kernel/memory/MemoryLayout.h"
+
+namespace Kernel {
+
+/**
+ * Front end for the kernel heap, which serves small allocations (up to 2 KiB) from per-CPU magazine caches.
+ *
+ * Small objects are grouped into power-of-two size classes. Each size class carves its objects out of slabs,
+ * which are allocated from the backing heap and are never returned to it. Free objects are kept in magazines
+ * (fixed-size stacks of object pointers) and each CPU owns two magazines per size class.
+ * This way, most allocations and frees neither walk the backing heap's free list nor touch a shared lock.
+ * Only if both magazines of a CPU are empty (or full), one of them is exchanged with the global depot.
+ * See Bonwick, Adams: "Magazines and Vmem: Extending the Slab Allocator to Many CPUs and Arbitrary Resources" (2001).
+ *
+ * Larger allocations are passed through to the backing heap.
+ */
+class MagazineAllocator : public Util::HeapMemoryManager {
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param backend The heap, from which slabs, magazines and large allocations are allocated
+     */
+    explicit MagazineAllocator(Util::HeapMemoryManager &backend);
+
+    /**
+     * Copy Constructor.
+     */
+    MagazineAllocator(const MagazineAllocator &copy) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    MagazineAllocator& operator=(const MagazineAllocator &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~MagazineAllocator() override = default;
+
+    PROTOTYPE_IMPLEMENT_GET_CLASS_NAME("Kernel::MagazineAllocator")
+
+    /**
+     * Overriding function from HeapMemoryManager.
+     */
+    void initialize(uint8_t *startAddress, uint8_t *endAddress) override;
+
+    /**
+     * Overriding function from HeapMemoryManager.
+     */
+    [[nodiscard]] void* allocateMemory(uint32_t size, uint32_t alignment) override;
+
+    /**
+     * Overriding function from HeapMemoryManager.
+     */
+    [[nodiscard]] void* reallocateMemory(void *pointer, uint32_t size, uint32_t alignment) override;
+
+    /**
+     * Overriding function from HeapMemoryManager.
+     */
+    void freeMemory(void *pointer, uint32_t alignment) override;
+
+    /**
+     * Overriding function from MemoryManager.
+     */
+    [[nodiscard]] uint32_t getTotalMemory() const override;
+
+    /**
+     * Overriding function from MemoryManager.
+     * Slabs are counted as used memory, regardless of how many of their objects are free.
+     */
+    [[nodiscard]] uint32_t getFreeMemory() const override;
+
+    /**
+     * Overriding function from MemoryManager.
+     */
+    [[nodiscard]] uint8_t* getStartAddress() const override;
+
+    /**
+     * Overriding function from MemoryManager.
+     */
+    [[nodiscard]] uint8_t* getEndAddress() const override;
+
+    /**
+     * Overriding function from HeapMemoryManager.
+     */
+    [[nodiscard]] bool isLocked() const override;
+
+    static const constexpr uint32_t MIN_OBJECT_SIZE = 8;
+    static const constexpr uint32_t MAX_OBJECT_SIZE = 2048;
+
+private:
+
+    static const constexpr uint32_t SIZE_CLASSES = 9; // 8, 16, 32, ..., 2048 bytes
+    static const constexpr uint32_t MAGAZINE_SIZE = 15;
+    static const constexpr uint32_t SLAB_SIZE = 8 * 1024;
+    static const constexpr uint32_t MAX_CPUS = 256;
+    static const constexpr uint8_t NO_SIZE_CLASS = 0xff;
+
+    struct Magazine {
+        Magazine *next;
+        uint32_t rounds;
+        void *objects[MAGAZINE_SIZE];
+    };
+
+    struct CpuCache {
+        Util::Async::Spinlock lock;
+        Magazine *loaded = nullptr;
+        Magazine *previous = nullptr;
+    };
+
+    struct Depot {
+        Util::Async::Spinlock lock;
+        Magazine *fullMagazines = nullptr;
+        Magazine *emptyMagazines = nullptr;
+        void *freeObjects = nullptr; // Objects, which are not held by any magazine (linked through their first word)
+    };
+
+    /**
+     * Hand an empty magazine (or nullptr) to the depot and get a full one in exchange.
+     */
+    Magazine* exchangeEmptyMagazine(uint8_t sizeClass, Magazine *emptyMagazine);
+
+    /**
+     * Hand a full magazine (or nullptr) to the depot and get an empty one in exchange.
+     */
+    Magazine* exchangeFullMagazine(uint8_t sizeClass, Magazine *fullMagazine);
+
+    /**
+     * Take a single object from the depot, bypassing the CPU's magazines.
+     */
+    void* allocateFromDepot(uint8_t sizeClass);
+
+    /**
+     * Return a single object to the depot, bypassing the CPU's magazines.
+     */
+    void freeToDepot(uint8_t sizeClass, void *object);
+
+    /**
+     * Take an object from the depot's free objects, allocating a new slab if there are none.
+     * The depot lock must be held and may be released temporarily.
+     */
+    void* takeFreeObject(uint8_t sizeClass);
+
+    Magazine* createMagazine();
+
+    [[nodiscard]] uint8_t getSlabSizeClass(const void *pointer) const;
+
+    static uint8_t getSizeClass(uint32_t size, uint32_t alignment);
+
+    static uint8_t getCpuId();
+
+    Util::HeapMemoryManager &backend;
+
+    CpuCache caches[MAX_CPUS][SIZE_CLASSES];
+    Depot depots[SIZE_CLASSES];
+
+    // Size class of each slab sized chunk in the kernel area (NO_SIZE_CLASS for memory managed by the backend)
+    uint8_t slabSizeClasses[MemoryLayout::KERNEL_HEAP_END_ADDRESS / SLAB_SIZE];
+};
+
+}
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "MappedFile.h"
+
+#include "filesystem/Node.h"
+#include "kernel/memory/Paging.h"
+#include "kernel/service/MemoryService.h"
+#include "kernel/service/Service.h"
+#include "lib/util/async/Atomic.h"
+#include "lib/util/base/Address.h"
+#include "lib/util/base/Constants.h"
+
+namespace Kernel {
+
+MappedFile::MappedFile(const Util::String &path, Filesystem::Node *node, uint32_t length) : path(path), node(node), length(length), pageCount((length + Util::PAGESIZE - 1) / Util::PAGESIZE), frames(new void*[pageCount]) {
+    for (uint32_t i = 0; i < pageCount; i++) {
+        frames[i] = nullptr;
+    }
+}
+
+MappedFile::~MappedFile() {
+    auto &memoryService = Service::getService<MemoryService>();
+    for (uint32_t i = 0; i < pageCount; i++) {
+        if (frames[i] != nullptr) {
+            memoryService.freePhysicalMemory(frames[i], 1);
+        }
+    }
+
+    delete[] frames;
+    delete node;
+}
+
+void MappedFile::acquire() {
+    Util::Async::Atomic<uint32_t>(references).inc();
+}
+
+void MappedFile::release() {
+    if (Util::Async::Atomic<uint32_t>(references).fetchAndDec() == 1) {
+        delete this;
+    }
+}
+
+void* MappedFile::getFrame(uint32_t pageIndex) {
+    if (pageIndex >= pageCount) {
+        return nullptr;
+    }
+
+    lock.acquire();
+    auto *frame = frames[pageIndex];
+    lock.release();
+
+    if (frame != nullptr) {
+        return frame;
+    }
+
+    // Fill a new frame via a temporary kernel mapping, so that it is never visible to user space, before it is complete.
+    // The lock is not held while reading, since the filesystem may block.
+    auto &memoryService = Service::getService<MemoryService>();
+    auto *newFrame = memoryService.allocatePageFrame();
+    auto *window = mapFrame(newFrame);
+
+    uint32_t offset = pageIndex * Util::PAGESIZE;
+    uint32_t readLength = length - offset < Util::PAGESIZE ? length - offset : Util::PAGESIZE;
+    uint32_t readBytes = read(window, offset, readLength);
+    Util::Address<uint32_t>(window + readBytes).setRange(0, Util::PAGESIZE - readBytes);
+
+    unmapFrame(window);
+
+    // Another thread may have read the same page in the meantime
+    lock.acquire();
+    if (frames[pageIndex] == nullptr) {
+        frames[pageIndex] = newFrame;
+        frame = newFrame;
+        newFrame = nullptr;
+    } else {
+        frame = frames[pageIndex];
+    }
+    lock.release();
+
+    if (newFrame != nullptr) {
+        memoryService.freePhysicalMemory(newFrame, 1);
+    }
+
+    return frame;
+}
+
+void MappedFile::writeBack(uint32_t pageIndex) {
+    if (pageIndex >= pageCount) {
+        return;
+    }
+
+    lock.acquire();
+    auto *frame = frames[pageIndex];
+    lock.release();
+
+    if (frame == nullptr) {
+        return;
+    }
+
+    uint32_t offset = pageIndex * Util::PAGESIZE;
+    uint32_t writeLength = length - offset < Util::PAGESIZE ? length - offset : Util::PAGESIZE;
+
+    auto *window = mapFrame(frame);
+    node->writeData(window, offset, writeLength);
+    unmapFrame(window);
+}
+
+uint32_t MappedFile::read(uint8_t *targetBuffer, uint32_t offset, uint32_t length) {
+    if (offset >= this->length) {
+        return 0;
+    }
+
+    if (offset + length > this->length) {
+        length = this->length - offset;
+    }
+
+    return node->readData(targetBuffer, offset, length);
+}
+
+const Util::String& MappedFile::getPath() const {
+    return path;
+}
+
+uint32_t MappedFile::getLength() const {
+    return length;
+}
+
+uint32_t MappedFile::getReferenceCount() const {
+    return references;
+}
+
+uint8_t* MappedFile::mapFrame(void *frame) {
+    auto &memoryService = Service::getService<MemoryService>();
+    auto *window = memoryService.allocateKernelMemory(Util::PAGESIZE, Util::PAGESIZE);
+    memoryService.mapPhysical(frame, window, 1, Paging::PRESENT | Paging::WRITABLE);
+
+    return static_cast<uint8_t*>(window);
+}
+
+void MappedFile::unmapFrame(uint8_t *window) {
+    auto &memoryService = Service::getService<MemoryService>();
+    memoryService.unmap(window, 1);
+    memoryService.freeKernelMemory(window, Util::PAGESIZE);
+}
+
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_MAPPEDFILE_H
+#define HHUOS_MAPPEDFILE_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Spinlock.h"
+#include "lib/util/base/String.h"
+
+namespace Filesystem {
+class Node;
+}  // namespace Filesystem
+
+namespace Kernel {
+
+/**
+ * Page cache of a file, that is mapped into one or more address spaces.
+ * Pages are read from the filesystem node on first access and their page frames are kept,
+ * so that all mappings of the file share the same frames.
+ *
+ * A mapped file is reference counted. Each mapping (and each cache holding the file) acquires a reference,
+ * and the file is deleted, once the last reference has been released.
+ */
+class MappedFile {
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param path The canonical path of the file
+     * @param node The filesystem node to read pages from (the mapped file takes ownership of it)
+     * @param length The length of the file in bytes
+     */
+    MappedFile(const Util::String &path, Filesystem::Node *node, uint32_t length);
+
+    /**
+     * Copy Constructor.
+     */
+    MappedFile(const MappedFile &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+    /**
+     * Acquire an additional reference to this file.
+     */
+    void acquire();
+
+    /**
+     * Release a reference to this file and delete it, if it was the last one.
+     */
+    void release();
+
+    /**
+     * Get the page frame holding the given page of the file, reading it from the filesystem if necessary.
+     * The returned frame is owned by the page cache. Callers, who map it, must acquire their own reference to it.
+     *
+     * @param pageIndex The page index (file offset / page size)
+     * @return The page frame, or nullptr if the page lies behind the end of the file
+     */
+    void* getFrame(uint32_t pageIndex);
+
+    /**
+     * Write a cached page back to the file (used for shared mappings, after the page has been modified).
+     * Only the part of the page, that lies inside the file, is written. Pages, that are not cached, are ignored.
+     *
+     * @param pageIndex The page index (file offset / page size)
+     */
+    void writeBack(uint32_t pageIndex);
+
+    /**
+     * Read data from the file (bypassing the page cache).
+     *
+     * @return The number of bytes read
+     */
+    uint32_t read(uint8_t *targetBuffer, uint32_t offset, uint32_t length);
+
+    /**
+     * Map a page frame to a temporary address in the kernel heap, so that its content can be accessed.
+     */
+    static uint8_t* mapFrame(void *frame);
+
+    /**
+     * Remove a temporary mapping created by mapFrame().
+     */
+    static void unmapFrame(uint8_t *window);
+
+    [[nodiscard]] const Util::String& getPath() const;
+
+    [[nodiscard]] uint32_t getLength() const;
+
+    [[nodiscard]] uint32_t getReferenceCount() const;
+
+private:
+    /**
+     * Destructor.
+     * Private, since a mapped file is only deleted by release().
+     */
+    ~MappedFile();
+
+    Util::String path;
+    Filesystem::Node *node;
+    uint32_t length;
+    uint32_t pageCount;
+    void **frames;
+
+    uint32_t references = 1;
+    Util::Async::Spinlock lock;
+};
+
+}
+
+#endif
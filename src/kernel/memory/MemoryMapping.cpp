@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "MemoryMapping.h"
+
+#include "kernel/memory/MappedFile.h"
+#include "kernel/memory/Paging.h"
+#include "kernel/memory/VirtualAddressSpace.h"
+#include "kernel/service/MemoryService.h"
+#include "kernel/service/Service.h"
+#include "lib/util/async/Atomic.h"
+#include "lib/util/base/Address.h"
+#include "lib/util/base/Constants.h"
+
+namespace Kernel {
+
+MemoryMapping::MemoryMapping(Type type, uint32_t startAddress, uint32_t endAddress, uint16_t flags, MappedFile *file, uint32_t dataStart, uint32_t dataEnd, uint32_t fileOffset) :
+        type(type), startAddress(startAddress), endAddress(endAddress), flags(flags), file(file), dataStart(dataStart), dataEnd(dataEnd), fileOffset(fileOffset) {
+    if (file != nullptr) {
+        file->acquire();
+    }
+}
+
+MemoryMapping::~MemoryMapping() {
+    if (file != nullptr) {
+        file->release();
+    }
+}
+
+void MemoryMapping::acquire() {
+    Util::Async::Atomic<uint32_t>(references).inc();
+}
+
+void MemoryMapping::release() {
+    if (Util::Async::Atomic<uint32_t>(references).fetchAndDec() == 1) {
+        delete this;
+    }
+}
+
+bool MemoryMapping::contains(uint32_t address) const {
+    return address >= startAddress && address < endAddress;
+}
+
+void MemoryMapping::handlePageFault(uint32_t address) {
+    auto &memoryService = Service::getService<MemoryService>();
+    auto &addressSpace = memoryService.getCurrentAddressSpace();
+    uint32_t page = address & ~(Util::PAGESIZE - 1);
+    uint32_t pageEnd = page + Util::PAGESIZE;
+    uint32_t copyStart = page > dataStart ? page : dataStart;
+    uint32_t copyEnd = pageEnd < dataEnd ? pageEnd : dataEnd;
+    bool fileBacked = file != nullptr && copyStart < copyEnd;
+
+    void *frame = nullptr;
+    bool cachedFrame = false;
+
+    // Shared mappings also map the last page of a file from the page cache, since it is filled with zeros behind the end of the file
+    if (fileBacked && copyStart == page && (copyEnd == pageEnd || type == SHARED)) {
+        uint32_t pageOffset = fileOffset + (page - dataStart);
+        if (pageOffset % Util::PAGESIZE == 0) {
+            // The whole page is backed by a page of the file -> Map the frame from the page cache
+            frame = file->getFrame(pageOffset / Util::PAGESIZE);
+            cachedFrame = frame != nullptr;
+        }
+    }
+
+    if (frame == nullptr) {
+        // Private page -> Take a zeroed frame and fill in the file data, that belongs to this page
+        frame = memoryService.allocateZeroedPageFrame();
+        if (fileBacked) {
+            auto *window = MappedFile::mapFrame(frame);
+            file->read(window + (copyStart - page), fileOffset + (copyStart - dataStart), copyEnd - copyStart);
+            MappedFile::unmapFrame(window);
+        }
+    }
+
+    // Another thread may have removed the mapping or mapped the same page, while this one was reading from the file
+    lock.acquire();
+    auto *virtualAddress = reinterpret_cast<void*>(page);
+    bool mapped = !removed && addressSpace.getPhysicalAddress(virtualAddress) == nullptr;
+    if (mapped) {
+        if (cachedFrame) {
+            memoryService.mapShared(frame, virtualAddress, flags, type != SHARED);
+        } else {
+            addressSpace.map(frame, virtualAddress, flags);
+        }
+    }
+    lock.release();
+
+    if (!mapped && !cachedFrame) {
+        memoryService.freePhysicalMemory(frame, 1);
+    }
+}
+
+void MemoryMapping::remove() {
+    lock.acquire();
+    removed = true;
+    lock.release();
+}
+
+void MemoryMapping::writeBack() {
+    if (type != SHARED || file == nullptr || (flags & Paging::WRITABLE) == 0) {
+        return;
+    }
+
+    // The dirty flag is set by the CPU, when a page is written to
+    auto &addressSpace = Service::getService<MemoryService>().getCurrentAddressSpace();
+    uint32_t end = dataEnd < endAddress ? dataEnd : endAddress;
+    for (uint32_t page = startAddress; page < end; page += Util::PAGESIZE) {
+        if (addressSpace.getFlags(reinterpret_cast<void*>(page)) & Paging::DIRTY) {
+            file->writeBack((fileOffset + (page - dataStart)) / Util::PAGESIZE);
+        }
+    }
+}
+
+MemoryMapping::Type MemoryMapping::getType() const {
+    return type;
+}
+
+uint32_t MemoryMapping::getStartAddress() const {
+    return startAddress;
+}
+
+uint32_t MemoryMapping::getEndAddress() const {
+    return endAddress;
+}
+
+uint16_t MemoryMapping::getFlags() const {
+    return flags;
+}
+
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_MEMORYMAPPING_H
+#define HHUOS_MEMORYMAPPING_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Spinlock.h"
+
+namespace Kernel {
+class MappedFile;
+
+/**
+ * A range of virtual memory in an address space, whose pages are mapped on demand by the page fault handler.
+ * Pages inside [dataStart, dataEnd) contain file data, all other pages of the range are filled with zeros.
+ * Pages completely filled with file data at a page aligned file offset are mapped from the file's page cache
+ * (read-only, or copy-on-write for writable private mappings). Pages that are only partially backed by the file
+ * (e.g. the boundary between .data and .bss) get a private copy.
+ *
+ * A mapping is reference counted, so that it can be removed from its address space,
+ * while another thread of the same process is still handling a page fault inside of it.
+ * Such a page fault does not map its page, once the mapping has been removed.
+ */
+class MemoryMapping {
+
+public:
+
+    enum Type : uint8_t {
+        // Segments of the running program, which exist as long as the address space
+        IMAGE,
+        // Mappings created via Util::System::MAP, whose pages are only visible to the current address space
+        PRIVATE,
+        // File mappings created via Util::System::MAP, whose pages are shared with all other shared mappings of the same file
+        SHARED
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param type The type of the mapping
+     * @param startAddress The page aligned start address of the mapping
+     * @param endAddress The page aligned end address of the mapping (exclusive)
+     * @param flags The paging flags for all pages of the mapping
+     * @param file The file backing the mapping (the mapping acquires its own reference), or nullptr for an anonymous mapping
+     * @param dataStart The virtual address, at which the file data starts
+     * @param dataEnd The virtual address, at which the file data ends (exclusive)
+     * @param fileOffset The file offset of the data located at dataStart
+     */
+    MemoryMapping(Type type, uint32_t startAddress, uint32_t endAddress, uint16_t flags, MappedFile *file = nullptr, uint32_t dataStart = 0, uint32_t dataEnd = 0, uint32_t fileOffset = 0);
+
+    /**
+     * Copy Constructor.
+     */
+    MemoryMapping(const MemoryMapping &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    MemoryMapping &operator=(const MemoryMapping &other) = delete;
+
+    /**
+     * Acquire an additional reference to this mapping.
+     */
+    void acquire();
+
+    /**
+     * Release a reference to this mapping and delete it, if it was the last one.
+     */
+    void release();
+
+    [[nodiscard]] bool contains(uint32_t address) const;
+
+    /**
+     * Map the page containing the given address into the current address space.
+     * The page is prepared without holding any lock (reading file data may block) and only mapped,
+     * if the mapping has not been removed in the meantime and no other thread has mapped the page already.
+     */
+    void handlePageFault(uint32_t address);
+
+    /**
+     * Mark this mapping as removed, so that page faults, which are still being handled, do not map any more pages.
+     * Pages, that are already mapped, must be unmapped by the caller afterward.
+     */
+    void remove();
+
+    /**
+     * Write all modified pages of a shared mapping back to the file.
+     * Must be called in the mapping's address space, before its pages are unmapped.
+     */
+    void writeBack();
+
+    [[nodiscard]] Type getType() const;
+
+    [[nodiscard]] uint32_t getStartAddress() const;
+
+    [[nodiscard]] uint32_t getEndAddress() const;
+
+    [[nodiscard]] uint16_t getFlags() const;
+
+private:
+    /**
+     * Destructor.
+     * Releases the reference to the backing file. Pages, that are still mapped, keep their own frame references.
+     * Private, since a mapping is only deleted by release().
+     */
+    ~MemoryMapping();
+
+    Type type;
+    uint32_t startAddress;
+    uint32_t endAddress;
+    uint16_t flags;
+
+    MappedFile *file;
+    uint32_t dataStart;
+    uint32_t dataEnd;
+    uint32_t fileOffset;
+
+    uint32_t references = 1;
+    bool removed = false;
+    Util::Async::Spinlock lock;
+};
+
+}
+
+#endif
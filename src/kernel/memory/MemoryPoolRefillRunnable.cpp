@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "MemoryPoolRefillRunnable.h"
+
+#include "kernel/memory/PagingAreaManager.h"
+#include "kernel/memory/ZeroedPageFramePool.h"
+#include "kernel/process/Scheduler.h"
+#include "kernel/service/ProcessService.h"
+#include "kernel/service/Service.h"
+#include "lib/util/async/Atomic.h"
+
+namespace Kernel {
+
+Thread *MemoryPoolRefillRunnable::refillThread = nullptr;
+uint32_t MemoryPoolRefillRunnable::waitState = Scheduler::INTERRUPT_SIGNALED;
+
+MemoryPoolRefillRunnable::MemoryPoolRefillRunnable(PagingAreaManager &pagingAreaManager, ZeroedPageFramePool &zeroedPageFramePool) :
+        pagingAreaManager(pagingAreaManager), zeroedPageFramePool(zeroedPageFramePool) {}
+
+void MemoryPoolRefillRunnable::run() {
+    auto &processService = Service::getService<ProcessService>();
+    refillThread = &processService.getScheduler().getCurrentThread();
+
+    while (true) {
+        // Requests arriving while the pools are refilled switch the state to signaled, so that the thread does not block afterward
+        Util::Async::Atomic<uint32_t>(waitState).set(Scheduler::INTERRUPT_PENDING);
+
+        // Page tables are needed to map frames, so the paging area pool is refilled first
+        pagingAreaManager.refillPool();
+        zeroedPageFramePool.refill();
+
+        processService.getScheduler().blockForInterrupt(waitState);
+    }
+}
+
+void MemoryPoolRefillRunnable::requestRefill() {
+    if (refillThread != nullptr) {
+        Scheduler::signalFromInterrupt(waitState, *refillThread);
+    }
+}
+
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_MEMORYPOOLREFILLRUNNABLE_H
+#define HHUOS_MEMORYPOOLREFILLRUNNABLE_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Runnable.h"
+
+namespace Kernel {
+class PagingAreaManager;
+class Thread;
+class ZeroedPageFramePool;
+
+/**
+ * Background thread, which keeps the pools of pre-zeroed memory filled:
+ * The paging area manager's pool of page table blocks and the pool of zeroed page frames.
+ * The thread is blocked until one of the pools drops below its low watermark and requests a refill via requestRefill().
+ */
+class MemoryPoolRefillRunnable : public Util::Async::Runnable {
+
+public:
+    /**
+     * Constructor.
+     */
+    MemoryPoolRefillRunnable(PagingAreaManager &pagingAreaManager, ZeroedPageFramePool &zeroedPageFramePool);
+
+    /**
+     * Copy Constructor.
+     */
+    MemoryPoolRefillRunnable(const MemoryPoolRefillRunnable &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    MemoryPoolRefillRunnable &operator=(const MemoryPoolRefillRunnable &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~MemoryPoolRefillRunnable() override = default;
+
+    void run() override;
+
+    /**
+     * Wake up the refill thread. Called by the pools, when they drop below their low watermark.
+     * No locks are acquired, so this is safe to call while allocating memory (e.g. in the page fault handler).
+     */
+    static void requestRefill();
+
+private:
+
+    PagingAreaManager &pagingAreaManager;
+    ZeroedPageFramePool &zeroedPageFramePool;
+
+    // There is only a single refill thread, so the pools do not need to know the runnable
+    static Thread *refillThread;
+    static uint32_t waitState;
+};
+
+}
+
+#endif
@@ -33,10 +33,26 @@ Util::String MemoryStatusNode::formatMemory(uint32_t value) {
 }
 
 Util::String MemoryStatusNode::getString() {
-    auto memoryStatus = Kernel::Service::getService<Kernel::MemoryService>().getMemoryStatus();
-    return "Physical:      " + formatMemory(memoryStatus.freePhysicalMemory) + " / " + formatMemory(memoryStatus.totalPhysicalMemory) + "\n"
+    auto &memoryService = Kernel::Service::getService<Kernel::MemoryService>();
+    auto memoryStatus = memoryService.getMemoryStatus();
+    auto string = "Physical:      " + formatMemory(memoryStatus.freePhysicalMemory) + " / " + formatMemory(memoryStatus.totalPhysicalMemory) + "\n"
             + "Kernel:        " + formatMemory(memoryStatus.freeKernelHeapMemory) + " / " + formatMemory(memoryStatus.totalKernelHeapMemory) + "\n"
-            + "Paging Area:   " + formatMemory(memoryStatus.freePagingAreaMemory) + " / " + formatMemory(memoryStatus.totalPagingAreaMemory) + "\n";
+            + "Paging Area:   " + formatMemory(memoryStatus.freePagingAreaMemory) + " / " + formatMemory(memoryStatus.totalPagingAreaMemory) + "\n"
+            + Util::String::format("Zeroed frames: %u / %u\n", memoryService.getZeroedPageFramePool().getFrameCount(), ZeroedPageFramePool::CAPACITY);
+
+    auto caches = memoryService.getSlabCaches();
+    if (caches.length() > 0) {
+        string += "\nSlab caches (used objects / total objects, object size, slabs, empty slabs, allocations, reclaimed slabs):\n";
+    }
+
+    for (auto *cache : caches) {
+        auto statistics = cache->getStatistics();
+        string += Util::String::format("%s: %u / %u, %u B, %u x %u KiB, %u, %u, %u\n", static_cast<const char*>(cache->getName()),
+                statistics.usedObjects, statistics.totalObjects, statistics.objectSize, statistics.slabCount, statistics.slabSize / 1024,
+                statistics.emptySlabCount, statistics.allocations, statistics.reclaimedSlabs);
+    }
+
+    return string;
 }
 
 }
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include "kernel/memory/PagingAreaManager.h"
 #include "kernel/memory/TableMemoryManager.h"
 #include "device/bus/isa/Isa.h"
+#include "device/system/Bios.h"
 #include "lib/util/base/Constants.h"
 
 extern const uint32_t ___KERNEL_DATA_END__;
@@ -26,9 +27,35 @@ const uint32_t KERNEL_DATA_END = reinterpret_cast<uint32_t>(&___KERNEL_DATA_END_
 
 namespace Kernel {
 
-PageFrameAllocator::PageFrameAllocator(PagingAreaManager &pagingAreaManager, uint8_t *startAddress, uint8_t *endAddress) : TableMemoryManager(pagingAreaManager, startAddress, endAddress, Util::PAGESIZE) {}
+PageFrameAllocator::PageFrameAllocator(PagingAreaManager &pagingAreaManager, uint8_t *startAddress, uint8_t *endAddress) : TableMemoryManager(pagingAreaManager, startAddress, endAddress, Util::PAGESIZE),
+        firstFrame(reinterpret_cast<uint32_t>(startAddress) / Util::PAGESIZE), frameCount((endAddress - startAddress + 1) / Util::PAGESIZE) {
+    const uint32_t zoneBoundaries[] = { 0, (Device::Bios::MAX_USABLE_ADDRESS + 1) / Util::PAGESIZE, Device::Isa::MAX_DMA_ADDRESS / Util::PAGESIZE, firstFrame + frameCount };
+
+    for (uint32_t i = 0; i <= HIGH_MEMORY; i++) {
+        auto &zone = zones[i];
+        zone.startFrame = zoneBoundaries[i] < firstFrame ? firstFrame : zoneBoundaries[i];
+        zone.endFrame = zoneBoundaries[i + 1] > firstFrame + frameCount ? firstFrame + frameCount : zoneBoundaries[i + 1];
+        if (zone.endFrame < zone.startFrame) {
+            zone.endFrame = zone.startFrame;
+        }
+
+        for (auto &freeList : zone.freeLists) {
+            freeList = INVALID_FRAME;
+        }
+    }
+}
+
+PageFrameAllocator::~PageFrameAllocator() {
+    delete[] freeBlockOrders;
+    delete[] nextFreeBlocks;
+    delete[] previousFreeBlocks;
+}
 
 void* PageFrameAllocator::allocateBlock() {
+    if (buddySystemEnabled) {
+        return allocateBlocks(1, HIGH_MEMORY);
+    }
+
     // Try to allocate memory over 16 MiB, to leave free memory for ISA DMA transfers
     auto *ret = TableMemoryManager::allocateBlockAfterAddress(reinterpret_cast<void*>(Device::Isa::MAX_DMA_ADDRESS));
     if (ret == nullptr) {
@@ -46,4 +73,357 @@ void* PageFrameAllocator::allocateBlock() {
     return ret;
 }
 
-}
\ No newline at end of file
+void* PageFrameAllocator::allocateBlocks(uint32_t count, Zone zone) {
+    auto order = calculateOrder(count);
+    if (count == 0 || order > MAX_ORDER) {
+        return nullptr;
+    }
+
+    if (!buddySystemEnabled) {
+        return allocateBlocksLinear(count, zone);
+    }
+
+    lock.acquire();
+
+    Zone fallbackOrder[HIGH_MEMORY + 1];
+    getFallbackOrder(zone, fallbackOrder);
+
+    auto frame = INVALID_FRAME;
+    for (uint32_t i = 0; i <= HIGH_MEMORY && frame == INVALID_FRAME; i++) {
+        frame = takeBlock(zones[fallbackOrder[i]], order);
+    }
+
+    if (frame == INVALID_FRAME) {
+        lock.release();
+        return nullptr;
+    }
+
+    // Give the unneeded end of the block back, by splitting it up into the largest possible aligned blocks.
+    // These cannot be merged with any buddy, since each of their buddies overlaps the allocated frames.
+    auto &zoneDescriptor = getZoneDescriptor(frame);
+    auto current = frame + count;
+    const auto end = frame + (1 << order);
+    while (current < end) {
+        uint32_t blockOrder = 0;
+        while (current % (1 << (blockOrder + 1)) == 0 && current + (1 << (blockOrder + 1)) <= end) {
+            blockOrder++;
+        }
+
+        insertBlock(zoneDescriptor, current, blockOrder);
+        current += 1 << blockOrder;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        static_cast<void>(TableMemoryManager::allocateBlockAtAddress(reinterpret_cast<void*>((frame + i) * Util::PAGESIZE)));
+    }
+
+    lock.release();
+    return reinterpret_cast<void*>(frame * Util::PAGESIZE);
+}
+
+void* PageFrameAllocator::allocateBlockAtAddress(void *address) {
+    auto frame = reinterpret_cast<uint32_t>(address) / Util::PAGESIZE;
+    if (!buddySystemEnabled || frame < firstFrame || frame >= firstFrame + frameCount) {
+        return TableMemoryManager::allocateBlockAtAddress(address);
+    }
+
+    // A free frame must be taken out of its free block, before it is in use
+    lock.acquire();
+    static_cast<void>(takeFrame(frame));
+    auto *ret = TableMemoryManager::allocateBlockAtAddress(address);
+    lock.release();
+
+    return ret;
+}
+
+void PageFrameAllocator::freeBlock(void *pointer) {
+    auto frame = reinterpret_cast<uint32_t>(pointer) / Util::PAGESIZE;
+    if (!buddySystemEnabled || frame < firstFrame || frame >= firstFrame + frameCount) {
+        TableMemoryManager::freeBlock(pointer);
+        return;
+    }
+
+    lock.acquire();
+    TableMemoryManager::freeBlock(pointer);
+    if (isFrameFree(frame)) {
+        releaseFrame(frame);
+    }
+    lock.release();
+}
+
+void PageFrameAllocator::setMemory(uint8_t *start, uint8_t *end, uint16_t useCount, bool reserved) {
+    if (!buddySystemEnabled) {
+        TableMemoryManager::setMemory(start, end, useCount, reserved);
+        return;
+    }
+
+    auto startFrame = reinterpret_cast<uint32_t>(start) / Util::PAGESIZE;
+    auto endFrame = reinterpret_cast<uint32_t>(end) / Util::PAGESIZE;
+    if (startFrame < firstFrame) {
+        startFrame = firstFrame;
+    }
+    if (endFrame >= firstFrame + frameCount) {
+        endFrame = firstFrame + frameCount - 1;
+    }
+
+    // Take all affected frames out of the buddy system and give back the ones, that are still free afterward
+    lock.acquire();
+    for (auto frame = startFrame; frame <= endFrame; frame++) {
+        static_cast<void>(takeFrame(frame));
+    }
+
+    TableMemoryManager::setMemory(start, end, useCount, reserved);
+
+    for (auto frame = startFrame; frame <= endFrame; frame++) {
+        if (isFrameFree(frame)) {
+            releaseFrame(frame);
+        }
+    }
+    lock.release();
+}
+
+void PageFrameAllocator::referenceBlock(void *address) {
+    // Allocating a block at a specific address increments its use count, regardless of the block already being in use
+    static_cast<void>(allocateBlockAtAddress(address));
+}
+
+uint16_t PageFrameAllocator::getReferenceCount(void *address) const {
+    return getUseCount(address);
+}
+
+void PageFrameAllocator::enableBuddySystem() {
+    // Initializing the arrays maps all of their pages, so that no page fault (which needs a page frame) occurs while holding the lock
+    freeBlockOrders = new uint8_t[frameCount];
+    nextFreeBlocks = new uint32_t[frameCount];
+    previousFreeBlocks = new uint32_t[frameCount];
+    for (uint32_t i = 0; i < frameCount; i++) {
+        freeBlockOrders[i] = 0;
+        nextFreeBlocks[i] = INVALID_FRAME;
+        previousFreeBlocks[i] = INVALID_FRAME;
+    }
+
+    lock.acquire();
+
+    // Fill each zone with the largest aligned blocks, that consist of free frames only
+    for (auto &zone : zones) {
+        auto frame = zone.startFrame;
+        while (frame < zone.endFrame) {
+            if (!isFrameFree(frame)) {
+                frame++;
+                continue;
+            }
+
+            uint32_t order = 0;
+            while (order < MAX_ORDER && frame % (1 << (order + 1)) == 0 && frame + (1 << (order + 1)) <= zone.endFrame) {
+                // The block can only be doubled, if the upper half is completely free as well
+                bool upperHalfFree = true;
+                for (auto i = frame + (1 << order); i < frame + (1 << (order + 1)); i++) {
+                    if (!isFrameFree(i)) {
+                        upperHalfFree = false;
+                        break;
+                    }
+                }
+
+                if (!upperHalfFree) {
+                    break;
+                }
+
+                order++;
+            }
+
+            insertBlock(zone, frame, order);
+            frame += 1 << order;
+        }
+    }
+
+    buddySystemEnabled = true;
+    lock.release();
+}
+
+uint32_t PageFrameAllocator::getFreeMemory() const {
+    if (!buddySystemEnabled) {
+        return TableMemoryManager::getFreeMemory();
+    }
+
+    uint32_t freeFrames = 0;
+    for (const auto &zone : zones) {
+        freeFrames += zone.freeFrames;
+    }
+
+    return freeFrames * Util::PAGESIZE;
+}
+
+PageFrameAllocator::Zone PageFrameAllocator::getZone(const void *address) {
+    if (reinterpret_cast<uint32_t>(address) <= Device::Bios::MAX_USABLE_ADDRESS) {
+        return LOWER_MEMORY;
+    }
+
+    return reinterpret_cast<uint32_t>(address) < Device::Isa::MAX_DMA_ADDRESS ? ISA_DMA : HIGH_MEMORY;
+}
+
+void* PageFrameAllocator::allocateBlocksLinear(uint32_t count, Zone zone) {
+    // Only used while booting, before the buddy system is enabled (e.g. for the slab allocator's memory), so there is no need for locking
+    Zone fallbackOrder[HIGH_MEMORY + 1];
+    getFallbackOrder(zone, fallbackOrder);
+
+    for (auto currentZone : fallbackOrder) {
+        auto &zoneDescriptor = zones[currentZone];
+        auto runStart = zoneDescriptor.startFrame;
+        for (auto frame = zoneDescriptor.startFrame; frame < zoneDescriptor.endFrame; frame++) {
+            if (!isFrameFree(frame)) {
+                runStart = frame + 1;
+                continue;
+            }
+
+            if (frame + 1 - runStart == count) {
+                for (auto i = runStart; i <= frame; i++) {
+                    static_cast<void>(TableMemoryManager::allocateBlockAtAddress(reinterpret_cast<void*>(i * Util::PAGESIZE)));
+                }
+
+                return reinterpret_cast<void*>(runStart * Util::PAGESIZE);
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+void PageFrameAllocator::getFallbackOrder(Zone zone, Zone (&fallbackOrder)[HIGH_MEMORY + 1]) {
+    // The preferred zone comes first, followed by the lower zones (from high to low) and finally the higher zones
+    uint32_t index = 0;
+    for (int32_t i = zone; i >= 0; i--) {
+        fallbackOrder[index++] = static_cast<Zone>(i);
+    }
+    for (uint32_t i = zone + 1; i <= HIGH_MEMORY; i++) {
+        fallbackOrder[index++] = static_cast<Zone>(i);
+    }
+}
+
+uint32_t PageFrameAllocator::takeBlock(ZoneDescriptor &zone, uint32_t order) {
+    // Find the smallest free block, that is large enough
+    auto blockOrder = order;
+    while (blockOrder <= MAX_ORDER && zone.freeLists[blockOrder] == INVALID_FRAME) {
+        blockOrder++;
+    }
+
+    if (blockOrder > MAX_ORDER) {
+        return INVALID_FRAME;
+    }
+
+    auto frame = zone.freeLists[blockOrder];
+    removeBlock(zone, frame, blockOrder);
+
+    // Split the block into halves, until it has the requested order, and keep the upper halves in the free lists
+    while (blockOrder > order) {
+        blockOrder--;
+        insertBlock(zone, frame + (1 << blockOrder), blockOrder);
+    }
+
+    return frame;
+}
+
+void PageFrameAllocator::releaseFrame(uint32_t frame) {
+    auto &zone = getZoneDescriptor(frame);
+
+    // Merge the block with its buddy, as long as the buddy is a free block of the same order
+    uint32_t order = 0;
+    while (order < MAX_ORDER) {
+        auto buddy = frame ^ (1 << order);
+        if (buddy < zone.startFrame || buddy + (1 << order) > zone.endFrame || freeBlockOrders[buddy - firstFrame] != order + 1) {
+            break;
+        }
+
+        removeBlock(zone, buddy, order);
+        frame &= ~(1 << order);
+        order++;
+    }
+
+    insertBlock(zone, frame, order);
+}
+
+bool PageFrameAllocator::takeFrame(uint32_t frame) {
+    auto &zone = getZoneDescriptor(frame);
+
+    // Find the free block containing the frame (its start is the frame, aligned down to the block size)
+    for (uint32_t order = 0; order <= MAX_ORDER; order++) {
+        auto blockStart = frame & ~((1 << order) - 1);
+        if (blockStart < zone.startFrame) {
+            return false;
+        }
+
+        if (freeBlockOrders[blockStart - firstFrame] != order + 1) {
+            continue;
+        }
+
+        // Split the block up and give back all halves, that do not contain the frame
+        removeBlock(zone, blockStart, order);
+        while (order > 0) {
+            order--;
+            auto half = 1u << order;
+            if (frame >= blockStart + half) {
+                insertBlock(zone, blockStart, order);
+                blockStart += half;
+            } else {
+                insertBlock(zone, blockStart + half, order);
+            }
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void PageFrameAllocator::insertBlock(ZoneDescriptor &zone, uint32_t frame, uint32_t order) {
+    auto index = frame - firstFrame;
+    auto head = zone.freeLists[order];
+
+    freeBlockOrders[index] = order + 1;
+    previousFreeBlocks[index] = INVALID_FRAME;
+    nextFreeBlocks[index] = head;
+    if (head != INVALID_FRAME) {
+        previousFreeBlocks[head - firstFrame] = frame;
+    }
+
+    zone.freeLists[order] = frame;
+    zone.freeFrames += 1 << order;
+}
+
+void PageFrameAllocator::removeBlock(ZoneDescriptor &zone, uint32_t frame, uint32_t order) {
+    auto index = frame - firstFrame;
+    auto next = nextFreeBlocks[index];
+    auto previous = previousFreeBlocks[index];
+
+    if (previous == INVALID_FRAME) {
+        zone.freeLists[order] = next;
+    } else {
+        nextFreeBlocks[previous - firstFrame] = next;
+    }
+
+    if (next != INVALID_FRAME) {
+        previousFreeBlocks[next - firstFrame] = previous;
+    }
+
+    freeBlockOrders[index] = 0;
+    zone.freeFrames -= 1 << order;
+}
+
+PageFrameAllocator::ZoneDescriptor& PageFrameAllocator::getZoneDescriptor(uint32_t frame) {
+    return zones[getZone(reinterpret_cast<void*>(frame * Util::PAGESIZE))];
+}
+
+bool PageFrameAllocator::isFrameFree(uint32_t frame) {
+    auto *address = reinterpret_cast<void*>(frame * Util::PAGESIZE);
+    return getUseCount(address) == 0 && !isReserved(address);
+}
+
+uint32_t PageFrameAllocator::calculateOrder(uint32_t count) {
+    uint32_t order = 0;
+    while (order <= MAX_ORDER && (1u << order) < count) {
+        order++;
+    }
+
+    return order;
+}
+
+}
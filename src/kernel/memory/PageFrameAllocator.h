@@ -21,6 +21,7 @@
 #include <stdint.h>
 
 #include "TableMemoryManager.h"
+#include "lib/util/async/Spinlock.h"
 
 namespace Kernel {
 class PagingAreaManager;
@@ -28,12 +29,32 @@ class PagingAreaManager;
 /**
  * Memory manager, that ist based on the BitmapMemoryManager and is used to manage the page frames in physical memory.
  *
+ * The allocation tables of the TableMemoryManager keep track of the use count of each page frame.
+ * On top of them, free page frames are organized in a buddy system, once it has been enabled:
+ * Free frames are grouped into naturally aligned blocks of 2^order frames, which are kept in one free list per order and zone.
+ * Allocating n contiguous frames takes the smallest free block with at least n frames and splits it up,
+ * while freed blocks are merged with their buddy, if it is free as well. Both operations take O(log n) steps.
+ *
  * @author Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
  * @date 2018
  */
 class PageFrameAllocator : public TableMemoryManager {
 
 public:
+
+    /**
+     * Physical memory is divided into zones, so that memory, which is needed for special purposes, is not used up by regular allocations.
+     * Blocks never cross zone boundaries.
+     */
+    enum Zone : uint8_t {
+        // Below 1 MiB (needed for BIOS calls)
+        LOWER_MEMORY = 0,
+        // Between 1 MiB and 16 MiB (needed for ISA DMA transfers)
+        ISA_DMA = 1,
+        // Above 16 MiB
+        HIGH_MEMORY = 2
+    };
+
     /**
      * Constructor.
      */
@@ -52,9 +73,124 @@ public:
     /**
      * Destructor.
      */
-     ~PageFrameAllocator() override = default;
+     ~PageFrameAllocator() override;
 
      void* allocateBlock() override;
+
+    /**
+     * Allocate physically contiguous page frames.
+     * The given zone is tried first. If it has no sufficiently large block left, the zones below it are tried (from high to low),
+     * followed by the zones above it. Callers, which need memory from a specific zone, have to check the returned address.
+     *
+     * @param frameCount The amount of page frames
+     * @param zone The preferred zone
+     * @return The physical start address, or nullptr if no contiguous block of the requested size is available
+     */
+    [[nodiscard]] void* allocateBlocks(uint32_t frameCount, Zone zone = HIGH_MEMORY);
+
+    /**
+     * Increment the use count of the page frame at the given address, regardless of it being in use already.
+     * If the frame is free, it is taken out of the buddy system.
+     */
+    [[nodiscard]] void* allocateBlockAtAddress(void *address);
+
+    void freeBlock(void *pointer) override;
+
+    void setMemory(uint8_t *start, uint8_t *end, uint16_t useCount, bool reserved);
+
+    /**
+     * Add a reference to an already allocated page frame, which is going to be mapped into another address space (or kept in a cache).
+     * The frame is only released, after freeBlock() has been called once for each reference.
+     *
+     * @param address The physical address of the page frame
+     */
+    void referenceBlock(void *address);
+
+    /**
+     * Check how many references to a page frame exist (e.g. to decide, if a copy-on-write page must be copied).
+     *
+     * @param address The physical address of the page frame
+     */
+    [[nodiscard]] uint16_t getReferenceCount(void *address) const;
+
+    /**
+     * Build the free lists of the buddy system from the allocation tables and use them for all further allocations.
+     * Until then, frames are allocated by searching the allocation tables linearly.
+     * The free lists need memory on the kernel heap, so this can only be done after page faults can be handled.
+     */
+    void enableBuddySystem();
+
+    [[nodiscard]] uint32_t getFreeMemory() const override;
+
+    /**
+     * Get the zone, that contains the given physical address.
+     */
+    [[nodiscard]] static Zone getZone(const void *address);
+
+    // Blocks can contain up to 2^MAX_ORDER frames (16 MiB)
+    static const constexpr uint32_t MAX_ORDER = 12;
+
+private:
+
+    struct ZoneDescriptor {
+        uint32_t startFrame;
+        uint32_t endFrame;
+        uint32_t freeFrames;
+        uint32_t freeLists[MAX_ORDER + 1];
+    };
+
+    /**
+     * Allocate contiguous frames by searching the allocation tables linearly (used before the buddy system is enabled).
+     */
+    void* allocateBlocksLinear(uint32_t frameCount, Zone zone);
+
+    /**
+     * Get the order, in which zones are tried, if the given zone is preferred.
+     */
+    static void getFallbackOrder(Zone zone, Zone (&fallbackOrder)[HIGH_MEMORY + 1]);
+
+    /**
+     * Take a free block of at least 2^order frames from the given zone and split it up, until it has the requested order.
+     *
+     * @return The first frame of the block, or INVALID_FRAME if the zone has no large enough block left
+     */
+    uint32_t takeBlock(ZoneDescriptor &zone, uint32_t order);
+
+    /**
+     * Give a single frame back to the buddy system and merge it with its buddies, as far as possible.
+     */
+    void releaseFrame(uint32_t frame);
+
+    /**
+     * Take a single free frame out of the buddy system, by splitting up the block containing it.
+     *
+     * @return false, if the frame is not free
+     */
+    bool takeFrame(uint32_t frame);
+
+    void insertBlock(ZoneDescriptor &zone, uint32_t frame, uint32_t order);
+
+    void removeBlock(ZoneDescriptor &zone, uint32_t frame, uint32_t order);
+
+    [[nodiscard]] ZoneDescriptor& getZoneDescriptor(uint32_t frame);
+
+    [[nodiscard]] bool isFrameFree(uint32_t frame);
+
+    [[nodiscard]] static uint32_t calculateOrder(uint32_t frameCount);
+
+    Util::Async::Spinlock lock;
+    bool buddySystemEnabled = false;
+
+    uint32_t firstFrame;
+    uint32_t frameCount;
+    ZoneDescriptor zones[HIGH_MEMORY + 1]{};
+
+    // Indexed by frame (relative to 'firstFrame') and only valid for the first frame of a free block
+    uint8_t *freeBlockOrders = nullptr; // Order + 1 for the first frame of a free block, 0 for all other frames
+    uint32_t *nextFreeBlocks = nullptr;
+    uint32_t *previousFreeBlocks = nullptr;
+
+    static const constexpr uint32_t INVALID_FRAME = 0xffffffff;
 };
 
 }
@@ -17,6 +17,7 @@
 
 #include "Paging.h"
 #include "lib/util/base/Address.h"
+#include "lib/util/base/Constants.h"
 #include "device/cpu/Cpu.h"
 
 namespace Kernel {
@@ -64,4 +65,40 @@ void Paging::loadDirectory(const Paging::Table &directory) {
     Device::Cpu::writeCr3(&directory);
 }
 
+void Paging::invalidate(const void *virtualAddress) {
+    asm volatile(
+            "invlpg (%0)"
+            : :
+            "r"(virtualAddress)
+            : "memory"
+            );
+}
+
+void Paging::invalidate(const void *virtualAddress, uint32_t pageCount) {
+    if (pageCount > MAX_SINGLE_INVALIDATIONS) {
+        flush();
+        return;
+    }
+
+    for (uint32_t i = 0; i < pageCount; i++) {
+        invalidate(reinterpret_cast<const uint8_t*>(virtualAddress) + i * Util::PAGESIZE);
+    }
+}
+
+void Paging::flush() {
+    auto cr4 = Device::Cpu::readCr4();
+    if (cr4 & Device::Cpu::PAGE_GLOBAL_ENABLE) {
+        // Toggling CR4.PGE flushes all entries, including global pages
+        Device::Cpu::writeCr4(cr4 & ~Device::Cpu::PAGE_GLOBAL_ENABLE);
+        Device::Cpu::writeCr4(cr4);
+    } else {
+        // Reloading CR3 flushes all entries, if there are no global pages
+        Device::Cpu::writeCr3(Device::Cpu::readCr3());
+    }
+}
+
+uint16_t Paging::getKernelPageFlags() {
+    return (Device::Cpu::readCr4() & Device::Cpu::PAGE_GLOBAL_ENABLE) ? GLOBAL : NONE;
+}
+
 }
\ No newline at end of file
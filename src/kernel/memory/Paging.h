@@ -34,6 +34,9 @@ public:
 
     static const constexpr uint32_t ENTRIES_PER_TABLE = 1024;
 
+    // Size of a large page, which is mapped by a single page directory entry (needs CR4.PSE)
+    static const constexpr uint32_t LARGE_PAGESIZE = 4 * 1024 * 1024;
+
     enum Flags : uint32_t {
         // System defined flags
         NONE = 0x00,
@@ -46,6 +49,8 @@ public:
         DIRTY = 0x40,
         HUGE_PAGE = 0x80,
         GLOBAL = 0x100,
+        // Operating system defined flags (stored in the bits ignored by the MMU)
+        COPY_ON_WRITE = 0x200
     };
 
     struct Entry {
@@ -92,6 +97,33 @@ public:
 
     static void loadDirectory(const Table &directory);
 
+    /**
+     * Invalidate the TLB entry of a single page on the current CPU (works for global and large pages as well).
+     */
+    static void invalidate(const void *virtualAddress);
+
+    /**
+     * Invalidate the TLB entries of a range of pages on the current CPU.
+     * Invalidating many pages one by one is slower than refilling the TLB,
+     * so ranges with more than MAX_SINGLE_INVALIDATIONS pages flush the whole TLB instead.
+     */
+    static void invalidate(const void *virtualAddress, uint32_t pageCount);
+
+    /**
+     * Flush the whole TLB of the current CPU, including global pages.
+     */
+    static void flush();
+
+    /**
+     * Get the flag, that should be set for pages inside the kernel area.
+     * Kernel pages are mapped into every address space, so they can survive address space switches as global pages.
+     *
+     * @return GLOBAL, if global pages are enabled (CR4.PGE), NONE otherwise
+     */
+    static uint16_t getKernelPageFlags();
+
+    static const constexpr uint32_t MAX_SINGLE_INVALIDATIONS = 32;
+
     static constexpr uint32_t DIRECTORY_INDEX(uint32_t virtualAddress) {
         return virtualAddress >> 22;
     }
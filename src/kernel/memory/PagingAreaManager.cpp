@@ -16,6 +16,7 @@
  */
 
 #include "MemoryLayout.h"
+#include "MemoryPoolRefillRunnable.h"
 #include "PagingAreaManager.h"
 #include "lib/util/base/Exception.h"
 #include "lib/util/base/Constants.h"
@@ -31,7 +32,12 @@ PagingAreaManager::PagingAreaManager(uint8_t *startAddress, uint32_t mappedPages
 }
 
 void *PagingAreaManager::allocateBlock() {
-    return blockPool.pop();
+    auto *block = blockPool.pop();
+    if (blockPool.getFillingDegree() < BLOCK_POOL_LOW_WATERMARK) {
+        MemoryPoolRefillRunnable::requestRefill();
+    }
+
+    return block;
 }
 
 void PagingAreaManager::freeBlock(void *pointer) {
@@ -39,7 +45,7 @@ void PagingAreaManager::freeBlock(void *pointer) {
 }
 
 void PagingAreaManager::refillPool() {
-    if (blockPool.isFull()) {
+    if (blockPool.getFillingDegree() >= BLOCK_POOL_LOW_WATERMARK) {
         return;
     }
 
@@ -66,6 +66,7 @@ private:
     Util::Pool<void> blockPool;
 
     static const constexpr uint32_t BLOCK_POOL_SIZE = 128;
+    static const constexpr uint32_t BLOCK_POOL_LOW_WATERMARK = 96;
 
 };
 
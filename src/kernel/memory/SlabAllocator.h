@@ -20,18 +20,29 @@
 
 #include <stdint.h>
 
-#include "BitmapMemoryManager.h"
-#include "lib/util/base/MemoryManager.h"
+#include "SlabCache.h"
+#include "lib/util/async/Spinlock.h"
+#include "lib/util/base/HeapMemoryManager.h"
+#include "lib/util/base/String.h"
+#include "lib/util/collection/Array.h"
+#include "lib/util/collection/ArrayList.h"
 
 namespace Kernel {
 
-class SlabAllocator : public Util::MemoryManager {
+/**
+ * Registry of slab caches, which all allocate their slabs from the same backing heap.
+ * Frequently allocated kernel objects of the same type should use their own cache,
+ * instead of allocating them from the general heap.
+ */
+class SlabAllocator {
 
 public:
     /**
-     * Default Constructor.
+     * Constructor.
+     *
+     * @param backend The heap, from which the caches allocate their slabs
      */
-    explicit SlabAllocator(uint8_t *slabMemory);
+    explicit SlabAllocator(Util::HeapMemoryManager &backend);
 
     /**
      * Copy Constructor.
@@ -46,32 +57,41 @@ public:
     /**
      * Destructor.
      */
-    ~SlabAllocator() override = default;
-
-    void *allocateBlock(uint32_t frameCount);
-
-    bool freeBlock(void *pointer);
+    ~SlabAllocator();
 
-    [[nodiscard]] uint32_t getTotalMemory() const override;
-
-    [[nodiscard]] uint32_t getFreeMemory() const override;
+    /**
+     * Create a new cache for objects of the given size.
+     *
+     * @param name The name of the cache (used for statistics)
+     * @param objectSize The size of each object in bytes
+     * @param alignment The alignment of each object (0 for the default alignment)
+     * @param constructor Called for each object, when its slab is created (see SlabCache)
+     * @return The new cache, which stays valid until it is passed to destroyCache()
+     */
+    SlabCache& createCache(const Util::String &name, uint32_t objectSize, uint32_t alignment = 0, void (*constructor)(void*) = nullptr);
 
-    [[nodiscard]] uint8_t* getStartAddress() const override;
+    /**
+     * Remove a cache and return all of its slabs to the backing heap.
+     * None of the cache's objects may be in use anymore.
+     */
+    void destroyCache(SlabCache &cache);
 
-    [[nodiscard]] uint8_t* getEndAddress() const override;
+    /**
+     * Return the empty slabs of all caches to the backing heap.
+     * Since this is called when memory runs low, it does not wait for locks and skips busy caches instead.
+     *
+     * @return The amount of bytes returned to the backing heap
+     */
+    uint32_t reclaim();
 
-    static const constexpr uint32_t MAX_SLAB_SIZE = 128 * 1024;
+    [[nodiscard]] Util::Array<SlabCache*> getCaches();
 
 private:
 
-    BitmapMemoryManager pool4K;
-    BitmapMemoryManager pool8K;
-    BitmapMemoryManager pool16K;
-    BitmapMemoryManager pool32K;
-    BitmapMemoryManager pool64K;
-    BitmapMemoryManager pool128K;
+    Util::HeapMemoryManager &backend;
 
-    static const constexpr uint32_t POOL_SIZE = 1 * 1024 * 1024;
+    Util::ArrayList<SlabCache*> caches;
+    Util::Async::Spinlock lock;
 };
 
 }
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "SlabCache.h"
+
+#include "lib/util/base/Constants.h"
+#include "lib/util/base/Exception.h"
+
+namespace Kernel {
+
+SlabCache::SlabCache(const Util::String &name, uint32_t objectSize, uint32_t alignment, void (*constructor)(void*), Util::HeapMemoryManager &backend) :
+        name(name), objectSize(objectSize), constructor(constructor), backend(backend) {
+    if (alignment == 0) {
+        alignment = DEFAULT_ALIGNMENT;
+    }
+
+    // Objects are aligned relative to their slab, which is at least page aligned
+    if (objectSize == 0 || (alignment & (alignment - 1)) != 0 || alignment > Util::PAGESIZE) {
+        Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "SlabCache: Invalid object size or alignment!");
+    }
+
+    linkOffset = (objectSize + sizeof(uint8_t*) - 1) & ~(sizeof(uint8_t*) - 1);
+    slotSize = (linkOffset + sizeof(uint8_t*) + alignment - 1) & ~(alignment - 1);
+    objectOffset = (sizeof(Slab) + alignment - 1) & ~(alignment - 1);
+
+    // Use the smallest power-of-two slab size, that holds enough objects to keep the slab header overhead low
+    slabSize = Util::PAGESIZE;
+    while (slabSize < MAX_SLAB_SIZE && objectOffset + MIN_OBJECTS_PER_SLAB * slotSize > slabSize) {
+        slabSize *= 2;
+    }
+
+    objectsPerSlab = (slabSize - objectOffset) / slotSize;
+    if (objectsPerSlab == 0) {
+        Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "SlabCache: Object size exceeds maximum slab size!");
+    }
+}
+
+SlabCache::~SlabCache() {
+    Slab *lists[] = {fullSlabs, partialSlabs, emptySlabs};
+    for (auto *list : lists) {
+        while (list != nullptr) {
+            auto *next = list->next;
+            backend.freeMemory(list, slabSize);
+            list = next;
+        }
+    }
+}
+
+void* SlabCache::allocate() {
+    lock.acquire();
+
+    while (partialSlabs == nullptr && emptySlabs == nullptr) {
+        // Another thread may have freed objects while the cache was unlocked, even if the backing heap is exhausted
+        if (!grow() && partialSlabs == nullptr && emptySlabs == nullptr) {
+            lock.release();
+            return nullptr;
+        }
+    }
+
+    void *object;
+    if (partialSlabs != nullptr) {
+        object = takeObject(*partialSlabs, partialSlabs);
+    } else {
+        emptySlabCount--;
+        object = takeObject(*emptySlabs, emptySlabs);
+    }
+
+    usedObjects++;
+    allocations++;
+
+    lock.release();
+    return object;
+}
+
+void SlabCache::free(void *object) {
+    if (object == nullptr) {
+        return;
+    }
+
+    auto *slotAddress = static_cast<uint8_t*>(object);
+    auto &slab = *reinterpret_cast<Slab*>(reinterpret_cast<uint32_t>(object) & ~(slabSize - 1));
+
+    lock.acquire();
+
+    auto wasFull = slab.freeObjects == nullptr;
+    getFreeLink(slotAddress) = slab.freeObjects;
+    slab.freeObjects = slotAddress;
+    slab.usedObjects--;
+    usedObjects--;
+
+    if (slab.usedObjects == 0) {
+        removeSlab(slab, wasFull ? fullSlabs : partialSlabs);
+        insertSlab(slab, emptySlabs);
+        emptySlabCount++;
+    } else if (wasFull) {
+        removeSlab(slab, fullSlabs);
+        insertSlab(slab, partialSlabs);
+    }
+
+    lock.release();
+}
+
+uint32_t SlabCache::reclaim() {
+    // Reclaiming is done under memory pressure (e.g. while handling a page fault), where waiting for a lock might never end
+    if (!lock.tryAcquire()) {
+        return 0;
+    }
+
+    auto *slabs = emptySlabs;
+    auto count = emptySlabCount;
+    emptySlabs = nullptr;
+    emptySlabCount = 0;
+    slabCount -= count;
+    reclaimedSlabs += count;
+
+    lock.release();
+
+    while (slabs != nullptr) {
+        auto *next = slabs->next;
+        backend.freeMemory(slabs, slabSize);
+        slabs = next;
+    }
+
+    return count * slabSize;
+}
+
+const Util::String& SlabCache::getName() const {
+    return name;
+}
+
+SlabCache::Statistics SlabCache::getStatistics() {
+    lock.acquire();
+    Statistics statistics{objectSize, slabSize, slabCount, emptySlabCount, usedObjects, slabCount * objectsPerSlab, allocations, reclaimedSlabs};
+    lock.release();
+
+    return statistics;
+}
+
+bool SlabCache::grow() {
+    // The backend must not be called with the cache locked, since it may allocate memory itself (e.g. when mapping pages)
+    lock.release();
+
+    auto *memory = static_cast<uint8_t*>(backend.allocateMemory(slabSize, slabSize));
+    if (memory == nullptr) {
+        lock.acquire();
+        return false;
+    }
+
+    auto &slab = *reinterpret_cast<Slab*>(memory);
+    slab.freeObjects = nullptr;
+    slab.usedObjects = 0;
+
+    // Construct all objects and link them, so that the first object is handed out first
+    for (uint32_t i = objectsPerSlab; i > 0; i--) {
+        auto *object = memory + objectOffset + (i - 1) * slotSize;
+        if (constructor != nullptr) {
+            constructor(object);
+        }
+
+        getFreeLink(object) = slab.freeObjects;
+        slab.freeObjects = object;
+    }
+
+    lock.acquire();
+
+    insertSlab(slab, emptySlabs);
+    slabCount++;
+    emptySlabCount++;
+
+    return true;
+}
+
+void* SlabCache::takeObject(Slab &slab, Slab *&list) {
+    auto *object = slab.freeObjects;
+    slab.freeObjects = getFreeLink(object);
+    slab.usedObjects++;
+
+    removeSlab(slab, list);
+    insertSlab(slab, slab.freeObjects == nullptr ? fullSlabs : partialSlabs);
+
+    return object;
+}
+
+void SlabCache::insertSlab(Slab &slab, Slab *&list) {
+    slab.previous = nullptr;
+    slab.next = list;
+    if (list != nullptr) {
+        list->previous = &slab;
+    }
+
+    list = &slab;
+}
+
+void SlabCache::removeSlab(Slab &slab, Slab *&list) {
+    if (slab.previous == nullptr) {
+        list = slab.next;
+    } else {
+        slab.previous->next = slab.next;
+    }
+
+    if (slab.next != nullptr) {
+        slab.next->previous = slab.previous;
+    }
+}
+
+uint8_t*& SlabCache::getFreeLink(uint8_t *object) const {
+    return *reinterpret_cast<uint8_t**>(object + linkOffset);
+}
+
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_SLABCACHE_H
+#define HHUOS_SLABCACHE_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Spinlock.h"
+#include "lib/util/base/HeapMemoryManager.h"
+#include "lib/util/base/String.h"
+
+namespace Kernel {
+
+/**
+ * Cache of equally sized objects (e.g. threads or memory mappings), which are carved out of slabs.
+ * A slab is a power-of-two sized chunk of the backing heap, that is aligned to its own size,
+ * so that the slab containing an object can be found by masking the object's address.
+ *
+ * Slabs are kept in three lists (full, partially used and empty). New objects are taken from partially used slabs first,
+ * so that objects are packed tightly and slabs become empty as often as possible.
+ * The cache grows by one slab at a time, when all slabs are full. Empty slabs are kept,
+ * until they are returned to the backing heap by reclaim() (e.g. when physical memory runs low).
+ *
+ * If the cache has a constructor, it is called once for each object, when its slab is created.
+ * Freed objects must be returned in their constructed state, so that allocate() can hand them out again without constructing them.
+ * Since free objects are still constructed, the free list is linked through a word behind each object.
+ * See Bonwick: "The Slab Allocator: An Object-Caching Kernel Memory Allocator" (1994).
+ */
+class SlabCache {
+
+public:
+
+    struct Statistics {
+        uint32_t objectSize;
+        uint32_t slabSize;
+        uint32_t slabCount;
+        uint32_t emptySlabCount;
+        uint32_t usedObjects;
+        uint32_t totalObjects;
+        uint32_t allocations;
+        uint32_t reclaimedSlabs;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param name The name of the cache (used for statistics)
+     * @param objectSize The size of each object in bytes
+     * @param alignment The alignment of each object (0 for the default alignment of 4 bytes)
+     * @param constructor Called for each object, when its slab is created (may be nullptr)
+     * @param backend The heap, from which slabs are allocated
+     */
+    SlabCache(const Util::String &name, uint32_t objectSize, uint32_t alignment, void (*constructor)(void*), Util::HeapMemoryManager &backend);
+
+    /**
+     * Copy Constructor.
+     */
+    SlabCache(const SlabCache &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    SlabCache &operator=(const SlabCache &other) = delete;
+
+    /**
+     * Destructor.
+     * Returns all slabs to the backing heap. No object of the cache may be in use anymore.
+     */
+    ~SlabCache();
+
+    /**
+     * Take an object from the cache, creating a new slab if all slabs are full.
+     * Returns nullptr, if all slabs are full and the backing heap cannot provide a new one.
+     */
+    [[nodiscard]] void* allocate();
+
+    /**
+     * Return an object to the cache (in its constructed state, if the cache has a constructor).
+     *
+     * @param object An object allocated by this cache
+     */
+    void free(void *object);
+
+    /**
+     * Return all empty slabs to the backing heap.
+     * Caches, which are currently locked by another thread, are skipped instead of waiting for them.
+     *
+     * @return The amount of bytes returned to the backing heap
+     */
+    uint32_t reclaim();
+
+    [[nodiscard]] const Util::String& getName() const;
+
+    [[nodiscard]] Statistics getStatistics();
+
+    static const constexpr uint32_t DEFAULT_ALIGNMENT = 4;
+    static const constexpr uint32_t MIN_OBJECTS_PER_SLAB = 8;
+    static const constexpr uint32_t MAX_SLAB_SIZE = 128 * 1024;
+
+private:
+
+    struct Slab {
+        Slab *previous;
+        Slab *next;
+        uint8_t *freeObjects;
+        uint32_t usedObjects;
+    };
+
+    /**
+     * Allocate a new slab from the backing heap, construct its objects and add it to the empty slabs.
+     * The cache lock must be held and is released while the backing heap is accessed.
+     * Returns false, if the backing heap is out of memory.
+     */
+    bool grow();
+
+    /**
+     * Take an object from a slab and move the slab to the matching list.
+     */
+    void* takeObject(Slab &slab, Slab *&list);
+
+    static void insertSlab(Slab &slab, Slab *&list);
+
+    static void removeSlab(Slab &slab, Slab *&list);
+
+    [[nodiscard]] uint8_t*& getFreeLink(uint8_t *object) const;
+
+    Util::String name;
+    uint32_t objectSize;
+    uint32_t linkOffset;
+    uint32_t slotSize;
+    uint32_t slabSize;
+    uint32_t objectOffset;
+    uint32_t objectsPerSlab;
+    void (*constructor)(void*);
+    Util::HeapMemoryManager &backend;
+
+    Slab *fullSlabs = nullptr;
+    Slab *partialSlabs = nullptr;
+    Slab *emptySlabs = nullptr;
+
+    uint32_t slabCount = 0;
+    uint32_t emptySlabCount = 0;
+    uint32_t usedObjects = 0;
+    uint32_t allocations = 0;
+    uint32_t reclaimedSlabs = 0;
+
+    Util::Async::Spinlock lock;
+};
+
+}
+
+#endif
@@ -153,6 +153,40 @@ void TableMemoryManager::freeBlock(void *pointer) {
     allocationTableEntry.decrementUseCount();
 }
 
+uint16_t TableMemoryManager::getUseCount(void *address) const {
+    if (address < startAddress || address > endAddress) {
+        return 0;
+    }
+
+    const auto index = calculateIndex(static_cast<uint8_t*>(address));
+
+    auto *referenceTable = reinterpret_cast<ReferenceTableEntry*>(referenceTableArray[index.referenceTableArrayIndex]);
+    auto &referenceTableEntry = referenceTable[index.referenceTableIndex];
+    if (referenceTableEntry.getAddress() == 0) {
+        return 0;
+    }
+
+    auto *allocationTable = reinterpret_cast<AllocationTableEntry*>(referenceTableEntry.getAddress());
+    return allocationTable[index.allocationTableIndex].getUseCount();
+}
+
+bool TableMemoryManager::isReserved(void *address) const {
+    if (address < startAddress || address > endAddress) {
+        return false;
+    }
+
+    const auto index = calculateIndex(static_cast<uint8_t*>(address));
+
+    auto *referenceTable = reinterpret_cast<ReferenceTableEntry*>(referenceTableArray[index.referenceTableArrayIndex]);
+    auto &referenceTableEntry = referenceTable[index.referenceTableIndex];
+    if (referenceTableEntry.getAddress() == 0) {
+        return false;
+    }
+
+    auto *allocationTable = reinterpret_cast<AllocationTableEntry*>(referenceTableEntry.getAddress());
+    return allocationTable[index.allocationTableIndex].isReserved();
+}
+
 void *TableMemoryManager::allocateBlockAfterAddress(void *address) {
     auto startIndex = calculateIndex(reinterpret_cast<uint8_t*>(address));
     auto endIndex = calculateIndex(endAddress);
@@ -60,6 +60,17 @@ public:
 
     void freeBlock(void *pointer) override;
 
+    /**
+     * Get the number of times the block containing the given address has been allocated and not yet freed.
+     * Blocks outside the managed memory, or inside an allocation table that has not been created yet, have a use count of 0.
+     */
+    [[nodiscard]] uint16_t getUseCount(void *address) const;
+
+    /**
+     * Check if the block containing the given address has been reserved via setMemory() and must never be allocated.
+     */
+    [[nodiscard]] bool isReserved(void *address) const;
+
     [[nodiscard]] uint32_t getTotalMemory() const override;
 
     [[nodiscard]] uint32_t getBlockSize() const override;
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "TlbShootdown.h"
+
+#include "device/interrupt/apic/LocalApic.h"
+#include "kernel/memory/Paging.h"
+#include "kernel/service/InterruptService.h"
+#include "kernel/service/Service.h"
+#include "lib/util/async/Atomic.h"
+
+namespace Kernel {
+
+void TlbShootdown::plugin() {
+    Service::getService<InterruptService>().assignInterrupt(InterruptVector::TLB_SHOOTDOWN, *this);
+}
+
+void TlbShootdown::trigger([[maybe_unused]] const InterruptFrame &frame, [[maybe_unused]] InterruptVector slot) {
+    handleRequest(Service::getService<InterruptService>().getCpuId());
+}
+
+void TlbShootdown::activate() {
+    auto &interruptService = Service::getService<InterruptService>();
+    if (!interruptService.usesApic()) {
+        // Without APIC, there is only a single CPU
+        return;
+    }
+
+    // The BSP activates itself before any AP, so the handler is registered before the first request can be sent
+    if (!pluggedIn) {
+        plugin();
+        pluggedIn = true;
+    }
+
+    auto cpuId = interruptService.getCpuId();
+    activeCpus[cpuId] = true;
+    Util::Async::Atomic<uint32_t>(activeCpuCount).inc();
+
+    // Drop all entries, that have been cached while this CPU was not receiving requests (including global kernel pages)
+    Paging::flush();
+}
+
+bool TlbShootdown::isActive(uint8_t cpuId) const {
+    return activeCpus[cpuId];
+}
+
+bool TlbShootdown::isEnabled() const {
+    return activeCpuCount > 1;
+}
+
+void TlbShootdown::invalidate(const void *virtualAddress, uint32_t pageCount, const bool (&targetCpus)[MAX_CPUS]) {
+    auto cpuId = Service::getService<InterruptService>().getCpuId();
+
+    // The kernel runs system calls and page faults with interrupts disabled, so another CPU waiting for its own request
+    // might never receive our IPI. Thus, while waiting, both sides handle requests addressed to them by polling.
+    while (!lock.tryAcquire()) {
+        handleRequest(cpuId);
+    }
+
+    requestAddress = virtualAddress;
+    requestPageCount = pageCount;
+
+    uint32_t targetCount = 0;
+    for (uint32_t i = 0; i < MAX_CPUS; i++) {
+        if (targetCpus[i] && i != cpuId) {
+            targetCount++;
+        }
+    }
+
+    // Publish the request before any target can see it (atomic operations are full memory barriers on x86)
+    Util::Async::Atomic<uint32_t>(remainingAcknowledgements).set(targetCount);
+    for (uint32_t i = 0; i < MAX_CPUS; i++) {
+        if (targetCpus[i] && i != cpuId) {
+            Util::Async::Atomic<uint8_t>(pendingRequests[i]).set(true);
+            Device::LocalApic::sendFixedInterProcessorInterrupt(i, InterruptVector::TLB_SHOOTDOWN);
+        }
+    }
+
+    while (Util::Async::Atomic<uint32_t>(remainingAcknowledgements).get() > 0) {
+        asm volatile("pause" : : : "memory");
+    }
+
+    lock.release();
+}
+
+void TlbShootdown::handleRequest(uint8_t cpuId) {
+    // The request may already have been handled by polling, before the IPI arrived
+    if (!Util::Async::Atomic<uint8_t>(pendingRequests[cpuId]).getAndSet(false)) {
+        return;
+    }
+
+    Paging::invalidate(requestAddress, requestPageCount);
+    Util::Async::Atomic<uint32_t>(remainingAcknowledgements).dec();
+}
+
+}
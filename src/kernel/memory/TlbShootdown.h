@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_TLBSHOOTDOWN_H
+#define HHUOS_TLBSHOOTDOWN_H
+
+#include <stdint.h>
+
+#include "kernel/interrupt/InterruptHandler.h"
+#include "lib/util/async/Spinlock.h"
+
+namespace Kernel {
+
+/**
+ * Invalidates TLB entries on other CPUs via inter-processor interrupts.
+ * Each CPU only invalidates its own TLB with invlpg, so after changing or removing a mapping,
+ * all other CPUs that may have cached the old entry must be told to do the same, before the old page frame can be reused.
+ *
+ * Only one shootdown request is in flight at a time. The initiating CPU waits until all targets have acknowledged it.
+ */
+class TlbShootdown : public InterruptHandler {
+
+public:
+
+    // Local APIC ids are 8 bits wide
+    static const constexpr uint32_t MAX_CPUS = 256;
+
+    /**
+     * Default Constructor.
+     */
+    TlbShootdown() = default;
+
+    /**
+     * Copy Constructor.
+     */
+    TlbShootdown(const TlbShootdown &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    TlbShootdown &operator=(const TlbShootdown &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~TlbShootdown() override = default;
+
+    /**
+     * Overriding function from InterruptHandler.
+     */
+    void plugin() override;
+
+    /**
+     * Overriding function from InterruptHandler.
+     */
+    void trigger(const InterruptFrame &frame, InterruptVector slot) override;
+
+    /**
+     * Let the current CPU receive shootdown requests. Must be called once by each CPU, before it starts scheduling.
+     * Until then, the CPU cannot be interrupted, so instead of receiving requests, its whole TLB is flushed here.
+     */
+    void activate();
+
+    /**
+     * Check if the given CPU receives shootdown requests.
+     */
+    [[nodiscard]] bool isActive(uint8_t cpuId) const;
+
+    /**
+     * Check if shootdowns are necessary at all (i.e. more than one CPU is active).
+     */
+    [[nodiscard]] bool isEnabled() const;
+
+    /**
+     * Invalidate a range of pages on the given CPUs and wait until all of them have done so.
+     * The executing CPU must not be among the targets (it can use Paging::invalidate() directly).
+     *
+     * @param virtualAddress The first page to invalidate
+     * @param pageCount The amount of pages to invalidate
+     * @param targetCpus Indexed by local APIC id, true for each CPU that has to invalidate the range
+     */
+    void invalidate(const void *virtualAddress, uint32_t pageCount, const bool (&targetCpus)[MAX_CPUS]);
+
+private:
+
+    /**
+     * Invalidate the requested range, if there is a pending request for the given CPU.
+     */
+    void handleRequest(uint8_t cpuId);
+
+    Util::Async::Spinlock lock;
+    bool pluggedIn = false;
+
+    const void *requestAddress = nullptr;
+    uint32_t requestPageCount = 0;
+    uint32_t remainingAcknowledgements = 0;
+    uint8_t pendingRequests[MAX_CPUS]{};
+
+    bool activeCpus[MAX_CPUS]{};
+    uint32_t activeCpuCount = 0;
+};
+
+}
+
+#endif
@@ -17,11 +17,13 @@
 
 #include "VirtualAddressSpace.h"
 
+#include "lib/util/async/Atomic.h"
 #include "lib/util/base/Constants.h"
 #include "lib/util/base/System.h"
 #include "kernel/service/MemoryService.h"
 #include "kernel/service/ProcessService.h"
 #include "MemoryLayout.h"
+#include "kernel/memory/MemoryMapping.h"
 #include "kernel/memory/Paging.h"
 #include "kernel/process/Process.h"
 #include "kernel/service/Service.h"
@@ -38,9 +40,9 @@ class HeapMemoryManager;
 namespace Kernel {
 
 VirtualAddressSpace::VirtualAddressSpace(Paging::Table *physicalPageDirectory, Paging::Table *virtualPageDirectory, Util::HeapMemoryManager &kernelHeapMemoryManager) :
-        kernelAddressSpace(true), physicalPageDirectory(physicalPageDirectory), virtualPageDirectory(virtualPageDirectory), memoryManager(kernelHeapMemoryManager) {}
+        kernelAddressSpace(true), physicalPageDirectory(physicalPageDirectory), virtualPageDirectory(virtualPageDirectory), memoryManager(kernelHeapMemoryManager), pageTables(1) {}
 
-VirtualAddressSpace::VirtualAddressSpace() : kernelAddressSpace(false), physicalPageDirectory(Service::getService<MemoryService>().allocatePageTable()), virtualPageDirectory(new Paging::Table()), memoryManager(Util::System::getAddressSpaceHeader().memoryManager) {
+VirtualAddressSpace::VirtualAddressSpace() : kernelAddressSpace(false), physicalPageDirectory(Service::getService<MemoryService>().allocatePageTable()), virtualPageDirectory(new Paging::Table()), memoryManager(Util::System::getAddressSpaceHeader().getMemoryManager()), pageTables(1) {
     auto &kernelSpace = Service::getService<ProcessService>().getKernelProcess().getAddressSpace();
 
     for (uint32_t address = MemoryLayout::KERNEL_AREA.startAddress; address < MemoryLayout::KERNEL_AREA.endAddress; address += 1024 * Util::PAGESIZE) {
@@ -54,12 +56,71 @@ VirtualAddressSpace::VirtualAddressSpace() : kernelAddressSpace(false), physical
 }
 
 VirtualAddressSpace::~VirtualAddressSpace() {
+    for (uint32_t i = 0; i < mappings.size(); i++) {
+        mappings.get(i)->release();
+    }
+
     if (!kernelAddressSpace) {
         Service::getService<MemoryService>().freePageTable(physicalPageDirectory);
         delete virtualPageDirectory;
     }
 }
 
+bool VirtualAddressSpace::addMapping(MemoryMapping *mapping) {
+    mappingLock.acquire();
+    for (uint32_t i = 0; i < mappings.size(); i++) {
+        auto *other = mappings.get(i);
+        if (mapping->getStartAddress() < other->getEndAddress() && other->getStartAddress() < mapping->getEndAddress()) {
+            mappingLock.release();
+            return false;
+        }
+    }
+
+    mappings.add(mapping);
+    mappingLock.release();
+    return true;
+}
+
+MemoryMapping* VirtualAddressSpace::findMapping(uint32_t address) {
+    mappingLock.acquire();
+    for (uint32_t i = 0; i < mappings.size(); i++) {
+        auto *mapping = mappings.get(i);
+        if (mapping->contains(address)) {
+            mapping->acquire();
+            mappingLock.release();
+            return mapping;
+        }
+    }
+
+    mappingLock.release();
+    return nullptr;
+}
+
+bool VirtualAddressSpace::removeMapping(MemoryMapping &mapping) {
+    mappingLock.acquire();
+    bool removed = mappings.remove(&mapping);
+    mappingLock.release();
+
+    if (removed) {
+        mapping.remove();
+    }
+
+    return removed;
+}
+
+Util::Array<MemoryMapping*> VirtualAddressSpace::removeAllMappings() {
+    mappingLock.acquire();
+    auto removedMappings = mappings.toArray();
+    mappings.clear();
+    mappingLock.release();
+
+    for (auto *mapping : removedMappings) {
+        mapping->remove();
+    }
+
+    return removedMappings;
+}
+
 Util::HeapMemoryManager& VirtualAddressSpace::getMemoryManager() const {
     return memoryManager;
 }
@@ -68,6 +129,42 @@ bool VirtualAddressSpace::isKernelAddressSpace() const {
     return kernelAddressSpace;
 }
 
+VirtualAddressSpace::MemoryUsage VirtualAddressSpace::getMemoryUsage() const {
+    return { residentPages, heapPages, pageTables, memoryLimit };
+}
+
+void VirtualAddressSpace::setHeapStartAddress(uint32_t address) {
+    heapStartAddress = address;
+}
+
+void VirtualAddressSpace::setMemoryLimit(uint32_t pageCount) {
+    memoryLimit = pageCount;
+}
+
+bool VirtualAddressSpace::isMemoryLimitReached() const {
+    return memoryLimit > 0 && residentPages >= memoryLimit;
+}
+
+void VirtualAddressSpace::accountPages(const void *virtualAddress, int32_t pageCount) {
+    auto &owner = getOwner(virtualAddress);
+    Util::Async::Atomic<uint32_t>(owner.residentPages).add(static_cast<uint32_t>(pageCount));
+    if (reinterpret_cast<uint32_t>(virtualAddress) >= owner.heapStartAddress) {
+        Util::Async::Atomic<uint32_t>(owner.heapPages).add(static_cast<uint32_t>(pageCount));
+    }
+}
+
+void VirtualAddressSpace::accountPageTables(const void *virtualAddress, int32_t pageTableCount) {
+    Util::Async::Atomic<uint32_t>(getOwner(virtualAddress).pageTables).add(static_cast<uint32_t>(pageTableCount));
+}
+
+VirtualAddressSpace& VirtualAddressSpace::getOwner(const void *virtualAddress) {
+    if (kernelAddressSpace || reinterpret_cast<uint32_t>(virtualAddress) >= MemoryLayout::KERNEL_AREA.endAddress) {
+        return *this;
+    }
+
+    return Service::getService<MemoryService>().getKernelAddressSpace();
+}
+
 void* VirtualAddressSpace::getPhysicalAddress(void *virtualAddress) const {
     // Get indices into page table and directory
     uint32_t pageDirectoryIndex = Paging::DIRECTORY_INDEX(reinterpret_cast<uint32_t>(virtualAddress));
@@ -78,6 +175,11 @@ void* VirtualAddressSpace::getPhysicalAddress(void *virtualAddress) const {
         return nullptr;
     }
 
+    // Large pages are mapped by the page directory entry itself
+    if ((*virtualPageDirectory)[pageDirectoryIndex].getFlags() & Paging::HUGE_PAGE) {
+        return reinterpret_cast<void*>((*virtualPageDirectory)[pageDirectoryIndex].getAddress() | (reinterpret_cast<uint32_t>(virtualAddress) & (Paging::LARGE_PAGESIZE - 1)));
+    }
+
     // Get corresponding page table
     auto &pageTable = *reinterpret_cast<Paging::Table*>((*virtualPageDirectory)[pageDirectoryIndex].getAddress());
 
@@ -104,21 +206,13 @@ void VirtualAddressSpace::map(const void *physicalAddress, const void *virtualAd
 
         // Calculate page directory flags
         auto pageDirectoryFlags = Paging::PRESENT | Paging::WRITABLE | (reinterpret_cast<uint32_t>(virtualAddress) >= Kernel::MemoryLayout::KERNEL_AREA.endAddress ? Paging::USER_ACCESSIBLE : Paging::NONE);
+        setDirectoryEntry(pageDirectoryIndex, reinterpret_cast<uint32_t>(virtualPageTable), reinterpret_cast<uint32_t>(physicalPageTable), pageDirectoryFlags);
+        accountPageTables(virtualAddress, 1);
+    }
 
-        // Check if the virtual address is inside kernel memory.
-        // In this case, we need to propagate the mapping to all active address spaces, because the kernel is mapped into each address space.
-        if (reinterpret_cast<uint32_t>(virtualAddress) <= MemoryLayout::KERNEL_AREA.endAddress) {
-            const auto &addressSpaces = memoryService.getAllAddressSpaces();
-            for (uint32_t i = 0; i < addressSpaces.size(); i++) { // Do not use a for-each loop, since the iterator itself requires memory and may cause a deadlock
-                auto &addressSpace = *addressSpaces.get(i);
-                (*addressSpace.virtualPageDirectory)[pageDirectoryIndex].set(reinterpret_cast<uint32_t>(virtualPageTable), pageDirectoryFlags);
-                (*addressSpace.physicalPageDirectory)[pageDirectoryIndex].set(reinterpret_cast<uint32_t>(physicalPageTable), pageDirectoryFlags);
-            }
-        } else {
-            // The virtual address concerns user space memory, and must not be visible to any other address space
-            (*virtualPageDirectory)[pageDirectoryIndex].set(reinterpret_cast<uint32_t>(virtualPageTable), pageDirectoryFlags);
-            (*physicalPageDirectory)[pageDirectoryIndex].set(reinterpret_cast<uint32_t>(physicalPageTable), pageDirectoryFlags);
-        }
+    // Check if the requested page is part of a large page
+    if ((*virtualPageDirectory)[pageDirectoryIndex].getFlags() & Paging::HUGE_PAGE) {
+        Util::Exception::throwException(Util::Exception::PAGING_ERROR, "PageDirectory: Requested page is already mapped!");
     }
 
     // Get corresponding page table
@@ -129,11 +223,17 @@ void VirtualAddressSpace::map(const void *physicalAddress, const void *virtualAd
         Util::Exception::throwException(Util::Exception::PAGING_ERROR, "PageDirectory: Requested page is already mapped!");
     }
 
+    // Kernel pages are mapped into every address space, so they can be kept in the TLB across address space switches
+    if (reinterpret_cast<uint32_t>(virtualAddress) < MemoryLayout::KERNEL_AREA.endAddress) {
+        flags |= Paging::getKernelPageFlags();
+    }
+
     // Set entry in page table
     pageTable[pageTableIndex].set(reinterpret_cast<uint32_t>(physicalAddress), flags);
+    accountPages(virtualAddress, 1);
 }
 
-void* VirtualAddressSpace::unmap(const void *virtualAddress) {
+void* VirtualAddressSpace::unmap(const void *virtualAddress, bool shootdown) {
     // Get indices into page table and directory
     uint32_t pageDirectoryIndex = Paging::DIRECTORY_INDEX(reinterpret_cast<uint32_t>(virtualAddress));
     uint32_t pageTableIndex = Paging::TABLE_INDEX(reinterpret_cast<uint32_t>(virtualAddress));
@@ -143,6 +243,11 @@ void* VirtualAddressSpace::unmap(const void *virtualAddress) {
         return nullptr;
     }
 
+    // Single pages of a large page can only be unmapped after splitting it up
+    if ((*virtualPageDirectory)[pageDirectoryIndex].getFlags() & Paging::HUGE_PAGE) {
+        splitLargePage(pageDirectoryIndex);
+    }
+
     // Get corresponding page table
     auto &pageTable = *reinterpret_cast<Paging::Table*>((*virtualPageDirectory)[pageDirectoryIndex].getAddress());
 
@@ -154,36 +259,146 @@ void* VirtualAddressSpace::unmap(const void *virtualAddress) {
     // Unmap page
     auto physicalAddress = pageTable[pageTableIndex].getAddress();
     pageTable[pageTableIndex].clear();
+    accountPages(virtualAddress, -1);
 
     // Invalidate entry in TLB
-    asm volatile(
-            "invlpg (%0)"
-            : :
-            "r"(virtualAddress)
-            );
+    Paging::invalidate(virtualAddress);
+    if (shootdown) {
+        Service::getService<MemoryService>().shootdownTlb(*this, virtualAddress);
+    }
 
     // Delete page table, if it is empty
     if (pageTable.isEmpty()) {
-        auto &memoryService = Service::getService<MemoryService>();
-
-        // Check if the virtual address is inside kernel memory.
-        // In this case, we need to propagate the mapping to all active address spaces, because the kernel is mapped into each address space.
-        if (reinterpret_cast<uint32_t>(virtualAddress) <= MemoryLayout::KERNEL_AREA.endAddress) {
-            const auto &addressSpaces = memoryService.getAllAddressSpaces();
-            for (uint32_t i = 0; i < addressSpaces.size(); i++) { // Do not use a for-each loop, since the iterator itself requires memory and may cause a deadlock
-                auto &addressSpace = *addressSpaces.get(i);
-                (*addressSpace.virtualPageDirectory)[pageDirectoryIndex].clear();
-                (*addressSpace.physicalPageDirectory)[pageDirectoryIndex].clear();
-            }
-        } else {
-            (*virtualPageDirectory)[pageDirectoryIndex].clear();
-            (*physicalPageDirectory)[pageDirectoryIndex].clear();
+        setDirectoryEntry(pageDirectoryIndex, 0, 0, Paging::NONE);
+        Service::getService<MemoryService>().freePageTable(&pageTable);
+        accountPageTables(virtualAddress, -1);
+    }
+
+    return reinterpret_cast<void*>(physicalAddress);
+}
+
+bool VirtualAddressSpace::mapLarge(const void *physicalAddress, const void *virtualAddress, uint16_t flags) {
+    if ((reinterpret_cast<uint32_t>(physicalAddress) | reinterpret_cast<uint32_t>(virtualAddress)) % Paging::LARGE_PAGESIZE != 0) {
+        return false;
+    }
+
+    // A large page replaces a whole page table, so no other page may be mapped in its range
+    uint32_t pageDirectoryIndex = Paging::DIRECTORY_INDEX(reinterpret_cast<uint32_t>(virtualAddress));
+    if (!(*virtualPageDirectory)[pageDirectoryIndex].isUnused()) {
+        return false;
+    }
+
+    if (reinterpret_cast<uint32_t>(virtualAddress) < MemoryLayout::KERNEL_AREA.endAddress) {
+        flags |= Paging::getKernelPageFlags();
+    }
+
+    setDirectoryEntry(pageDirectoryIndex, reinterpret_cast<uint32_t>(physicalAddress), reinterpret_cast<uint32_t>(physicalAddress), flags | Paging::HUGE_PAGE);
+    accountPages(virtualAddress, Paging::ENTRIES_PER_TABLE);
+    return true;
+}
+
+void VirtualAddressSpace::splitLargePage(uint32_t pageDirectoryIndex) {
+    const auto &entry = (*virtualPageDirectory)[pageDirectoryIndex];
+    auto physicalAddress = entry.getAddress();
+    auto flags = entry.getFlags() & ~Paging::HUGE_PAGE;
+    auto virtualAddress = pageDirectoryIndex * Paging::LARGE_PAGESIZE;
+
+    // Create a page table, which maps the same frames with the same flags
+    auto *virtualPageTable = Service::getService<MemoryService>().allocatePageTable();
+    auto *physicalPageTable = getPhysicalAddress(virtualPageTable);
+    for (uint32_t i = 0; i < Paging::ENTRIES_PER_TABLE; i++) {
+        (*virtualPageTable)[i].set(physicalAddress + i * Util::PAGESIZE, flags);
+    }
+
+    auto pageDirectoryFlags = Paging::PRESENT | Paging::WRITABLE | (virtualAddress >= Kernel::MemoryLayout::KERNEL_AREA.endAddress ? Paging::USER_ACCESSIBLE : Paging::NONE);
+    setDirectoryEntry(pageDirectoryIndex, reinterpret_cast<uint32_t>(virtualPageTable), reinterpret_cast<uint32_t>(physicalPageTable), pageDirectoryFlags);
+    accountPageTables(reinterpret_cast<const void*>(virtualAddress), 1);
+
+    // A single invlpg removes the whole large page from the TLB.
+    // Other CPUs may keep their entry, since the new page table translates all addresses the same way.
+    Paging::invalidate(reinterpret_cast<const void*>(virtualAddress));
+}
+
+void VirtualAddressSpace::setDirectoryEntry(uint32_t pageDirectoryIndex, uint32_t virtualAddress, uint32_t physicalAddress, uint16_t flags) {
+    // Check if the entry is inside kernel memory.
+    // In this case, we need to propagate the mapping to all active address spaces, because the kernel is mapped into each address space.
+    if (pageDirectoryIndex * Paging::LARGE_PAGESIZE < MemoryLayout::KERNEL_AREA.endAddress) {
+        const auto &addressSpaces = Service::getService<MemoryService>().getAllAddressSpaces();
+        for (uint32_t i = 0; i < addressSpaces.size(); i++) { // Do not use a for-each loop, since the iterator itself requires memory and may cause a deadlock
+            auto &addressSpace = *addressSpaces.get(i);
+            (*addressSpace.virtualPageDirectory)[pageDirectoryIndex].set(virtualAddress, flags);
+            (*addressSpace.physicalPageDirectory)[pageDirectoryIndex].set(physicalAddress, flags);
         }
+    } else {
+        // The virtual address concerns user space memory, and must not be visible to any other address space
+        (*virtualPageDirectory)[pageDirectoryIndex].set(virtualAddress, flags);
+        (*physicalPageDirectory)[pageDirectoryIndex].set(physicalAddress, flags);
+    }
+}
+
+void VirtualAddressSpace::mapCopyOnWrite(const void *physicalAddress, const void *virtualAddress, uint16_t flags) {
+    map(physicalAddress, virtualAddress, (flags & ~Paging::WRITABLE) | Paging::COPY_ON_WRITE);
+}
 
-        memoryService.freePageTable(&pageTable);
+bool VirtualAddressSpace::remap(const void *physicalAddress, const void *virtualAddress, uint16_t flags) {
+    // Get indices into page table and directory
+    uint32_t pageDirectoryIndex = Paging::DIRECTORY_INDEX(reinterpret_cast<uint32_t>(virtualAddress));
+    uint32_t pageTableIndex = Paging::TABLE_INDEX(reinterpret_cast<uint32_t>(virtualAddress));
+
+    // Check if the requested page table is present
+    if ((*virtualPageDirectory)[pageDirectoryIndex].isUnused()) {
+        return false;
     }
 
-    return reinterpret_cast<void*>(physicalAddress);
+    // Single pages of a large page can only be remapped after splitting it up
+    if ((*virtualPageDirectory)[pageDirectoryIndex].getFlags() & Paging::HUGE_PAGE) {
+        splitLargePage(pageDirectoryIndex);
+    }
+
+    // Get corresponding page table
+    auto &pageTable = *reinterpret_cast<Paging::Table*>((*virtualPageDirectory)[pageDirectoryIndex].getAddress());
+
+    // Check if the requested page is present
+    if (pageTable[pageTableIndex].isUnused()) {
+        return false;
+    }
+
+    // Other CPUs only need to drop their entries, if the frame changes or access rights are revoked.
+    // A stale entry with fewer rights just causes a page fault, which refreshes the entry on the faulting CPU (see MemoryService::resolveCopyOnWrite()).
+    auto &entry = pageTable[pageTableIndex];
+    auto revokedFlags = entry.getFlags() & ~flags & (Paging::PRESENT | Paging::WRITABLE | Paging::USER_ACCESSIBLE);
+    auto changedCacheFlags = (entry.getFlags() ^ flags) & (Paging::WRITE_THROUGH | Paging::CACHE_DISABLE);
+    auto shootdown = entry.getAddress() != (reinterpret_cast<uint32_t>(physicalAddress) & ~(Util::PAGESIZE - 1)) || revokedFlags != 0 || changedCacheFlags != 0;
+
+    entry.set(reinterpret_cast<uint32_t>(physicalAddress), flags);
+
+    // Invalidate entry in TLB
+    Paging::invalidate(virtualAddress);
+    if (shootdown) {
+        Service::getService<MemoryService>().shootdownTlb(*this, virtualAddress);
+    }
+
+    return true;
+}
+
+uint16_t VirtualAddressSpace::getFlags(const void *virtualAddress) const {
+    // Get indices into page table and directory
+    uint32_t pageDirectoryIndex = Paging::DIRECTORY_INDEX(reinterpret_cast<uint32_t>(virtualAddress));
+    uint32_t pageTableIndex = Paging::TABLE_INDEX(reinterpret_cast<uint32_t>(virtualAddress));
+
+    // Check if the requested page table is present
+    if ((*virtualPageDirectory)[pageDirectoryIndex].isUnused()) {
+        return Paging::NONE;
+    }
+
+    // Large pages are mapped by the page directory entry itself
+    if ((*virtualPageDirectory)[pageDirectoryIndex].getFlags() & Paging::HUGE_PAGE) {
+        return (*virtualPageDirectory)[pageDirectoryIndex].getFlags() & ~Paging::HUGE_PAGE;
+    }
+
+    // Get corresponding page table
+    auto &pageTable = *reinterpret_cast<Paging::Table*>((*virtualPageDirectory)[pageDirectoryIndex].getAddress());
+    return pageTable[pageTableIndex].getFlags();
 }
 
 const Paging::Table& VirtualAddressSpace::getPageDirectoryPhysical() const {
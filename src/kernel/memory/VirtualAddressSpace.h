@@ -21,6 +21,10 @@
 #include <stdint.h>
 
 #include "Paging.h"
+#include "MemoryLayout.h"
+#include "lib/util/async/Spinlock.h"
+#include "lib/util/collection/Array.h"
+#include "lib/util/collection/ArrayList.h"
 
 namespace Util {
 
@@ -29,6 +33,7 @@ class HeapMemoryManager;
 }  // namespace Util
 
 namespace Kernel {
+class MemoryMapping;
 
 /**
  * VirtualAddressSpace - represents a virtual address space with corresponding page directory
@@ -40,6 +45,17 @@ namespace Kernel {
 class VirtualAddressSpace {
 
 public:
+
+    /**
+     * Memory used by an address space. Pages in the kernel area are always accounted to the kernel address space,
+     * since they are shared by all address spaces.
+     */
+    struct MemoryUsage {
+        uint32_t residentPages; // Mapped 4 KiB pages (including pages shared with other address spaces)
+        uint32_t heapPages;     // Resident pages at or above the heap start address (heap, stacks and memory mappings)
+        uint32_t pageTables;    // Page tables and the page directory
+        uint32_t memoryLimit;   // Maximum amount of resident pages (0, if unlimited)
+    };
     /**
      * Constructor for the kernel address space.
      */
@@ -70,7 +86,78 @@ public:
 
     void map(const void *physicalAddress, const void *virtualAddress, uint16_t flags);
 
-    void* unmap(const void *virtualAddress);
+    /**
+     * Unmap a single page and invalidate its TLB entry.
+     *
+     * @param virtualAddress The page to unmap
+     * @param shootdown Invalidate the entry on other CPUs as well (callers unmapping many pages may batch this via MemoryService::shootdownTlb())
+     * @return The physical address of the unmapped page, or nullptr if the page has not been mapped
+     */
+    void* unmap(const void *virtualAddress, bool shootdown = true);
+
+    /**
+     * Map a 4 MiB large page with a single page directory entry (needs CR4.PSE).
+     * Unmapping or remapping a single page inside a large page splits it up into 4 KiB pages first.
+     *
+     * @param physicalAddress The 4 MiB aligned physical start address
+     * @param virtualAddress The 4 MiB aligned virtual start address
+     * @param flags The flags for the page directory entry
+     * @return false, if an address is not aligned or any page inside the large page is already mapped
+     */
+    bool mapLarge(const void *physicalAddress, const void *virtualAddress, uint16_t flags);
+
+    /**
+     * Map a physical page frame, that is shared with other address spaces, as copy-on-write.
+     * The page is mapped read-only and the first write access causes a page fault, which is resolved by MemoryService::handlePageFault().
+     *
+     * @param physicalAddress The shared page frame
+     * @param virtualAddress The virtual address to map the frame to
+     * @param flags The flags, the page should have after it has been copied (should contain Paging::WRITABLE)
+     */
+    void mapCopyOnWrite(const void *physicalAddress, const void *virtualAddress, uint16_t flags);
+
+    /**
+     * Replace the page frame and flags of an existing mapping and invalidate the corresponding TLB entry.
+     * Other CPUs are only asked to invalidate their entry, if the page frame changes or access rights are revoked.
+     *
+     * @return true, if the virtual address has been mapped before
+     */
+    bool remap(const void *physicalAddress, const void *virtualAddress, uint16_t flags);
+
+    /**
+     * Get the paging flags of a mapped page (Paging::NONE, if the page is not mapped).
+     */
+    [[nodiscard]] uint16_t getFlags(const void *virtualAddress) const;
+
+    /**
+     * Add a memory mapping, whose pages are mapped on demand, when they are accessed.
+     * The address space takes over the mapping's initial reference and releases it, when the mapping is removed
+     * or the address space is destroyed.
+     *
+     * @return false, if the mapping overlaps an existing one (the mapping is not added and still belongs to the caller)
+     */
+    bool addMapping(MemoryMapping *mapping);
+
+    /**
+     * Search the memory mapping containing the given address.
+     * The returned mapping has been acquired and must be released by the caller.
+     *
+     * @return The mapping, or nullptr if the address does not belong to a memory mapping
+     */
+    [[nodiscard]] MemoryMapping* findMapping(uint32_t address);
+
+    /**
+     * Remove a memory mapping from this address space and mark it as removed.
+     * The address space's reference is passed to the caller, who must unmap the mapping's pages and release it afterward.
+     *
+     * @return false, if the mapping does not belong to this address space (e.g. because it has already been removed)
+     */
+    bool removeMapping(MemoryMapping &mapping);
+
+    /**
+     * Remove all memory mappings from this address space (see removeMapping()).
+     */
+    [[nodiscard]] Util::Array<MemoryMapping*> removeAllMappings();
 
     [[nodiscard]] Util::HeapMemoryManager& getMemoryManager() const;
 
@@ -78,12 +165,63 @@ public:
 
     [[nodiscard]] bool isKernelAddressSpace() const;
 
+    [[nodiscard]] MemoryUsage getMemoryUsage() const;
+
+    /**
+     * Set the address, at which the process' heap starts. Resident pages above it are accounted as heap pages.
+     */
+    void setHeapStartAddress(uint32_t address);
+
+    /**
+     * Limit the amount of resident pages. Page faults beyond the limit kill the process (see MemoryService::handlePageFault()).
+     *
+     * @param pageCount The maximum amount of resident pages (0 to remove the limit)
+     */
+    void setMemoryLimit(uint32_t pageCount);
+
+    /**
+     * Check if mapping another page would exceed the memory limit.
+     */
+    [[nodiscard]] bool isMemoryLimitReached() const;
+
 private:
 
+    /**
+     * Add or remove pages to/from the memory usage of the address space, that owns the given address.
+     */
+    void accountPages(const void *virtualAddress, int32_t pageCount);
+
+    /**
+     * Add or remove page tables to/from the memory usage of the address space, that owns the given address.
+     */
+    void accountPageTables(const void *virtualAddress, int32_t pageTableCount);
+
+    [[nodiscard]] VirtualAddressSpace& getOwner(const void *virtualAddress);
+
+    /**
+     * Replace a large page with a page table mapping the same frames.
+     */
+    void splitLargePage(uint32_t pageDirectoryIndex);
+
+    /**
+     * Set an entry of the page directory. Entries of the kernel area are set in all address spaces.
+     */
+    void setDirectoryEntry(uint32_t pageDirectoryIndex, uint32_t virtualAddress, uint32_t physicalAddress, uint16_t flags);
+
     bool kernelAddressSpace;
     Paging::Table *physicalPageDirectory;
     Paging::Table *virtualPageDirectory;
     Util::HeapMemoryManager &memoryManager;
+
+    Util::ArrayList<MemoryMapping*> mappings;
+    Util::Async::Spinlock mappingLock;
+
+    // Changed by all threads of a process concurrently (e.g. on page faults), so only modified atomically
+    uint32_t residentPages = 0;
+    uint32_t heapPages = 0;
+    uint32_t pageTables = 0;
+    uint32_t heapStartAddress = MemoryLayout::MEMORY_END;
+    uint32_t memoryLimit = 0;
 };
 
 }
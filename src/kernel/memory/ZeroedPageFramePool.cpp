@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "ZeroedPageFramePool.h"
+
+#include "kernel/memory/MemoryPoolRefillRunnable.h"
+#include "kernel/memory/PageFrameAllocator.h"
+#include "kernel/memory/VirtualAddressSpace.h"
+#include "kernel/service/MemoryService.h"
+#include "kernel/service/Service.h"
+#include "lib/util/base/Address.h"
+#include "lib/util/base/Constants.h"
+
+namespace Kernel {
+
+ZeroedPageFramePool::ZeroedPageFramePool(PageFrameAllocator &pageFrameAllocator) : pageFrameAllocator(pageFrameAllocator), frames(CAPACITY) {}
+
+void* ZeroedPageFramePool::take() {
+    auto *frame = frames.tryPop();
+    if (frames.getFillingDegree() < LOW_WATERMARK) {
+        MemoryPoolRefillRunnable::requestRefill();
+    }
+
+    return frame;
+}
+
+void ZeroedPageFramePool::refill() {
+    auto frameCount = frames.getFillingDegree();
+    if (frameCount >= LOW_WATERMARK) {
+        return;
+    }
+
+    auto &memoryService = Service::getService<MemoryService>();
+    auto &addressSpace = memoryService.getCurrentAddressSpace();
+    if (window == nullptr) {
+        window = static_cast<uint8_t*>(memoryService.allocateKernelMemory(BATCH_SIZE * Util::PAGESIZE, Util::PAGESIZE));
+        // Parts of the heap memory may already be mapped, but the window must only ever map frames to be zeroed
+        memoryService.unmap(window, BATCH_SIZE);
+    }
+
+    auto missingFrames = CAPACITY - frameCount;
+    while (missingFrames > 0) {
+        void *batch[BATCH_SIZE];
+        uint32_t batchSize = 0;
+        while (batchSize < BATCH_SIZE && batchSize < missingFrames && pageFrameAllocator.getFreeMemory() > MIN_FREE_MEMORY) {
+            auto *frame = pageFrameAllocator.allocateBlock();
+            if (frame == nullptr) {
+                break;
+            }
+
+            addressSpace.map(frame, window + batchSize * Util::PAGESIZE, Paging::PRESENT | Paging::WRITABLE);
+            batch[batchSize++] = frame;
+        }
+
+        if (batchSize == 0) {
+            return;
+        }
+
+        Util::Address<uint32_t>(window).setRange(0, batchSize * Util::PAGESIZE);
+
+        // Only invalidate the window locally for each page and shoot it down on other CPUs once for the whole batch
+        for (uint32_t i = 0; i < batchSize; i++) {
+            addressSpace.unmap(window + i * Util::PAGESIZE, false);
+        }
+        memoryService.shootdownTlb(addressSpace, window, batchSize);
+
+        for (uint32_t i = 0; i < batchSize; i++) {
+            if (!frames.push(batch[i])) {
+                pageFrameAllocator.freeBlock(batch[i]);
+            }
+        }
+
+        missingFrames -= batchSize;
+    }
+}
+
+uint32_t ZeroedPageFramePool::reclaim() {
+    uint32_t reclaimed = 0;
+    for (auto *frame = frames.tryPop(); frame != nullptr; frame = frames.tryPop()) {
+        pageFrameAllocator.freeBlock(frame);
+        reclaimed += Util::PAGESIZE;
+    }
+
+    return reclaimed;
+}
+
+uint32_t ZeroedPageFramePool::getFrameCount() {
+    return frames.getFillingDegree();
+}
+
+}
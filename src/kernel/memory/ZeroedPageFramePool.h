@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_ZEROEDPAGEFRAMEPOOL_H
+#define HHUOS_ZEROEDPAGEFRAMEPOOL_H
+
+#include <stdint.h>
+
+#include "kernel/memory/Paging.h"
+#include "lib/util/collection/Pool.h"
+
+namespace Kernel {
+class PageFrameAllocator;
+
+/**
+ * Pool of page frames, which have already been filled with zeros by a background thread (see MemoryPoolRefillRunnable).
+ * This way, fresh pages can be mapped on a page fault without zeroing them first.
+ *
+ * Once the pool drops below LOW_WATERMARK frames, it is refilled up to CAPACITY frames.
+ * Frames are zeroed in batches through a temporary window in the kernel heap,
+ * so that the window's TLB entries only need to be shot down once per batch.
+ */
+class ZeroedPageFramePool {
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param pageFrameAllocator The allocator, from which the pooled frames are taken
+     */
+    explicit ZeroedPageFramePool(PageFrameAllocator &pageFrameAllocator);
+
+    /**
+     * Copy Constructor.
+     */
+    ZeroedPageFramePool(const ZeroedPageFramePool &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    ZeroedPageFramePool &operator=(const ZeroedPageFramePool &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~ZeroedPageFramePool() = default;
+
+    /**
+     * Take a zeroed page frame from the pool. Never blocks.
+     * If the pool drops below its low watermark, the refill thread is woken up.
+     *
+     * @return The physical address of the frame, or nullptr if the pool is empty
+     */
+    [[nodiscard]] void* take();
+
+    /**
+     * Fill the pool up to its capacity, if it has dropped below the low watermark.
+     * Must be called from a thread, since it maps and zeroes frames.
+     */
+    void refill();
+
+    /**
+     * Give all pooled frames back to the page frame allocator (e.g. when physical memory runs low).
+     *
+     * @return The amount of bytes freed
+     */
+    uint32_t reclaim();
+
+    [[nodiscard]] uint32_t getFrameCount();
+
+    static const constexpr uint32_t CAPACITY = 256;
+    static const constexpr uint32_t LOW_WATERMARK = 64;
+
+private:
+
+    PageFrameAllocator &pageFrameAllocator;
+    Util::Pool<void> frames;
+    uint8_t *window = nullptr;
+
+    // Frames are only pooled, if enough physical memory is left for other purposes
+    static const constexpr uint32_t MIN_FREE_MEMORY = 4 * 1024 * 1024;
+    static const constexpr uint32_t BATCH_SIZE = Paging::MAX_SINGLE_INVALIDATIONS;
+};
+
+}
+
+#endif
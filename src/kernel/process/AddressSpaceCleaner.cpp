@@ -34,7 +34,10 @@ void AddressSpaceCleaner::run() {
         processService.getScheduler().yield();
     }
 
-    Service::getService<MemoryService>().unmap(reinterpret_cast<void*>(Kernel::MemoryLayout::KERNEL_END), ((Kernel::MemoryLayout::MEMORY_END - Kernel::MemoryLayout::KERNEL_END) + 1) / Util::PAGESIZE, 0);
+    // Shared file mappings must write back their modified pages, before they are unmapped
+    auto &memoryService = Service::getService<MemoryService>();
+    memoryService.removeAllMappings();
+    memoryService.unmap(reinterpret_cast<void*>(Kernel::MemoryLayout::KERNEL_END), ((Kernel::MemoryLayout::MEMORY_END - Kernel::MemoryLayout::KERNEL_END) + 1) / Util::PAGESIZE, 0);
     processService.cleanup(&currentProcess);
 }
 
@@ -20,11 +20,11 @@
 #include <stdint.h>
 
 #include "lib/util/io/file/File.h"
-#include "lib/util/io/stream/FileInputStream.h"
 #include "lib/util/io/file/elf/File.h"
 #include "kernel/service/ProcessService.h"
 #include "kernel/process/Process.h"
 #include "kernel/process/Thread.h"
+#include "kernel/memory/VirtualAddressSpace.h"
 #include "lib/util/base/Exception.h"
 #include "lib/util/base/Address.h"
 #include "kernel/service/Service.h"
@@ -47,38 +47,22 @@ void BinaryLoader::run() {
         Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "BinaryLoader: Not a file!");
     }
 
-    auto *buffer = new uint8_t[file.getLength()];
-    auto binaryStream = Util::Io::FileInputStream(file);
-    binaryStream.read(buffer, 0, file.getLength());
-
-    // Buffer is automatically deleted by file destructor
-    auto executable = Util::Io::Elf::File(buffer);
-    executable.loadProgram();
-
-    // Needed for allocating memory before user space heap
-    auto *currentAddress = reinterpret_cast<uint8_t*>(executable.getEndAddress());
+    // The executable is not read here. Its segments are mapped into the new address space and loaded on demand.
+    auto &imageCache = Service::getService<ProcessService>().getImageCache();
+    auto &image = imageCache.acquire(path, file.getLength());
+    auto *currentAddress = reinterpret_cast<uint8_t*>(image.map());
 
     auto &addressSpaceHeader = *reinterpret_cast<Util::System::AddressSpaceHeader*>(Util::USER_SPACE_MEMORY_START_ADDRESS);
+    addressSpaceHeader.heapManager = image.getHeapManager();
 
-    // Copy symbol and string table to user space (needed for stack trace with symbol names)
-    auto &symbolTableHeader = executable.getSectionHeader(Util::Io::Elf::SectionHeaderType::SYMTAB);
-    auto &stringTableHeader = executable.getSectionHeader(Util::Io::Elf::SectionHeaderType::STRTAB);
-    addressSpaceHeader.symbolTableSize = symbolTableHeader.size;
-
-    auto symbolTableAddress = Util::Address<uint32_t>(buffer + symbolTableHeader.offset);
-    auto stringTableAddress = Util::Address<uint32_t>(buffer + stringTableHeader.offset);
-
-    Util::Address<uint32_t>(currentAddress).copyRange(symbolTableAddress, symbolTableHeader.size);
-    addressSpaceHeader.symbolTable = reinterpret_cast<const Util::Io::Elf::SymbolEntry*>(currentAddress);
-    currentAddress += symbolTableHeader.size;
-
-    Util::Address<uint32_t>(currentAddress).copyRange(stringTableAddress, stringTableHeader.size);
-    addressSpaceHeader.stringTable = reinterpret_cast<const char*>(currentAddress);
-    currentAddress += stringTableHeader.size;
+    // Symbol and string table are mapped behind the program (needed for stack trace with symbol names)
+    addressSpaceHeader.symbolTableSize = image.getSymbolTableSize();
+    addressSpaceHeader.symbolTable = reinterpret_cast<const Util::Io::Elf::SymbolEntry*>(image.getSymbolTableAddress());
+    addressSpaceHeader.stringTable = reinterpret_cast<const char*>(image.getStringTableAddress());
 
     // Copy arguments to user space
     uint32_t argc = arguments.length() + 1;
-    char **argv = reinterpret_cast<char**>(executable.getEndAddress() + 1);
+    char **argv = reinterpret_cast<char**>(currentAddress);
     currentAddress += sizeof(char**) * argc;
 
     for (uint32_t i = 0; i < argc; i++) {
@@ -93,10 +77,12 @@ void BinaryLoader::run() {
     auto &processService = Service::getService<ProcessService>();
     auto &process = processService.getCurrentProcess();
     auto heapAddress = Util::Address<uint32_t>(currentAddress + 1).alignUp(Util::PAGESIZE).get();
-    auto &userThread = Thread::createMainUserThread(file.getName(), process, (uint32_t) executable.getEntryPoint(), argc, argv, nullptr, heapAddress);
+    process.getAddressSpace().setHeapStartAddress(heapAddress);
+    auto &userThread = Thread::createMainUserThread(file.getName(), process, image.getEntryPoint(), argc, argv, nullptr, heapAddress);
+    imageCache.release(image);
 
     processService.getCurrentProcess().setMainThread(userThread);
-    processService.getScheduler().ready(userThread);
+    processService.ready(userThread);
 }
 
 }
\ No newline at end of file
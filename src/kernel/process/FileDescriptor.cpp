@@ -59,11 +59,19 @@ Util::Io::File::AccessMode FileDescriptor::getAccessMode() const {
     return accessMode;
 }
 
+const Util::String& FileDescriptor::getPath() const {
+    return path;
+}
+
 void FileDescriptor::setNode(Filesystem::Node *node) {
     delete FileDescriptor::node;
     FileDescriptor::node = node;
 }
 
+void FileDescriptor::setPath(const Util::String &path) {
+    FileDescriptor::path = path;
+}
+
 void FileDescriptor::setAccessMode(Util::Io::File::AccessMode accessMode) {
     FileDescriptor::accessMode = accessMode;
 }
@@ -71,6 +79,7 @@ void FileDescriptor::setAccessMode(Util::Io::File::AccessMode accessMode) {
 void FileDescriptor::clear() {
     delete node;
     node = nullptr;
+    path = "";
     accessMode = Util::Io::File::BLOCKING;
 }
 
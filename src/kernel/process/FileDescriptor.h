@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 
+#include "lib/util/base/String.h"
 #include "lib/util/collection/Array.h"
 #include "lib/util/io/file/File.h"
 
@@ -65,8 +66,16 @@ public:
 
     [[nodiscard]] Util::Io::File::AccessMode getAccessMode() const;
 
+    /**
+     * Get the canonical path, the file has been opened with.
+     * Nodes registered without a path (e.g. sockets) have an empty path.
+     */
+    [[nodiscard]] const Util::String& getPath() const;
+
     void setNode(Filesystem::Node *node);
 
+    void setPath(const Util::String &path);
+
     void setAccessMode(Util::Io::File::AccessMode accessMode);
 
     void clear();
@@ -74,6 +83,7 @@ public:
 private:
 
     Filesystem::Node *node = nullptr;
+    Util::String path;
     Util::Io::File::AccessMode accessMode = Util::Io::File::BLOCKING;
 };
 
@@ -18,11 +18,12 @@ FileDescriptorManager::~FileDescriptorManager() {
     delete[] descriptorTable;
 }
 
-int32_t FileDescriptorManager::registerFile(Filesystem::Node *node) const {
+int32_t FileDescriptorManager::registerFile(Filesystem::Node *node, const Util::String &path) const {
     for (int32_t fileDescriptor = 0; fileDescriptor < size; fileDescriptor++) {
         if (!descriptorTable[fileDescriptor].isValid()) {
             descriptorTable[fileDescriptor].clear();
             descriptorTable[fileDescriptor].setNode(node);
+            descriptorTable[fileDescriptor].setPath(path);
             return fileDescriptor;
         }
     }
@@ -37,7 +38,7 @@ int32_t FileDescriptorManager::openFile(const Util::String &path) const {
         return -1;
     }
 
-    return registerFile(node);
+    return registerFile(node, Util::Io::File::getCanonicalPath(path));
 }
 
 void FileDescriptorManager::closeFile(int32_t fileDescriptor) const {
@@ -35,7 +35,7 @@ public:
      */
     ~FileDescriptorManager();
 
-    int32_t registerFile(Filesystem::Node *node) const;
+    int32_t registerFile(Filesystem::Node *node, const Util::String &path = "") const;
 
     int32_t openFile(const Util::String &path) const;
 
@@ -15,21 +15,24 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>
  */
 
-#include "PagingAreaManagerRefillRunnable.h"
+#include "IdleThread.h"
 
 #include "lib/util/async/Thread.h"
-#include "kernel/memory/PagingAreaManager.h"
-#include "lib/util/time/Timestamp.h"
+#include "kernel/service/ProcessService.h"
+#include "kernel/service/Service.h"
+#include "kernel/process/Scheduler.h"
 
 namespace Kernel {
 
-PagingAreaManagerRefillRunnable::PagingAreaManagerRefillRunnable(PagingAreaManager &pagingAreaManager) : pagingAreaManager(pagingAreaManager) {}
+void IdleThread::run() {
+    // The idle thread is pinned to its core, so the scheduler reference stays valid
+    auto &scheduler = Service::getService<ProcessService>().getScheduler();
 
-void PagingAreaManagerRefillRunnable::run() {
     while (true) {
-        pagingAreaManager.refillPool();
-        Util::Async::Thread::sleep(Util::Time::Timestamp::ofSeconds(1));
+        scheduler.balance();
+        scheduler.idle();
+        Util::Async::Thread::yield();
     }
 }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "ImageCache.h"
+
+#include "filesystem/Filesystem.h"
+#include "filesystem/Node.h"
+#include "kernel/memory/MappedFile.h"
+#include "kernel/memory/MemoryMapping.h"
+#include "kernel/memory/Paging.h"
+#include "kernel/memory/VirtualAddressSpace.h"
+#include "kernel/service/FilesystemService.h"
+#include "kernel/service/MemoryService.h"
+#include "kernel/service/Service.h"
+#include "lib/util/base/Address.h"
+#include "lib/util/base/Constants.h"
+#include "lib/util/base/Exception.h"
+#include "lib/util/io/file/elf/File.h"
+
+namespace Kernel {
+
+ImageCache::Image::Image(const Util::String &path, uint32_t fileLength) : path(path), fileLength(fileLength) {
+    auto *node = Service::getService<FilesystemService>().getFilesystem().getNode(path);
+    if (node == nullptr) {
+        Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "ImageCache: File not found!");
+    }
+
+    // Only the headers are read here, the segments are read on demand by the page fault handler
+    Util::Io::Elf::FileHeader fileHeader{};
+    if (node->readData(reinterpret_cast<uint8_t*>(&fileHeader), 0, sizeof(Util::Io::Elf::FileHeader)) != sizeof(Util::Io::Elf::FileHeader) || !fileHeader.isValid()) {
+        delete node;
+        Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "Elf: Invalid file!");
+    }
+
+    auto *programHeaders = new Util::Io::Elf::ProgramHeader[fileHeader.programHeaderEntries];
+    auto *sectionHeaders = new Util::Io::Elf::SectionHeader[fileHeader.sectionHeaderEntries];
+    auto programHeadersSize = fileHeader.programHeaderEntries * sizeof(Util::Io::Elf::ProgramHeader);
+    auto sectionHeadersSize = fileHeader.sectionHeaderEntries * sizeof(Util::Io::Elf::SectionHeader);
+    if (node->readData(reinterpret_cast<uint8_t*>(programHeaders), fileHeader.programHeader, programHeadersSize) != programHeadersSize ||
+        node->readData(reinterpret_cast<uint8_t*>(sectionHeaders), fileHeader.sectionHeader, sectionHeadersSize) != sectionHeadersSize) {
+        delete[] programHeaders;
+        delete[] sectionHeaders;
+        delete node;
+        Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "Elf: Invalid file!");
+    }
+
+    entryPoint = fileHeader.entry;
+
+    for (uint32_t i = 0; i < fileHeader.programHeaderEntries; i++) {
+        if (programHeaders[i].type == Util::Io::Elf::ProgramHeaderType::LOAD) {
+            segmentCount++;
+        }
+    }
+
+    segments = new Segment[segmentCount];
+    for (uint32_t i = 0, j = 0; i < fileHeader.programHeaderEntries; i++) {
+        const auto &header = programHeaders[i];
+        if (header.type != Util::Io::Elf::ProgramHeaderType::LOAD) {
+            continue;
+        }
+
+        if (header.offset + header.fileSize > fileLength || header.fileSize > header.memorySize || header.virtualAddress < Util::USER_SPACE_MEMORY_START_ADDRESS + sizeof(Util::System::AddressSpaceHeader)) {
+            delete[] segments;
+            delete[] programHeaders;
+            delete[] sectionHeaders;
+            delete node;
+            Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "Elf: Invalid program header!");
+        }
+
+        bool writable = (header.flags & static_cast<uint32_t>(Util::Io::Elf::ProgramHeaderFlag::WRITABLE)) != 0;
+        segments[j++] = { header.virtualAddress, header.offset, header.fileSize, header.memorySize, static_cast<uint16_t>(Paging::PRESENT | Paging::USER_ACCESSIBLE | (writable ? Paging::WRITABLE : Paging::NONE)) };
+
+        if (header.virtualAddress + header.memorySize > endAddress) {
+            endAddress = header.virtualAddress + header.memorySize;
+        }
+    }
+
+    for (uint32_t i = 0; i < fileHeader.sectionHeaderEntries; i++) {
+        const auto &header = sectionHeaders[i];
+        if (header.offset + header.size > fileLength && header.type != Util::Io::Elf::SectionHeaderType::NOBITS) {
+            continue;
+        }
+
+        if (header.type == Util::Io::Elf::SectionHeaderType::SYMTAB && symbolTableSize == 0) {
+            symbolTableOffset = header.offset;
+            symbolTableSize = header.size;
+        } else if (header.type == Util::Io::Elf::SectionHeaderType::STRTAB && stringTableSize == 0 && i != fileHeader.sectionHeaderStringIndex) {
+            stringTableOffset = header.offset;
+            stringTableSize = header.size;
+        } else if (header.type == Util::Io::Elf::SectionHeaderType::NOTE && heapManager == Util::System::FREE_LIST_HEAP_MANAGER) {
+            // Applications may request a heap memory manager via an ELF note
+            auto *notes = new uint8_t[header.size];
+            if (node->readData(notes, header.offset, header.size) != header.size) {
+                delete[] notes;
+                delete[] segments;
+                delete[] programHeaders;
+                delete[] sectionHeaders;
+                delete node;
+                Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "Elf: Invalid note section!");
+            }
+
+            uint32_t noteSize = 0;
+            const auto *heapManagerNote = Util::Io::Elf::File::findNote(notes, header.size, Util::System::NOTE_NAME, Util::System::HEAP_MANAGER_NOTE_TYPE, noteSize);
+            if (heapManagerNote != nullptr && noteSize == sizeof(Util::System::HeapManager)) {
+                auto requestedHeapManager = *reinterpret_cast<const Util::System::HeapManager*>(heapManagerNote);
+                if (requestedHeapManager == Util::System::TLSF_HEAP_MANAGER) {
+                    heapManager = requestedHeapManager;
+                }
+            }
+
+            delete[] notes;
+        }
+    }
+
+    delete[] programHeaders;
+    delete[] sectionHeaders;
+
+    file = new MappedFile(path, node, fileLength);
+}
+
+ImageCache::Image::~Image() {
+    delete[] segments;
+    file->release();
+}
+
+uint32_t ImageCache::Image::map() const {
+    auto &addressSpace = Service::getService<MemoryService>().getCurrentAddressSpace();
+    const auto pageMask = ~(Util::PAGESIZE - 1);
+
+    // Loadable segments are sorted by their virtual address. A page shared with the previous segment
+    // is loaded eagerly below and not part of this segment's mapping, since mappings must not overlap.
+    uint32_t previousEndAddress = 0;
+    for (uint32_t i = 0; i < segmentCount; i++) {
+        const auto &segment = segments[i];
+        uint32_t startAddress = segment.virtualAddress & pageMask;
+        uint32_t endAddress = Util::Address<uint32_t>(segment.virtualAddress + segment.memorySize).alignUp(Util::PAGESIZE).get();
+        if (startAddress < previousEndAddress) {
+            startAddress = previousEndAddress;
+        }
+
+        if (startAddress >= endAddress) {
+            continue;
+        }
+
+        previousEndAddress = endAddress;
+        addressSpace.addMapping(new MemoryMapping(MemoryMapping::IMAGE, startAddress, endAddress, segment.flags, file, segment.virtualAddress, segment.virtualAddress + segment.fileSize, segment.fileOffset));
+    }
+
+    // Segments, that are not page aligned, may share a page, which must then be loaded right away
+    for (uint32_t i = 0; i < segmentCount; i++) {
+        for (uint32_t j = i + 1; j < segmentCount; j++) {
+            uint32_t start = (segments[i].virtualAddress > segments[j].virtualAddress ? segments[i].virtualAddress : segments[j].virtualAddress) & pageMask;
+            uint32_t endI = segments[i].virtualAddress + segments[i].memorySize;
+            uint32_t endJ = segments[j].virtualAddress + segments[j].memorySize;
+            uint32_t end = Util::Address<uint32_t>(endI < endJ ? endI : endJ).alignUp(Util::PAGESIZE).get();
+
+            for (uint32_t page = start; page < end; page += Util::PAGESIZE) {
+                if (addressSpace.getPhysicalAddress(reinterpret_cast<void*>(page)) == nullptr) {
+                    loadPage(page);
+                }
+            }
+        }
+    }
+
+    const uint16_t tableFlags = Paging::PRESENT | Paging::USER_ACCESSIBLE;
+    uint32_t symbolTableAddress = getSymbolTableAddress();
+    uint32_t stringTableAddress = getStringTableAddress();
+    uint32_t tableEndAddress = Util::Address<uint32_t>(stringTableAddress + stringTableSize).alignUp(Util::PAGESIZE).get();
+
+    if (symbolTableSize > 0) {
+        addressSpace.addMapping(new MemoryMapping(MemoryMapping::IMAGE, symbolTableAddress, stringTableAddress, tableFlags, file, symbolTableAddress, symbolTableAddress + symbolTableSize, symbolTableOffset));
+    }
+
+    if (stringTableSize > 0) {
+        addressSpace.addMapping(new MemoryMapping(MemoryMapping::IMAGE, stringTableAddress, tableEndAddress, tableFlags, file, stringTableAddress, stringTableAddress + stringTableSize, stringTableOffset));
+    }
+
+    return tableEndAddress;
+}
+
+void ImageCache::Image::loadPage(uint32_t page) const {
+    auto &memoryService = Service::getService<MemoryService>();
+    auto *pageAddress = reinterpret_cast<uint8_t*>(page);
+    uint16_t flags = Paging::PRESENT | Paging::USER_ACCESSIBLE;
+
+    memoryService.map(pageAddress, 1, flags | Paging::WRITABLE, true);
+
+    for (uint32_t i = 0; i < segmentCount; i++) {
+        const auto &segment = segments[i];
+        uint32_t dataStart = segment.virtualAddress > page ? segment.virtualAddress : page;
+        uint32_t dataEnd = segment.virtualAddress + segment.fileSize < page + Util::PAGESIZE ? segment.virtualAddress + segment.fileSize : page + Util::PAGESIZE;
+        if (segment.virtualAddress < page + Util::PAGESIZE && segment.virtualAddress + segment.memorySize > page) {
+            flags |= segment.flags;
+        }
+
+        if (dataStart < dataEnd) {
+            file->read(pageAddress + (dataStart - page), segment.fileOffset + (dataStart - segment.virtualAddress), dataEnd - dataStart);
+        }
+    }
+
+    if ((flags & Paging::WRITABLE) == 0) {
+        auto &addressSpace = memoryService.getCurrentAddressSpace();
+        addressSpace.remap(addressSpace.getPhysicalAddress(pageAddress), pageAddress, flags);
+    }
+}
+
+uint32_t ImageCache::Image::getEntryPoint() const {
+    return entryPoint;
+}
+
+uint32_t ImageCache::Image::getEndAddress() const {
+    return endAddress;
+}
+
+Util::System::HeapManager ImageCache::Image::getHeapManager() const {
+    return heapManager;
+}
+
+uint32_t ImageCache::Image::getSymbolTableAddress() const {
+    return Util::Address<uint32_t>(endAddress).alignUp(Util::PAGESIZE).get();
+}
+
+uint32_t ImageCache::Image::getSymbolTableSize() const {
+    return symbolTableSize;
+}
+
+uint32_t ImageCache::Image::getStringTableAddress() const {
+    return Util::Address<uint32_t>(getSymbolTableAddress() + symbolTableSize).alignUp(Util::PAGESIZE).get();
+}
+
+uint32_t ImageCache::Image::getStringTableSize() const {
+    return stringTableSize;
+}
+
+ImageCache::~ImageCache() {
+    invalidateAll();
+}
+
+ImageCache::Image& ImageCache::acquire(const Util::String &path, uint32_t fileLength) {
+    lock.acquire();
+
+    for (uint32_t i = 0; i < images.size(); i++) {
+        auto *image = images.get(i);
+        if (image->path == path && image->fileLength == fileLength) {
+            image->users++;
+
+            // Keep the list ordered by last use, so that the least recently used image is evicted first
+            images.removeIndex(i);
+            images.add(image);
+
+            lock.release();
+            return *image;
+        }
+    }
+
+    lock.release();
+
+    // Reading the headers may block, so the lock is not held while creating a new image
+    auto *image = new Image(path, fileLength);
+
+    lock.acquire();
+
+    // Another process may have cached the same executable in the meantime (or an older version of it)
+    for (uint32_t i = 0; i < images.size(); i++) {
+        if (images.get(i)->path == path) {
+            remove(*images.get(i));
+            break;
+        }
+    }
+
+    if (images.size() >= MAX_IMAGES) {
+        remove(*images.get(0));
+    }
+
+    image->cached = true;
+    images.add(image);
+
+    lock.release();
+    return *image;
+}
+
+void ImageCache::release(Image &image) {
+    lock.acquire();
+    image.users--;
+    bool unused = !image.cached && image.users == 0;
+    lock.release();
+
+    if (unused) {
+        delete &image;
+    }
+}
+
+void ImageCache::invalidate(const Util::String &path) {
+    lock.acquire();
+
+    for (uint32_t i = 0; i < images.size(); i++) {
+        if (images.get(i)->path == path) {
+            remove(*images.get(i));
+            break;
+        }
+    }
+
+    lock.release();
+}
+
+void ImageCache::invalidateAll() {
+    lock.acquire();
+
+    while (!images.isEmpty()) {
+        remove(*images.get(0));
+    }
+
+    lock.release();
+}
+
+void ImageCache::remove(Image &image) {
+    images.remove(&image);
+    image.cached = false;
+
+    if (image.users == 0) {
+        delete &image;
+    }
+}
+
+}
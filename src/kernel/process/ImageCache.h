@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_IMAGECACHE_H
+#define HHUOS_IMAGECACHE_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Spinlock.h"
+#include "lib/util/base/String.h"
+#include "lib/util/base/System.h"
+#include "lib/util/collection/ArrayList.h"
+
+namespace Kernel {
+class MappedFile;
+
+/**
+ * Keeps the parsed headers and the page cache of recently started programs.
+ * Programs are not loaded up front. Instead, their segments are added as memory mappings to the new address space
+ * and each page is read from the executable, when it is accessed for the first time.
+ * Since all processes running the same image map their pages from the same page cache, read-only segments (.text, .rodata)
+ * are shared between them, while writable segments (.data) are mapped copy-on-write.
+ *
+ * Cached images are identified by their canonical path and file length.
+ * Since files carry no modification time, the filesystem service invalidates images, when executables are modified or deleted.
+ */
+class ImageCache {
+
+public:
+
+    class Image {
+
+    friend class ImageCache;
+
+    public:
+        /**
+         * Constructor.
+         * Reads and validates the headers of an executable.
+         */
+        Image(const Util::String &path, uint32_t fileLength);
+
+        /**
+         * Copy Constructor.
+         */
+        Image(const Image &other) = delete;
+
+        /**
+         * Assignment operator.
+         */
+        Image &operator=(const Image &other) = delete;
+
+        /**
+         * Destructor.
+         * Releases the reference to the page cache.
+         */
+        ~Image();
+
+        /**
+         * Add memory mappings for all segments, as well as for the symbol and string table, to the current address space.
+         * The tables are mapped to page aligned addresses behind the program's end address (needed for stack traces with symbol names).
+         *
+         * @return The page aligned address behind the mapped string table
+         */
+        uint32_t map() const;
+
+        [[nodiscard]] uint32_t getEntryPoint() const;
+
+        [[nodiscard]] uint32_t getEndAddress() const;
+
+        [[nodiscard]] Util::System::HeapManager getHeapManager() const;
+
+        [[nodiscard]] uint32_t getSymbolTableAddress() const;
+
+        [[nodiscard]] uint32_t getSymbolTableSize() const;
+
+        [[nodiscard]] uint32_t getStringTableAddress() const;
+
+        [[nodiscard]] uint32_t getStringTableSize() const;
+
+    private:
+
+        struct Segment {
+            uint32_t virtualAddress;
+            uint32_t fileOffset;
+            uint32_t fileSize;
+            uint32_t memorySize;
+            uint16_t flags;
+        };
+
+        /**
+         * Fill a page, that is covered by multiple segments, with the data of all of them.
+         * Such pages cannot be mapped on demand, since each memory mapping only knows a single segment.
+         */
+        void loadPage(uint32_t page) const;
+
+        Util::String path;
+        uint32_t fileLength;
+        MappedFile *file = nullptr;
+
+        uint32_t entryPoint = 0;
+        uint32_t endAddress = 0;
+        Util::System::HeapManager heapManager = Util::System::FREE_LIST_HEAP_MANAGER;
+
+        uint32_t symbolTableOffset = 0;
+        uint32_t symbolTableSize = 0;
+        uint32_t stringTableOffset = 0;
+        uint32_t stringTableSize = 0;
+
+        Segment *segments = nullptr;
+        uint32_t segmentCount = 0;
+
+        // Number of loaders currently using this image (an image removed from the cache is deleted once it is no longer used)
+        uint32_t users = 1;
+        bool cached = false;
+    };
+
+    /**
+     * Default Constructor.
+     */
+    ImageCache() = default;
+
+    /**
+     * Copy Constructor.
+     */
+    ImageCache(const ImageCache &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    ImageCache &operator=(const ImageCache &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~ImageCache();
+
+    /**
+     * Search for a cached image of an executable and create a new one, if none is found.
+     * The image must be released via release(), once it is no longer needed.
+     *
+     * @param path The executable's canonical path
+     * @param fileLength The executable's current length
+     * @return The image
+     */
+    [[nodiscard]] Image& acquire(const Util::String &path, uint32_t fileLength);
+
+    /**
+     * Release an image acquired via acquire().
+     */
+    void release(Image &image);
+
+    /**
+     * Remove the cached image of the executable at the given path (e.g. because it has been deleted).
+     */
+    void invalidate(const Util::String &path);
+
+    /**
+     * Remove all cached images.
+     */
+    void invalidateAll();
+
+    static const constexpr uint32_t MAX_IMAGES = 16;
+
+private:
+
+    /**
+     * Remove an image from the cache and delete it, if it is not in use. The lock must be held by the caller.
+     */
+    void remove(Image &image);
+
+    Util::ArrayList<Image*> images;
+    Util::Async::Spinlock lock;
+};
+
+}
+
+#endif
@@ -120,24 +120,44 @@ Util::String Process::getName() const {
 }
 
 Util::Array<Thread*> Process::getThreads() const {
-    return threads.toArray();
+    threadLock.acquire();
+    auto array = threads.toArray();
+    threadLock.release();
+
+    return array;
+}
+
+Thread* Process::getThread(uint32_t id) const {
+    threadLock.acquire();
+    for (auto *thread : threads) {
+        if (thread->getId() == id) {
+            return threadLock.releaseAndReturn(thread);
+        }
+    }
+
+    return threadLock.releaseAndReturn<Thread*>(nullptr);
 }
 
 void Process::addThread(Thread &thread) {
+    threadLock.acquire();
     threads.add(&thread);
+    threadLock.release();
 }
 
 void Process::removeThread(Thread &thread) {
+    threadLock.acquire();
     threads.remove(&thread);
+    threadLock.release();
 }
 
 void Process::killAllThreadsButCurrent() {
     auto &scheduler = Service::getService<ProcessService>().getScheduler();
     auto currentThreadId = scheduler.getCurrentThread().getId();
 
-    for (auto *thread : threads) {
+    // Threads may run on any core, so each thread is killed by the scheduler it has been registered at
+    for (auto *thread : getThreads()) {
         if (thread->getId() != currentThreadId) {
-            scheduler.kill(*thread);
+            thread->getScheduler()->kill(*thread);
         }
     }
 }
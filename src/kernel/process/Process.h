@@ -25,6 +25,7 @@
 #include "lib/util/collection/Array.h"
 #include "lib/util/collection/ArrayList.h"
 #include "lib/util/base/String.h"
+#include "lib/util/async/Spinlock.h"
 #include "kernel/process/Thread.h"
 
 namespace Util {
@@ -89,6 +90,8 @@ public:
 
     [[nodiscard]] Util::Array<Thread*> getThreads() const;
 
+    [[nodiscard]] Thread* getThread(uint32_t id) const;
+
     void addThread(Thread &thread);
 
     void removeThread(Thread &thread);
@@ -105,6 +108,7 @@ private:
     FileDescriptorManager fileDescriptorManager;
     Util::Io::File workingDirectory;
     Util::ArrayList<Thread*> threads;
+    mutable Util::Async::Spinlock threadLock; // Threads of a process may be added and removed by different cores
     Thread *mainThread = nullptr;
 
     bool finished = false;
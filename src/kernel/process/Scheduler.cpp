@@ -21,8 +21,13 @@
 
 #include "kernel/service/TimeService.h"
 #include "device/cpu/Fpu.h"
+#include "device/interrupt/apic/Apic.h"
+#include "device/interrupt/apic/LocalApic.h"
+#include "device/time/apic/ApicTimer.h"
+#include "kernel/interrupt/InterruptVector.h"
 #include "kernel/process/Process.h"
 #include "kernel/process/Thread.h"
+#include "kernel/process/WaitQueue.h"
 #include "kernel/service/MemoryService.h"
 #include "lib/util/base/Exception.h"
 #include "lib/util/time/Timestamp.h"
@@ -35,10 +40,11 @@
 #include "lib/util/base/HeapMemoryManager.h"
 #include "kernel/service/ProcessService.h"
 #include "kernel/memory/VirtualAddressSpace.h"
+#include "lib/util/async/Thread.h"
 
 namespace Kernel {
 
-Scheduler::Scheduler() {
+Scheduler::Scheduler(uint8_t cpuId) : cpuId(cpuId) {
     defaultFpuContext = static_cast<uint8_t*>(Service::getService<MemoryService>().allocateKernelMemory(512, 16));
     Util::Address<uint32_t>(defaultFpuContext).setRange(0, 512);
 
@@ -51,8 +57,10 @@ Scheduler::Scheduler() {
 }
 
 Scheduler::~Scheduler() {
-    while (!readyQueue.isEmpty()) {
-        delete readyQueue.poll();
+    for (auto &readyQueue : readyQueues) {
+        while (!readyQueue.isEmpty()) {
+            delete readyQueue.poll();
+        }
     }
 
     for (auto id : joinMap.keys()) {
@@ -68,6 +76,14 @@ bool Scheduler::isInitialized() const {
     return initialized;
 }
 
+uint8_t Scheduler::getCpuId() const {
+    return cpuId;
+}
+
+void Scheduler::setCpuId(uint8_t cpuId) {
+    Scheduler::cpuId = cpuId;
+}
+
 Thread& Scheduler::getCurrentThread() {
     if (!initialized) {
         readyQueueLock.release();
@@ -78,114 +94,135 @@ Thread& Scheduler::getCurrentThread() {
 }
 
 Thread* Scheduler::getLastFpuThread() {
-    return lastFpuThread;
+    return reinterpret_cast<Thread*>(lastFpuThread);
 }
 
 void Scheduler::start() {
     readyQueueLock.acquire();
-    if (readyQueue.isEmpty()) {
+    if (isReadyQueueEmpty()) {
         readyQueueLock.release();
         Util::Exception::throwException(Util::Exception::ILLEGAL_STATE, "Scheduler: No thread registered!");
     }
 
-    auto *thread = readyQueue.poll();
+    auto *thread = dequeue();
     currentThread = thread;
+    lastPriorityBoost = Util::Time::getSystemTime();
 
     Thread::startFirstThread(*currentThread);
 }
 
 void Scheduler::ready(Thread &thread) {
+    // This scheduler may belong to another core, so we always yield the scheduler of the executing core while waiting
     lockReadyQueue();
     while (!joinLock.tryAcquire()) {
         readyQueueLock.release();
-        yield();
+        Util::Async::Thread::yield();
         lockReadyQueue();
     }
 
-    if (readyQueue.contains(&thread)) {
+    if (readyQueues[thread.level].contains(&thread)) {
         Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "Scheduler: Thread is already running!");
     }
 
-    readyQueue.offer(&thread);
+    thread.scheduler = this;
+    thread.migratable = true;
+    enqueue(thread);
     thread.getParent().addThread(thread);
 
     joinMap.put(thread.getId(), new Util::ArrayList<Thread*>());
 
     joinLock.release();
     readyQueueLock.release();
+
+    wakeup();
 }
 
 void Scheduler::exit() {
-    lockReadyQueue();
-    while (!joinLock.tryAcquire()) {
-        readyQueueLock.release();
-        yield();
-        lockReadyQueue();
-    }
-
-    // Ready threads that are joining on the current thread
-    auto threadId = currentThread->getId();
-    auto *joinList = joinMap.get(threadId);
-    for (uint32_t i = 0; i < joinList->size(); i++) {
-        readyQueue.offer(joinList->get(i));
-    }
-
-    delete joinMap.remove(threadId);
-    joinLock.release();
+    // Ready threads that are joining on the current thread (they may be scheduled on other cores)
+    readyJoiningThreads(removeJoinList(currentThread->getId()));
 
+    lockReadyQueue();
     currentThread->getParent().removeThread(*currentThread);
     resetLastFpuThread(*currentThread);
     Service::getService<ProcessService>().cleanup(currentThread);
 
-    readyQueueLock.release();
-    block();
+    blockWithLockedReadyQueue();
 }
 
 void Scheduler::kill(Thread &thread) {
-    if (thread.getId() == currentThread->getId()) {
+    auto &localScheduler = Service::getService<ProcessService>().getScheduler();
+    if (&localScheduler == this && &thread == currentThread) {
         Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT,"Scheduler: A thread cannot kill itself!");
     }
 
     lockReadyQueue();
-    while (!joinLock.tryAcquire()) {
+    while (thread.scheduler == this && (currentThread == &thread || thread.waitingForInterrupt || !removeFromWaitQueue(thread))) {
+        // Thread is currently running on another core, being woken up or waiting for an I/O operation -> Wait until it gets preempted/unblocked
         readyQueueLock.release();
-        yield();
+        Util::Async::Thread::yield();
         lockReadyQueue();
     }
 
-    sleepQueueLock.acquire();
-    sleepList.remove(SleepEntry{&thread, Util::Time::Timestamp()});
-    sleepQueueLock.release();
-
-    // Ready threads that are joining on the current thread
-    auto *joinList = joinMap.get(thread.getId());
-    for (uint32_t i = 0; i < joinList->size(); i++) {
-        readyQueue.offer(joinList->get(i));
+    if (thread.scheduler != this) {
+        // Thread has been stolen by another core in the meantime -> Let its new scheduler kill it
+        readyQueueLock.release();
+        thread.scheduler->kill(thread);
+        return;
     }
 
-    delete joinMap.remove(thread.getId());
-    joinLock.release();
+    sleepQueueLock.acquire();
+    sleepQueue.remove(SleepEntry{&thread, Util::Time::Timestamp()});
+    sleepQueueLock.release();
 
-    readyQueue.remove(&thread);
+    readyQueues[thread.level].remove(&thread);
     thread.getParent().removeThread(thread);
 
     resetLastFpuThread(thread);
     Service::getService<ProcessService>().cleanup(&thread);
     readyQueueLock.release();
+
+    // Ready threads that are joining on the killed thread
+    readyJoiningThreads(removeJoinList(thread.getId()));
 }
 
-void Scheduler::yield(bool interrupt) {
+void Scheduler::yield(bool interrupt, bool userMode) {
     if (!initialized || !readyQueueLock.tryAcquire()) {
         return;
     }
 
-    checkSleepList();
+    checkSleepQueue();
+    checkInterruptWakeups();
 
     auto *current = currentThread;
-    auto *next = readyQueue.poll();
+    if (interrupt) {
+        boostPriorities();
+
+        // The current thread keeps running until its time slice is used up, unless a thread with a higher priority is ready
+        if (++usedTimeSlice < getTimeSlice(current->level) && !hasReadyThreadAbove(current->level)) {
+            readyQueueLock.release();
+            return;
+        }
+
+        // Threads using up their whole time slice are considered CPU-bound and are moved one level down
+        if (current->level > Util::Async::Thread::LOW) {
+            current->level = static_cast<Util::Async::Thread::Priority>(current->level - 1);
+        }
+    }
+
+    // Nothing else to run on this core (e.g. the idle thread is yielding)
+    if (isReadyQueueEmpty()) {
+        usedTimeSlice = 0;
+        readyQueueLock.release();
+        return;
+    }
+
+    auto *next = dequeue();
     currentThread = next;
+    usedTimeSlice = 0;
 
-    readyQueue.offer(current);
+    // A thread preempted in user mode does not hold any references to this core's scheduler, so another core may steal it
+    current->migratable = userMode;
+    enqueue(*current);
 
     if (fpu != nullptr) {
         Device::Fpu::armFpuMonitor();
@@ -209,19 +246,24 @@ void Scheduler::switchFpuContext() {
     // Disable FPU monitoring (will be enabled by scheduler at next thread switch)
     Device::Fpu::disarmFpuMonitor();
 
-    if (currentThread == lastFpuThread) {
+    if (reinterpret_cast<uint32_t>(currentThread) == lastFpuThread) {
         readyQueueLock.release();
         return;
     }
 
     fpu->switchContext();
 
-    lastFpuThread = currentThread;
+    lastFpuThread = reinterpret_cast<uint32_t>(currentThread);
     readyQueueLock.release();
 }
 
 uint32_t Scheduler::getThreadCount() const {
-    return readyQueue.size();
+    uint32_t count = 0;
+    for (const auto &readyQueue : readyQueues) {
+        count += readyQueue.size();
+    }
+
+    return count;
 }
 
 uint8_t* Scheduler::getDefaultFpuContext() {
@@ -234,17 +276,30 @@ void Scheduler::unlockReadyQueue() {
 
 void Scheduler::block() {
     readyQueueLock.acquire();
+    blockWithLockedReadyQueue();
+}
 
+void Scheduler::block(Util::Async::Lock &lock) {
+    lockReadyQueue();
+    lock.release();
+    blockWithLockedReadyQueue();
+}
+
+void Scheduler::blockWithLockedReadyQueue() {
     do {
-        checkSleepList();
-    } while (readyQueue.isEmpty());
+        checkSleepQueue();
+        checkInterruptWakeups();
+    } while (isReadyQueueEmpty());
 
     auto *current = currentThread;
-    auto *next = readyQueue.poll();
+    auto *next = dequeue();
     currentThread = next;
+    current->migratable = false;
+    usedTimeSlice = 0;
 
-    // Thread has enqueued itself into sleep list and waited so long, that it dequeued itself in the meantime
+    // Thread has enqueued itself into sleep queue and waited so long, that it dequeued itself in the meantime
     if (current == next) {
+        readyQueueLock.release();
         return;
     }
 
@@ -255,67 +310,252 @@ void Scheduler::block() {
     Thread::switchThread(*current, *next);
 }
 
-void Scheduler::unblock(Thread &thread) {
+void Scheduler::unblock(Thread &thread, bool boost) {
     readyQueueLock.acquire();
-    readyQueue.offer(&thread);
+    if (boost) {
+        boostPriority(thread);
+    }
+
+    enqueue(thread);
     readyQueueLock.release();
+
+    wakeup();
+}
+
+void Scheduler::blockForInterrupt(uint32_t &state) {
+    auto stateWrapper = Util::Async::Atomic<uint32_t>(state);
+
+    lockReadyQueue();
+    if (!stateWrapper.compareAndSet(INTERRUPT_PENDING, INTERRUPT_WAITING)) {
+        // The interrupt handler has already signaled the state
+        readyQueueLock.release();
+        return;
+    }
+
+    auto *current = currentThread;
+    current->waitingForInterrupt = true;
+    blockWithLockedReadyQueue();
+
+    // A thread executing in kernel mode is never stolen by another core, so it is still running on this scheduler
+    current->waitingForInterrupt = false;
+}
+
+void Scheduler::signalFromInterrupt(uint32_t &state, Thread &thread) {
+    auto stateWrapper = Util::Async::Atomic<uint32_t>(state);
+    if (stateWrapper.getAndSet(INTERRUPT_SIGNALED) != INTERRUPT_WAITING) {
+        // The thread has not been blocked yet and will notice the signal by itself
+        return;
+    }
+
+    auto &scheduler = *thread.scheduler;
+    auto headWrapper = Util::Async::Atomic<uint32_t>(scheduler.interruptWakeups);
+    do {
+        thread.nextInterruptWakeup = reinterpret_cast<Thread*>(headWrapper.get());
+    } while (!headWrapper.compareAndSet(reinterpret_cast<uint32_t>(thread.nextInterruptWakeup), reinterpret_cast<uint32_t>(&thread)));
+
+    scheduler.wakeup();
+}
+
+bool Scheduler::setPriority(Thread &thread, Util::Async::Thread::Priority priority) {
+    lockReadyQueue();
+    if (thread.scheduler != this) {
+        // Thread has been stolen by another core in the meantime
+        readyQueueLock.release();
+        return false;
+    }
+
+    auto ready = readyQueues[thread.level].remove(&thread);
+    thread.priority = priority;
+    thread.level = priority;
+    if (ready) {
+        enqueue(thread);
+    }
+
+    readyQueueLock.release();
+    return true;
 }
 
 void Scheduler::sleep(const Util::Time::Timestamp &time) {
-    sleepQueueLock.acquire();
+    while (true) {
+        // Reserve space in the sleep queue up front, since allocating memory with the ready queue locked may deadlock
+        sleepQueueLock.acquire();
+        auto reservedSize = sleepQueue.size() + 1;
+        sleepQueue.ensureCapacity(reservedSize);
+        sleepQueueLock.release();
+
+        lockReadyQueue();
+        sleepQueueLock.acquire();
+        if (sleepQueue.size() < reservedSize) {
+            break;
+        }
+
+        // Another thread of this core has gone to sleep in the meantime and used up the reserved space
+        sleepQueueLock.release();
+        readyQueueLock.release();
+    }
+
     auto wakeupTime = Util::Time::getSystemTime() + time;
-    sleepList.add(SleepEntry{currentThread, wakeupTime});
+    sleepQueue.offer(SleepEntry{currentThread, wakeupTime});
     sleepQueueLock.release();
 
-    block();
+    blockWithLockedReadyQueue();
 }
 
 void Scheduler::join(const Thread& thread) {
-    joinLock.acquire();
-    if (!joinMap.containsKey(thread.getId())) {
+    auto *threadScheduler = thread.scheduler;
+    if (threadScheduler == nullptr) {
         return;
     }
 
-    auto *joinList = joinMap.get(thread.getId());
-    joinList->add(currentThread);
-    joinLock.release();
+    // Keep the ready queue locked, so that the joined thread cannot ready us before we are blocked
+    lockReadyQueue();
+    while (!threadScheduler->addJoiningThread(thread.getId(), *currentThread)) {
+        if (thread.scheduler == threadScheduler) {
+            // Thread has already finished
+            readyQueueLock.release();
+            return;
+        }
+
+        // Thread has been stolen by another core in the meantime -> Its join list has moved as well
+        threadScheduler = thread.scheduler;
+    }
 
-    block();
+    blockWithLockedReadyQueue();
 }
 
-void Scheduler::checkSleepList() {
+bool Scheduler::removeFromWaitQueue(Thread &thread) {
+    auto *waitQueue = thread.waitQueue;
+    return waitQueue == nullptr || waitQueue->tryRemove(thread);
+}
+
+void Scheduler::checkSleepQueue() {
     if (sleepQueueLock.tryAcquire()) {
+        // The sleep queue is sorted by wakeup time, so we only need to look at its head
         auto systemTime = Service::getService<TimeService>().getSystemTime();
-        for (uint32_t i = 0; i < sleepList.size(); i++) {
-            const auto &entry = sleepList.get(i);
-            if (systemTime >= entry.wakeupTime) {
-                readyQueue.offer(entry.thread);
-                sleepList.remove(entry);
-            }
+        while (!sleepQueue.isEmpty() && systemTime >= sleepQueue.peek().wakeupTime) {
+            enqueue(*sleepQueue.poll().thread);
         }
         sleepQueueLock.release();
     }
 }
 
+void Scheduler::checkInterruptWakeups() {
+    auto headWrapper = Util::Async::Atomic<uint32_t>(interruptWakeups);
+    auto *thread = reinterpret_cast<Thread*>(headWrapper.getAndSet(0));
+
+    while (thread != nullptr) {
+        auto *next = thread->nextInterruptWakeup;
+        thread->nextInterruptWakeup = nullptr;
+
+        // Threads woken up by interrupt handlers have been waiting for I/O
+        boostPriority(*thread);
+        enqueue(*thread);
+
+        thread = next;
+    }
+}
+
+void Scheduler::boostPriority(Thread &thread) {
+    if (thread.priority != Util::Async::Thread::IDLE) {
+        // Threads waiting for I/O are usually interactive, so they are allowed to run before CPU-bound threads
+        thread.level = thread.priority == Util::Async::Thread::HIGH ? Util::Async::Thread::HIGH : static_cast<Util::Async::Thread::Priority>(thread.priority + 1);
+    }
+}
+
+bool Scheduler::getNextWakeupTime(Util::Time::Timestamp &wakeupTime) {
+    sleepQueueLock.acquire();
+    if (sleepQueue.isEmpty()) {
+        sleepQueueLock.release();
+        return false;
+    }
+
+    wakeupTime = sleepQueue.peek().wakeupTime;
+    sleepQueueLock.release();
+    return true;
+}
+
+void Scheduler::idle() {
+    auto &interruptService = Service::getService<InterruptService>();
+    auto timeout = Util::Time::Timestamp::ofMilliseconds(MAX_IDLE_TIME);
+
+    // No other thread of this core can go to sleep while the idle thread is running, so the deadline cannot move forward
+    Util::Time::Timestamp wakeupTime;
+    if (getNextWakeupTime(wakeupTime)) {
+        auto systemTime = Service::getService<TimeService>().getSystemTime();
+        if (wakeupTime <= systemTime) {
+            return;
+        }
+
+        if (wakeupTime - systemTime < timeout) {
+            timeout = wakeupTime - systemTime;
+        }
+    }
+
+    // Interrupts are disabled until 'hlt', so that no wakeup gets lost between checking the ready queues and halting
+    auto haltedWrapper = Util::Async::Atomic<uint32_t>(halted);
+    asm volatile ("cli");
+    if (interruptService.usesApic()) {
+        // Setting the flag is a locked operation, so it is visible to other cores before the ready queues are checked
+        haltedWrapper.set(true);
+    }
+
+    if (isReadyQueueEmpty() && Util::Async::Atomic<uint32_t>(interruptWakeups).get() == 0) {
+        auto *timer = interruptService.usesApic() ? &interruptService.getApic().getCurrentTimer() : nullptr;
+        if (timer != nullptr) {
+            timer->setOneShot(timeout);
+        }
+
+        // 'sti' only takes effect after the next instruction, so the core cannot miss an interrupt before halting
+        asm volatile (
+                "sti;"
+                "hlt;"
+                "cli;"
+                );
+
+        if (timer != nullptr) {
+            timer->setPeriodic();
+        }
+    }
+
+    haltedWrapper.set(false);
+    asm volatile ("sti");
+}
+
+void Scheduler::wakeup() {
+    // Only the core halted by its idle thread needs an interrupt, all others check their ready queues on their next tick
+    auto haltedWrapper = Util::Async::Atomic<uint32_t>(halted);
+    if (haltedWrapper.compareAndSet(true, false)) {
+        Device::LocalApic::sendFixedInterProcessorInterrupt(cpuId, InterruptVector::WAKEUP);
+    }
+}
+
 void Scheduler::resetLastFpuThread(Thread &terminatedThread) {
-    Util::Async::Atomic<uint32_t> wrapper(reinterpret_cast<uint32_t&>(lastFpuThread));
+    Util::Async::Atomic<uint32_t> wrapper(lastFpuThread);
     wrapper.compareAndSet(reinterpret_cast<uint32_t>(&terminatedThread), 0);
 }
 
 Thread* Scheduler::getThread(uint32_t id) {
     readyQueueLock.acquire();
-    for (uint32_t i = 0; i < readyQueue.size(); i++) {
-        auto *thread = readyQueue.get(i);
-        if (thread->getId() == id) {
-            readyQueueLock.release();
-            return thread;
+    // With multiple cores, the thread may currently be running on the core this scheduler belongs to
+    if (currentThread != nullptr && currentThread->getId() == id) {
+        auto *thread = currentThread;
+        readyQueueLock.release();
+        return thread;
+    }
+
+    for (auto &readyQueue : readyQueues) {
+        for (uint32_t i = 0; i < readyQueue.size(); i++) {
+            auto *thread = readyQueue.get(i);
+            if (thread->getId() == id) {
+                readyQueueLock.release();
+                return thread;
+            }
         }
     }
     readyQueueLock.release();
 
     sleepQueueLock.acquire();
-    for (uint32_t i = 0; i < sleepList.size(); i++) {
-        const auto &entry = sleepList.get(i);
+    for (const auto &entry : sleepQueue) {
         if (entry.thread->getId() == id) {
             sleepQueueLock.release();
             return entry.thread;
@@ -326,6 +566,137 @@ Thread* Scheduler::getThread(uint32_t id) {
     return nullptr;
 }
 
+bool Scheduler::isScheduled(const Thread &thread) {
+    // The ready queue lock is held until a thread switch has finished, so the current thread is safe to check inside 'getThread()'
+    return getThread(thread.getId()) != nullptr;
+}
+
+bool Scheduler::addJoiningThread(uint32_t threadId, Thread &joiningThread) {
+    joinLock.acquire();
+    if (!joinMap.containsKey(threadId)) {
+        joinLock.release();
+        return false;
+    }
+
+    joinMap.get(threadId)->add(&joiningThread);
+    joinLock.release();
+
+    return true;
+}
+
+Util::ArrayList<Thread*>* Scheduler::removeJoinList(uint32_t threadId) {
+    joinLock.acquire();
+    auto *joinList = joinMap.containsKey(threadId) ? joinMap.remove(threadId) : nullptr;
+    joinLock.release();
+
+    return joinList;
+}
+
+void Scheduler::readyJoiningThreads(Util::ArrayList<Thread*> *joinList) {
+    if (joinList == nullptr) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < joinList->size(); i++) {
+        auto *joiningThread = joinList->get(i);
+        joiningThread->scheduler->unblock(*joiningThread);
+    }
+
+    delete joinList;
+}
+
+void Scheduler::balance() {
+    if (!initialized || !isReadyQueueEmpty()) {
+        return;
+    }
+
+    // All schedulers have been created before the first idle thread runs, so the list only needs to be fetched once
+    if (balanceTargets.length() == 0) {
+        balanceTargets = Service::getService<ProcessService>().getSchedulers();
+    }
+
+    // A core with only one ready thread will run it soon anyway, so only cores with more threads are considered
+    Scheduler *busiest = nullptr;
+    for (auto *scheduler : balanceTargets) {
+        if (scheduler == this || scheduler->getThreadCount() <= 1) {
+            continue;
+        }
+
+        // Threads with an affinity hint for this core are stolen from any busy core
+        if (steal(*scheduler, true)) {
+            return;
+        }
+
+        if (busiest == nullptr || scheduler->getThreadCount() > busiest->getThreadCount()) {
+            busiest = scheduler;
+        }
+    }
+
+    if (busiest != nullptr) {
+        steal(*busiest, false);
+    }
+}
+
+bool Scheduler::steal(Scheduler &victim, bool affineOnly) {
+    // We must not wait for the victim's locks while holding our own, since the victim might try to steal from us at the same time
+    lockReadyQueue();
+    if (!victim.readyQueueLock.tryAcquire()) {
+        readyQueueLock.release();
+        return false;
+    }
+
+    auto *thread = victim.findStealableThread(cpuId, affineOnly);
+    if (thread == nullptr || !victim.joinLock.tryAcquire()) {
+        victim.readyQueueLock.release();
+        readyQueueLock.release();
+        return false;
+    }
+
+    if (!joinLock.tryAcquire()) {
+        victim.joinLock.release();
+        victim.readyQueueLock.release();
+        readyQueueLock.release();
+        return false;
+    }
+
+    // Joining threads look up the join list at the thread's scheduler, so it has to move together with the thread
+    victim.readyQueues[thread->level].remove(thread);
+    if (victim.joinMap.containsKey(thread->getId())) {
+        joinMap.put(thread->getId(), victim.joinMap.remove(thread->getId()));
+    }
+
+    thread->scheduler = this;
+    enqueue(*thread);
+
+    joinLock.release();
+    victim.joinLock.release();
+    victim.readyQueueLock.release();
+    readyQueueLock.release();
+
+    return true;
+}
+
+Thread* Scheduler::findStealableThread(uint8_t thiefCpuId, bool affineOnly) {
+    // Steal from the tail, since these threads have run most recently and are the least likely to run here soon.
+    // Lower levels are searched first, because CPU-bound threads profit the most from getting a core on their own.
+    for (auto &readyQueue : readyQueues) {
+        for (uint32_t i = readyQueue.size(); i > 0; i--) {
+            auto *thread = readyQueue.get(i - 1);
+
+            // The FPU registers of this core may still hold the last FPU thread's state
+            if (!thread->migratable || reinterpret_cast<uint32_t>(thread) == lastFpuThread) {
+                continue;
+            }
+
+            if (thread->affinity == thiefCpuId || (!affineOnly && thread->affinity == Thread::NO_AFFINITY)) {
+                return thread;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
 void Scheduler::removeFromJoinMap(uint32_t threadId) {
     joinLock.acquire();
     delete joinMap.remove(threadId);
@@ -341,13 +712,79 @@ void Scheduler::lockReadyQueue() {
     readyQueueLock.acquire();
     while (kernelSpace.getMemoryManager().isLocked()) {
         readyQueueLock.release();
-        yield();
+        Util::Async::Thread::yield();
         readyQueueLock.acquire();
     }
 }
 
+void Scheduler::enqueue(Thread &thread) {
+    readyQueues[thread.level].offer(&thread);
+}
+
+Thread* Scheduler::dequeue() {
+    for (uint32_t i = Util::Async::Thread::PRIORITY_LEVELS; i > 0; i--) {
+        auto &readyQueue = readyQueues[i - 1];
+        if (!readyQueue.isEmpty()) {
+            return readyQueue.poll();
+        }
+    }
+
+    return nullptr;
+}
+
+bool Scheduler::isReadyQueueEmpty() const {
+    for (const auto &readyQueue : readyQueues) {
+        if (!readyQueue.isEmpty()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool Scheduler::hasReadyThreadAbove(Util::Async::Thread::Priority level) const {
+    for (uint32_t i = level + 1; i < Util::Async::Thread::PRIORITY_LEVELS; i++) {
+        if (!readyQueues[i].isEmpty()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t Scheduler::getTimeSlice(Util::Async::Thread::Priority level) {
+    // Lower levels run less often, but get longer time slices (HIGH: 1, NORMAL: 2, LOW: 4 timer ticks)
+    return level == Util::Async::Thread::IDLE ? 1 : 1 << (Util::Async::Thread::HIGH - level);
+}
+
+void Scheduler::boostPriorities() {
+    auto now = Util::Time::getSystemTime();
+    if ((now - lastPriorityBoost).toMilliseconds() < PRIORITY_BOOST_INTERVAL) {
+        return;
+    }
+
+    // Move all threads back to their base priority, so that CPU-bound threads cannot starve forever
+    lastPriorityBoost = now;
+    currentThread->level = currentThread->priority;
+    for (uint32_t i = Util::Async::Thread::IDLE; i < Util::Async::Thread::PRIORITY_LEVELS; i++) {
+        auto &readyQueue = readyQueues[i];
+        for (uint32_t j = readyQueue.size(); j > 0; j--) {
+            auto *thread = readyQueue.get(j - 1);
+            if (thread->level != thread->priority) {
+                readyQueue.remove(thread);
+                thread->level = thread->priority;
+                enqueue(*thread);
+            }
+        }
+    }
+}
+
 bool Scheduler::SleepEntry::operator!=(const Scheduler::SleepEntry &other) const {
     return thread->getId() != other.thread->getId();
 }
 
+bool Scheduler::SleepEntry::operator<(const Scheduler::SleepEntry &other) const {
+    return wakeupTime < other.wakeupTime;
+}
+
 }
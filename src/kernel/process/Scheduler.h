@@ -23,8 +23,11 @@
 #include "lib/util/collection/ArrayListBlockingQueue.h"
 #include "lib/util/async/Spinlock.h"
 #include "lib/util/collection/ArrayList.h"
+#include "lib/util/collection/Array.h"
 #include "lib/util/collection/HashMap.h"
+#include "lib/util/collection/PriorityQueue.h"
 #include "lib/util/time/Timestamp.h"
+#include "lib/util/async/Thread.h"
 #include "kernel/service/InterruptService.h"
 #include "kernel/service/Service.h"
 
@@ -39,10 +42,24 @@ enum InterruptVector : uint8_t;
 class Scheduler {
 
 public:
+
+    /**
+     * States of a thread waiting for an interrupt handler (see blockForInterrupt() and signalFromInterrupt()).
+     */
+    enum InterruptWaitState : uint32_t {
+        INTERRUPT_PENDING = 0,
+        INTERRUPT_WAITING = 1,
+        INTERRUPT_SIGNALED = 2
+    };
+
     /**
      * Constructor.
+     * Each CPU has its own scheduler, which must be constructed on the CPU it belongs to,
+     * since the FPU is set up for the executing core.
+     *
+     * @param cpuId The local APIC id of the CPU, this scheduler runs on (0 without APIC)
      */
-    explicit Scheduler();
+    explicit Scheduler(uint8_t cpuId = 0);
 
     /**
      * Copy Constructor.
@@ -66,6 +83,14 @@ public:
 
     bool isInitialized() const;
 
+    [[nodiscard]] uint8_t getCpuId() const;
+
+    /**
+     * Update the CPU id of the bootstrap processor's scheduler, which is created before the APIC is enabled
+     * (see ProcessService::assignBootstrapProcessorId()).
+     */
+    void setCpuId(uint8_t cpuId);
+
     /**
      * Start the first thread.
      */
@@ -83,7 +108,28 @@ public:
      */
     void exit();
 
-    void yield(bool interrupt = false);
+    /**
+     * Switch to the next thread in the ready queue.
+     *
+     * @param interrupt true, if called by the timer interrupt (an EOI is sent before switching)
+     * @param userMode true, if the timer interrupt has preempted the current thread in user mode
+     */
+    void yield(bool interrupt = false, bool userMode = false);
+
+    /**
+     * Steal a thread from another core's ready queue, if this core has nothing else to do.
+     * Threads with an affinity hint for this core are preferred, otherwise the tail of the busiest core's ready queue is used.
+     * This is called by the idle thread and never blocks on another core's locks.
+     */
+    void balance();
+
+    /**
+     * Halt the executing core until the next interrupt, if no thread is ready to run.
+     * In APIC systems, the core's timer is switched to one-shot mode for the next sleep deadline,
+     * so an idle core does not wake up on every tick. Other cores readying a thread on this scheduler wake it up via IPI.
+     * This must only be called by the idle thread of this scheduler.
+     */
+    void idle();
 
     void switchFpuContext();
 
@@ -96,7 +142,49 @@ public:
 
     void block();
 
-    void unblock(Thread &thread);
+    /**
+     * Block the current thread and release the given lock, once this scheduler's ready queue is locked.
+     * Threads that acquire the same lock before unblocking the current thread can thus never miss it.
+     *
+     * @param lock The lock to release (must be held by the current thread)
+     */
+    void block(Util::Async::Lock &lock);
+
+    /**
+     * Put a blocked thread back into the ready queue.
+     *
+     * @param thread The thread to ready
+     * @param boost true, if the thread has been waiting for I/O (it is moved one level above its base priority)
+     */
+    void unblock(Thread &thread, bool boost = false);
+
+    /**
+     * Block the current thread until an interrupt handler calls signalFromInterrupt() on the given state.
+     * The state is switched from INTERRUPT_PENDING to INTERRUPT_WAITING while the ready queue is locked,
+     * so a signal arriving before the thread has been blocked is never missed (the thread does not block at all in this case).
+     *
+     * @param state The wait state (must be set to INTERRUPT_PENDING before starting the operation, the interrupt handler signals)
+     */
+    void blockForInterrupt(uint32_t &state);
+
+    /**
+     * Set a wait state to INTERRUPT_SIGNALED and ready the thread blocked on it (if any).
+     * No locks are acquired, so this is safe to call from interrupt handlers: The thread is pushed onto a lock-free list,
+     * which its scheduler moves into the ready queue on its next tick (halted cores are woken up via IPI).
+     *
+     * @param state The wait state
+     * @param thread The thread, that is (or is going to be) waiting on the state
+     */
+    static void signalFromInterrupt(uint32_t &state, Thread &thread);
+
+    /**
+     * Change the base priority of a thread registered at this scheduler.
+     *
+     * @param thread The thread
+     * @param priority The new base priority
+     * @return false, if the thread has been stolen by another core in the meantime
+     */
+    bool setPriority(Thread &thread, Util::Async::Thread::Priority priority);
 
     void sleep(const Util::Time::Timestamp &time);
 
@@ -113,6 +201,24 @@ public:
 
     Thread* getThread(uint32_t id);
 
+    /**
+     * Get the earliest wakeup time of all threads sleeping on this core.
+     *
+     * @param wakeupTime Is set to the earliest wakeup time (system time), if there is a sleeping thread
+     * @return false, if no thread is sleeping
+     */
+    bool getNextWakeupTime(Util::Time::Timestamp &wakeupTime);
+
+    /**
+     * Check if a thread is still known to this scheduler (ready, sleeping or currently running).
+     * A thread, that has exited on another core, may not be deleted before this returns false,
+     * since that core might still be running on the thread's stack.
+     *
+     * @param thread The thread to check
+     * @return true, if the thread is still in use by this scheduler
+     */
+    bool isScheduled(const Thread &thread);
+
     [[nodiscard]] uint32_t getThreadCount() const;
 
     uint8_t* getDefaultFpuContext();
@@ -125,7 +231,39 @@ private:
 
     void lockReadyQueue();
 
-    void checkSleepList();
+    void blockWithLockedReadyQueue();
+
+    bool addJoiningThread(uint32_t threadId, Thread &joiningThread);
+
+    Util::ArrayList<Thread*>* removeJoinList(uint32_t threadId);
+
+    static void readyJoiningThreads(Util::ArrayList<Thread*> *joinList);
+
+    Thread* findStealableThread(uint8_t thiefCpuId, bool affineOnly);
+
+    void enqueue(Thread &thread);
+
+    Thread* dequeue();
+
+    [[nodiscard]] bool isReadyQueueEmpty() const;
+
+    [[nodiscard]] bool hasReadyThreadAbove(Util::Async::Thread::Priority level) const;
+
+    void boostPriorities();
+
+    static uint32_t getTimeSlice(Util::Async::Thread::Priority level);
+
+    bool steal(Scheduler &victim, bool affineOnly);
+
+    void checkSleepQueue();
+
+    void checkInterruptWakeups();
+
+    static void boostPriority(Thread &thread);
+
+    static bool removeFromWaitQueue(Thread &thread);
+
+    void wakeup();
 
     void resetLastFpuThread(Thread &terminatedThread);
 
@@ -134,25 +272,42 @@ private:
         Util::Time::Timestamp wakeupTime;
 
         bool operator!=(const SleepEntry &other) const;
+
+        bool operator<(const SleepEntry &other) const;
     };
 
+    uint8_t cpuId;
     bool initialized = false;
     Thread *currentThread = nullptr;
 
     Device::Fpu *fpu = nullptr;
     uint8_t *defaultFpuContext = nullptr;
-    Thread *lastFpuThread = nullptr;
+    uint32_t lastFpuThread = 0; // Address of the thread, whose FPU context is loaded (reset atomically by terminating threads)
 
     InterruptVector timerInterrupt = Service::getService<InterruptService>().getTimerInterrupt();
 
-    Util::ArrayListBlockingQueue<Thread*> readyQueue;
+    // Multilevel feedback queue with one ready queue per priority level (all protected by the same lock)
+    Util::ArrayListBlockingQueue<Thread*> readyQueues[Util::Async::Thread::PRIORITY_LEVELS];
     Util::Async::Spinlock readyQueueLock;
+    uint32_t usedTimeSlice = 0;
+    Util::Time::Timestamp lastPriorityBoost;
 
-    Util::ArrayList<SleepEntry> sleepList;
+    // Sleeping threads, ordered by their wakeup time (min-heap)
+    Util::PriorityQueue<SleepEntry> sleepQueue;
     Util::Async::Spinlock sleepQueueLock;
 
     Util::HashMap<uint32_t, Util::ArrayList<Thread*>*> joinMap;
     Util::Async::Spinlock joinLock;
+
+    Util::Array<Scheduler*> balanceTargets = Util::Array<Scheduler*>(0);
+
+    // Address of the first thread readied by interrupt handlers, linked via Thread::nextInterruptWakeup (only accessed atomically)
+    uint32_t interruptWakeups = 0;
+
+    uint32_t halted = false; // Set while the idle thread halts this core (only accessed atomically)
+
+    static const constexpr uint32_t PRIORITY_BOOST_INTERVAL = 1000; // Milliseconds
+    static const constexpr uint32_t MAX_IDLE_TIME = 50; // Milliseconds (halted cores still need to look for threads to steal)
 };
 
 }
@@ -35,15 +35,21 @@ SchedulerCleaner::~SchedulerCleaner() {
 }
 
 void SchedulerCleaner::cleanup(Process *process) {
+    queueLock.acquire();
     if (!processQueue.offer(process)) {
+        queueLock.release();
         Util::Exception::throwException(Util::Exception::OUT_OF_BOUNDS, "Too many processes to cleanup!");
     }
+    queueLock.release();
 }
 
 void SchedulerCleaner::cleanup(Thread *thread) {
+    queueLock.acquire();
     if (!threadQueue.offer(thread)) {
+        queueLock.release();
         Util::Exception::throwException(Util::Exception::OUT_OF_BOUNDS, "Too many threads to cleanup!");
     }
+    queueLock.release();
 }
 
 void SchedulerCleaner::run() {
@@ -55,25 +61,36 @@ void SchedulerCleaner::run() {
 }
 
 void SchedulerCleaner::cleanupProcesses() {
+    queueLock.acquire();
     while (processQueue.size() > 0) {
-        delete processQueue.poll();
+        auto *process = processQueue.poll();
+        queueLock.release();
+        delete process;
+        queueLock.acquire();
     }
+    queueLock.release();
 }
 
 void SchedulerCleaner::cleanupThreads() {
-    auto &scheduler = Service::getService<ProcessService>().getScheduler();
-
+    queueLock.acquire();
     while (threadQueue.size() > 0) {
         auto *thread = threadQueue.poll();
+        queueLock.release();
 
-        if (scheduler.getThread(thread->getId())) {
-            // Thread is still inside ready queue -> Wait until the scheduler has finished blocking the thread
+        // The thread may have exited on another core, so we need to ask the scheduler it has been registered at
+        if (thread->getScheduler()->isScheduled(*thread)) {
+            // Thread is still inside ready queue or running -> Wait until the scheduler has finished blocking the thread
+            queueLock.acquire();
             threadQueue.add(thread);
+            queueLock.release();
             Util::Async::Thread::yield();
         } else {
             delete thread;
         }
+
+        queueLock.acquire();
     }
+    queueLock.release();
 }
 
 }
\ No newline at end of file
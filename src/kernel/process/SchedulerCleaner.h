@@ -20,6 +20,7 @@
 
 #include "lib/util/collection/ArrayBlockingQueue.h"
 #include "lib/util/async/Runnable.h"
+#include "lib/util/async/Spinlock.h"
 
 namespace Kernel {
 class Process;
@@ -62,6 +63,7 @@ private:
 
     Util::ArrayBlockingQueue<Process*> processQueue;
     Util::ArrayBlockingQueue<Thread*> threadQueue;
+    Util::Async::Spinlock queueLock;
 };
 
 }
@@ -26,6 +26,7 @@
 #include "kernel/service/Service.h"
 #include "kernel/service/ProcessService.h"
 #include "kernel/process/Scheduler.h"
+#include "lib/util/base/Exception.h"
 
 extern "C" {
     void start_kernel_thread(uint32_t *oldStackPointer);
@@ -61,6 +62,19 @@ Thread::~Thread() {
     }
 }
 
+void* Thread::operator new(size_t) {
+    auto *thread = Service::getService<ProcessService>().getThreadCache().allocate();
+    if (thread == nullptr) {
+        Util::Exception::throwException(Util::Exception::OUT_OF_MEMORY, "Thread: No memory left for a new thread!");
+    }
+
+    return thread;
+}
+
+void Thread::operator delete(void *pointer) {
+    Service::getService<ProcessService>().getThreadCache().free(pointer);
+}
+
 Thread& Thread::createKernelThread(const Util::String &name, Process &parent, Util::Async::Runnable *runnable) {
     auto *stack = createKernelStack(STACK_SIZE);
     auto *thread = new Thread(name, parent, runnable, 0, stack, nullptr);
@@ -208,6 +222,27 @@ bool Thread::isKernelThread() const {
     return userStack == nullptr;
 }
 
+Scheduler* Thread::getScheduler() const {
+    return scheduler;
+}
+
+void Thread::setAffinity(int16_t cpuId) {
+    affinity = cpuId;
+}
+
+int16_t Thread::getAffinity() const {
+    return affinity;
+}
+
+void Thread::setPriority(Util::Async::Thread::Priority priority) {
+    Thread::priority = priority;
+    level = priority;
+}
+
+Util::Async::Thread::Priority Thread::getPriority() const {
+    return priority;
+}
+
 void Thread::join() {
     Service::getService<ProcessService>().getScheduler().join(*this);
 }
@@ -19,8 +19,10 @@
 #define HHUOS_THREAD_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include "lib/util/base/String.h"
+#include "lib/util/async/Thread.h"
 
 namespace Util {
 namespace Async {
@@ -32,10 +34,13 @@ template <typename T> class IdGenerator;
 namespace Kernel {
 
 class Process;
+class Scheduler;
+class WaitQueue;
 
 class Thread {
 
     friend class Scheduler;
+    friend class WaitQueue;
 
 public:
 
@@ -70,6 +75,13 @@ public:
      */
     virtual ~Thread();
 
+    /**
+     * Threads are created and destroyed frequently, so they are allocated from their own slab cache (see ProcessService).
+     */
+    static void* operator new(size_t size);
+
+    static void operator delete(void *pointer);
+
     static Thread& createKernelThread(const Util::String &name, Process &parent, Util::Async::Runnable *runnable);
 
     static Thread &createUserThread(const Util::String &name, Process &parent, uint32_t eip, Util::Async::Runnable *runnable);
@@ -86,6 +98,34 @@ public:
 
     [[nodiscard]] bool isKernelThread() const;
 
+    /**
+     * Get the scheduler, this thread has been registered at.
+     *
+     * @return The thread's scheduler, or nullptr if it has not been readied yet
+     */
+    [[nodiscard]] Scheduler* getScheduler() const;
+
+    /**
+     * Set a hint, on which core this thread should run.
+     * The hint is applied when the thread is registered at a scheduler and when an idle core steals threads from busier ones.
+     * It does not migrate the thread immediately.
+     *
+     * @param cpuId The local APIC id of the preferred core, or NO_AFFINITY to let the schedulers decide
+     */
+    void setAffinity(int16_t cpuId);
+
+    [[nodiscard]] int16_t getAffinity() const;
+
+    /**
+     * Set the base priority of a thread, that has not been registered at a scheduler yet.
+     * Use ProcessService::setThreadPriority() for threads, that are already running.
+     *
+     * @param priority The base priority
+     */
+    void setPriority(Util::Async::Thread::Priority priority);
+
+    [[nodiscard]] Util::Async::Thread::Priority getPriority() const;
+
     void join();
 
     virtual void run();
@@ -94,6 +134,8 @@ public:
 
     static void switchThread(Thread &current, const Thread &next);
 
+    static const constexpr int16_t NO_AFFINITY = -1;
+
 private:
 
     Thread(const Util::String &name, Process &parent, Util::Async::Runnable *runnable, uint32_t userInstructionPointer, uint32_t *kernelStack, uint32_t *userStack);
@@ -121,6 +163,15 @@ private:
     uint32_t *oldStackPointer;
 
     uint8_t *fpuContext;
+    Scheduler *scheduler = nullptr;
+    int16_t affinity = NO_AFFINITY;
+    Util::Async::Thread::Priority priority = Util::Async::Thread::NORMAL; // Base priority, set by the user
+    Util::Async::Thread::Priority level = Util::Async::Thread::NORMAL; // Current level in the scheduler's multilevel feedback queue
+    // Only threads, that have not run yet or have been preempted in user mode, hold no references to their core's scheduler and may be stolen
+    bool migratable = false;
+    WaitQueue *volatile waitQueue = nullptr; // The wait queue this thread is blocked in (if any)
+    volatile bool waitingForInterrupt = false; // Set while the thread is blocked until an interrupt handler signals it
+    Thread *nextInterruptWakeup = nullptr; // Link in the scheduler's list of threads readied by interrupt handlers
 
     static Util::Async::IdGenerator<uint32_t> idGenerator;
     static const constexpr uint32_t STACK_SIZE = 0x10000;
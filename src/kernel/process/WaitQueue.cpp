@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "WaitQueue.h"
+
+#include "kernel/process/Scheduler.h"
+#include "kernel/process/Thread.h"
+#include "kernel/service/ProcessService.h"
+#include "kernel/service/Service.h"
+
+namespace Kernel {
+
+bool WaitQueue::wait(const volatile uint32_t &value, uint32_t expectedValue, uint32_t key) {
+    // A thread executing in kernel mode is never stolen by another core, so the scheduler stays the same
+    auto &scheduler = Service::getService<ProcessService>().getScheduler();
+    auto &thread = scheduler.getCurrentThread();
+
+    lock.acquire();
+    if (value != expectedValue) {
+        lock.release();
+        return false;
+    }
+
+    entries.add(Entry{&thread, key});
+    thread.waitQueue = this;
+
+    // The queue lock is released by the scheduler, after it has locked its ready queue
+    scheduler.block(lock);
+
+    // Only the thread itself resets its wait queue, since it may already be waiting on another queue once it has been woken up
+    thread.waitQueue = nullptr;
+    return true;
+}
+
+uint32_t WaitQueue::wakeUp(uint32_t count, uint32_t key) {
+    uint32_t woken = 0;
+
+    lock.acquire();
+    for (uint32_t i = 0; i < entries.size() && woken < count;) {
+        auto entry = entries.get(i);
+        if (entry.key != key) {
+            i++;
+            continue;
+        }
+
+        // The queue stays locked until the thread is unblocked, so that a concurrent kill does not miss it
+        entries.removeIndex(i);
+        entry.thread->getScheduler()->unblock(*entry.thread);
+        woken++;
+    }
+
+    lock.release();
+    return woken;
+}
+
+bool WaitQueue::tryRemove(Thread &thread) {
+    if (!lock.tryAcquire()) {
+        return false;
+    }
+
+    if (thread.waitQueue == this) {
+        for (uint32_t i = 0; i < entries.size(); i++) {
+            if (entries.get(i).thread == &thread) {
+                entries.removeIndex(i);
+                break;
+            }
+        }
+
+        thread.waitQueue = nullptr;
+    }
+
+    lock.release();
+    return true;
+}
+
+bool WaitQueue::Entry::operator!=(const WaitQueue::Entry &other) const {
+    return thread != other.thread || key != other.key;
+}
+
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_WAITQUEUE_H
+#define HHUOS_WAITQUEUE_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Spinlock.h"
+#include "lib/util/collection/ArrayList.h"
+
+namespace Kernel {
+class Thread;
+
+/**
+ * A queue of threads, that are blocked until another thread wakes them up.
+ * Waiting threads are removed from their scheduler's ready queue, so they do not consume any CPU time.
+ *
+ * Each waiting thread is tagged with a key, so that a single queue can be shared by multiple wait conditions
+ * (e.g. the process service hashes the addresses of futex-like user space locks into a fixed number of queues).
+ * Threads must only be woken up from thread context, never from an interrupt handler.
+ */
+class WaitQueue {
+
+public:
+    /**
+     * Default Constructor.
+     */
+    WaitQueue() = default;
+
+    /**
+     * Copy Constructor.
+     */
+    WaitQueue(const WaitQueue &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    WaitQueue &operator=(const WaitQueue &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~WaitQueue() = default;
+
+    /**
+     * Block the current thread, if the given value equals the expected value.
+     * The value is checked while the queue is locked, so a thread changing the value
+     * and calling wakeUp() afterward can never slip in between checking and blocking.
+     *
+     * @param value The value to check
+     * @param expectedValue The current thread only blocks, if the value equals this
+     * @param key The key to wait on
+     * @return true, if the current thread has been blocked and woken up again
+     */
+    bool wait(const volatile uint32_t &value, uint32_t expectedValue, uint32_t key = 0);
+
+    /**
+     * Wake up threads waiting on the given key in FIFO order.
+     *
+     * @param count The maximum number of threads to wake up
+     * @param key The key to wake up threads for
+     * @return The number of threads woken up
+     */
+    uint32_t wakeUp(uint32_t count = 1, uint32_t key = 0);
+
+    /**
+     * Remove a thread from this queue without waking it up (e.g. because it is about to be killed).
+     * This never blocks, since it is called by schedulers while their ready queue is locked.
+     *
+     * @param thread The thread to remove
+     * @return false, if the queue is currently locked (the thread is still in the queue in this case)
+     */
+    bool tryRemove(Thread &thread);
+
+private:
+
+    struct Entry {
+        Thread *thread;
+        uint32_t key;
+
+        bool operator!=(const Entry &other) const;
+    };
+
+    Util::ArrayList<Entry> entries;
+    Util::Async::Spinlock lock;
+};
+
+}
+
+#endif
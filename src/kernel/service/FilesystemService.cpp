@@ -20,6 +20,7 @@
 #include "ProcessService.h"
 #include "FilesystemService.h"
 #include "filesystem/Node.h"
+#include "filesystem/fat/FatDriver.h"
 #include "kernel/process/FileDescriptorManager.h"
 #include "kernel/process/Process.h"
 #include "kernel/service/MemoryService.h"
@@ -173,7 +174,21 @@ FilesystemService::FilesystemService() {
         auto length = va_arg(arguments, uint64_t);
         auto &written = *va_arg(arguments, uint64_t*);
 
-        written = filesystemService.getFileDescriptor(fileDescriptor).getNode().writeData(sourceBuffer, pos, length);
+        auto &descriptor = filesystemService.getFileDescriptor(fileDescriptor);
+        auto &node = descriptor.getNode();
+        if (node.getType() == Util::Io::File::REGULAR) {
+            const auto &path = descriptor.getPath();
+            if (path.isEmpty()) {
+                // Without a path, any cached executable or mapped file might have been modified
+                Service::getService<ProcessService>().getImageCache().invalidateAll();
+                Service::getService<MemoryService>().invalidateMappedFiles();
+            } else {
+                Service::getService<ProcessService>().getImageCache().invalidate(path);
+                Service::getService<MemoryService>().invalidateMappedFile(path);
+            }
+        }
+
+        written = node.writeData(sourceBuffer, pos, length);
         return true;
     });
 
@@ -261,6 +276,8 @@ bool FilesystemService::mount(const Util::String &deviceName, const Util::String
 }
 
 bool FilesystemService::unmount(const Util::String &path) {
+    Service::getService<ProcessService>().getImageCache().invalidateAll();
+    Service::getService<MemoryService>().invalidateMappedFiles();
     return filesystem.unmount(path);
 }
 
@@ -277,6 +294,9 @@ bool FilesystemService::createDirectory(const Util::String &path) {
 }
 
 bool FilesystemService::deleteFile(const Util::String &path) {
+    auto canonicalPath = Util::Io::File::getCanonicalPath(path);
+    Service::getService<ProcessService>().getImageCache().invalidate(canonicalPath);
+    Service::getService<MemoryService>().invalidateMappedFile(canonicalPath);
     return filesystem.deleteFile(path);
 }
 
@@ -296,6 +316,11 @@ FileDescriptor& FilesystemService::getFileDescriptor(int32_t fileDescriptor) {
     return Service::getService<ProcessService>().getCurrentProcess().getFileDescriptorManager().getDescriptor(fileDescriptor);
 }
 
+bool FilesystemService::flush() {
+    // FAT is the only driver, that caches data in memory
+    return Filesystem::Fat::FatDriver::flushAll();
+}
+
 Filesystem::Filesystem& FilesystemService::getFilesystem() {
     return filesystem;
 }
@@ -75,6 +75,13 @@ public:
 
     FileDescriptor& getFileDescriptor(int32_t fileDescriptor);
 
+    /**
+     * Write back data, that filesystem drivers have cached in memory (e.g. FAT volumes in write-back mode).
+     *
+     * @return false, if some data could not be written back
+     */
+    bool flush();
+
     [[nodiscard]] Filesystem::Filesystem& getFilesystem();
 
     [[nodiscard]] Util::Array<Filesystem::MountInformation> getMountInformation();
@@ -126,7 +126,7 @@ private:
     InterruptDispatcher interruptDispatcher;
     SystemCallDispatcher systemCallDispatcher;
 
-    bool parallelComputingAllowed = false;
+    volatile bool parallelComputingAllowed = false;
 };
 
 }
@@ -22,6 +22,8 @@
 #include "kernel/memory/MemoryLayout.h"
 #include "MemoryService.h"
 #include "kernel/service/MemoryService.h"
+#include "kernel/memory/MappedFile.h"
+#include "kernel/memory/MemoryMapping.h"
 #include "kernel/memory/PageFrameAllocator.h"
 #include "kernel/memory/PagingAreaManager.h"
 #include "kernel/memory/VirtualAddressSpace.h"
@@ -34,12 +36,19 @@
 #include "lib/util/base/Address.h"
 #include "lib/util/base/Constants.h"
 #include "device/system/Bios.h"
+#include "filesystem/Filesystem.h"
+#include "filesystem/Node.h"
+#include "kernel/service/FilesystemService.h"
+#include "lib/util/io/file/File.h"
 
 namespace Kernel {
 
 MemoryService::MemoryService(GlobalDescriptorTable *gdt, GlobalDescriptorTable::TaskStateSegment *tss, PageFrameAllocator *pageFrameAllocator, PagingAreaManager *pagingAreaManager, VirtualAddressSpace *kernelAddressSpace) :
-        gdt(gdt), tss(tss), pageFrameAllocator(*pageFrameAllocator), pagingAreaManager(*pagingAreaManager), pageFrameSlabAllocator(reinterpret_cast<uint8_t*>(allocatePhysicalMemory(SlabAllocator::MAX_SLAB_SIZE / Util::PAGESIZE))),
-        currentAddressSpace(kernelAddressSpace), kernelAddressSpace(*kernelAddressSpace) {
+        gdt(gdt), pageFrameAllocator(*pageFrameAllocator), pagingAreaManager(*pagingAreaManager),
+        zeroedPageFramePool(*pageFrameAllocator), kernelAddressSpace(*kernelAddressSpace), slabAllocator(kernelAddressSpace->getMemoryManager()) {
+    // The memory service is created by the bootstrap processor, before any application processor is running
+    taskStateSegments[0] = tss;
+    currentAddressSpaces[0] = kernelAddressSpace;
     addressSpaces.add(kernelAddressSpace);
 
     Service::getService<InterruptService>().assignSystemCall(Util::System::UNMAP, [](uint32_t paramCount, va_list arguments) -> bool {
@@ -59,6 +68,32 @@ MemoryService::MemoryService(GlobalDescriptorTable *gdt, GlobalDescriptorTable::
         return memoryService.unmap(virtualAddress, pageCount, breakCount) != nullptr;
     });
 
+    Service::getService<InterruptService>().assignSystemCall(Util::System::MAP, [](uint32_t paramCount, va_list arguments) -> bool {
+        if (paramCount < 5) {
+            return false;
+        }
+
+        auto &memoryService = Kernel::Service::getService<Kernel::MemoryService>();
+        auto *virtualAddress = va_arg(arguments, void*);
+        auto *path = va_arg(arguments, const char*);
+        auto offset = va_arg(arguments, uint32_t);
+        auto length = va_arg(arguments, uint32_t);
+        auto flags = va_arg(arguments, uint32_t);
+
+        return memoryService.createMapping(virtualAddress, path == nullptr ? Util::String() : Util::String(path), offset, length, flags);
+    });
+
+    Service::getService<InterruptService>().assignSystemCall(Util::System::REMOVE_MAPPING, [](uint32_t paramCount, va_list arguments) -> bool {
+        if (paramCount < 1) {
+            return false;
+        }
+
+        auto &memoryService = Kernel::Service::getService<Kernel::MemoryService>();
+        auto *virtualAddress = va_arg(arguments, void*);
+
+        return memoryService.removeMapping(virtualAddress);
+    });
+
     Service::getService<InterruptService>().assignSystemCall(Util::System::MAP_IO, [](uint32_t paramCount, va_list arguments) -> bool {
         if (paramCount < 3) {
             return false;
@@ -75,6 +110,8 @@ MemoryService::MemoryService(GlobalDescriptorTable *gdt, GlobalDescriptorTable::
 }
 
 MemoryService::~MemoryService() {
+    invalidateMappedFiles();
+
     delete &pageFrameAllocator;
     delete &pagingAreaManager;
 
@@ -96,21 +133,23 @@ void MemoryService::freeKernelMemory(void *pointer, uint32_t alignment) {
 }
 
 void *MemoryService::allocateUserMemory(uint32_t size, uint32_t alignment) {
-    return currentAddressSpace->getMemoryManager().allocateMemory(size, alignment);
+    return getCurrentAddressSpace().getMemoryManager().allocateMemory(size, alignment);
 }
 
 void *MemoryService::reallocateUserMemory(void *pointer, uint32_t size, uint32_t alignment) {
-    return currentAddressSpace->getMemoryManager().reallocateMemory(pointer, size, alignment);
+    return getCurrentAddressSpace().getMemoryManager().reallocateMemory(pointer, size, alignment);
 }
 
 void MemoryService::freeUserMemory(void *pointer, uint32_t alignment) {
-    currentAddressSpace->getMemoryManager().freeMemory(pointer, alignment);
+    getCurrentAddressSpace().getMemoryManager().freeMemory(pointer, alignment);
 }
 
 void* MemoryService::allocateBiosMemory(uint32_t pageCount) {
     // Allocate memory below 1 MiB
-    void *physicalAddress = allocatePhysicalMemory(pageCount, nullptr);
-    if (reinterpret_cast<uint32_t>(physicalAddress) >= Device::Bios::MAX_USABLE_ADDRESS) {
+    void *physicalAddress = pageFrameAllocator.allocateBlocks(pageCount, PageFrameAllocator::LOWER_MEMORY);
+    if (physicalAddress == nullptr) {
+        return nullptr;
+    } else if (reinterpret_cast<uint32_t>(physicalAddress) >= Device::Bios::MAX_USABLE_ADDRESS) {
         freePhysicalMemory(physicalAddress, pageCount);
         return nullptr;
     }
@@ -130,7 +169,7 @@ void* MemoryService::allocateBiosMemory(uint32_t pageCount) {
         // This can happen because the headers of the free list are mapped to arbitrary physical addresses, but the memory should be mapped to the given physical addresses.
         unmap(currentVirtualAddress, 1);
         // Map the page into the current address space
-        currentAddressSpace->map(currentPhysicalAddress, currentVirtualAddress, flags);
+        getCurrentAddressSpace().map(currentPhysicalAddress, currentVirtualAddress, flags);
     }
 
     return virtualAddress;
@@ -138,8 +177,10 @@ void* MemoryService::allocateBiosMemory(uint32_t pageCount) {
 
 void* MemoryService::allocateIsaMemory(uint32_t pageCount) {
     // Allocate memory below 16 MiB
-    void *physicalAddress = allocatePhysicalMemory(pageCount, nullptr);
-    if (reinterpret_cast<uint32_t>(physicalAddress) >= Device::Isa::MAX_DMA_ADDRESS) {
+    void *physicalAddress = pageFrameAllocator.allocateBlocks(pageCount, PageFrameAllocator::ISA_DMA);
+    if (physicalAddress == nullptr) {
+        return nullptr;
+    } else if (reinterpret_cast<uint32_t>(physicalAddress) >= Device::Isa::MAX_DMA_ADDRESS) {
         freePhysicalMemory(physicalAddress, pageCount);
         return nullptr;
     }
@@ -159,68 +200,59 @@ void* MemoryService::allocateIsaMemory(uint32_t pageCount) {
         // This can happen because the headers of the free list are mapped to arbitrary physical addresses, but the memory should be mapped to the given physical addresses.
         unmap(currentVirtualAddress, 1);
         // Map the page into the current address space
-        currentAddressSpace->map(currentPhysicalAddress, currentVirtualAddress, flags);
+        getCurrentAddressSpace().map(currentPhysicalAddress, currentVirtualAddress, flags);
     }
 
     return virtualAddress;
 }
 
 void* MemoryService::allocatePhysicalMemory(uint32_t frameCount, void *startAddress) {
-    if (slabAllocatorEnabled) {
-        void *physicalStartAddress = pageFrameSlabAllocator.allocateBlock(frameCount);
-        if (physicalStartAddress != nullptr) {
-            return physicalStartAddress;
-        }
+    auto zone = PageFrameAllocator::getZone(startAddress);
+    auto *physicalStartAddress = pageFrameAllocator.allocateBlocks(frameCount, zone);
+    if (physicalStartAddress == nullptr && reclaimMemory() > 0) {
+        physicalStartAddress = pageFrameAllocator.allocateBlocks(frameCount, zone);
     }
 
-    void *physicalStartAddress = pageFrameAllocator.allocateBlockAfterAddress(startAddress);
-    void *currentPhysicalAddress = physicalStartAddress;
-    void *lastPhysicalAddress;
-    bool contiguous;
-
-    // Page frame allocator only works with independent physical frames (4 KiB).
-    // We allocate a large chunk of physical memory, by allocating single frames and checking, if they are contiguous
-    do {
-        contiguous = true;
-
-        for (uint32_t i = 1; i < frameCount; i++) {
-            lastPhysicalAddress = currentPhysicalAddress;
-            currentPhysicalAddress = pageFrameAllocator.allocateBlockAfterAddress(physicalStartAddress);
+    return physicalStartAddress;
+}
 
-            if (reinterpret_cast<uint32_t>(currentPhysicalAddress) - reinterpret_cast<uint32_t>(lastPhysicalAddress) != Util::PAGESIZE) {
-                contiguous = false;
+void MemoryService::freePhysicalMemory(void *pointer, uint32_t frameCount) {
+    for (uint32_t i = 0; i < frameCount; i++) {
+        pageFrameAllocator.freeBlock(static_cast<uint8_t*>(pointer) + i * Util::PAGESIZE);
+    }
+}
 
-                // Allocated frames are not contiguous -> Free them and try again
-                freePhysicalMemory(physicalStartAddress, i);
+void* MemoryService::allocateZeroedPageFrame() {
+    auto *frame = zeroedPageFramePool.take();
+    if (frame != nullptr) {
+        return frame;
+    }
 
-                physicalStartAddress = currentPhysicalAddress;
-                break;
-            }
-        }
-    } while (!contiguous);
+    // The pool is empty -> Zero a frame via a temporary mapping
+    frame = allocatePageFrame();
+    auto *window = MappedFile::mapFrame(frame);
+    Util::Address<uint32_t>(window).setRange(0, Util::PAGESIZE);
+    MappedFile::unmapFrame(window);
 
-    return physicalStartAddress;
+    return frame;
 }
 
-void MemoryService::freePhysicalMemory(void *pointer, uint32_t frameCount) {
-    if (slabAllocatorEnabled && pageFrameSlabAllocator.freeBlock(pointer)) {
-        return;
+void* MemoryService::allocatePageFrame() {
+    auto *frame = allocateFrame();
+    if (frame == nullptr) {
+        Util::Exception::throwException(Util::Exception::OUT_OF_PHYSICAL_MEMORY, "No page frame left!");
     }
 
-    for (uint32_t i = 0; i < frameCount; i++) {
-        pageFrameAllocator.freeBlock(static_cast<uint8_t*>(pointer) + i * Util::PAGESIZE);
-    }
+    return frame;
 }
 
 Paging::Table* MemoryService::allocatePageTable() {
-    auto *pageTable = static_cast<Paging::Table*>(pagingAreaManager.allocateBlock());
-    pageTable->clear();
-
-    return pageTable;
+    // Blocks are zeroed, before they are put into the paging area manager's pool
+    return static_cast<Paging::Table*>(pagingAreaManager.allocateBlock());
 }
 
 void MemoryService::freePageTable(Paging::Table *pageTable) {
-    void *physicalAddress = currentAddressSpace->unmap(pageTable);
+    void *physicalAddress = getCurrentAddressSpace().unmap(pageTable);
     if (physicalAddress == nullptr) {
         return;
     }
@@ -229,12 +261,26 @@ void MemoryService::freePageTable(Paging::Table *pageTable) {
     pagingAreaManager.freeBlock(pageTable);
 }
 
-void Kernel::MemoryService::map(void *virtualAddress, uint32_t pageCount, uint16_t flags) {
+void Kernel::MemoryService::map(void *virtualAddress, uint32_t pageCount, uint16_t flags, bool zero) {
     for (uint32_t i = 0; i < pageCount; i++) {
-        // Allocate a physical page frames to where the page should be mapped
-        auto *physicalAddress = pageFrameAllocator.allocateBlock();
+        // Allocate a physical page frames to where the page should be mapped (preferably an already zeroed one, if requested)
+        auto *physicalAddress = zero ? zeroedPageFramePool.take() : nullptr;
+        auto zeroed = physicalAddress != nullptr;
+        if (!zeroed) {
+            physicalAddress = allocateFrame();
+            if (physicalAddress == nullptr) {
+                Util::Exception::throwException(Util::Exception::OUT_OF_PHYSICAL_MEMORY, "No page frame left!");
+            }
+        }
+
         // Map the frame to given virtual address
-        currentAddressSpace->map(physicalAddress, reinterpret_cast<uint8_t*>(virtualAddress) + i * Util::PAGESIZE, flags);
+        auto *currentVirtualAddress = reinterpret_cast<uint8_t*>(virtualAddress) + i * Util::PAGESIZE;
+        getCurrentAddressSpace().map(physicalAddress, currentVirtualAddress, flags);
+
+        if (zero && !zeroed) {
+            // The pool is empty -> Zero the page on the spot
+            Util::Address<uint32_t>(reinterpret_cast<uint32_t>(currentVirtualAddress) & ~(Util::PAGESIZE - 1)).setRange(0, Util::PAGESIZE);
+        }
     }
 }
 
@@ -248,25 +294,45 @@ void* Kernel::MemoryService::unmap(void *virtualAddress, uint32_t pageCount, uin
         pageCount -= 1;
     }
 
-    // Loop through pages and unmap them individually
+    // Loop through pages and unmap them individually.
+    // Other CPUs may still access a frame via a stale TLB entry, until it has been shot down.
+    // Thus, frames are collected and only freed after the TLB entries of their batch have been invalidated on all CPUs.
+    auto &addressSpace = getCurrentAddressSpace();
     void *physicalAddress = nullptr;
+    void *unmappedFrames[Paging::MAX_SINGLE_INVALIDATIONS];
+    uint32_t unmappedFrameCount = 0;
+    uint32_t batchStart = 0;
     uint8_t nonMappedCount = 0;
     for (uint32_t i = 0; i < pageCount; i++) {
         auto currentVirtualAddress = reinterpret_cast<uint32_t>(virtualAddress) + (i * Util::PAGESIZE);
-        physicalAddress = currentAddressSpace->unmap(reinterpret_cast<const void*>(currentVirtualAddress));
+        physicalAddress = addressSpace.unmap(reinterpret_cast<const void*>(currentVirtualAddress), false);
 
         if (physicalAddress == nullptr) {
             nonMappedCount++;
         } else {
             nonMappedCount = 0;
-            freePhysicalMemory(physicalAddress, 1);
+            unmappedFrames[unmappedFrameCount++] = physicalAddress;
         }
 
         // TODO: This is ugly! We need a proper management for mapped/unmapped pages
         // If there were eight pages after each other already unmapped, we break here.
         // This is sort of a workaround because by merging large free memory blocks in memory management
         // it might happen that some parts of the memory are already unmapped.
-        if (breakCount > 0 && nonMappedCount == breakCount) {
+        auto stop = breakCount > 0 && nonMappedCount == breakCount;
+        auto batchSize = i + 1 - batchStart;
+        if (stop || i + 1 == pageCount || batchSize == Paging::MAX_SINGLE_INVALIDATIONS) {
+            if (unmappedFrameCount > 0) {
+                shootdownTlb(addressSpace, reinterpret_cast<uint8_t*>(virtualAddress) + batchStart * Util::PAGESIZE, batchSize);
+                for (uint32_t j = 0; j < unmappedFrameCount; j++) {
+                    freePhysicalMemory(unmappedFrames[j], 1);
+                }
+            }
+
+            batchStart = i + 1;
+            unmappedFrameCount = 0;
+        }
+
+        if (stop) {
             break;
         }
     }
@@ -285,8 +351,196 @@ void Kernel::MemoryService::mapPhysical(void *physicalAddress, void *virtualAddr
         // Mark the physical page frame as used
         currentPhysicalAddress = pageFrameAllocator.allocateBlockAtAddress(currentPhysicalAddress);
         // Map the page into the current address space
-        currentAddressSpace->map(currentPhysicalAddress, currentVirtualAddress, flags);
+        getCurrentAddressSpace().map(currentPhysicalAddress, currentVirtualAddress, flags);
+    }
+}
+
+void *MemoryService::sharePage(void *virtualAddress, uint16_t flags) {
+    auto &addressSpace = getCurrentAddressSpace();
+    auto *page = reinterpret_cast<void*>(reinterpret_cast<uint32_t>(virtualAddress) & ~(Util::PAGESIZE - 1));
+    auto *physicalAddress = addressSpace.getPhysicalAddress(page);
+    if (physicalAddress == nullptr) {
+        return nullptr;
+    }
+
+    pageFrameAllocator.referenceBlock(physicalAddress);
+    addressSpace.remap(physicalAddress, page, (flags & Paging::WRITABLE) ? (flags & ~Paging::WRITABLE) | Paging::COPY_ON_WRITE : flags);
+
+    return physicalAddress;
+}
+
+void MemoryService::mapShared(void *physicalAddress, void *virtualAddress, uint16_t flags, bool copyOnWrite) {
+    // Mark the physical page frame as used by one more address space
+    pageFrameAllocator.referenceBlock(physicalAddress);
+
+    if (copyOnWrite && (flags & Paging::WRITABLE)) {
+        getCurrentAddressSpace().mapCopyOnWrite(physicalAddress, virtualAddress, flags);
+    } else {
+        getCurrentAddressSpace().map(physicalAddress, virtualAddress, flags);
+    }
+}
+
+bool MemoryService::createMapping(void *virtualAddress, const Util::String &path, uint32_t offset, uint32_t length, uint32_t mappingFlags) {
+    auto startAddress = reinterpret_cast<uint32_t>(virtualAddress);
+    auto pageCount = (length + Util::PAGESIZE - 1) / Util::PAGESIZE;
+    auto endAddress = startAddress + pageCount * Util::PAGESIZE;
+
+    // Mappings are resolved by the page fault handler for user space addresses only
+    auto &addressSpace = getCurrentAddressSpace();
+    if (addressSpace.isKernelAddressSpace() || startAddress < MemoryLayout::KERNEL_END || startAddress % Util::PAGESIZE != 0 ||
+        length == 0 || endAddress <= startAddress || offset % Util::PAGESIZE != 0) {
+        return false;
+    }
+
+    MappedFile *file = nullptr;
+    if (!path.isEmpty()) {
+        file = acquireMappedFile(Util::Io::File::getCanonicalPath(path));
+        if (file == nullptr) {
+            return false;
+        }
+    }
+
+    auto dataEnd = startAddress;
+    if (file != nullptr && offset < file->getLength()) {
+        auto fileLength = file->getLength() - offset;
+        dataEnd = fileLength < endAddress - startAddress ? startAddress + fileLength : endAddress;
     }
+
+    // Anonymous memory is never shared, since there is no other process, that could map it
+    auto type = file != nullptr && (mappingFlags & Util::System::MAP_SHARED) ? MemoryMapping::SHARED : MemoryMapping::PRIVATE;
+    uint16_t flags = Paging::PRESENT | Paging::USER_ACCESSIBLE | ((mappingFlags & Util::System::MAP_WRITABLE) ? Paging::WRITABLE : Paging::NONE);
+    auto *mapping = new MemoryMapping(type, startAddress, endAddress, flags, file, startAddress, dataEnd, offset);
+
+    // The mapping has acquired its own reference to the file
+    if (file != nullptr) {
+        file->release();
+    }
+
+    if (!addressSpace.addMapping(mapping)) {
+        mapping->release();
+        return false;
+    }
+
+    // The memory has usually been allocated on the heap, so some of its pages may still be mapped
+    unmap(virtualAddress, pageCount);
+    return true;
+}
+
+bool MemoryService::removeMapping(void *virtualAddress) {
+    auto &addressSpace = getCurrentAddressSpace();
+    auto *mapping = addressSpace.findMapping(reinterpret_cast<uint32_t>(virtualAddress));
+    if (mapping == nullptr) {
+        return false;
+    }
+
+    // Program segments do not belong to the heap and cannot be removed
+    if (mapping->getType() == MemoryMapping::IMAGE || mapping->getStartAddress() != reinterpret_cast<uint32_t>(virtualAddress) || !addressSpace.removeMapping(*mapping)) {
+        mapping->release();
+        return false;
+    }
+
+    unmapMapping(*mapping);
+
+    // Release the reference acquired by findMapping() and the one passed on by the address space
+    mapping->release();
+    mapping->release();
+
+    return true;
+}
+
+void MemoryService::removeAllMappings() {
+    for (auto *mapping : getCurrentAddressSpace().removeAllMappings()) {
+        unmapMapping(*mapping);
+        mapping->release();
+    }
+}
+
+void MemoryService::invalidateMappedFile(const Util::String &path) {
+    mappedFileLock.acquire();
+
+    for (uint32_t i = 0; i < mappedFiles.size(); i++) {
+        auto *file = mappedFiles.get(i);
+        if (file->getPath() == path) {
+            mappedFiles.removeIndex(i);
+            file->release();
+            break;
+        }
+    }
+
+    mappedFileLock.release();
+}
+
+void MemoryService::invalidateMappedFiles() {
+    mappedFileLock.acquire();
+
+    while (!mappedFiles.isEmpty()) {
+        mappedFiles.removeIndex(0)->release();
+    }
+
+    mappedFileLock.release();
+}
+
+MappedFile* MemoryService::acquireMappedFile(const Util::String &path) {
+    auto *node = Service::getService<FilesystemService>().getFilesystem().getNode(path);
+    if (node == nullptr) {
+        return nullptr;
+    }
+
+    if (node->getType() != Util::Io::File::REGULAR) {
+        delete node;
+        return nullptr;
+    }
+
+    auto length = static_cast<uint32_t>(node->getLength());
+    mappedFileLock.acquire();
+
+    for (uint32_t i = 0; i < mappedFiles.size(); i++) {
+        auto *file = mappedFiles.get(i);
+        if (file->getPath() == path) {
+            if (file->getLength() == length) {
+                file->acquire();
+                mappedFileLock.release();
+
+                delete node;
+                return file;
+            }
+
+            // The file has changed its length -> Existing mappings keep the old page cache
+            mappedFiles.removeIndex(i);
+            file->release();
+            break;
+        }
+    }
+
+    // Forget page caches of files, that are not mapped anymore
+    if (mappedFiles.size() >= MAX_MAPPED_FILES) {
+        for (uint32_t i = 0; i < mappedFiles.size();) {
+            auto *file = mappedFiles.get(i);
+            if (file->getReferenceCount() == 1) {
+                mappedFiles.removeIndex(i);
+                file->release();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    // One reference is held by the registry and one is passed to the caller
+    auto *file = new MappedFile(path, node, length);
+    file->acquire();
+    mappedFiles.add(file);
+
+    mappedFileLock.release();
+    return file;
+}
+
+void MemoryService::unmapMapping(MemoryMapping &mapping) {
+    // Modified pages of shared mappings must be written back, before their dirty flags are lost
+    mapping.writeBack();
+
+    auto startAddress = mapping.getStartAddress();
+    auto pageCount = (mapping.getEndAddress() - startAddress) / Util::PAGESIZE;
+    unmap(reinterpret_cast<void*>(startAddress), pageCount);
 }
 
 void *MemoryService::mapIO(uint32_t pageCount, bool mapToKernelHeap) {
@@ -297,9 +551,14 @@ void *MemoryService::mapIO(uint32_t pageCount, bool mapToKernelHeap) {
 }
 
 void *Kernel::MemoryService::mapIO(void *physicalAddress, uint32_t pageCount, bool mapToKernelHeap) {
+    // Large regions starting at a 4 MiB boundary (e.g. frame buffers) are mapped with large pages, if the CPU supports them.
+    // This only works, if the virtual address is 4 MiB aligned as well.
+    const auto largePageCount = Paging::LARGE_PAGESIZE / Util::PAGESIZE;
+    bool useLargePages = (Device::Cpu::readCr4() & Device::Cpu::PAGE_SIZE_EXTENSION) && pageCount >= largePageCount && reinterpret_cast<uint32_t>(physicalAddress) % Paging::LARGE_PAGESIZE == 0;
+
     // Allocate page aligned virtual memory
-    auto &manager = mapToKernelHeap ? kernelAddressSpace.getMemoryManager() : currentAddressSpace->getMemoryManager();
-    void *virtualAddress = manager.allocateMemory(pageCount * Util::PAGESIZE, Util::PAGESIZE);
+    auto &manager = mapToKernelHeap ? kernelAddressSpace.getMemoryManager() : getCurrentAddressSpace().getMemoryManager();
+    void *virtualAddress = manager.allocateMemory(pageCount * Util::PAGESIZE, useLargePages ? Paging::LARGE_PAGESIZE : Util::PAGESIZE);
 
     // Create mapping
     uint32_t flags = Paging::PRESENT | Paging::WRITABLE | Paging::CACHE_DISABLE | (reinterpret_cast<uint32_t>(virtualAddress) >= Kernel::MemoryLayout::KERNEL_END ? Paging::USER_ACCESSIBLE : Paging::NONE);
@@ -307,18 +566,27 @@ void *Kernel::MemoryService::mapIO(void *physicalAddress, uint32_t pageCount, bo
         void *currentPhysicalAddress = reinterpret_cast<uint8_t*>(physicalAddress) + i * Util::PAGESIZE;
         void *currentVirtualAddress = reinterpret_cast<uint8_t*>(virtualAddress) + i * Util::PAGESIZE;
 
+        if (useLargePages && pageCount - i >= largePageCount && i % largePageCount == 0) {
+            // The heap may have mapped some of the pages already (unmapping all of them also frees their page table)
+            unmap(currentVirtualAddress, largePageCount);
+            if (getCurrentAddressSpace().mapLarge(currentPhysicalAddress, currentVirtualAddress, flags)) {
+                i += largePageCount - 1;
+                continue;
+            }
+        }
+
         // If the virtual address is already mapped, we have to unmap it.
         // This can happen because the headers of the free list are mapped to arbitrary physical addresses, but the memory should be mapped to the given physical addresses.
         unmap(currentVirtualAddress, 1);
         // Map the page into the current address space
-        currentAddressSpace->map(currentPhysicalAddress, currentVirtualAddress, flags);
+        getCurrentAddressSpace().map(currentPhysicalAddress, currentVirtualAddress, flags);
     }
 
     return virtualAddress;
 }
 
 void* MemoryService::getPhysicalAddress(void *virtualAddress) {
-    return currentAddressSpace->getPhysicalAddress(virtualAddress);
+    return getCurrentAddressSpace().getPhysicalAddress(virtualAddress);
 }
 
 VirtualAddressSpace& MemoryService::createAddressSpace() {
@@ -329,7 +597,8 @@ VirtualAddressSpace& MemoryService::createAddressSpace() {
 }
 
 void MemoryService::switchAddressSpace(VirtualAddressSpace &addressSpace) {
-    if (currentAddressSpace == &addressSpace) {
+    auto cpuId = Service::getService<InterruptService>().getCpuId();
+    if (currentAddressSpaces[cpuId] == &addressSpace) {
         return;
     }
 
@@ -337,7 +606,7 @@ void MemoryService::switchAddressSpace(VirtualAddressSpace &addressSpace) {
     auto *pageDirectoryPhysical = getPhysicalAddress(const_cast<void*>(reinterpret_cast<const void*>(&addressSpace.getPageDirectoryPhysical())));
 
     // Set current address space
-    currentAddressSpace = &addressSpace;
+    currentAddressSpaces[cpuId] = &addressSpace;
 
     asm volatile (
             "mov %0, %%cr3"
@@ -346,9 +615,39 @@ void MemoryService::switchAddressSpace(VirtualAddressSpace &addressSpace) {
             );
 }
 
+void MemoryService::shootdownTlb(const VirtualAddressSpace &addressSpace, const void *virtualAddress, uint32_t pageCount) {
+    if (!tlbShootdown.isEnabled()) {
+        return;
+    }
+
+    // Switching address spaces drops all non-global TLB entries, so CPUs that switch to the address space later on are safe.
+    // Kernel pages are global and mapped into every address space, so all CPUs may have cached them.
+    auto cpuId = Service::getService<InterruptService>().getCpuId();
+    auto kernelPage = reinterpret_cast<uint32_t>(virtualAddress) < MemoryLayout::KERNEL_AREA.endAddress;
+    bool targetCpus[TlbShootdown::MAX_CPUS]{};
+    bool hasTargets = false;
+
+    for (uint32_t i = 0; i < TlbShootdown::MAX_CPUS; i++) {
+        if (i != cpuId && tlbShootdown.isActive(i) && (kernelPage || currentAddressSpaces[i] == &addressSpace)) {
+            targetCpus[i] = true;
+            hasTargets = true;
+        }
+    }
+
+    if (hasTargets) {
+        tlbShootdown.invalidate(virtualAddress, pageCount, targetCpus);
+    }
+}
+
+void MemoryService::enableTlbShootdown() {
+    tlbShootdown.activate();
+}
+
 void MemoryService::removeAddressSpace(VirtualAddressSpace &addressSpace) {
-    if (currentAddressSpace == &addressSpace) {
-        Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "MemoryService: Trying to delete the currently active address space!");
+    for (const auto *currentAddressSpace : currentAddressSpaces) {
+        if (currentAddressSpace == &addressSpace) {
+            Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "MemoryService: Trying to delete an active address space!");
+        }
     }
 
     addressSpaces.remove(&addressSpace);
@@ -365,12 +664,82 @@ void MemoryService::handlePageFault(uint32_t errorCode) {
     }
 
     // Check if page fault was caused by an illegal page access
-    if ((errorCode & 0x00000001u) > 0) {
+    if ((errorCode & PROTECTION_VIOLATION) > 0) {
+        // Writing to a copy-on-write page is legal and needs a private copy of the page
+        if ((errorCode & WRITE_ACCESS) > 0 && resolveCopyOnWrite(faultAddress)) {
+            return;
+        }
+
         Util::Exception::throwException(Util::Exception::ILLEGAL_PAGE_ACCESS, "Privilege level not sufficient to access page!");
     }
 
-    // Map the faulted Page
-    map(reinterpret_cast<void*>(faultAddress), 1, Paging::PRESENT | Paging::WRITABLE | (faultAddress >= Kernel::MemoryLayout::KERNEL_AREA.endAddress ? Paging::USER_ACCESSIBLE : Paging::NONE));
+    // A process, that has reached its memory limit, is killed instead of letting it take the memory of other processes
+    if (faultAddress >= Kernel::MemoryLayout::KERNEL_AREA.endAddress && getCurrentAddressSpace().isMemoryLimitReached()) {
+        Util::Exception::throwException(Util::Exception::OUT_OF_MEMORY, "Memory limit of process exceeded!");
+    }
+
+    // Pages of memory mappings (e.g. executables or mapped files) are filled from their backing file.
+    // Mappings only exist in user space, so kernel heap faults (e.g. while a mapping is added) never need the mapping lock.
+    if (faultAddress >= Kernel::MemoryLayout::KERNEL_AREA.endAddress) {
+        auto *mapping = getCurrentAddressSpace().findMapping(faultAddress);
+        if (mapping != nullptr) {
+            mapping->handlePageFault(faultAddress);
+            mapping->release();
+            return;
+        }
+    }
+
+    // Map the faulted page to a zeroed frame, so that no data of other processes is leaked
+    map(reinterpret_cast<void*>(faultAddress), 1, Paging::PRESENT | Paging::WRITABLE | (faultAddress >= Kernel::MemoryLayout::KERNEL_AREA.endAddress ? Paging::USER_ACCESSIBLE : Paging::NONE), true);
+}
+
+bool MemoryService::resolveCopyOnWrite(uint32_t faultAddress) {
+    auto &addressSpace = getCurrentAddressSpace();
+    auto *page = reinterpret_cast<void*>(faultAddress & ~(Util::PAGESIZE - 1));
+
+    copyOnWriteLock.acquire();
+    auto flags = addressSpace.getFlags(page);
+    auto *physicalAddress = addressSpace.getPhysicalAddress(page);
+
+    if ((flags & Paging::WRITABLE) > 0) {
+        // Another thread has already resolved the fault and this CPU used a stale TLB entry
+        addressSpace.remap(physicalAddress, page, flags);
+        copyOnWriteLock.release();
+        return true;
+    }
+
+    if ((flags & Paging::COPY_ON_WRITE) == 0) {
+        copyOnWriteLock.release();
+        return false;
+    }
+
+    flags = (flags & ~Paging::COPY_ON_WRITE) | Paging::WRITABLE;
+
+    if (pageFrameAllocator.getReferenceCount(physicalAddress) > 1) {
+        // The frame is still shared -> Copy its content to a new frame, that belongs only to this address space
+        auto *frame = allocateFrame();
+        if (frame == nullptr) {
+            copyOnWriteLock.release();
+            Util::Exception::throwException(Util::Exception::OUT_OF_PHYSICAL_MEMORY, "No page frame left to resolve copy-on-write fault!");
+        }
+
+        // The new frame is filled via a temporary kernel window, so that other threads never see it with incomplete content
+        auto *window = allocateKernelMemory(Util::PAGESIZE, Util::PAGESIZE);
+        mapPhysical(frame, window, 1, Paging::PRESENT | Paging::WRITABLE);
+        Util::Address<uint32_t>(window).copyRange(Util::Address<uint32_t>(page), Util::PAGESIZE);
+        unmap(window, 1);
+        freeKernelMemory(window, Util::PAGESIZE);
+
+        addressSpace.remap(frame, page, flags);
+
+        freePhysicalMemory(physicalAddress, 1);
+    } else {
+        // All other references have been released -> This address space can use the frame exclusively
+        addressSpace.remap(physicalAddress, page, flags);
+    }
+
+    copyOnWriteLock.release();
+    return true;
 }
 
 MemoryService::MemoryStatus MemoryService::getMemoryStatus() {
@@ -384,7 +753,8 @@ VirtualAddressSpace& MemoryService::getKernelAddressSpace() const {
 }
 
 VirtualAddressSpace &MemoryService::getCurrentAddressSpace() const {
-    return *currentAddressSpace;
+    auto *currentAddressSpace = currentAddressSpaces[Service::getService<InterruptService>().getCpuId()];
+    return currentAddressSpace == nullptr ? kernelAddressSpace : *currentAddressSpace;
 }
 
 const Util::ArrayList<VirtualAddressSpace *> &MemoryService::getAllAddressSpaces() const {
@@ -392,16 +762,66 @@ const Util::ArrayList<VirtualAddressSpace *> &MemoryService::getAllAddressSpaces
 }
 
 void MemoryService::setTaskStateSegmentStackEntry(const uint32_t *stackPointer) {
+    auto *tss = taskStateSegments[Service::getService<InterruptService>().getCpuId()];
     tss->esp0 = reinterpret_cast<uint32_t>(stackPointer);
     tss->ss0 = static_cast<uint16_t>(Device::Cpu::SegmentSelector(Device::Cpu::Ring0, 2));
 }
 
+void MemoryService::registerTaskStateSegment(GlobalDescriptorTable::TaskStateSegment *taskStateSegment) {
+    taskStateSegments[Service::getService<InterruptService>().getCpuId()] = taskStateSegment;
+}
+
+void MemoryService::assignBootstrapProcessorId(uint8_t cpuId) {
+    if (cpuId == 0) {
+        return;
+    }
+
+    taskStateSegments[cpuId] = taskStateSegments[0];
+    currentAddressSpaces[cpuId] = currentAddressSpaces[0];
+    taskStateSegments[0] = nullptr;
+    currentAddressSpaces[0] = nullptr;
+}
+
 void MemoryService::loadGlobalDescriptorTable() {
     gdt->load();
 }
 
-void MemoryService::enableSlabAllocator() {
-    slabAllocatorEnabled = true;
+SlabCache& MemoryService::createSlabCache(const Util::String &name, uint32_t objectSize, uint32_t alignment, void (*constructor)(void*)) {
+    return slabAllocator.createCache(name, objectSize, alignment, constructor);
+}
+
+void MemoryService::destroySlabCache(SlabCache &cache) {
+    slabAllocator.destroyCache(cache);
+}
+
+Util::Array<SlabCache*> MemoryService::getSlabCaches() {
+    return slabAllocator.getCaches();
+}
+
+uint32_t MemoryService::reclaimMemory() {
+    // Pooled zeroed frames can be given back without any further work
+    auto reclaimed = zeroedPageFramePool.reclaim();
+
+    // Empty slabs are returned to the kernel heap, which unmaps their pages and frees the page frames.
+    // If the heap is locked, this may be a page fault inside the heap, which must not re-enter it.
+    if (!kernelAddressSpace.getMemoryManager().isLocked()) {
+        reclaimed += slabAllocator.reclaim();
+    }
+
+    return reclaimed;
+}
+
+ZeroedPageFramePool& MemoryService::getZeroedPageFramePool() {
+    return zeroedPageFramePool;
+}
+
+void* MemoryService::allocateFrame() {
+    auto *frame = pageFrameAllocator.allocateBlock();
+    if (frame == nullptr && reclaimMemory() > 0) {
+        frame = pageFrameAllocator.allocateBlock();
+    }
+
+    return frame;
 }
 
 }
\ No newline at end of file
@@ -21,11 +21,17 @@
 #include <stdint.h>
 
 #include "Service.h"
+#include "lib/util/async/Spinlock.h"
+#include "lib/util/base/Constants.h"
+#include "lib/util/base/String.h"
+#include "lib/util/collection/Array.h"
 #include "lib/util/collection/ArrayList.h"
 #include "device/bus/isa/Isa.h"
 #include "kernel/memory/GlobalDescriptorTable.h"
 #include "kernel/memory/Paging.h"
 #include "kernel/memory/SlabAllocator.h"
+#include "kernel/memory/TlbShootdown.h"
+#include "kernel/memory/ZeroedPageFramePool.h"
 
 namespace Kernel {
 class PageFrameAllocator;
@@ -33,6 +39,8 @@ class PagingAreaManager;
 }  // namespace Kernel
 
 namespace Kernel {
+class MappedFile;
+class MemoryMapping;
 class VirtualAddressSpace;
 
 class MemoryService : public Service {
@@ -88,10 +96,28 @@ public:
 
     void* allocateIsaMemory(uint32_t pageCount);
 
+    /**
+     * Allocate physically contiguous page frames.
+     *
+     * @param frameCount The amount of page frames
+     * @param startAddress Frames are preferably taken from the memory zone containing this address (see PageFrameAllocator::Zone)
+     * @return The physical start address, or nullptr if no contiguous block of the requested size is available
+     */
     void* allocatePhysicalMemory(uint32_t frameCount, void *startAddress = reinterpret_cast<void*>(Device::Isa::MAX_DMA_ADDRESS));
 
     void freePhysicalMemory(void *pointer, uint32_t frameCount);
 
+    /**
+     * Allocate a single page frame, that can be shared between address spaces via its reference count.
+     */
+    void* allocatePageFrame();
+
+    /**
+     * Allocate a single page frame like allocatePageFrame(), that is filled with zeros.
+     * Frames are taken from the pool of pre-zeroed frames, as long as it is not empty.
+     */
+    void* allocateZeroedPageFrame();
+
     /**
      * Allocate space in PageTableArea.
      *
@@ -111,8 +137,9 @@ public:
      *
      * @param virtualAddress Virtual address where a page should be mapped
      * @param flags Flags for Page Table Entry
+     * @param zero Fill the pages with zeros (requires Paging::WRITABLE, if the pool of pre-zeroed frames is empty)
      */
-    void map(void *virtualAddress, uint32_t pageCount, uint16_t flags);
+    void map(void *virtualAddress, uint32_t pageCount, uint16_t flags, bool zero = false);
 
     /**
      * Unmap a page at a given virtual address.
@@ -133,6 +160,72 @@ public:
      */
     void mapPhysical(void *physicalAddress, void *virtualAddress, uint32_t pageCount, uint16_t flags);
 
+    /**
+     * Share a mapped page of the current address space (e.g. to keep it in a cache and map it into other address spaces later).
+     * The page is remapped read-only (copy-on-write, if the given flags contain Paging::WRITABLE)
+     * and its page frame gets an additional reference, which must be released via freePhysicalMemory().
+     *
+     * @param virtualAddress Virtual address of the page to share
+     * @param flags Flags for the Page Table entry
+     *
+     * @return Physical address of the shared page frame, or nullptr if the page is not mapped
+     */
+    void* sharePage(void *virtualAddress, uint16_t flags);
+
+    /**
+     * Map a shared page frame into the current address space and add a reference to it.
+     * If the given flags contain Paging::WRITABLE, the page is mapped copy-on-write,
+     * so that writing to it never affects other address spaces.
+     *
+     * @param physicalAddress Physical address of the shared page frame
+     * @param virtualAddress Virtual address where the page should be mapped
+     * @param flags Flags for the Page Table entry
+     * @param copyOnWrite false, if writing to the page should modify the shared frame (e.g. for shared file mappings)
+     */
+    void mapShared(void *physicalAddress, void *virtualAddress, uint16_t flags, bool copyOnWrite = true);
+
+    /**
+     * Create a memory mapping in the current (user) address space, whose pages are mapped on demand, when they are accessed.
+     * Private mappings of a file start with the file's content, but modifications are only visible to the current process.
+     * Shared mappings modify the file's page cache directly and are written back to the file, when they are removed.
+     * Since there is no fork(), anonymous mappings are always private.
+     *
+     * @param virtualAddress The page aligned start address of the mapping (usually allocated on the user space heap)
+     * @param path The file to map, or an empty string for an anonymous mapping (filled with zeros)
+     * @param offset The page aligned file offset, at which the mapping starts
+     * @param length The length of the mapping in bytes (rounded up to whole pages)
+     * @param mappingFlags A combination of Util::System::MappingFlag values
+     *
+     * @return true, if the mapping has been created
+     */
+    bool createMapping(void *virtualAddress, const Util::String &path, uint32_t offset, uint32_t length, uint32_t mappingFlags);
+
+    /**
+     * Remove a memory mapping created by createMapping() from the current address space and unmap its pages.
+     *
+     * @param virtualAddress The start address of the mapping
+     *
+     * @return false, if there is no such mapping
+     */
+    bool removeMapping(void *virtualAddress);
+
+    /**
+     * Remove all memory mappings from the current address space, writing back modified pages of shared mappings.
+     * Used when a process exits.
+     */
+    void removeAllMappings();
+
+    /**
+     * Forget the page cache of a file, that has been mapped via createMapping() (e.g. because it has been modified).
+     * Existing mappings keep using the old page cache, while new mappings read the file again.
+     */
+    void invalidateMappedFile(const Util::String &path);
+
+    /**
+     * Forget the page caches of all files, that have been mapped via createMapping().
+     */
+    void invalidateMappedFiles();
+
     /**
      * Map a physical address into the current address space's heap.
      * This is usually used for memory mapped IO (e.g. for the LFB).
@@ -188,6 +281,14 @@ public:
      */
     void handlePageFault(uint32_t errorCode);
 
+    /**
+     * Give the current address space its own copy of a copy-on-write page after a write access.
+     * Besides the page fault handler, this is used to resolve copy-on-write pages, whose physical address must not change anymore.
+     *
+     * @return false, if the page is not a copy-on-write page (the access is illegal)
+     */
+    bool resolveCopyOnWrite(uint32_t faultAddress);
+
     /**
      * Switch to a given address space.
      *
@@ -195,6 +296,23 @@ public:
      */
     void switchAddressSpace(VirtualAddressSpace &addressSpace);
 
+    /**
+     * Invalidate TLB entries of a range of pages on all other CPUs, that may have cached them, and wait until they are done.
+     * Kernel pages may be cached by every CPU, while user pages may only be cached by CPUs currently using the address space.
+     * The executing CPU has to invalidate its own entries with Paging::invalidate().
+     *
+     * @param addressSpace The address space, that contains the pages
+     * @param virtualAddress The first page to invalidate
+     * @param pageCount The amount of pages to invalidate
+     */
+    void shootdownTlb(const VirtualAddressSpace &addressSpace, const void *virtualAddress, uint32_t pageCount = 1);
+
+    /**
+     * Let the current CPU take part in TLB shootdowns.
+     * Needs to be called by every CPU, before it starts scheduling threads.
+     */
+    void enableTlbShootdown();
+
     void loadGlobalDescriptorTable();
 
     [[nodiscard]] VirtualAddressSpace& getKernelAddressSpace() const;
@@ -207,23 +325,105 @@ public:
 
     void setTaskStateSegmentStackEntry(const uint32_t *stackPointer);
 
-    void enableSlabAllocator();
+    /**
+     * Register the task state segment, that is loaded by the current CPU.
+     * Needs to be called by every application processor, before it starts scheduling threads.
+     *
+     * @param taskStateSegment The current CPU's task state segment
+     */
+    void registerTaskStateSegment(GlobalDescriptorTable::TaskStateSegment *taskStateSegment);
+
+    /**
+     * Move the bootstrap processor's task state segment and current address space from index 0 to the processor's local APIC id.
+     * Must be called right after the APIC has been enabled, before any application processor is started.
+     *
+     * @param cpuId The local APIC id of the bootstrap processor
+     */
+    void assignBootstrapProcessorId(uint8_t cpuId);
+
+    /**
+     * Create a slab cache for frequently allocated kernel objects of the same size (see SlabCache).
+     * The cache's slabs are allocated from the kernel heap.
+     *
+     * @param name The name of the cache, shown in the memory status
+     * @param objectSize The size of each object in bytes
+     * @param alignment The alignment of each object (0 for the default alignment)
+     * @param constructor Called for each object, when its slab is created
+     * @return The new cache
+     */
+    SlabCache& createSlabCache(const Util::String &name, uint32_t objectSize, uint32_t alignment = 0, void (*constructor)(void*) = nullptr);
+
+    void destroySlabCache(SlabCache &cache);
+
+    [[nodiscard]] Util::Array<SlabCache*> getSlabCaches();
+
+    /**
+     * Free memory held by caches (e.g. empty slabs), because physical memory is running low.
+     * Called automatically, when no page frame is left.
+     *
+     * @return The amount of bytes freed
+     */
+    uint32_t reclaimMemory();
+
+    /**
+     * Get the pool of pre-zeroed page frames, which is refilled by a background thread (see MemoryPoolRefillRunnable).
+     */
+    [[nodiscard]] ZeroedPageFramePool& getZeroedPageFramePool();
 
     static const constexpr uint8_t SERVICE_ID = 2;
 
+    static const constexpr uint32_t MAX_MAPPED_FILES = 16;
+
 private:
 
+    /**
+     * Get the page cache of a regular file, that is shared by all mappings of the file.
+     * The returned file has been acquired and must be released by the caller.
+     *
+     * @return The mapped file, or nullptr if the path does not point to a regular file
+     */
+    MappedFile* acquireMappedFile(const Util::String &path);
+
+    /**
+     * Write back and unmap all pages of a removed memory mapping.
+     */
+    void unmapMapping(MemoryMapping &mapping);
+
+    /**
+     * Allocate a single page frame, reclaiming cached memory if none is left.
+     *
+     * @return The page frame, or nullptr if there is still none left
+     */
+    void* allocateFrame();
+
+    enum PageFaultError : uint32_t {
+        PROTECTION_VIOLATION = 0x01,
+        WRITE_ACCESS = 0x02
+    };
+
     GlobalDescriptorTable *gdt;
-    GlobalDescriptorTable::TaskStateSegment *tss;
 
-    bool slabAllocatorEnabled = false;
+    // Each CPU has its own task state segment and address space, indexed by its local APIC id (0 without APIC)
+    GlobalDescriptorTable::TaskStateSegment *taskStateSegments[256]{};
+    VirtualAddressSpace *currentAddressSpaces[256]{};
+
     PageFrameAllocator &pageFrameAllocator;
     PagingAreaManager &pagingAreaManager;
-    SlabAllocator pageFrameSlabAllocator;
+    ZeroedPageFramePool zeroedPageFramePool;
 
     Util::ArrayList<VirtualAddressSpace*> addressSpaces;
-    VirtualAddressSpace *currentAddressSpace;
     VirtualAddressSpace &kernelAddressSpace;
+
+    SlabAllocator slabAllocator;
+
+    TlbShootdown tlbShootdown;
+
+    // Copying a page must not be interleaved with another thread of the same process resolving the same fault
+    Util::Async::Spinlock copyOnWriteLock;
+
+    // Page caches of files mapped via createMapping() (file mappings are cached at most until MAX_MAPPED_FILES are reached)
+    Util::ArrayList<MappedFile*> mappedFiles;
+    Util::Async::Spinlock mappedFileLock;
 };
 
 }
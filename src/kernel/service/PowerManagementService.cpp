@@ -22,8 +22,11 @@
 #include "lib/util/hardware/Machine.h"
 #include "InterruptService.h"
 #include "kernel/service/Service.h"
+#include "kernel/service/FilesystemService.h"
+#include "kernel/service/StorageService.h"
 #include "lib/util/base/System.h"
 #include "device/system/Machine.h"
+#include "kernel/log/Log.h"
 
 namespace Kernel {
 
@@ -48,11 +51,24 @@ PowerManagementService::PowerManagementService(Device::Machine *machine) : machi
 }
 
 void PowerManagementService::shutdownMachine() {
+    flushStorage();
     machine->shutdown();
 }
 
 void PowerManagementService::rebootMachine() {
+    flushStorage();
     machine->reboot();
 }
 
+void PowerManagementService::flushStorage() {
+    // Write back cached data, before the machine is powered off (filesystems first, since they write through the storage devices)
+    if (Service::isServiceRegistered(FilesystemService::SERVICE_ID) && !Service::getService<FilesystemService>().flush()) {
+        LOG_ERROR("Failed to write back cached filesystem data");
+    }
+
+    if (Service::isServiceRegistered(StorageService::SERVICE_ID) && !Service::getService<StorageService>().flush()) {
+        LOG_ERROR("Failed to write back dirty sectors of the buffer cache");
+    }
+}
+
 }
\ No newline at end of file
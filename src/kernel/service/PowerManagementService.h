@@ -59,6 +59,8 @@ public:
 
 private:
 
+    static void flushStorage();
+
     Device::Machine *machine;
 };
 
@@ -25,6 +25,9 @@
 #include "kernel/process/Process.h"
 #include "kernel/process/Thread.h"
 #include "kernel/service/MemoryService.h"
+#include "kernel/memory/MemoryLayout.h"
+#include "kernel/memory/Paging.h"
+#include "kernel/memory/VirtualAddressSpace.h"
 #include "lib/util/base/Exception.h"
 #include "lib/util/io/file/File.h"
 #include "lib/util/base/System.h"
@@ -32,6 +35,8 @@
 #include "InterruptService.h"
 #include "kernel/service/Service.h"
 #include "kernel/process/SchedulerCleaner.h"
+#include "kernel/process/IdleThread.h"
+#include "kernel/log/Log.h"
 
 namespace Util {
 namespace Async {
@@ -44,11 +49,13 @@ class Timestamp;
 
 
 namespace Kernel {
-class VirtualAddressSpace;
 
-ProcessService::ProcessService(Process *kernelProcess) : kernelProcess(kernelProcess) {
+ProcessService::ProcessService(Process *kernelProcess) : kernelProcess(kernelProcess), threadCache(Service::getService<MemoryService>().createSlabCache("Thread", sizeof(Thread))) {
     processList.add(kernelProcess);
 
+    // The process service is created before the APIC is initialized, so this is always the bootstrap processor
+    schedulers[0] = new Scheduler(0);
+
     Service::getService<InterruptService>().assignSystemCall(Util::System::YIELD, [](uint32_t, va_list) -> bool {
         Service::getService<ProcessService>().getScheduler().yield();
         return true;
@@ -80,7 +87,7 @@ ProcessService::ProcessService(Process *kernelProcess) : kernelProcess(kernelPro
         auto &thread = Kernel::Thread::createUserThread(name, processService.getCurrentProcess(), eip, runnable);
 
         threadId = thread.getId();
-        processService.getScheduler().ready(thread);
+        processService.ready(thread);
         return true;
     });
 
@@ -104,7 +111,7 @@ ProcessService::ProcessService(Process *kernelProcess) : kernelProcess(kernelPro
         auto &processService = Service::getService<ProcessService>();
         auto threadId = va_arg(arguments, uint32_t);
 
-        auto *thread = processService.getScheduler().getThread(threadId);
+        auto *thread = processService.getThread(threadId);
         if (thread != nullptr) {
             thread->join();
         }
@@ -112,6 +119,81 @@ ProcessService::ProcessService(Process *kernelProcess) : kernelProcess(kernelPro
         return true;
     });
 
+    Service::getService<InterruptService>().assignSystemCall(Util::System::SET_THREAD_AFFINITY, [](uint32_t paramCount, va_list arguments) -> bool {
+        if (paramCount < 2) {
+            return false;
+        }
+
+        auto &processService = Service::getService<ProcessService>();
+        auto threadId = va_arg(arguments, uint32_t);
+        auto cpuId = static_cast<int16_t>(va_arg(arguments, int32_t));
+
+        auto *thread = processService.getThread(threadId);
+        if (thread == nullptr || cpuId < Thread::NO_AFFINITY || cpuId > 255) {
+            return false;
+        }
+
+        // Processes may only change the scheduling parameters of their own threads
+        if (&thread->getParent() != &processService.getCurrentProcess()) {
+            return false;
+        }
+
+        thread->setAffinity(cpuId);
+        return true;
+    });
+
+    Service::getService<InterruptService>().assignSystemCall(Util::System::SET_THREAD_PRIORITY, [](uint32_t paramCount, va_list arguments) -> bool {
+        if (paramCount < 2) {
+            return false;
+        }
+
+        auto &processService = Service::getService<ProcessService>();
+        auto threadId = va_arg(arguments, uint32_t);
+        auto priority = va_arg(arguments, uint32_t);
+
+        auto *thread = processService.getThread(threadId);
+        if (thread == nullptr || priority >= Util::Async::Thread::PRIORITY_LEVELS) {
+            return false;
+        }
+
+        if (&thread->getParent() != &processService.getCurrentProcess()) {
+            return false;
+        }
+
+        processService.setThreadPriority(*thread, static_cast<Util::Async::Thread::Priority>(priority));
+        return true;
+    });
+
+    Service::getService<InterruptService>().assignSystemCall(Util::System::WAIT_ON_ADDRESS, [](uint32_t paramCount, va_list arguments) -> bool {
+        if (paramCount < 2) {
+            return false;
+        }
+
+        auto *address = va_arg(arguments, const uint32_t*);
+        auto expectedValue = va_arg(arguments, uint32_t);
+        if (!isUserAddress(address)) {
+            return false;
+        }
+
+        return Service::getService<ProcessService>().waitOnAddress(address, expectedValue);
+    });
+
+    Service::getService<InterruptService>().assignSystemCall(Util::System::WAKE_ADDRESS, [](uint32_t paramCount, va_list arguments) -> bool {
+        if (paramCount < 3) {
+            return false;
+        }
+
+        auto *address = va_arg(arguments, const uint32_t*);
+        auto count = va_arg(arguments, uint32_t);
+        auto &woken = *va_arg(arguments, uint32_t*);
+        if (!isUserAddress(address)) {
+            return false;
+        }
+
+        woken = Service::getService<ProcessService>().wakeAddress(address, count);
+        return true;
+    });
+
     Service::getService<InterruptService>().assignSystemCall(Util::System::EXIT_THREAD, []([[maybe_unused]] uint32_t paramCount, [[maybe_unused]] va_list arguments) -> bool {
         Service::getService<ProcessService>().getScheduler().exit();
         return true;
@@ -215,7 +297,7 @@ Process& ProcessService::loadBinary(const Util::Io::File &binaryFile, const Util
     auto &process = createProcess(virtualAddressSpace, binaryFile.getCanonicalPath(), Util::Io::File::getCurrentWorkingDirectory(), inputFile, outputFile, errorFile);
     auto &thread = Kernel::Thread::createKernelThread("Loader", process, new Kernel::BinaryLoader(binaryFile.getCanonicalPath(), command, arguments));
 
-    scheduler.ready(thread);
+    ready(thread);
     return process;
 }
 
@@ -225,11 +307,11 @@ void ProcessService::killProcess(Process &process) {
     }
 
     for (auto *thread : process.getThreads()) {
-        scheduler.kill(*thread);
+        thread->getScheduler()->kill(*thread);
     }
 
     auto &cleanerThread = Thread::createKernelThread("Address-Space-Cleaner", process, new AddressSpaceCleaner());
-    scheduler.ready(cleanerThread);
+    ready(cleanerThread);
     process.setExitCode(-1);
 
     lock.acquire();
@@ -238,11 +320,11 @@ void ProcessService::killProcess(Process &process) {
 }
 
 Process& ProcessService::getCurrentProcess() {
-    if (!scheduler.isInitialized()) {
+    if (!isSchedulerInitialized()) {
         return *kernelProcess;
     }
 
-    return scheduler.getCurrentThread().getParent();
+    return getScheduler().getCurrentThread().getParent();
 }
 
 bool ProcessService::isProcessActive(uint32_t id) {
@@ -260,7 +342,7 @@ void ProcessService::exitCurrentProcess(int32_t exitCode) {
     auto &cleanerThread = Thread::createKernelThread("Address-Space-Cleaner", process, new AddressSpaceCleaner());
 
     process.killAllThreadsButCurrent();
-    scheduler.ready(cleanerThread);
+    ready(cleanerThread);
 
     process.setExitCode(exitCode);
 
@@ -268,7 +350,7 @@ void ProcessService::exitCurrentProcess(int32_t exitCode) {
     processList.remove(&process);
     lock.release();
 
-    scheduler.exit();
+    getScheduler().exit();
 
     __builtin_unreachable();
 }
@@ -287,6 +369,10 @@ Process& ProcessService::getKernelProcess() const {
     return *kernelProcess;
 }
 
+SlabCache& ProcessService::getThreadCache() const {
+    return threadCache;
+}
+
 Util::Array<uint32_t> ProcessService::getActiveProcessIds() const {
     auto ids = Util::Array<uint32_t>(processList.size());
     for (uint32_t i = 0; i < processList.size(); i++) {
@@ -297,7 +383,154 @@ Util::Array<uint32_t> ProcessService::getActiveProcessIds() const {
 }
 
 Scheduler &ProcessService::getScheduler() {
-    return scheduler;
+    auto *scheduler = schedulers[Service::getService<InterruptService>().getCpuId()];
+    if (scheduler == nullptr) {
+        Util::Exception::throwException(Util::Exception::ILLEGAL_STATE, "ProcessService: No scheduler running on this core!");
+    }
+
+    return *scheduler;
+}
+
+bool ProcessService::isSchedulerInitialized() {
+    auto *scheduler = schedulers[Service::getService<InterruptService>().getCpuId()];
+    return scheduler != nullptr && scheduler->isInitialized();
+}
+
+void ProcessService::createScheduler() {
+    auto cpuId = Service::getService<InterruptService>().getCpuId();
+    if (schedulers[cpuId] != nullptr) {
+        Util::Exception::throwException(Util::Exception::ILLEGAL_STATE, "ProcessService: Scheduler for this core has already been created!");
+    }
+
+    schedulers[cpuId] = new Scheduler(cpuId);
+}
+
+void ProcessService::assignBootstrapProcessorId(uint8_t cpuId) {
+    if (cpuId == 0) {
+        return;
+    }
+
+    schedulers[cpuId] = schedulers[0];
+    schedulers[0] = nullptr;
+    schedulers[cpuId]->setCpuId(cpuId);
+}
+
+Util::Array<Scheduler*> ProcessService::getSchedulers() const {
+    uint32_t count = 0;
+    for (const auto *scheduler : schedulers) {
+        if (scheduler != nullptr) {
+            count++;
+        }
+    }
+
+    auto array = Util::Array<Scheduler*>(count);
+    for (uint32_t i = 0, j = 0; i < 256; i++) {
+        if (schedulers[i] != nullptr) {
+            array[j++] = schedulers[i];
+        }
+    }
+
+    return array;
+}
+
+void ProcessService::ready(Thread &thread) {
+    auto affinity = thread.getAffinity();
+    if (affinity >= 0 && affinity < 256 && schedulers[affinity] != nullptr) {
+        schedulers[affinity]->ready(thread);
+        return;
+    }
+
+    Scheduler *target = nullptr;
+    for (auto *scheduler : schedulers) {
+        if (scheduler != nullptr && (target == nullptr || scheduler->getThreadCount() < target->getThreadCount())) {
+            target = scheduler;
+        }
+    }
+
+    target->ready(thread);
+}
+
+Thread* ProcessService::getThread(uint32_t id) {
+    // Threads blocked in a wait queue, waiting for an interrupt or joining are not known to any scheduler,
+    // but every thread is registered at its process, until it has exited or has been killed
+    lock.acquire();
+    for (auto *process : processList) {
+        auto *thread = process->getThread(id);
+        if (thread != nullptr) {
+            return lock.releaseAndReturn(thread);
+        }
+    }
+
+    return lock.releaseAndReturn<Thread*>(nullptr);
+}
+
+void ProcessService::setThreadPriority(Thread &thread, Util::Async::Thread::Priority priority) {
+    while (true) {
+        auto *scheduler = thread.getScheduler();
+        if (scheduler == nullptr) {
+            thread.setPriority(priority);
+            return;
+        }
+
+        if (scheduler->setPriority(thread, priority)) {
+            return;
+        }
+    }
+}
+
+bool ProcessService::waitOnAddress(const uint32_t *address, uint32_t expectedValue) {
+    auto *waitQueue = getAddressWaitQueue(address);
+    if (waitQueue == nullptr) {
+        return false;
+    }
+
+    return waitQueue->wait(*address, expectedValue, getAddressKey(address));
+}
+
+uint32_t ProcessService::wakeAddress(const uint32_t *address, uint32_t count) {
+    auto *waitQueue = getAddressWaitQueue(address);
+    if (waitQueue == nullptr) {
+        return 0;
+    }
+
+    return waitQueue->wakeUp(count, getAddressKey(address));
+}
+
+WaitQueue* ProcessService::getAddressWaitQueue(const uint32_t *address) {
+    if (address == nullptr || reinterpret_cast<uint32_t>(address) % sizeof(uint32_t) != 0) {
+        return nullptr;
+    }
+
+    // Touch the address first, so that lazily mapped pages (e.g. on the heap) are present
+    [[maybe_unused]] volatile uint32_t value = *address;
+
+    // The key of a copy-on-write page would change with the first write, so that waiting threads would never be woken up
+    auto &memoryService = Service::getService<MemoryService>();
+    if ((memoryService.getCurrentAddressSpace().getFlags(address) & Paging::COPY_ON_WRITE) > 0) {
+        memoryService.resolveCopyOnWrite(reinterpret_cast<uint32_t>(address));
+    }
+
+    auto key = getAddressKey(address);
+    if (key == 0) {
+        return nullptr;
+    }
+
+    return &addressWaitQueues[(key / sizeof(uint32_t)) % ADDRESS_WAIT_QUEUES];
+}
+
+bool ProcessService::isUserAddress(const uint32_t *address) {
+    // User processes must not wait on kernel memory, and the address is dereferenced, so it has to be properly aligned
+    auto value = reinterpret_cast<uint32_t>(address);
+    return value >= MemoryLayout::KERNEL_AREA.endAddress && value % sizeof(uint32_t) == 0;
+}
+
+uint32_t ProcessService::getAddressKey(const uint32_t *address) {
+    // Physical addresses are unique across all address spaces, so that threads may also wait on shared memory
+    return reinterpret_cast<uint32_t>(Service::getService<MemoryService>().getPhysicalAddress(const_cast<uint32_t*>(address)));
+}
+
+ImageCache& ProcessService::getImageCache() {
+    return imageCache;
 }
 
 void ProcessService::cleanup(Thread *thread) {
@@ -311,9 +544,33 @@ void ProcessService::cleanup(Process *process) {
 void ProcessService::startScheduler() {
     cleaner = new Kernel::SchedulerCleaner();
     auto &schedulerCleanerThread = Kernel::Thread::createKernelThread("Scheduler-Cleaner", *kernelProcess, cleaner);
-    scheduler.ready(schedulerCleanerThread);
+    ready(schedulerCleanerThread);
+
+    // Every scheduler gets an idle thread, so that its ready queue never runs empty
+    uint32_t schedulerCount = 0;
+    for (auto *scheduler : schedulers) {
+        if (scheduler != nullptr) {
+            auto &idleThread = Kernel::Thread::createKernelThread("Idle", *kernelProcess, new IdleThread());
+            idleThread.setAffinity(scheduler->getCpuId()); // Pin the idle thread, so that it is never stolen
+            idleThread.setPriority(Util::Async::Thread::IDLE);
+            scheduler->ready(idleThread);
+            schedulerCount++;
+        }
+    }
 
-    scheduler.start();
+    LOG_INFO("Starting [%u] scheduler(s)", schedulerCount);
+    Service::getService<MemoryService>().enableTlbShootdown();
+    Service::getService<InterruptService>().allowParallelComputing();
+    getScheduler().start();
+}
+
+void ProcessService::startApplicationProcessorScheduler() {
+    auto &interruptService = Service::getService<InterruptService>();
+    while (!interruptService.isParallelComputingAllowed()) {}
+
+    Service::getService<MemoryService>().enableTlbShootdown();
+    getScheduler().start();
+    __builtin_unreachable();
 }
 
 }
\ No newline at end of file
@@ -25,7 +25,9 @@
 #include "lib/util/collection/Array.h"
 #include "lib/util/collection/ArrayList.h"
 #include "lib/util/base/String.h"
+#include "kernel/process/ImageCache.h"
 #include "kernel/process/Scheduler.h"
+#include "kernel/process/WaitQueue.h"
 
 namespace Util {
 namespace Io {
@@ -36,6 +38,7 @@ class File;
 namespace Kernel {
 class VirtualAddressSpace;
 class SchedulerCleaner;
+class SlabCache;
 class Thread;
 class Process;
 
@@ -78,26 +81,131 @@ public:
 
     [[nodiscard]] Process& getKernelProcess() const;
 
+    /**
+     * Get the slab cache, from which all thread objects are allocated.
+     */
+    [[nodiscard]] SlabCache& getThreadCache() const;
+
     [[nodiscard]] Util::Array<uint32_t> getActiveProcessIds() const;
 
+    /**
+     * Get the scheduler of the executing core.
+     */
     [[nodiscard]] Scheduler& getScheduler();
 
+    /**
+     * Check if the executing core has a scheduler, which has already started running threads.
+     */
+    [[nodiscard]] bool isSchedulerInitialized();
+
+    /**
+     * Create the scheduler for the executing core.
+     * Must be called by each application processor during its startup, before parallel computing is allowed.
+     */
+    void createScheduler();
+
+    /**
+     * Move the bootstrap processor's scheduler from index 0 to the processor's local APIC id.
+     * Must be called right after the APIC has been enabled, before any application processor is started.
+     *
+     * @param cpuId The local APIC id of the bootstrap processor
+     */
+    void assignBootstrapProcessorId(uint8_t cpuId);
+
+    /**
+     * Get the schedulers of all cores.
+     */
+    [[nodiscard]] Util::Array<Scheduler*> getSchedulers() const;
+
+    /**
+     * Register a new thread at the scheduler of the core it has an affinity hint for,
+     * or at the scheduler with the fewest threads in its ready queue.
+     *
+     * @param thread The thread to register
+     */
+    void ready(Thread &thread);
+
+    /**
+     * Search all schedulers for a thread with the given id.
+     *
+     * @param id The thread id
+     * @return The thread, or nullptr if no scheduler knows a thread with the given id
+     */
+    [[nodiscard]] Thread* getThread(uint32_t id);
+
+    /**
+     * Change the base priority of a thread, regardless of which core's scheduler it is registered at.
+     *
+     * @param thread The thread
+     * @param priority The new base priority
+     */
+    void setThreadPriority(Thread &thread, Util::Async::Thread::Priority priority);
+
+    /**
+     * Block the current thread, if the value at the given address equals the expected value (futex-like wait).
+     * This is the kernel side of the synchronization primitives in Util::Async (e.g. Mutex).
+     * Since the value may change before the thread blocks, callers always need to recheck their condition after returning.
+     *
+     * @param address The address to wait on (must be 4-byte aligned)
+     * @param expectedValue The current thread only blocks, if the value at the address equals this
+     * @return true, if the current thread has been blocked and woken up again
+     */
+    bool waitOnAddress(const uint32_t *address, uint32_t expectedValue);
+
+    /**
+     * Wake up threads waiting on the given address via waitOnAddress().
+     *
+     * @param address The address to wake up waiting threads for
+     * @param count The maximum number of threads to wake up
+     * @return The number of threads woken up
+     */
+    uint32_t wakeAddress(const uint32_t *address, uint32_t count);
+
+    /**
+     * Get the cache of recently started executables, whose pages are shared between processes.
+     */
+    [[nodiscard]] ImageCache& getImageCache();
+
     void cleanup(Thread *thread);
 
     void cleanup(Process *process);
 
+    /**
+     * Start the scheduler on the bootstrap processor and allow the application processors to start their schedulers.
+     */
     void startScheduler();
 
+    /**
+     * Start the scheduler of an application processor (called once parallel computing is allowed).
+     */
+    [[noreturn]] void startApplicationProcessorScheduler();
+
     static const constexpr uint8_t SERVICE_ID = 7;
 
 private:
 
-    Scheduler scheduler;
+    WaitQueue* getAddressWaitQueue(const uint32_t *address);
+
+    static uint32_t getAddressKey(const uint32_t *address);
+
+    static bool isUserAddress(const uint32_t *address);
+
+    // Each CPU has its own scheduler, indexed by its local APIC id (0 without APIC)
+    Scheduler *schedulers[256]{};
     SchedulerCleaner *cleaner = nullptr;
 
     Util::ArrayList<Process*> processList;
     Util::Async::Spinlock lock;
     Process *kernelProcess;
+
+    SlabCache &threadCache;
+
+    static const constexpr uint32_t ADDRESS_WAIT_QUEUES = 64;
+
+    ImageCache imageCache;
+
+    // Threads waiting on an address are distributed across a fixed number of queues by the address' physical location
+    WaitQueue addressWaitQueues[ADDRESS_WAIT_QUEUES];
 };
 
 }
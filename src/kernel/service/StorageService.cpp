@@ -20,43 +20,77 @@
 #include "device/storage/PartitionHandler.h"
 #include "device/storage/Partition.h"
 #include "device/storage/StorageDevice.h"
+#include "device/storage/block/BlockRequestQueue.h"
+#include "device/storage/block/BufferCache.h"
+#include "kernel/process/Thread.h"
+#include "kernel/service/ProcessService.h"
+#include "kernel/service/Service.h"
 #include "kernel/log/Log.h"
+#include "lib/util/async/PeriodicRunnable.h"
 #include "lib/util/base/Exception.h"
 #include "lib/util/collection/Array.h"
+#include "lib/util/time/Timestamp.h"
 
 namespace Kernel {
 
 Util::HashMap<Util::String, uint32_t> StorageService::nameMap;
 
+StorageService::StorageService(uint32_t bufferCacheSize) {
+    if (bufferCacheSize > 0) {
+        auto &processService = Service::getService<ProcessService>();
+        bufferCache = new Device::Storage::BufferCache(bufferCacheSize);
+
+        auto *flusher = new Util::Async::PeriodicRunnable(Util::Time::Timestamp::ofMilliseconds(Device::Storage::BufferCache::FLUSH_INTERVAL), [](void *cache) {
+            static_cast<Device::Storage::BufferCache*>(cache)->flush();
+        }, bufferCache);
+
+        auto &flusherThread = Thread::createKernelThread("Buffer-Cache-Flusher", processService.getKernelProcess(), flusher);
+        processService.ready(flusherThread);
+    }
+}
+
 StorageService::~StorageService() {
     for (const auto &key : deviceMap.keys()) {
         delete deviceMap.get(key);
     }
+
+    delete bufferCache;
 }
 
 Util::String StorageService::registerDevice(Device::Storage::StorageDevice *device, const Util::String &deviceClass) {
     lock.acquire();
+    auto name = addDevice(device, deviceClass, true);
+    lock.release();
+
+    return name;
+}
+
+Util::String StorageService::addDevice(Device::Storage::StorageDevice *device, const Util::String &deviceClass, bool physicalDevice) {
     if (!nameMap.containsKey(deviceClass)) {
         nameMap.put(deviceClass, 0);
     }
 
     auto value = nameMap.get(deviceClass);
     auto name = Util::String::format("%s%u", static_cast<char*>(deviceClass), value);
-    deviceMap.put(name, device);
     nameMap.put(deviceClass, value + 1);
 
+    // Physical devices are accessed through a block request queue (partitions pass their requests on to their parent's queue)
+    if (physicalDevice) {
+        device = new Device::Storage::BlockRequestQueue(device, name, bufferCache);
+    }
+
+    deviceMap.put(name, device);
     LOG_INFO("Registered device [%s]",static_cast<char*>(name));
 
-    if (lock.getDepth() == 1) {
+    if (physicalDevice) {
         LOG_INFO("Scanning device [%s] for partitions", static_cast<char *>(name));
         auto partitionReader = Device::Storage::PartitionHandler(*device);
         for (const auto &info: partitionReader.readPartitionTable()) {
             auto *partition = new Device::Storage::Partition(*device, info.startSector, info.sectorCount);
-            registerDevice(partition, name + "p");
+            addDevice(partition, name + "p", false);
         }
     }
 
-    lock.release();
     return name;
 }
 
@@ -81,4 +115,12 @@ bool StorageService::isDeviceRegistered(const Util::String &deviceName) {
     return result;
 }
 
+bool StorageService::flush() {
+    return bufferCache == nullptr || bufferCache->flush();
+}
+
+Device::Storage::BufferCache* StorageService::getBufferCache() const {
+    return bufferCache;
+}
+
 }
\ No newline at end of file
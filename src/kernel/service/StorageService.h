@@ -27,6 +27,7 @@
 
 namespace Device {
 namespace Storage {
+class BufferCache;
 class StorageDevice;
 }  // namespace Storage
 }  // namespace Device
@@ -38,8 +39,11 @@ class StorageService : public Service {
 public:
     /**
      * Constructor.
+     * Creates the buffer cache, which is shared by all devices, and its flusher thread.
+     *
+     * @param bufferCacheSize The size of the buffer cache in bytes (0 disables the cache)
      */
-    StorageService() = default;
+    explicit StorageService(uint32_t bufferCacheSize);
 
     /**
      * Copy Constructor.
@@ -62,11 +66,30 @@ public:
 
     bool isDeviceRegistered(const Util::String &deviceName);
 
+    /**
+     * Write back all dirty sectors of the buffer cache (e.g. before shutting down).
+     *
+     * @return false, if at least one sector could not be written back
+     */
+    bool flush();
+
+    /**
+     * Get the buffer cache shared by all devices (nullptr, if it is disabled).
+     */
+    [[nodiscard]] Device::Storage::BufferCache* getBufferCache() const;
+
     static const constexpr uint8_t SERVICE_ID = 5;
 
 private:
 
+    /**
+     * Register a device under a new name of the given class. The lock must be held.
+     * Physical devices get a block request queue and are scanned for partitions, which are registered as well.
+     */
+    Util::String addDevice(Device::Storage::StorageDevice *device, const Util::String &deviceClass, bool physicalDevice);
+
     Util::Async::ReentrantSpinlock lock;
+    Device::Storage::BufferCache *bufferCache = nullptr;
     Util::HashMap<Util::String, Device::Storage::StorageDevice*> deviceMap;
 
     static Util::HashMap<Util::String, uint32_t> nameMap;
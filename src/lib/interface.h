@@ -21,6 +21,7 @@
 #include <stdint.h>
 
 #include "lib/util/base/Exception.h"
+#include "lib/util/base/System.h"
 #include "lib/util/io/file/File.h"
 #include "lib/util/time/Timestamp.h"
 #include "lib/util/time/Date.h"
@@ -48,6 +49,9 @@ void freeMemory(void *pointer, uint32_t alignment = 0);
 bool isMemoryManagementInitialized();
 void* mapIO(void *physicalAddress, uint32_t pageCount);
 void unmap(void *virtualAddress, uint32_t pageCount, uint32_t breakCount = 0);
+void* mapMemory(uint32_t length, uint32_t flags = Util::System::MAP_WRITABLE);
+void* mapFile(const Util::String &path, uint32_t offset, uint32_t length, uint32_t flags = 0);
+bool removeMapping(void *address);
 
 bool mount(const Util::String &deviceName, const Util::String &targetPath, const Util::String &driverName);
 bool unmount(const Util::String &path);
@@ -74,6 +78,10 @@ Util::Async::Process getCurrentProcess();
 Util::Async::Thread createThread(const Util::String &name, Util::Async::Runnable *runnable);
 Util::Async::Thread getCurrentThread();
 void joinThread(uint32_t id);
+bool setThreadAffinity(uint32_t id, int16_t cpuId);
+bool setThreadPriority(uint32_t id, Util::Async::Thread::Priority priority);
+bool waitOnAddress(const uint32_t *address, uint32_t expectedValue);
+uint32_t wakeAddress(const uint32_t *address, uint32_t count);
 void joinProcess(uint32_t id);
 void killProcess(uint32_t id);
 void sleep(const Util::Time::Timestamp &time);
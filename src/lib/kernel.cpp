@@ -86,6 +86,19 @@ void unmap(void *virtualAddress, uint32_t pageCount, uint32_t breakCount) {
     Kernel::Service::getService<Kernel::MemoryService>().unmap(virtualAddress, pageCount, breakCount);
 }
 
+void* mapMemory([[maybe_unused]] uint32_t length, [[maybe_unused]] uint32_t flags) {
+    // Memory mappings are resolved by the page fault handler for user space addresses only
+    Util::Exception::throwException(Util::Exception::UNSUPPORTED_OPERATION, "Memory mappings are not supported in kernel space!");
+}
+
+void* mapFile([[maybe_unused]] const Util::String &path, [[maybe_unused]] uint32_t offset, [[maybe_unused]] uint32_t length, [[maybe_unused]] uint32_t flags) {
+    Util::Exception::throwException(Util::Exception::UNSUPPORTED_OPERATION, "Memory mappings are not supported in kernel space!");
+}
+
+bool removeMapping([[maybe_unused]] void *address) {
+    Util::Exception::throwException(Util::Exception::UNSUPPORTED_OPERATION, "Memory mappings are not supported in kernel space!");
+}
+
 bool mount(const Util::String &deviceName, const Util::String &targetPath, const Util::String &driverName) {
     return Kernel::Service::getService<Kernel::FilesystemService>().mount(deviceName, targetPath, driverName);
 }
@@ -201,7 +214,7 @@ Util::Async::Process getCurrentProcess() {
 }
 Util::Async::Thread createThread(const Util::String &name, Util::Async::Runnable *runnable) {
     auto &thread = Kernel::Thread::createKernelThread(name, Kernel::Service::getService<Kernel::ProcessService>().getKernelProcess(), runnable);
-    Kernel::Service::getService<Kernel::ProcessService>().getScheduler().ready(thread);
+    Kernel::Service::getService<Kernel::ProcessService>().ready(thread);
     return Util::Async::Thread(thread.getId());
 }
 
@@ -211,12 +224,50 @@ Util::Async::Thread getCurrentThread() {
 }
 
 void joinThread(uint32_t id) {
-    auto *thread = Kernel::Service::getService<Kernel::ProcessService>().getScheduler().getThread(id);
+    auto *thread = Kernel::Service::getService<Kernel::ProcessService>().getThread(id);
     if (thread != nullptr) {
         thread->join();
     }
 }
 
+bool setThreadAffinity(uint32_t id, int16_t cpuId) {
+    auto *thread = Kernel::Service::getService<Kernel::ProcessService>().getThread(id);
+    if (thread == nullptr) {
+        return false;
+    }
+
+    thread->setAffinity(cpuId);
+    return true;
+}
+
+bool setThreadPriority(uint32_t id, Util::Async::Thread::Priority priority) {
+    auto &processService = Kernel::Service::getService<Kernel::ProcessService>();
+    auto *thread = processService.getThread(id);
+    if (thread == nullptr) {
+        return false;
+    }
+
+    processService.setThreadPriority(*thread, priority);
+    return true;
+}
+
+bool waitOnAddress(const uint32_t *address, uint32_t expectedValue) {
+    // Without a scheduler, there is no other thread to wait for -> Let the caller recheck its condition
+    if (!isSchedulerInitialized()) {
+        return false;
+    }
+
+    return Kernel::Service::getService<Kernel::ProcessService>().waitOnAddress(address, expectedValue);
+}
+
+uint32_t wakeAddress(const uint32_t *address, uint32_t count) {
+    if (!isSchedulerInitialized()) {
+        return 0;
+    }
+
+    return Kernel::Service::getService<Kernel::ProcessService>().wakeAddress(address, count);
+}
+
 void joinProcess(uint32_t id) {
     auto *process = Kernel::Service::getService<Kernel::ProcessService>().getProcess(id);
     if (process != nullptr) {
@@ -241,11 +292,14 @@ void sleep(const Util::Time::Timestamp &time) {
 }
 
 void yield() {
-    Kernel::Service::getService<Kernel::ProcessService>().getScheduler().yield();
+    // Application processors may spin on a lock before their scheduler has been created
+    if (isSchedulerInitialized()) {
+        Kernel::Service::getService<Kernel::ProcessService>().getScheduler().yield();
+    }
 }
 
 bool isSchedulerInitialized() {
-    return Kernel::Service::getService<Kernel::ProcessService>().getScheduler().isInitialized();
+    return Kernel::Service::getService<Kernel::ProcessService>().isSchedulerInitialized();
 }
 
 Util::Time::Timestamp getSystemTime() {
@@ -311,7 +365,7 @@ void printKernelStackTrace(bool log) {
 }
 
 void throwError(Util::Exception::Error error, const char *message) {
-    if (Kernel::Service::isServiceRegistered(Kernel::ProcessService::SERVICE_ID) && Kernel::Service::getService<Kernel::ProcessService>().getScheduler().isInitialized()) {
+    if (Kernel::Service::isServiceRegistered(Kernel::ProcessService::SERVICE_ID) && Kernel::Service::getService<Kernel::ProcessService>().isSchedulerInitialized()) {
         auto &processService = Kernel::Service::getService<Kernel::ProcessService>();
         if (processService.getCurrentProcess().isKernelProcess()) {
             Device::Cpu::disableInterrupts();
@@ -3,6 +3,7 @@
 #include "lib/util/base/operators.h"
 #include "lib/util/base/Constants.h"
 #include "lib/util/base/FreeListMemoryManager.h"
+#include "lib/util/base/TlsfMemoryManager.h"
 #include "lib/util/base/System.h"
 #include "lib/util/collection/ArrayList.h"
 #include "lib/util/graphic/Ansi.h"
@@ -21,7 +22,16 @@ void _exit(int32_t);
 extern "C" void _fini();
 
 void initMemoryManager(uint8_t *startAddress) {
-    auto *memoryManager = new (&Util::System::getAddressSpaceHeader().memoryManager) Util::FreeListMemoryManager();
+    auto &addressSpaceHeader = Util::System::getAddressSpaceHeader();
+    Util::HeapMemoryManager *memoryManager;
+
+    // The heap memory manager has been selected by the binary loader (see HHUOS_HEAP_MANAGER)
+    if (addressSpaceHeader.heapManager == Util::System::TLSF_HEAP_MANAGER) {
+        memoryManager = new (addressSpaceHeader.memoryManager) Util::TlsfMemoryManager();
+    } else {
+        memoryManager = new (addressSpaceHeader.memoryManager) Util::FreeListMemoryManager();
+    }
+
     memoryManager->initialize(startAddress, reinterpret_cast<uint8_t*>(Util::MAIN_STACK_START_ADDRESS - 1));
 }
 
@@ -20,6 +20,7 @@
 #include "lib/interface.h"
 #include "lib/util/base/System.h"
 #include "lib/util/base/Constants.h"
+#include "lib/util/base/Address.h"
 #include "lib/util/async/Runnable.h"
 #include "lib/util/io/stream/PrintStream.h"
 #include "lib/util/async/Process.h"
@@ -41,7 +42,7 @@ class Datagram;
 }  // namespace Util
 
 void* allocateMemory(uint32_t size, uint32_t alignment) {
-    return Util::System::getAddressSpaceHeader().memoryManager.allocateMemory(size, alignment);
+    return Util::System::getAddressSpaceHeader().getMemoryManager().allocateMemory(size, alignment);
 }
 
 void* reallocateMemory(void *pointer, uint32_t size, uint32_t alignment) {
@@ -49,11 +50,11 @@ void* reallocateMemory(void *pointer, uint32_t size, uint32_t alignment) {
         return allocateMemory(size, alignment);
     }
 
-    return Util::System::getAddressSpaceHeader().memoryManager.reallocateMemory(pointer, size, alignment);
+    return Util::System::getAddressSpaceHeader().getMemoryManager().reallocateMemory(pointer, size, alignment);
 }
 
 void freeMemory(void *pointer, uint32_t alignment) {
-    Util::System::getAddressSpaceHeader().memoryManager.freeMemory(pointer, alignment);
+    Util::System::getAddressSpaceHeader().getMemoryManager().freeMemory(pointer, alignment);
 }
 
 bool isMemoryManagementInitialized() {
@@ -70,6 +71,35 @@ void unmap(void *virtualAddress, uint32_t pageCount, uint32_t breakCount) {
     Util::System::call(Util::System::UNMAP, 3, virtualAddress, pageCount, breakCount);
 }
 
+void* mapMemory(uint32_t length, uint32_t flags) {
+    return mapFile(Util::String(), 0, length, flags);
+}
+
+void* mapFile(const Util::String &path, uint32_t offset, uint32_t length, uint32_t flags) {
+    // The virtual memory is taken from the heap and the kernel maps its pages on demand
+    auto *address = allocateMemory(Util::Address<uint32_t>(length).alignUp(Util::PAGESIZE).get(), Util::PAGESIZE);
+    if (address == nullptr) {
+        return nullptr;
+    }
+
+    const char *pathString = path.isEmpty() ? nullptr : static_cast<const char*>(path);
+    if (!Util::System::call(Util::System::MAP, 5, address, pathString, offset, length, flags)) {
+        freeMemory(address, Util::PAGESIZE);
+        return nullptr;
+    }
+
+    return address;
+}
+
+bool removeMapping(void *address) {
+    if (!Util::System::call(Util::System::REMOVE_MAPPING, 1, address)) {
+        return false;
+    }
+
+    freeMemory(address, Util::PAGESIZE);
+    return true;
+}
+
 bool mount(const Util::String &deviceName, const Util::String &targetPath, const Util::String &driverName) {
     return Util::System::call(Util::System::MOUNT, 3, static_cast<const char*>(deviceName), static_cast<const char*>(targetPath), static_cast<const char*>(driverName)) ;
 }
@@ -193,7 +223,7 @@ Util::Async::Thread createThread(const Util::String &name, Util::Async::Runnable
 
 Util::Async::Thread getCurrentThread() {
     uint32_t threadId;
-    Util::System::call(Util::System::GET_CURRENT_PROCESS, 1, &threadId);
+    Util::System::call(Util::System::GET_CURRENT_THREAD, 1, &threadId);
     return Util::Async::Thread(threadId);
 }
 
@@ -201,6 +231,24 @@ void joinThread(uint32_t id) {
     Util::System::call(Util::System::JOIN_THREAD, 1, id);
 }
 
+bool setThreadAffinity(uint32_t id, int16_t cpuId) {
+    return Util::System::call(Util::System::SET_THREAD_AFFINITY, 2, id, static_cast<int32_t>(cpuId));
+}
+
+bool setThreadPriority(uint32_t id, Util::Async::Thread::Priority priority) {
+    return Util::System::call(Util::System::SET_THREAD_PRIORITY, 2, id, priority);
+}
+
+bool waitOnAddress(const uint32_t *address, uint32_t expectedValue) {
+    return Util::System::call(Util::System::WAIT_ON_ADDRESS, 2, address, expectedValue);
+}
+
+uint32_t wakeAddress(const uint32_t *address, uint32_t count) {
+    uint32_t woken = 0;
+    Util::System::call(Util::System::WAKE_ADDRESS, 3, address, count, &woken);
+    return woken;
+}
+
 void joinProcess(uint32_t id) {
     Util::System::call(Util::System::JOIN_PROCESS, 1, id);
 }
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "ConditionVariable.h"
+
+#include "lib/interface.h"
+#include "lib/util/async/Mutex.h"
+
+namespace Util::Async {
+
+ConditionVariable::ConditionVariable() : sequenceWrapper(sequence), waitersWrapper(waiters) {}
+
+void ConditionVariable::wait(Mutex &mutex) {
+    waitersWrapper.inc();
+    auto currentSequence = sequenceWrapper.get();
+
+    mutex.release();
+    waitOnAddress(&sequence, currentSequence);
+    waitersWrapper.dec();
+    mutex.acquire();
+}
+
+void ConditionVariable::signal() {
+    sequenceWrapper.inc();
+    if (waitersWrapper.get() > 0) {
+        wakeAddress(&sequence, 1);
+    }
+}
+
+void ConditionVariable::signalAll() {
+    sequenceWrapper.inc();
+    if (waitersWrapper.get() > 0) {
+        wakeAddress(&sequence, UINT32_MAX);
+    }
+}
+
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_CONDITIONVARIABLE_H
+#define HHUOS_CONDITIONVARIABLE_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Atomic.h"
+
+namespace Util::Async {
+class Mutex;
+
+/**
+ * A condition variable, that blocks threads until another thread signals a change of some shared state.
+ *
+ * The shared state must be protected by a mutex, which is released while waiting and reacquired before wait() returns.
+ * Threads may return from wait() without the condition being true, so it should always be checked in a loop.
+ */
+class ConditionVariable {
+
+public:
+    /**
+     * Default Constructor.
+     */
+    ConditionVariable();
+
+    /**
+     * Copy Constructor.
+     */
+    ConditionVariable(const ConditionVariable &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    ConditionVariable &operator=(const ConditionVariable &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~ConditionVariable() = default;
+
+    /**
+     * Release the mutex and block the current thread, until the condition variable is signaled.
+     *
+     * @param mutex The mutex protecting the shared state (must be held by the current thread)
+     */
+    void wait(Mutex &mutex);
+
+    /**
+     * Wake up a single waiting thread.
+     */
+    void signal();
+
+    /**
+     * Wake up all waiting threads.
+     */
+    void signalAll();
+
+private:
+
+    uint32_t sequence = 0; // Incremented on every signal, so that waiting threads notice signals sent after they released the mutex
+    Atomic<uint32_t> sequenceWrapper;
+
+    uint32_t waiters = 0;
+    Atomic<uint32_t> waitersWrapper;
+};
+
+}
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "Mutex.h"
+
+#include "lib/interface.h"
+
+namespace Util::Async {
+
+Mutex::Mutex() : stateWrapper(state) {}
+
+void Mutex::acquire() {
+    if (tryAcquire()) {
+        return;
+    }
+
+    // Mark the mutex as contended, so that the holder wakes up a waiting thread when releasing it.
+    // Since it is unknown whether other threads are still waiting, a thread acquiring the mutex here keeps it marked as contended.
+    while (stateWrapper.getAndSet(CONTENDED) != UNLOCKED) {
+        waitOnAddress(&state, CONTENDED);
+    }
+}
+
+bool Mutex::tryAcquire() {
+    return stateWrapper.compareAndSet(UNLOCKED, LOCKED);
+}
+
+void Mutex::release() {
+    if (stateWrapper.getAndSet(UNLOCKED) == CONTENDED) {
+        wakeAddress(&state, 1);
+    }
+}
+
+bool Mutex::isLocked() const {
+    return stateWrapper.get() != UNLOCKED;
+}
+
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_MUTEX_H
+#define HHUOS_MUTEX_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Atomic.h"
+#include "Lock.h"
+
+namespace Util::Async {
+
+/**
+ * A mutual exclusion lock, that blocks waiting threads instead of letting them spin.
+ *
+ * An uncontended mutex is acquired and released with a single atomic instruction.
+ * Only if another thread already holds it, the kernel is asked to block the calling thread
+ * until the holder releases the mutex (see waitOnAddress() and wakeAddress()).
+ */
+class Mutex : public Lock {
+
+public:
+    /**
+     * Default Constructor.
+     */
+    Mutex();
+
+    /**
+     * Copy Constructor.
+     */
+    Mutex(const Mutex &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    Mutex &operator=(const Mutex &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~Mutex() override = default;
+
+    void acquire() override;
+
+    bool tryAcquire() override;
+
+    void release() override;
+
+    [[nodiscard]] bool isLocked() const override;
+
+private:
+
+    uint32_t state = UNLOCKED;
+    Atomic<uint32_t> stateWrapper;
+
+    static const constexpr uint32_t UNLOCKED = 0;
+    static const constexpr uint32_t LOCKED = 1;
+    static const constexpr uint32_t CONTENDED = 2; // Locked and at least one thread may be waiting
+};
+
+}
+
+#endif
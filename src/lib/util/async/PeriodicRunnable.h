@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_PERIODICRUNNABLE_H
+#define HHUOS_PERIODICRUNNABLE_H
+
+#include "Runnable.h"
+#include "lib/util/time/Timestamp.h"
+
+namespace Util::Async {
+
+/**
+ * Runnable for background threads, which call a function periodically (e.g. to flush caches or check for timeouts).
+ * The thread sleeps for the given interval before each call and never terminates.
+ */
+class PeriodicRunnable : public Runnable {
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param interval The time to sleep before each call
+     * @param function The function to call
+     * @param argument Passed to the function on each call (e.g. the object to work on)
+     */
+    PeriodicRunnable(const Time::Timestamp &interval, void (*function)(void *argument), void *argument = nullptr);
+
+    /**
+     * Copy Constructor.
+     */
+    PeriodicRunnable(const PeriodicRunnable &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    PeriodicRunnable &operator=(const PeriodicRunnable &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~PeriodicRunnable() override = default;
+
+    void run() override;
+
+private:
+
+    Time::Timestamp interval;
+    void (*function)(void *argument);
+    void *argument;
+};
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_SEMAPHORE_H
+#define HHUOS_SEMAPHORE_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Atomic.h"
+
+namespace Util::Async {
+
+/**
+ * A counting semaphore, that blocks threads while no permits are available.
+ */
+class Semaphore {
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param permits The number of initially available permits
+     */
+    explicit Semaphore(uint32_t permits = 0);
+
+    /**
+     * Copy Constructor.
+     */
+    Semaphore(const Semaphore &other) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    Semaphore &operator=(const Semaphore &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~Semaphore() = default;
+
+    /**
+     * Take a permit, blocking the current thread until one is available.
+     */
+    void acquire();
+
+    /**
+     * Try to take a permit without blocking.
+     *
+     * @return true, if a permit has been taken
+     */
+    bool tryAcquire();
+
+    /**
+     * Return a permit and wake up a waiting thread.
+     */
+    void release();
+
+    [[nodiscard]] uint32_t getPermits() const;
+
+private:
+
+    uint32_t permits;
+    Atomic<uint32_t> permitsWrapper;
+
+    uint32_t waiters = 0;
+    Atomic<uint32_t> waitersWrapper;
+};
+
+}
+
+#endif
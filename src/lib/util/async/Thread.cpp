@@ -55,4 +55,16 @@ void Thread::join() const {
     ::joinThread(id);
 }
 
+bool Thread::setAffinity(uint8_t cpuId) const {
+    return ::setThreadAffinity(id, cpuId);
+}
+
+bool Thread::clearAffinity() const {
+    return ::setThreadAffinity(id, -1);
+}
+
+bool Thread::setPriority(Priority priority) const {
+    return ::setThreadPriority(id, priority);
+}
+
 }
\ No newline at end of file
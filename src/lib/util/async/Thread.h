@@ -36,6 +36,20 @@ namespace Util::Async {
 class Thread {
 
 public:
+    /**
+     * Scheduling priorities. Each priority has its own level in the multilevel feedback queue of each core's scheduler.
+     * Threads, that use up their whole time slice, are moved down to lower levels (but never below LOW),
+     * while threads, that are woken up after waiting for I/O, are temporarily moved up one level.
+     */
+    enum Priority : uint8_t {
+        IDLE,
+        LOW,
+        NORMAL,
+        HIGH
+    };
+
+    static const constexpr uint8_t PRIORITY_LEVELS = HIGH + 1;
+
     /**
      * Constructor.
      */
@@ -68,6 +82,30 @@ public:
 
     void join() const;
 
+    /**
+     * Hint the schedulers to run this thread on the core with the given local APIC id.
+     * The thread is not migrated immediately, but when it is created or when the core steals work from busier cores.
+     *
+     * @param cpuId The local APIC id of the preferred core
+     * @return true, if the hint has been set
+     */
+    bool setAffinity(uint8_t cpuId) const;
+
+    /**
+     * Remove the affinity hint, so that the thread may run on any core.
+     *
+     * @return true, if the hint has been removed
+     */
+    bool clearAffinity() const;
+
+    /**
+     * Set the base priority of this thread.
+     *
+     * @param priority The new priority
+     * @return true, if the priority has been set
+     */
+    bool setPriority(Priority priority) const;
+
 private:
 
     uint32_t id;
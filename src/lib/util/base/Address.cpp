@@ -17,8 +17,173 @@
 
 #include "Address.h"
 
+#include "lib/util/hardware/CpuId.h"
+
 namespace Util {
 
+/**
+ * Memory blocks of at least this size are copied/set with 'rep movsb'/'rep stosb', if the CPU supports ERMS.
+ */
+static const constexpr uint32_t REP_STRING_THRESHOLD = 128;
+
+/**
+ * Memory blocks of at least this size are copied/set with SSE2, if available and ERMS is not supported.
+ */
+static const constexpr uint32_t SSE2_THRESHOLD = 128;
+
+/**
+ * Memory blocks of at least this size are written with non-temporal stores (if SSE2 is available),
+ * so that large copies (e.g. flushing a frame buffer) do not evict the whole cache.
+ */
+static const constexpr uint32_t NON_TEMPORAL_THRESHOLD = 256 * 1024;
+
+struct MemoryFeatures {
+    bool initialized;
+    bool enhancedRepMovsb;
+    bool sse2;
+};
+
+static MemoryFeatures memoryFeatures{};
+
+/**
+ * Detect the CPU features, that are used to accelerate setRange() and copyRange().
+ * SSE2 is only used in user mode: The kernel is compiled without SSE support and switches the FPU context lazily,
+ * so using XMM registers in kernel mode would corrupt the FPU state of the current thread.
+ */
+static const MemoryFeatures& getMemoryFeatures() {
+    if (!memoryFeatures.initialized) {
+        uint16_t codeSegment;
+        asm volatile ("mov %%cs, %0" : "=r"(codeSegment));
+        auto userMode = (codeSegment & 0x03) == 0x03;
+
+        memoryFeatures.enhancedRepMovsb = (Hardware::CpuId::getExtendedCpuFeatureBits() & Hardware::CpuId::ERMS) != 0;
+        memoryFeatures.sse2 = userMode && (Hardware::CpuId::getCpuFeatureBits() & Hardware::CpuId::SSE2) != 0;
+
+        // Concurrent initialization is harmless, since every caller detects the same features
+        asm volatile ("" : : : "memory");
+        memoryFeatures.initialized = true;
+    }
+
+    return memoryFeatures;
+}
+
+/**
+ * The XMM registers are not declared as clobbered in the following functions, since SSE is disabled for the compiler
+ * (it never keeps values in XMM registers) and they are caller-saved anyway.
+ */
+static void setRangeSse2(uint8_t *target, uint8_t value, uint32_t length, bool nonTemporal) {
+    // Fill bytes up to the next 16-byte aligned address
+    while (reinterpret_cast<uint32_t>(target) % 16 != 0) {
+        *target++ = value;
+        length--;
+    }
+
+    auto blocks = length / 64;
+    auto intValue = value * 0x01010101U;
+
+    if (blocks > 0) {
+        if (nonTemporal) {
+            asm volatile (
+                    "movd %3, %%xmm0;"
+                    "pshufd $0, %%xmm0, %%xmm0;"
+                    "1:;"
+                    "movntdq %%xmm0, (%0);"
+                    "movntdq %%xmm0, 16(%0);"
+                    "movntdq %%xmm0, 32(%0);"
+                    "movntdq %%xmm0, 48(%0);"
+                    "add $64, %0;"
+                    "dec %1;"
+                    "jnz 1b;"
+                    "sfence;"
+                    : "=r"(target), "=r"(blocks)
+                    : "0"(target), "r"(intValue), "1"(blocks)
+                    : "memory"
+                    );
+        } else {
+            asm volatile (
+                    "movd %3, %%xmm0;"
+                    "pshufd $0, %%xmm0, %%xmm0;"
+                    "1:;"
+                    "movdqa %%xmm0, (%0);"
+                    "movdqa %%xmm0, 16(%0);"
+                    "movdqa %%xmm0, 32(%0);"
+                    "movdqa %%xmm0, 48(%0);"
+                    "add $64, %0;"
+                    "dec %1;"
+                    "jnz 1b;"
+                    : "=r"(target), "=r"(blocks)
+                    : "0"(target), "r"(intValue), "1"(blocks)
+                    : "memory"
+                    );
+        }
+    }
+
+    // Fill remaining bytes
+    length %= 64;
+    while (length-- > 0) {
+        *target++ = value;
+    }
+}
+
+static void copyRangeSse2(uint8_t *target, const uint8_t *source, uint32_t length, bool nonTemporal) {
+    // Copy bytes up to the next 16-byte aligned target address (the source may still be unaligned)
+    while (reinterpret_cast<uint32_t>(target) % 16 != 0) {
+        *target++ = *source++;
+        length--;
+    }
+
+    auto blocks = length / 64;
+
+    if (blocks > 0) {
+        if (nonTemporal) {
+            asm volatile (
+                    "1:;"
+                    "movdqu (%1), %%xmm0;"
+                    "movdqu 16(%1), %%xmm1;"
+                    "movdqu 32(%1), %%xmm2;"
+                    "movdqu 48(%1), %%xmm3;"
+                    "movntdq %%xmm0, (%0);"
+                    "movntdq %%xmm1, 16(%0);"
+                    "movntdq %%xmm2, 32(%0);"
+                    "movntdq %%xmm3, 48(%0);"
+                    "add $64, %1;"
+                    "add $64, %0;"
+                    "dec %2;"
+                    "jnz 1b;"
+                    "sfence;"
+                    : "+r"(target), "+r"(source), "+r"(blocks)
+                    :
+                    : "memory"
+                    );
+        } else {
+            asm volatile (
+                    "1:;"
+                    "movdqu (%1), %%xmm0;"
+                    "movdqu 16(%1), %%xmm1;"
+                    "movdqu 32(%1), %%xmm2;"
+                    "movdqu 48(%1), %%xmm3;"
+                    "movdqa %%xmm0, (%0);"
+                    "movdqa %%xmm1, 16(%0);"
+                    "movdqa %%xmm2, 32(%0);"
+                    "movdqa %%xmm3, 48(%0);"
+                    "add $64, %1;"
+                    "add $64, %0;"
+                    "dec %2;"
+                    "jnz 1b;"
+                    : "+r"(target), "+r"(source), "+r"(blocks)
+                    :
+                    : "memory"
+                    );
+        }
+    }
+
+    // Copy remaining bytes
+    length %= 64;
+    while (length-- > 0) {
+        *target++ = *source++;
+    }
+}
+
 template<typename T>
 Address<T>::Address(T address) : address(address) {}
 
@@ -145,6 +310,20 @@ void Address<T>::setRange(uint8_t value, T length) const {
         return;
     }
 
+    const auto &features = getMemoryFeatures();
+    if (features.sse2 && length >= NON_TEMPORAL_THRESHOLD) {
+        setRangeSse2(reinterpret_cast<uint8_t*>(address), value, length, true);
+        return;
+    } else if (features.enhancedRepMovsb && length >= REP_STRING_THRESHOLD) {
+        auto *target = reinterpret_cast<uint8_t*>(address);
+        uint32_t count = length;
+        asm volatile ("rep stosb" : "+D"(target), "+c"(count) : "a"(value) : "memory");
+        return;
+    } else if (features.sse2 && length >= SSE2_THRESHOLD) {
+        setRangeSse2(reinterpret_cast<uint8_t*>(address), value, length, false);
+        return;
+    }
+
     // Variables needed to fill the bytes up to the next 8-byte aligned address
     auto alignDifference = address % 8; // Number of bytes to next 8-byte aligned address
     auto beforeAlignTarget = reinterpret_cast<uint8_t*>(address); // Start of the memory block (used to fill the bytes before the 8-byte aligned address)
@@ -188,6 +367,21 @@ void Address<T>::copyRange(const Address<T> &sourceAddress, T length) const {
         return;
     }
 
+    const auto &features = getMemoryFeatures();
+    if (features.sse2 && length >= NON_TEMPORAL_THRESHOLD) {
+        copyRangeSse2(reinterpret_cast<uint8_t*>(address), reinterpret_cast<uint8_t*>(sourceAddress.get()), length, true);
+        return;
+    } else if (features.enhancedRepMovsb && length >= REP_STRING_THRESHOLD) {
+        auto *target = reinterpret_cast<uint8_t*>(address);
+        auto *source = reinterpret_cast<uint8_t*>(sourceAddress.get());
+        uint32_t count = length;
+        asm volatile ("rep movsb" : "+D"(target), "+S"(source), "+c"(count) : : "memory");
+        return;
+    } else if (features.sse2 && length >= SSE2_THRESHOLD) {
+        copyRangeSse2(reinterpret_cast<uint8_t*>(address), reinterpret_cast<uint8_t*>(sourceAddress.get()), length, false);
+        return;
+    }
+
     // Variables needed to fill the bytes up to the next 8-byte aligned address
     auto alignDifference = address % 8; // Number of bytes to next 8-byte aligned address
     auto beforeAlignSource = reinterpret_cast<uint8_t*>(sourceAddress.get()); // Start of the source memory block (used to copy the bytes before the 8-byte aligned address)
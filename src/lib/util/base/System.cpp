@@ -129,4 +129,8 @@ System::AddressSpaceHeader &System::getAddressSpaceHeader() {
     return *reinterpret_cast<AddressSpaceHeader*>(USER_SPACE_MEMORY_START_ADDRESS);
 }
 
+HeapMemoryManager &System::AddressSpaceHeader::getMemoryManager() {
+    return *reinterpret_cast<HeapMemoryManager*>(memoryManager);
+}
+
 }
\ No newline at end of file
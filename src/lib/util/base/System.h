@@ -24,6 +24,7 @@
 #include "lib/util/io/stream/InputStream.h" // IWYU pragma: keep
 #include "lib/util/io/stream/PrintStream.h" // IWYU pragma: keep
 #include "FreeListMemoryManager.h"
+#include "TlsfMemoryManager.h"
 
 namespace Util {
 namespace Io {
@@ -53,6 +54,12 @@ public:
         JOIN_PROCESS,
         KILL_PROCESS,
         SLEEP,
+        SET_THREAD_AFFINITY,
+        SET_THREAD_PRIORITY,
+        WAIT_ON_ADDRESS,
+        WAKE_ADDRESS,
+        MAP,
+        REMOVE_MAPPING,
         UNMAP,
         MAP_IO,
         MOUNT,
@@ -79,13 +86,50 @@ public:
         SHUTDOWN
     };
 
+    /**
+     * Options for memory mappings created via mapFile() and mapMemory().
+     * Mappings without MAP_SHARED are private: Modifications are not visible to other processes and not written back.
+     */
+    enum MappingFlag : uint32_t {
+        MAP_WRITABLE = 0x01,
+        MAP_SHARED = 0x02
+    };
+
+    /**
+     * Heap memory managers, that an application can choose from (see HHUOS_HEAP_MANAGER).
+     */
+    enum HeapManager : uint32_t {
+        FREE_LIST_HEAP_MANAGER,
+        TLSF_HEAP_MANAGER
+    };
+
+    static const constexpr uint32_t HEAP_MANAGER_SIZE = sizeof(FreeListMemoryManager) > sizeof(TlsfMemoryManager) ? sizeof(FreeListMemoryManager) : sizeof(TlsfMemoryManager);
+
     struct AddressSpaceHeader {
-        FreeListMemoryManager memoryManager;
+        // Storage for the heap memory manager, which is constructed by the runtime according to 'heapManager'
+        alignas(HeapMemoryManager) uint8_t memoryManager[HEAP_MANAGER_SIZE];
+        HeapManager heapManager;
         uint32_t symbolTableSize;
         const Util::Io::Elf::SymbolEntry *symbolTable;
         const char *stringTable;
+
+        [[nodiscard]] HeapMemoryManager& getMemoryManager();
     };
 
+    /**
+     * ELF note, which is placed in the '.note.hhuos' section by HHUOS_HEAP_MANAGER and read by the kernel's binary loader.
+     */
+    struct HeapManagerNote {
+        uint32_t nameSize;
+        uint32_t descriptionSize;
+        uint32_t type;
+        char name[8];
+        HeapManager heapManager;
+    };
+
+    static const constexpr char *NOTE_NAME = "hhuOS";
+    static const constexpr uint32_t HEAP_MANAGER_NOTE_TYPE = 1;
+
     /**
      * Default Constructor.
      * Deleted, as this class has only static members.
@@ -140,4 +184,16 @@ private:
 
 }
 
+/**
+ * Select the heap memory manager for an application by placing this macro in one of its source files (at file scope).
+ * Without it, applications use the FreeListMemoryManager.
+ *
+ * Example: HHUOS_HEAP_MANAGER(TLSF_HEAP_MANAGER)
+ */
+#define HHUOS_HEAP_MANAGER(MANAGER) \
+    [[gnu::used, gnu::section(".note.hhuos"), gnu::aligned(4)]] \
+    static const Util::System::HeapManagerNote hhuosHeapManagerNote = { \
+        6, sizeof(Util::System::HeapManager), Util::System::HEAP_MANAGER_NOTE_TYPE, "hhuOS", Util::System::MANAGER \
+    };
+
 #endif
@@ -0,0 +1,412 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "TlsfMemoryManager.h"
+
+#include "lib/util/base/Address.h"
+#include "lib/interface.h"
+#include "lib/util/base/Constants.h"
+#include "lib/util/base/Exception.h"
+
+namespace Util {
+
+uint32_t TlsfMemoryManager::BlockHeader::getSize() const {
+    return size & SIZE_MASK;
+}
+
+bool TlsfMemoryManager::BlockHeader::isFree() const {
+    return (size & BLOCK_FREE) != 0;
+}
+
+bool TlsfMemoryManager::BlockHeader::isPreviousFree() const {
+    return (size & PREVIOUS_BLOCK_FREE) != 0;
+}
+
+uint8_t* TlsfMemoryManager::BlockHeader::getPayload() {
+    return reinterpret_cast<uint8_t*>(this) + HEADER_SIZE;
+}
+
+TlsfMemoryManager::BlockHeader* TlsfMemoryManager::BlockHeader::getNextPhysical() {
+    return reinterpret_cast<BlockHeader*>(getPayload() + getSize());
+}
+
+TlsfMemoryManager::BlockHeader* TlsfMemoryManager::BlockHeader::fromPayload(void *ptr) {
+    return reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(ptr) - HEADER_SIZE);
+}
+
+void TlsfMemoryManager::initialize(uint8_t *startAddress, uint8_t *endAddress) {
+    this->startAddress = startAddress;
+    this->endAddress = endAddress;
+
+    auto controlAddress = Address<uint32_t>(startAddress).alignUp(ALIGNMENT).get();
+    auto firstBlockAddress = Address<uint32_t>(controlAddress + sizeof(Control)).alignUp(ALIGNMENT).get();
+    auto heapEnd = reinterpret_cast<uint32_t>(endAddress) + 1;
+
+    if (heapEnd < firstBlockAddress || heapEnd - firstBlockAddress < 2 * HEADER_SIZE + MIN_BLOCK_SIZE) {
+        Util::Exception::throwException(Util::Exception::ILLEGAL_STATE, "TlsfMemoryManager: Heap is too small!");
+    }
+
+    control = reinterpret_cast<Control*>(controlAddress);
+    control->firstLevelBitmap = 0;
+    for (uint32_t i = 0; i < FIRST_LEVEL_COUNT; i++) {
+        control->secondLevelBitmaps[i] = 0;
+        for (uint32_t j = 0; j < SECOND_LEVEL_COUNT; j++) {
+            control->freeLists[i][j] = nullptr;
+        }
+    }
+
+    // The whole heap is a single free block, followed by an empty sentinel block, which is never free.
+    // The sentinel stops merging at the end of the heap, so that no boundary checks are necessary.
+    auto blockSize = (heapEnd - firstBlockAddress - 2 * HEADER_SIZE) & SIZE_MASK;
+    if (blockSize > MAX_BLOCK_SIZE) {
+        blockSize = MAX_BLOCK_SIZE;
+    }
+
+    auto *block = reinterpret_cast<BlockHeader*>(firstBlockAddress);
+    block->previousPhysical = nullptr;
+    block->size = blockSize;
+
+    auto *sentinel = block->getNextPhysical();
+    sentinel->previousPhysical = block;
+    sentinel->size = 0;
+
+    freeBytes = 0;
+    releaseBlock(block);
+}
+
+void* TlsfMemoryManager::allocateMemory(uint32_t size, uint32_t alignment) {
+    lock.acquire();
+    void *ret = allocAlgorithm(size, alignment);
+    lock.release();
+
+    if (size > 0 && ret == nullptr) {
+        Util::Exception::throwException(Exception::OUT_OF_MEMORY, "TlsfMemoryManager: Allocation failed!");
+    } else if (size > 0 && (ret < getStartAddress() || ret > getEndAddress())) {
+        Util::Exception::throwException(Exception::ILLEGAL_STATE, "TlsfMemoryManager: Allocated memory outside of heap boundaries!");
+    }
+
+    return ret;
+}
+
+void* TlsfMemoryManager::reallocateMemory(void *ptr, uint32_t size, uint32_t alignment) {
+    if (ptr == nullptr) {
+        return allocateMemory(size, alignment);
+    }
+
+    if (size == 0) {
+        freeMemory(ptr, alignment);
+        return nullptr;
+    }
+
+    if (ptr < startAddress || ptr > endAddress) {
+        Util::Exception::throwException(Exception::OUT_OF_BOUNDS, "realloc: Trying to reallocate memory outside of heap boundaries");
+    }
+
+    lock.acquire();
+    auto *block = BlockHeader::fromPayload(ptr);
+    auto adjustedSize = adjustSize(size);
+    auto oldSize = block->getSize();
+
+    // Try to resize the block in place (shrinking or growing into a free successor)
+    if (adjustedSize != 0 && (alignment <= ALIGNMENT || reinterpret_cast<uint32_t>(ptr) % alignment == 0)) {
+        auto *next = block->getNextPhysical();
+        auto availableSize = oldSize + (next->isFree() ? HEADER_SIZE + next->getSize() : 0);
+
+        if (adjustedSize <= availableSize) {
+            if (adjustedSize > oldSize) {
+                removeFreeBlock(next);
+                block->size += HEADER_SIZE + next->getSize();
+
+                next = block->getNextPhysical();
+                next->previousPhysical = block;
+                next->size &= ~PREVIOUS_BLOCK_FREE;
+            }
+
+            trimBlock(block, adjustedSize);
+            lock.release();
+            return ptr;
+        }
+    }
+
+    auto *ret = allocAlgorithm(size, alignment);
+    if (ret == nullptr) {
+        lock.release();
+        Util::Exception::throwException(Exception::OUT_OF_MEMORY, "TlsfMemoryManager: Reallocation failed!");
+    }
+
+    auto targetAddress = Address<uint32_t>(ret);
+    targetAddress.copyRange(Address<uint32_t>(ptr), oldSize < size ? oldSize : size);
+    freeAlgorithm(ptr);
+
+    lock.release();
+    return ret;
+}
+
+void TlsfMemoryManager::freeMemory(void *ptr, [[maybe_unused]] uint32_t alignment) {
+    lock.acquire();
+    freeAlgorithm(ptr);
+    lock.release();
+}
+
+void* TlsfMemoryManager::allocAlgorithm(uint32_t size, uint32_t alignment) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    auto adjustedSize = adjustSize(size);
+    if (adjustedSize == 0) {
+        return nullptr;
+    }
+
+    if (alignment <= ALIGNMENT) {
+        auto *block = findFreeBlock(adjustedSize);
+        if (block == nullptr) {
+            return nullptr;
+        }
+
+        removeFreeBlock(block);
+        useBlock(block, adjustedSize);
+        return block->getPayload();
+    }
+
+    // Search a block, that is large enough to split off a free block in front of the aligned payload
+    auto gapSize = HEADER_SIZE + MIN_BLOCK_SIZE;
+    if (adjustedSize > MAX_BLOCK_SIZE - alignment - gapSize) {
+        return nullptr;
+    }
+
+    auto *block = findFreeBlock(adjustedSize + alignment + gapSize);
+    if (block == nullptr) {
+        return nullptr;
+    }
+
+    removeFreeBlock(block);
+
+    auto payload = reinterpret_cast<uint32_t>(block->getPayload());
+    auto alignedPayload = Address<uint32_t>(payload).alignUp(alignment).get();
+    if (alignedPayload != payload && alignedPayload - payload < gapSize) {
+        alignedPayload = Address<uint32_t>(payload + gapSize).alignUp(alignment).get();
+    }
+
+    if (alignedPayload != payload) {
+        auto gap = alignedPayload - payload;
+        auto *alignedBlock = BlockHeader::fromPayload(reinterpret_cast<void*>(alignedPayload));
+        alignedBlock->previousPhysical = block;
+        alignedBlock->size = block->getSize() - gap;
+        alignedBlock->getNextPhysical()->previousPhysical = alignedBlock;
+
+        // The leading block keeps its flags (its predecessor cannot be free, since free blocks are always merged)
+        block->size = (block->size & ~SIZE_MASK) | (gap - HEADER_SIZE);
+        block->size |= BLOCK_FREE;
+        insertFreeBlock(block);
+
+        alignedBlock->size |= PREVIOUS_BLOCK_FREE;
+        block = alignedBlock;
+    }
+
+    useBlock(block, adjustedSize);
+    return block->getPayload();
+}
+
+void TlsfMemoryManager::freeAlgorithm(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    if (ptr < startAddress || ptr > endAddress) {
+        Util::Exception::throwException(Exception::OUT_OF_BOUNDS, "free: Trying to free memory outside of heap boundaries");
+    }
+
+    auto *block = BlockHeader::fromPayload(ptr);
+    if (block->isFree()) {
+        Util::Exception::throwException(Exception::ILLEGAL_STATE, "free: Trying to free an unused block of memory");
+    }
+
+    auto *mergedBlock = releaseBlock(block);
+
+    // If the free block spans at least one page, its memory can possibly be unmapped (but not the free list pointers!)
+    if (unmapFreedMemory && mergedBlock->getSize() >= Util::PAGESIZE && isMemoryManagementInitialized()) {
+        auto unmapSize = mergedBlock->getSize() - MIN_BLOCK_SIZE;
+        unmap(mergedBlock->getPayload() + MIN_BLOCK_SIZE, unmapSize / Util::PAGESIZE, 8);
+    }
+}
+
+void TlsfMemoryManager::mapInsert(uint32_t size, uint32_t &firstLevel, uint32_t &secondLevel) {
+    if (size < SMALL_BLOCK_SIZE) {
+        // Small blocks are stored in the first list, which is linearly subdivided
+        firstLevel = 0;
+        secondLevel = size / (SMALL_BLOCK_SIZE / SECOND_LEVEL_COUNT);
+    } else {
+        auto mostSignificantBit = 31 - __builtin_clz(size);
+        secondLevel = (size >> (mostSignificantBit - SECOND_LEVEL_LOG2)) ^ (1 << SECOND_LEVEL_LOG2);
+        firstLevel = mostSignificantBit - (FIRST_LEVEL_SHIFT - 1);
+    }
+}
+
+void TlsfMemoryManager::mapSearch(uint32_t size, uint32_t &firstLevel, uint32_t &secondLevel) {
+    if (size >= SMALL_BLOCK_SIZE) {
+        auto mostSignificantBit = 31 - __builtin_clz(size);
+        size += (1 << (mostSignificantBit - SECOND_LEVEL_LOG2)) - 1;
+    }
+
+    mapInsert(size, firstLevel, secondLevel);
+}
+
+uint32_t TlsfMemoryManager::adjustSize(uint32_t size) {
+    if (size > MAX_BLOCK_SIZE) {
+        return 0;
+    }
+
+    auto adjustedSize = (size + ALIGNMENT - 1) & SIZE_MASK;
+    return adjustedSize < MIN_BLOCK_SIZE ? MIN_BLOCK_SIZE : adjustedSize;
+}
+
+TlsfMemoryManager::BlockHeader* TlsfMemoryManager::findFreeBlock(uint32_t size) {
+    uint32_t firstLevel, secondLevel;
+    mapSearch(size, firstLevel, secondLevel);
+    if (firstLevel >= FIRST_LEVEL_COUNT) {
+        return nullptr;
+    }
+
+    // Search the second level for a list with sufficiently large blocks, falling back to the next larger first level
+    auto secondLevelMap = control->secondLevelBitmaps[firstLevel] & (~0U << secondLevel);
+    if (secondLevelMap == 0) {
+        auto firstLevelMap = firstLevel + 1 < FIRST_LEVEL_COUNT ? control->firstLevelBitmap & (~0U << (firstLevel + 1)) : 0;
+        if (firstLevelMap == 0) {
+            return nullptr;
+        }
+
+        firstLevel = __builtin_ctz(firstLevelMap);
+        secondLevelMap = control->secondLevelBitmaps[firstLevel];
+    }
+
+    secondLevel = __builtin_ctz(secondLevelMap);
+    return control->freeLists[firstLevel][secondLevel];
+}
+
+void TlsfMemoryManager::insertFreeBlock(BlockHeader *block) {
+    uint32_t firstLevel, secondLevel;
+    mapInsert(block->getSize(), firstLevel, secondLevel);
+
+    auto *head = control->freeLists[firstLevel][secondLevel];
+    block->nextFree = head;
+    block->previousFree = nullptr;
+    if (head != nullptr) {
+        head->previousFree = block;
+    }
+
+    control->freeLists[firstLevel][secondLevel] = block;
+    control->firstLevelBitmap |= 1U << firstLevel;
+    control->secondLevelBitmaps[firstLevel] |= 1U << secondLevel;
+    freeBytes += block->getSize();
+}
+
+void TlsfMemoryManager::removeFreeBlock(BlockHeader *block) {
+    uint32_t firstLevel, secondLevel;
+    mapInsert(block->getSize(), firstLevel, secondLevel);
+
+    if (block->previousFree != nullptr) {
+        block->previousFree->nextFree = block->nextFree;
+    }
+
+    if (block->nextFree != nullptr) {
+        block->nextFree->previousFree = block->previousFree;
+    }
+
+    if (control->freeLists[firstLevel][secondLevel] == block) {
+        control->freeLists[firstLevel][secondLevel] = block->nextFree;
+
+        if (block->nextFree == nullptr) {
+            control->secondLevelBitmaps[firstLevel] &= ~(1U << secondLevel);
+            if (control->secondLevelBitmaps[firstLevel] == 0) {
+                control->firstLevelBitmap &= ~(1U << firstLevel);
+            }
+        }
+    }
+
+    freeBytes -= block->getSize();
+}
+
+void TlsfMemoryManager::useBlock(BlockHeader *block, uint32_t size) {
+    block->size &= ~BLOCK_FREE;
+    block->getNextPhysical()->size &= ~PREVIOUS_BLOCK_FREE;
+    trimBlock(block, size);
+}
+
+void TlsfMemoryManager::trimBlock(BlockHeader *block, uint32_t size) {
+    if (block->getSize() < size + HEADER_SIZE + MIN_BLOCK_SIZE) {
+        return;
+    }
+
+    auto remainingSize = block->getSize() - size - HEADER_SIZE;
+    block->size = (block->size & ~SIZE_MASK) | size;
+
+    auto *remainingBlock = block->getNextPhysical();
+    remainingBlock->previousPhysical = block;
+    remainingBlock->size = remainingSize;
+    releaseBlock(remainingBlock);
+}
+
+TlsfMemoryManager::BlockHeader* TlsfMemoryManager::releaseBlock(BlockHeader *block) {
+    block->size |= BLOCK_FREE;
+
+    if (block->isPreviousFree()) {
+        auto *previous = block->previousPhysical;
+        removeFreeBlock(previous);
+        previous->size += HEADER_SIZE + block->getSize();
+        block = previous;
+    }
+
+    auto *next = block->getNextPhysical();
+    if (next->isFree()) {
+        removeFreeBlock(next);
+        block->size += HEADER_SIZE + next->getSize();
+        next = block->getNextPhysical();
+    }
+
+    next->previousPhysical = block;
+    next->size |= PREVIOUS_BLOCK_FREE;
+    insertFreeBlock(block);
+
+    return block;
+}
+
+uint32_t TlsfMemoryManager::getTotalMemory() const {
+    return endAddress - startAddress + 1;
+}
+
+uint32_t TlsfMemoryManager::getFreeMemory() const {
+    return freeBytes;
+}
+
+uint8_t* TlsfMemoryManager::getStartAddress() const {
+    return startAddress;
+}
+
+uint8_t* TlsfMemoryManager::getEndAddress() const {
+    return endAddress;
+}
+
+void TlsfMemoryManager::disableAutomaticUnmapping() {
+    unmapFreedMemory = false;
+}
+
+bool TlsfMemoryManager::isLocked() const {
+    return lock.isLocked();
+}
+
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_TLSFMEMORYMANAGER_H
+#define HHUOS_TLSFMEMORYMANAGER_H
+
+#include <stdint.h>
+
+#include "lib/util/async/Spinlock.h"
+#include "HeapMemoryManager.h"
+#include "lib/util/base/String.h"
+#include "lib/util/reflection/Prototype.h"
+
+namespace Util {
+
+/**
+ * Memory manager, that uses the two-level segregated fit (TLSF) algorithm.
+ *
+ * Free blocks are kept in segregated lists, indexed by a first level (power of two) and a second level
+ * (linear subdivision of each power of two). Two levels of bitmaps allow finding a fitting list in constant time,
+ * so that allocation and deallocation do not depend on the number of free blocks (unlike FreeListMemoryManager,
+ * which has to traverse its list). Freed blocks are merged with their physical neighbours immediately.
+ *
+ * The control structure with all list heads is stored at the beginning of the managed memory,
+ * so that instances of this class are not larger than other heap memory managers.
+ */
+class TlsfMemoryManager : public HeapMemoryManager {
+
+public:
+    /**
+     * Constructor.
+     */
+    TlsfMemoryManager() = default;
+
+    /**
+     * Copy Constructor.
+     */
+    TlsfMemoryManager(const TlsfMemoryManager &copy) = delete;
+
+    /**
+     * Assignment operator.
+     */
+    TlsfMemoryManager& operator=(const TlsfMemoryManager &other) = delete;
+
+    /**
+     * Destructor.
+     */
+    ~TlsfMemoryManager() override = default;
+
+    PROTOTYPE_IMPLEMENT_CLONE(TlsfMemoryManager);
+
+    PROTOTYPE_IMPLEMENT_GET_CLASS_NAME("Util::TlsfMemoryManager")
+
+    /**
+     * Overriding function from HeapMemoryManager.
+     */
+    void initialize(uint8_t *startAddress, uint8_t *endAddress) override;
+
+    /**
+     * Overriding function from HeapMemoryManager.
+     */
+    [[nodiscard]] void* allocateMemory(uint32_t size, uint32_t alignment) override;
+
+    /**
+     * Overriding function from HeapMemoryManager.
+     */
+    [[nodiscard]] void* reallocateMemory(void *ptr, uint32_t size, uint32_t alignment) override;
+
+    /**
+     * Overriding function from HeapMemoryManager.
+     */
+    void freeMemory(void *ptr, uint32_t alignment) override;
+
+    /**
+     * Overriding function from MemoryManager.
+     */
+    [[nodiscard]] uint32_t getTotalMemory() const override;
+
+    /**
+     * Overriding function from MemoryManager.
+     */
+    [[nodiscard]] uint32_t getFreeMemory() const override;
+
+    /**
+     * Overriding function from MemoryManager.
+     */
+    [[nodiscard]] uint8_t* getStartAddress() const override;
+
+    /**
+     * Overriding function from MemoryManager.
+     */
+    [[nodiscard]] uint8_t* getEndAddress() const override;
+
+    /**
+     * Overriding function from MemoryManager.
+     */
+    [[nodiscard]] bool isLocked() const override;
+
+    void disableAutomaticUnmapping();
+
+private:
+    /**
+     * Header of a block of memory. Blocks are physically adjacent, so that the next block can be found by adding
+     * the size to the payload address. The free list pointers are only valid for free blocks and are stored
+     * in the payload, so that the overhead of a used block is only 'HEADER_SIZE' bytes.
+     */
+    struct BlockHeader {
+        BlockHeader *previousPhysical;
+        uint32_t size;
+        BlockHeader *nextFree;
+        BlockHeader *previousFree;
+
+        [[nodiscard]] uint32_t getSize() const;
+
+        [[nodiscard]] bool isFree() const;
+
+        [[nodiscard]] bool isPreviousFree() const;
+
+        [[nodiscard]] uint8_t* getPayload();
+
+        [[nodiscard]] BlockHeader* getNextPhysical();
+
+        static BlockHeader* fromPayload(void *ptr);
+    };
+
+    static const constexpr uint32_t ALIGNMENT = 8;
+    static const constexpr uint32_t SECOND_LEVEL_LOG2 = 4;
+    static const constexpr uint32_t SECOND_LEVEL_COUNT = 1 << SECOND_LEVEL_LOG2;
+    static const constexpr uint32_t FIRST_LEVEL_SHIFT = 7;
+    static const constexpr uint32_t FIRST_LEVEL_COUNT = 32 - FIRST_LEVEL_SHIFT + 1;
+    static const constexpr uint32_t SMALL_BLOCK_SIZE = 1 << FIRST_LEVEL_SHIFT;
+    static const constexpr uint32_t MAX_BLOCK_SIZE = 1U << 31;
+
+    static const constexpr uint32_t BLOCK_FREE = 0x01;
+    static const constexpr uint32_t PREVIOUS_BLOCK_FREE = 0x02;
+    static const constexpr uint32_t SIZE_MASK = ~(ALIGNMENT - 1);
+
+    static const constexpr uint32_t HEADER_SIZE = sizeof(BlockHeader*) + sizeof(uint32_t);
+    static const constexpr uint32_t MIN_BLOCK_SIZE = sizeof(BlockHeader) - HEADER_SIZE;
+
+    /**
+     * Bitmaps and heads of all segregated free lists.
+     */
+    struct Control {
+        uint32_t firstLevelBitmap;
+        uint32_t secondLevelBitmaps[FIRST_LEVEL_COUNT];
+        BlockHeader *freeLists[FIRST_LEVEL_COUNT][SECOND_LEVEL_COUNT];
+    };
+
+    void* allocAlgorithm(uint32_t size, uint32_t alignment);
+
+    void freeAlgorithm(void *ptr);
+
+    /**
+     * Calculate the list indices for a block of the given size (used for inserting free blocks).
+     */
+    static void mapInsert(uint32_t size, uint32_t &firstLevel, uint32_t &secondLevel);
+
+    /**
+     * Calculate the list indices for a request of the given size. The size is rounded up to the next list,
+     * so that every block in the resulting list (or any larger list) is large enough.
+     */
+    static void mapSearch(uint32_t size, uint32_t &firstLevel, uint32_t &secondLevel);
+
+    [[nodiscard]] static uint32_t adjustSize(uint32_t size);
+
+    BlockHeader* findFreeBlock(uint32_t size);
+
+    void insertFreeBlock(BlockHeader *block);
+
+    void removeFreeBlock(BlockHeader *block);
+
+    /**
+     * Mark a block as used and return its unneeded tail to the free lists, if it is large enough to form a block.
+     */
+    void useBlock(BlockHeader *block, uint32_t size);
+
+    /**
+     * Split off the part of a used block, that exceeds the given size, and release it as a new free block.
+     */
+    void trimBlock(BlockHeader *block, uint32_t size);
+
+    /**
+     * Mark a block as free, merge it with its free physical neighbours and insert the result into the free lists.
+     *
+     * @return The merged block
+     */
+    BlockHeader* releaseBlock(BlockHeader *block);
+
+    uint8_t *startAddress{};
+    uint8_t *endAddress{};
+
+    Util::Async::Spinlock lock;
+    Control *control = nullptr;
+    uint32_t freeBytes = 0;
+    bool unmapFreedMemory = true;
+};
+
+}
+
+#endif
@@ -81,10 +81,10 @@ public:
 
     [[nodiscard]] Array<T> toArray() const override;
 
-private:
-
     void ensureCapacity(uint32_t newCapacity) override;
 
+private:
+
     T *elements = nullptr;
     uint32_t capacity = 0;
     uint32_t length = 0;
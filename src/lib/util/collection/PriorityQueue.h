@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2018-2024 Heinrich-Heine-Universitaet Duesseldorf,
+ * Institute of Computer Science, Department Operating Systems
+ * Burak Akguel, Christian Gesse, Fabian Ruhland, Filip Krakowski, Michael Schoettner
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef HHUOS_PRIORITYQUEUE_H
+#define HHUOS_PRIORITYQUEUE_H
+
+#include <stdint.h>
+
+#include "Queue.h"
+#include "ArrayList.h"
+#include "lib/util/async/Thread.h"
+
+namespace Util {
+
+/**
+ * A queue, that always returns its smallest element first (according to 'operator<').
+ * It is implemented as a binary min-heap on top of an ArrayList, so offering and polling
+ * elements takes O(log n) time, while peeking at the smallest element takes O(1) time.
+ * Removing an arbitrary element requires a linear search for the element.
+ */
+template <typename T>
+class PriorityQueue : public Queue<T> {
+
+public:
+
+    PriorityQueue();
+
+    explicit PriorityQueue(uint32_t capacity);
+
+    ~PriorityQueue() = default;
+
+    PriorityQueue(const PriorityQueue<T> &other) = delete;
+
+    PriorityQueue<T> &operator=(const PriorityQueue<T> &other) = delete;
+
+    bool offer(const T &element) override;
+
+    T poll() override;
+
+    T peek() override;
+
+    bool add(const T &element) override;
+
+    bool addAll(const Collection<T> &other) override;
+
+    bool remove(const T &element) override;
+
+    bool removeAll(const Collection<T> &other) override;
+
+    [[nodiscard]] bool contains(const T &element) const override;
+
+    [[nodiscard]] bool containsAll(const Collection<T> &other) const override;
+
+    [[nodiscard]] bool isEmpty() const override;
+
+    void clear() override;
+
+    Iterator<T> begin() const override;
+
+    Iterator<T> end() const override;
+
+    [[nodiscard]] uint32_t size() const override;
+
+    [[nodiscard]] Array<T> toArray() const override;
+
+    void ensureCapacity(uint32_t capacity);
+
+private:
+
+    void removeIndex(uint32_t index);
+
+    void siftUp(uint32_t index);
+
+    void siftDown(uint32_t index);
+
+    void swap(uint32_t first, uint32_t second);
+
+    ArrayList<T> elements;
+
+    static const uint32_t DEFAULT_CAPACITY = 16;
+};
+
+template<class T>
+PriorityQueue<T>::PriorityQueue() : elements(DEFAULT_CAPACITY) {}
+
+template<class T>
+PriorityQueue<T>::PriorityQueue(uint32_t capacity) : elements(capacity) {}
+
+template<class T>
+bool PriorityQueue<T>::offer(const T &element) {
+    elements.add(element);
+    siftUp(elements.size() - 1);
+    return true;
+}
+
+template<class T>
+T PriorityQueue<T>::poll() {
+    while (isEmpty()) {
+        Util::Async::Thread::yield();
+    }
+
+    T element = elements.get(0);
+    removeIndex(0);
+
+    return element;
+}
+
+template<class T>
+T PriorityQueue<T>::peek() {
+    while (isEmpty()) {
+        Util::Async::Thread::yield();
+    }
+
+    return elements.get(0);
+}
+
+template<class T>
+bool PriorityQueue<T>::add(const T &element) {
+    return offer(element);
+}
+
+template<class T>
+bool PriorityQueue<T>::addAll(const Collection<T> &other) {
+    for (const T &element : other) {
+        offer(element);
+    }
+
+    return true;
+}
+
+template<class T>
+bool PriorityQueue<T>::remove(const T &element) {
+    auto index = elements.indexOf(element);
+    if (index >= elements.size()) {
+        return false;
+    }
+
+    removeIndex(index);
+    return true;
+}
+
+template<class T>
+bool PriorityQueue<T>::removeAll(const Collection<T> &other) {
+    bool changed = false;
+    for (const T &element : other) {
+        if (remove(element)) {
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+template<class T>
+bool PriorityQueue<T>::contains(const T &element) const {
+    return elements.contains(element);
+}
+
+template<class T>
+bool PriorityQueue<T>::containsAll(const Collection<T> &other) const {
+    return elements.containsAll(other);
+}
+
+template<class T>
+bool PriorityQueue<T>::isEmpty() const {
+    return elements.isEmpty();
+}
+
+template<class T>
+void PriorityQueue<T>::clear() {
+    elements.clear();
+}
+
+template<class T>
+Iterator<T> PriorityQueue<T>::begin() const {
+    return elements.begin();
+}
+
+template<class T>
+Iterator<T> PriorityQueue<T>::end() const {
+    return elements.end();
+}
+
+template<class T>
+uint32_t PriorityQueue<T>::size() const {
+    return elements.size();
+}
+
+template<class T>
+Array<T> PriorityQueue<T>::toArray() const {
+    return elements.toArray();
+}
+
+template<class T>
+void PriorityQueue<T>::ensureCapacity(uint32_t capacity) {
+    elements.ensureCapacity(capacity);
+}
+
+template<class T>
+void PriorityQueue<T>::removeIndex(uint32_t index) {
+    // Replace the removed element with the last one and restore the heap property
+    auto last = elements.size() - 1;
+    if (index != last) {
+        swap(index, last);
+    }
+
+    elements.removeIndex(last);
+    if (index < elements.size()) {
+        siftDown(index);
+        siftUp(index);
+    }
+}
+
+template<class T>
+void PriorityQueue<T>::siftUp(uint32_t index) {
+    while (index > 0) {
+        auto parent = (index - 1) / 2;
+        if (!(elements.get(index) < elements.get(parent))) {
+            return;
+        }
+
+        swap(index, parent);
+        index = parent;
+    }
+}
+
+template<class T>
+void PriorityQueue<T>::siftDown(uint32_t index) {
+    while (true) {
+        auto left = 2 * index + 1;
+        auto right = left + 1;
+        auto smallest = index;
+
+        if (left < elements.size() && elements.get(left) < elements.get(smallest)) {
+            smallest = left;
+        }
+
+        if (right < elements.size() && elements.get(right) < elements.get(smallest)) {
+            smallest = right;
+        }
+
+        if (smallest == index) {
+            return;
+        }
+
+        swap(index, smallest);
+        index = smallest;
+    }
+}
+
+template<class T>
+void PriorityQueue<T>::swap(uint32_t first, uint32_t second) {
+    T tmp = elements.get(first);
+    elements.set(first, elements.get(second));
+    elements.set(second, tmp);
+}
+
+}
+
+#endif
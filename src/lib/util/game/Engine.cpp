@@ -143,7 +143,7 @@ void Engine::drawStatus() {
     auto charHeight = statisticsFont.getCharHeight() + 2;
     auto color = graphics.getColor();
 
-    const auto &memoryManager = Util::System::getAddressSpaceHeader().memoryManager;
+    const auto &memoryManager = Util::System::getAddressSpaceHeader().getMemoryManager();
     auto heapUsed = (memoryManager.getTotalMemory() - memoryManager.getFreeMemory());
     auto heapUsedM = heapUsed / 1000 / 1000;
     auto heapUsedK = (heapUsed - heapUsedM * 1000 * 1000) / 1000;
@@ -143,7 +143,7 @@ void LinearFrameBufferTerminal::setCursor(bool enabled) {
         }
 
         cursorRunnable = new CursorRunnable(*this, cursor);
-        Util::Async::Thread::createThread("Cursor", cursorRunnable);
+        Util::Async::Thread::createThread("Cursor", cursorRunnable).setPriority(Util::Async::Thread::HIGH);
     } else if (cursorRunnable != nullptr) {
         cursorRunnable->stop();
         cursorRunnable = nullptr;
@@ -37,7 +37,8 @@ namespace Util::Graphic {
 
 Terminal::Terminal(uint16_t columns, uint16_t rows) : outputStream(*this), columns(columns), rows(rows) {
     outputStream.connect(inputStream);
-    Async::Thread::createThread("Terminal", new KeyboardRunnable(*this));
+    // Keyboard input should be handled quickly, even if CPU-bound threads are running
+    Async::Thread::createThread("Terminal", new KeyboardRunnable(*this)).setPriority(Async::Thread::HIGH);
 }
 
 void Terminal::write(uint8_t c) {
@@ -56,8 +56,6 @@ uint64_t CpuId::getCpuFeatureBits() {
         return 0;
     }
 
-    auto features = Util::ArrayList<CpuFeature>();
-
     uint32_t ecx, edx;
     asm volatile(
             "mov $1,%%eax;"
@@ -66,12 +64,43 @@ uint64_t CpuId::getCpuFeatureBits() {
             "mov %%ecx,%1;"
             : "=r"(edx), "=r"(ecx)
             :
-            : "%ecx", "%edx"
+            : "%eax", "%ebx", "%ecx", "%edx"
             );
 
     return static_cast<uint64_t>(ecx) << 32 | edx;
 }
 
+uint32_t CpuId::getExtendedCpuFeatureBits() {
+    if (!isAvailable()) {
+        return 0;
+    }
+
+    uint32_t maxLeaf;
+    asm volatile(
+            "mov $0,%%eax;"
+            "cpuid;"
+            : "=a"(maxLeaf)
+            :
+            : "%ebx", "%ecx", "%edx"
+            );
+
+    if (maxLeaf < 7) {
+        return 0;
+    }
+
+    uint32_t ebx;
+    asm volatile(
+            "mov $7,%%eax;"
+            "mov $0,%%ecx;"
+            "cpuid;"
+            : "=b"(ebx)
+            :
+            : "%eax", "%ecx", "%edx"
+            );
+
+    return ebx;
+}
+
 Util::Array<CpuId::CpuFeature> CpuId::getCpuFeatures() {
     if (!isAvailable()) {
         return Util::Array<CpuId::CpuFeature>(0);
@@ -107,6 +107,17 @@ public:
         RDRAND = 1ull << 62
     };
 
+    enum ExtendedCpuFeature : uint32_t {
+        /* EBX features of leaf 7 */
+        FSGSBASE = 1 << 0,
+        BMI1 = 1 << 3,
+        AVX2 = 1 << 5,
+        SMEP = 1 << 7,
+        BMI2 = 1 << 8,
+        ERMS = 1 << 9,
+        INVPCID = 1 << 10
+    };
+
     /**
      * Default Constructor.
      * Deleted, as this class has only static members.
@@ -136,6 +147,8 @@ public:
 
     [[nodiscard]] static Util::Array<CpuFeature> getCpuFeatures();
 
+    [[nodiscard]] static uint32_t getExtendedCpuFeatureBits();
+
     [[nodiscard]] static CpuInfo getCpuInfo();
 
     [[nodiscard]] static const char* getFeatureAsString(CpuFeature);
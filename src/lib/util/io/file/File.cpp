@@ -159,6 +159,15 @@ bool File::isReadyToRead() {
     return isReadyToRead(fileDescriptor);
 }
 
+bool File::sync() {
+    ensureFileIsOpened();
+    if (fileDescriptor < 0) {
+        Util::Exception::throwException(Exception::INVALID_ARGUMENT, "File: Could not open file!");
+    }
+
+    return sync(fileDescriptor);
+}
+
 Util::String File::getCanonicalPath(const Util::String &path) {
     if (path.isEmpty()) {
         return "";
@@ -227,6 +236,10 @@ bool File::isReadyToRead(int32_t fileDescriptor) {
     return readyToRead;
 }
 
+bool File::sync(int32_t fileDescriptor) {
+    return controlFile(fileDescriptor, SYNC, Util::Array<uint32_t>(0));
+}
+
 void File::close(int32_t fileDescriptor) {
     return ::closeFile(fileDescriptor);
 }
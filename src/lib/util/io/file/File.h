@@ -55,6 +55,14 @@ public:
         IS_READY_TO_READ
     };
 
+    /**
+     * Requests to regular files, which are handled by the filesystem driver (see controlFile()).
+     * The values do not overlap with requests of other nodes (e.g. devices), so they can safely be sent to any file.
+     */
+    enum FileRequest {
+        SYNC = 0x1000
+    };
+
     /**
      * Constructor.
      */
@@ -107,6 +115,13 @@ public:
 
     bool isReadyToRead();
 
+    /**
+     * Write back cached data of the file to its storage device (like fsync()).
+     *
+     * @return false, if the file does not support syncing (e.g. it is not stored on a device) or writing back has failed
+     */
+    bool sync();
+
     [[nodiscard]] static String getCanonicalPath(const Util::String &path);
 
     [[nodiscard]] static File getCurrentWorkingDirectory();
@@ -123,6 +138,8 @@ public:
 
     static bool isReadyToRead(int32_t fileDescriptor);
 
+    static bool sync(int32_t fileDescriptor);
+
     static void close(int32_t fileDescriptor);
 
     static bool mount(const Util::String &device, const Util::String &targetPath, const Util::String &driverName);
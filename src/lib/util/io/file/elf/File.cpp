@@ -104,6 +104,18 @@ void File::loadProgram() {
     }
 }
 
+const FileHeader &File::getFileHeader() const {
+    return fileHeader;
+}
+
+const ProgramHeader &File::getProgramHeader(uint32_t index) const {
+    if (index >= fileHeader.programHeaderEntries) {
+        Util::Exception::throwException(Util::Exception::OUT_OF_BOUNDS, "ELF: Program header index out of bounds!");
+    }
+
+    return programHeaders[index];
+}
+
 const SectionHeader &File::getSectionHeader(SectionHeaderType headerType) const {
     for (int i = 0; i < fileHeader.sectionHeaderEntries; i++) {
         const auto &header = sectionHeaders[i];
@@ -115,4 +127,43 @@ const SectionHeader &File::getSectionHeader(SectionHeaderType headerType) const
     Util::Exception::throwException(Util::Exception::INVALID_ARGUMENT, "ELF: Section header not found!");
 }
 
+const uint8_t* File::getSectionContent(const SectionHeader &header) const {
+    return buffer + header.offset;
+}
+
+const uint8_t* File::findNote(const char *name, uint32_t type, uint32_t &descriptionSize) const {
+    for (int i = 0; i < fileHeader.sectionHeaderEntries; i++) {
+        const auto &header = sectionHeaders[i];
+        if (header.type != SectionHeaderType::NOTE) {
+            continue;
+        }
+
+        const auto *description = findNote(buffer + header.offset, header.size, name, type, descriptionSize);
+        if (description != nullptr) {
+            return description;
+        }
+    }
+
+    return nullptr;
+}
+
+const uint8_t* File::findNote(const uint8_t *notes, uint32_t size, const char *name, uint32_t type, uint32_t &descriptionSize) {
+    // Name and description of each note are padded to a multiple of 4 bytes
+    uint32_t offset = 0;
+    while (offset + sizeof(NoteHeader) <= size) {
+        const auto &note = *reinterpret_cast<const NoteHeader*>(notes + offset);
+        const auto *noteName = reinterpret_cast<const char*>(&note + 1);
+        const auto *description = reinterpret_cast<const uint8_t*>(noteName) + Util::Address<uint32_t>(note.nameSize).alignUp(4).get();
+
+        if (note.type == type && note.nameSize > 0 && Util::Address<uint32_t>(noteName).compareString(name) == 0) {
+            descriptionSize = note.descriptionSize;
+            return description;
+        }
+
+        offset += sizeof(NoteHeader) + Util::Address<uint32_t>(note.nameSize).alignUp(4).get() + Util::Address<uint32_t>(note.descriptionSize).alignUp(4).get();
+    }
+
+    return nullptr;
+}
+
 }
\ No newline at end of file
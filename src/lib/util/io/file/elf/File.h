@@ -60,6 +60,12 @@ enum class ProgramHeaderType : uint32_t {
     PHDR = 0x06,
 };
 
+enum class ProgramHeaderFlag : uint32_t {
+    EXECUTABLE = 0x01,
+    WRITABLE = 0x02,
+    READABLE = 0x04
+};
+
 enum class MachineType : uint16_t {
     X86 = 0x03
 };
@@ -210,6 +216,12 @@ struct DynamicEntry {
     uint32_t value;
 } __attribute__((packed));
 
+struct NoteHeader {
+    uint32_t nameSize;
+    uint32_t descriptionSize;
+    uint32_t type;
+} __attribute__((packed));
+
 class File {
 
 public:
@@ -228,6 +240,35 @@ public:
 
     [[nodiscard]] const SectionHeader& getSectionHeader(SectionHeaderType headerType) const;
 
+    [[nodiscard]] const uint8_t* getSectionContent(const SectionHeader &header) const;
+
+    /**
+     * Search all note sections for a note with the given name and type.
+     *
+     * @param name The note's name (owner)
+     * @param type The note's type
+     * @param descriptionSize Is set to the size of the note's description, if the note is found
+     * @return The note's description or nullptr, if the note is not found
+     */
+    [[nodiscard]] const uint8_t* findNote(const char *name, uint32_t type, uint32_t &descriptionSize) const;
+
+    /**
+     * Search the content of a single note section for a note with the given name and type
+     * (e.g. if only the note section has been read from the file).
+     *
+     * @param notes The content of the note section
+     * @param size The size of the note section
+     * @param name The note's name (owner)
+     * @param type The note's type
+     * @param descriptionSize Is set to the size of the note's description, if the note is found
+     * @return The note's description or nullptr, if the note is not found
+     */
+    [[nodiscard]] static const uint8_t* findNote(const uint8_t *notes, uint32_t size, const char *name, uint32_t type, uint32_t &descriptionSize);
+
+    [[nodiscard]] const FileHeader& getFileHeader() const;
+
+    [[nodiscard]] const ProgramHeader& getProgramHeader(uint32_t index) const;
+
     [[nodiscard]] int32_t (*getEntryPoint() const)(int, char**) {
         return reinterpret_cast<int (*)(int, char**)>(fileHeader.entry);
     }
@@ -19,7 +19,6 @@
 #include "lib/util/base/Exception.h"
 #include "PipedOutputStream.h"
 #include "PipedInputStream.h"
-#include "lib/util/async/Thread.h"
 
 namespace Util::Io {
 
@@ -72,9 +71,7 @@ int32_t PipedInputStream::read(uint8_t *targetBuffer, uint32_t offset, uint32_t
     // Block while buffer is empty
     lock.acquire();
     while (inPosition < 0) {
-        lock.release();
-        Async::Thread::yield();
-        lock.acquire();
+        bufferNotEmpty.wait(lock);
     }
 
     uint32_t remaining = length;
@@ -111,6 +108,7 @@ int32_t PipedInputStream::read(uint8_t *targetBuffer, uint32_t offset, uint32_t
 
         // Check if we have copied the requested amount of bytes or if the internal buffer is empty
         if (remaining == 0 || inPosition == -1) {
+            bufferNotFull.signal();
             lock.release();
             return ret;
         }
@@ -129,9 +127,7 @@ void PipedInputStream::write(const uint8_t *sourceBuffer, uint32_t offset, uint3
     while (remaining > 0) {
         // Block while buffer is full
         while (inPosition == outPosition) {
-            lock.release();
-            Async::Thread::yield();
-            lock.acquire();
+            bufferNotFull.wait(lock);
         }
 
         if (inPosition < 0) { // Buffer is empty
@@ -159,6 +155,8 @@ void PipedInputStream::write(const uint8_t *sourceBuffer, uint32_t offset, uint3
         if (inPosition == bufferSize) {
             inPosition = 0;
         }
+
+        bufferNotEmpty.signal();
     }
 
     lock.release();
@@ -21,7 +21,8 @@
 #include <stdint.h>
 
 #include "InputStream.h"
-#include "lib/util/async/Spinlock.h"
+#include "lib/util/async/Mutex.h"
+#include "lib/util/async/ConditionVariable.h"
 
 namespace Util::Io {
 
@@ -61,7 +62,9 @@ private:
 
     PipedOutputStream *source = nullptr;
 
-    Util::Async::Spinlock lock;
+    Util::Async::Mutex lock;
+    Util::Async::ConditionVariable bufferNotEmpty;
+    Util::Async::ConditionVariable bufferNotFull;
 
     uint8_t *buffer;
     int32_t bufferSize;